@@ -0,0 +1,63 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "BlobTrackingComponent.h"
+
+UBlobTrackingComponent::UBlobTrackingComponent(const class FObjectInitializer& ObjInit) 
+	: Super(ObjInit) 
+{ 
+	m_feature = RealSenseFeature::BLOB_TRACKING;
+
+	lastFrameNumber = 0;
+}
+
+// Copies the blobs once per camera frame, reusing the allocation of Blobs.
+void UBlobTrackingComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, 
+	                                       FActorComponentTickFunction *ThisTickFunction) 
+{
+	if (globalRealSenseSession->IsCameraRunning() == false) {
+		return;
+	}
+
+	const uint64 FrameNumber = globalRealSenseSession->GetFrameNumber();
+	if (FrameNumber == lastFrameNumber) {
+		return;
+	}
+	lastFrameNumber = FrameNumber;
+
+	const TArray<FDepthBlob>& Source = globalRealSenseSession->GetBlobs();
+	Blobs.Reset(Source.Num());
+	Blobs.Append(Source);
+
+	OnBlobsUpdated.Broadcast();
+}
+
+void UBlobTrackingComponent::ConfigureBlobTracking(int32 MinDepth, int32 MaxDepth, int32 MinArea, int32 MaxBlobs, 
+												   float MaxMatchDistance)
+{
+	globalRealSenseSession->ConfigureBlobTracking(MinDepth, MaxDepth, MinArea, MaxBlobs, MaxMatchDistance);
+}
+
+bool UBlobTrackingComponent::FindBlob(int32 Id, FDepthBlob& Blob)
+{
+	for (const FDepthBlob& Candidate : Blobs) {
+		if (Candidate.Id == Id) {
+			Blob = Candidate;
+			return true;
+		}
+	}
+	return false;
+}
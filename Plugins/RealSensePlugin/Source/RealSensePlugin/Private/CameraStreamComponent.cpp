@@ -33,7 +33,8 @@ void UCameraStreamComponent::InitializeComponent()
 	DepthTexture = UTexture2D::CreateTransient(1, 1, EPixelFormat::PF_B8G8R8A8);
 }
 
-// Copies the ColorBuffer and DepthBuffer from the RealSenseSessionManager.
+// Copies the ColorBuffer, DepthBuffer, DepthStatistics, and segmentation mask from the 
+// RealSenseSessionManager.
 void UCameraStreamComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, 
 	                                       FActorComponentTickFunction *ThisTickFunction)
 {
@@ -43,11 +44,14 @@ void UCameraStreamComponent::TickComponent(float DeltaTime, enum ELevelTick Tick
 
 	ColorBuffer = globalRealSenseSession->GetColorBuffer();
 	DepthBuffer = globalRealSenseSession->GetDepthBuffer();
+	DepthStatistics = globalRealSenseSession->GetDepthStatistics();
+	SegmentationMask = globalRealSenseSession->GetSegmentationMask();
+	SegmentationRuns = globalRealSenseSession->GetSegmentationRuns();
 }
 
 // If the supplied resolution is valid, this function will pass that resolution
-// along to the RealSenseSessionManager and recreate the ColorTexture objects
-// to have the same resolution.
+// along to the RealSenseSessionManager and switch the ColorTexture object to a
+// texture with the same resolution.
 void UCameraStreamComponent::SetColorCameraResolution(EColorResolution resolution) 
 {
 	if (resolution == EColorResolution::UNDEFINED) {
@@ -58,14 +62,12 @@ void UCameraStreamComponent::SetColorCameraResolution(EColorResolution resolutio
 
 	int ColorImageWidth = globalRealSenseSession->GetColorImageWidth();
 	int ColorImageHeight = globalRealSenseSession->GetColorImageHeight();
-	ColorTexture = UTexture2D::CreateTransient(ColorImageWidth, ColorImageHeight,
-											   PF_B8G8R8A8);
-	ColorTexture->UpdateResource();
+	ColorTexture = FindOrCreateTexture(ColorImageWidth, ColorImageHeight);
 }
 
 // If the supplied resolution is valid, this function will pass that resolution
-// along to the RealSenseSessionManager and recreate the DepthTexture objects
-// to have the same resolution.
+// along to the RealSenseSessionManager and switch the DepthTexture object to a
+// texture with the same resolution.
 void UCameraStreamComponent::SetDepthCameraResolution(EDepthResolution resolution)
 {
 	if (resolution == EDepthResolution::UNDEFINED) {
@@ -76,9 +78,7 @@ void UCameraStreamComponent::SetDepthCameraResolution(EDepthResolution resolutio
 	
 	int DepthImageWidth = globalRealSenseSession->GetDepthImageWidth();
 	int DepthImageHeight = globalRealSenseSession->GetDepthImageHeight();
-	DepthTexture = UTexture2D::CreateTransient(DepthImageWidth, DepthImageHeight, 
-											   PF_B8G8R8A8);
-	DepthTexture->UpdateResource();
+	DepthTexture = FindOrCreateTexture(DepthImageWidth, DepthImageHeight);
 }
 
 // Enable 3D segmentation.
@@ -89,4 +89,92 @@ void UCameraStreamComponent::Enable3DSegmentation(bool b3DSeg)
 		m_feature = RealSenseFeature::SEGMENTATION_3D;
 		Super::EnableFeature();
 	}
-}
\ No newline at end of file
+}
+
+void UCameraStreamComponent::SetSegmentationOutput(ESegmentationOutput Output)
+{
+	globalRealSenseSession->SetSegmentationOutput(Output);
+}
+
+void UCameraStreamComponent::SetSegmentationCleanup(int32 OpenRadius, int32 CloseRadius, int32 FeatherWidth)
+{
+	globalRealSenseSession->SetSegmentationCleanup(OpenRadius, CloseRadius, FeatherWidth);
+}
+
+int32 UCameraStreamComponent::GetDepthAt(int32 X, int32 Y) const
+{
+	return globalRealSenseSession->GetDepthAt(X, Y);
+}
+
+float UCameraStreamComponent::GetDepthInRect(int32 X, int32 Y, int32 Width, int32 Height, 
+											 EDepthRegionStatistic Statistic) const
+{
+	return globalRealSenseSession->GetDepthInRect(X, Y, Width, Height, Statistic);
+}
+
+TArray<int32> UCameraStreamComponent::GetDepthAtPoints(const TArray<FIntPoint>& Points) const
+{
+	TArray<int32> Depths;
+	globalRealSenseSession->GetDepthAtPoints(Points, Depths);
+	return Depths;
+}
+
+void UCameraStreamComponent::EnableDepthSummedAreaTable(bool bEnable)
+{
+	globalRealSenseSession->EnableDepthSummedAreaTable(bEnable);
+}
+
+bool UCameraStreamComponent::StartStreamServer(int32 Port, int32 JpegQuality)
+{
+	return globalRealSenseSession->StartStreamServer(Port, JpegQuality);
+}
+
+void UCameraStreamComponent::StopStreamServer()
+{
+	globalRealSenseSession->StopStreamServer();
+}
+
+bool UCameraStreamComponent::ConnectToStreamServer(const FString& Host, int32 Port)
+{
+	return globalRealSenseSession->ConnectToStreamServer(Host, Port);
+}
+
+void UCameraStreamComponent::DisconnectFromStreamServer()
+{
+	globalRealSenseSession->DisconnectFromStreamServer();
+}
+
+FRealSenseStreamStats UCameraStreamComponent::GetStreamStats() const
+{
+	return globalRealSenseSession->GetStreamStats();
+}
+
+bool UCameraStreamComponent::StartSharedMemoryPublisher(const FString& Name)
+{
+	return globalRealSenseSession->StartSharedMemoryPublisher(Name);
+}
+
+void UCameraStreamComponent::StopSharedMemoryPublisher()
+{
+	globalRealSenseSession->StopSharedMemoryPublisher();
+}
+
+void UCameraStreamComponent::StartFrameHistory(int32 MemoryBudgetMB, int32 Downsample)
+{
+	globalRealSenseSession->StartFrameHistory(MemoryBudgetMB, Downsample);
+}
+
+void UCameraStreamComponent::StopFrameHistory()
+{
+	globalRealSenseSession->StopFrameHistory();
+}
+
+bool UCameraStreamComponent::GetDepthFrameAgo(float SecondsAgo, TArray<int32>& Depth, int32& Width, int32& Height) const
+{
+	return globalRealSenseSession->GetHistoryDepthFrame(SecondsAgo, Depth, Width, Height);
+}
+
+bool UCameraStreamComponent::GetColorFrameAgo(float SecondsAgo, TArray<FSimpleColor>& Color, int32& Width, int32& Height) const
+{
+	return globalRealSenseSession->GetHistoryColorFrame(SecondsAgo, Color, Width, Height);
+}
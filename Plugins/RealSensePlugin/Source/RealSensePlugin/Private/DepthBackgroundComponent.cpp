@@ -0,0 +1,63 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "DepthBackgroundComponent.h"
+
+UDepthBackgroundComponent::UDepthBackgroundComponent(const class FObjectInitializer& ObjInit) 
+	: Super(ObjInit) 
+{ 
+	m_feature = RealSenseFeature::DEPTH_BACKGROUND;
+
+	bLearningBackground = false;
+	lastFrameNumber = 0;
+}
+
+// Copies the mask once per camera frame, reusing the allocation of 
+// ForegroundMask.
+void UDepthBackgroundComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, 
+	                                          FActorComponentTickFunction *ThisTickFunction) 
+{
+	if (globalRealSenseSession->IsCameraRunning() == false) {
+		return;
+	}
+
+	const uint64 FrameNumber = globalRealSenseSession->GetFrameNumber();
+	if (FrameNumber == lastFrameNumber) {
+		return;
+	}
+	lastFrameNumber = FrameNumber;
+
+	bLearningBackground = globalRealSenseSession->IsLearningDepthBackground();
+
+	const TArray<uint8>& Source = globalRealSenseSession->GetForegroundMask();
+	ForegroundMask.Reset(Source.Num());
+	ForegroundMask.Append(Source);
+
+	OnForegroundUpdated.Broadcast();
+}
+
+void UDepthBackgroundComponent::ConfigureDepthBackground(int32 LearningFrames, int32 AdaptationStep, int32 AbsorbInterval, 
+														 int32 MinBand, int32 BandScale, int32 OpenRadius, 
+														 int32 UnobservedFrames)
+{
+	globalRealSenseSession->ConfigureDepthBackground(LearningFrames, AdaptationStep, AbsorbInterval, MinBand, BandScale, 
+													 OpenRadius, UnobservedFrames);
+}
+
+void UDepthBackgroundComponent::LearnBackground()
+{
+	globalRealSenseSession->LearnDepthBackground();
+}
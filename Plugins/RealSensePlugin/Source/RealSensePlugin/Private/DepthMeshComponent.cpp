@@ -0,0 +1,60 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "DepthMeshComponent.h"
+#include "RealSenseDepthMesh.h"
+
+UDepthMeshComponent::UDepthMeshComponent(const class FObjectInitializer& ObjInit) 
+	: Super(ObjInit) 
+{ 
+	m_feature = RealSenseFeature::CAMERA_STREAMING;
+
+	RealSenseDepthMeshSettings defaults;
+	GridStep = defaults.step;
+	DiscontinuityRatio = defaults.discontinuityRatio;
+	MaxDepth = defaults.maxDepth;
+	bTrianglesChanged = false;
+
+	depthMesh = std::make_shared<RealSenseDepthMesh>();
+	lastFrameNumber = 0;
+}
+
+// Rebuilds the mesh once per camera frame, directly into the Blueprint-visible
+// arrays so that their allocations are reused from frame to frame.
+void UDepthMeshComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, 
+	                                    FActorComponentTickFunction *ThisTickFunction) 
+{
+	bTrianglesChanged = false;
+
+	if (globalRealSenseSession->IsCameraRunning() == false) {
+		return;
+	}
+
+	const uint64 FrameNumber = globalRealSenseSession->GetFrameNumber();
+	if (FrameNumber == lastFrameNumber) {
+		return;
+	}
+	lastFrameNumber = FrameNumber;
+
+	RealSenseDepthMeshSettings Settings;
+	Settings.step = GridStep;
+	Settings.discontinuityRatio = DiscontinuityRatio;
+	Settings.maxDepth = MaxDepth;
+	depthMesh->Configure(Settings);
+
+	bTrianglesChanged = globalRealSenseSession->UpdateDepthMesh(*depthMesh, Vertices, Normals, UV, Triangles);
+	OnMeshUpdated.Broadcast();
+}
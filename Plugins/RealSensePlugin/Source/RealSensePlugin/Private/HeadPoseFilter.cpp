@@ -0,0 +1,219 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "HeadPoseFilter.h"
+
+// Returns the smoothing factor of a first-order low-pass filter with the
+// given cutoff frequency (Hz) sampled at interval dt (seconds).
+static double SmoothingFactor(double cutoff, double dt)
+{
+	const double tau = 1.0 / (2.0 * PI * cutoff);
+	return 1.0 / (1.0 + tau / dt);
+}
+
+HeadPoseFilter::HeadPoseFilter()
+{
+	Reset();
+}
+
+void HeadPoseFilter::Configure(const HeadPoseFilterSettings& newSettings)
+{
+	if (newSettings.type != settings.type) {
+		Reset();
+	}
+	settings = newSettings;
+}
+
+void HeadPoseFilter::Reset()
+{
+	FMemory::Memzero(channels, sizeof(channels));
+	bInitialized = false;
+	lastTimestamp = 0.0;
+}
+
+// Splits the pose into six channels and advances each one. Rotation channels
+// are unwound against the previous measurement so the filters only ever see
+// continuous angles.
+void HeadPoseFilter::Update(const FVector& position, const FRotator& rotation, double timestamp)
+{
+	const double measurements[NumChannels] = { position.X, position.Y, position.Z,
+											   rotation.Pitch, rotation.Yaw, rotation.Roll };
+
+	if (bInitialized == false) {
+		for (int32 i = 0; i < NumChannels; i++) {
+			channels[i].value = measurements[i];
+			channels[i].raw = measurements[i];
+			channels[i].velocity = 0.0;
+			channels[i].variance[0] = settings.measurementNoise;
+			channels[i].variance[1] = 0.0;
+			channels[i].variance[2] = settings.processNoise;
+		}
+		lastTimestamp = timestamp;
+		bInitialized = true;
+		return;
+	}
+
+	const double dt = timestamp - lastTimestamp;
+	if (dt <= 0.0) {
+		return;
+	}
+	lastTimestamp = timestamp;
+
+	for (int32 i = 0; i < NumChannels; i++) {
+		Channel& channel = channels[i];
+
+		double measurement = measurements[i];
+		if (i >= 3) {
+			measurement = channel.raw + FRotator::NormalizeAxis(measurement - channel.raw);
+		}
+
+		switch (settings.type) {
+		case EHeadPoseFilter::ONE_EURO:
+			UpdateOneEuro(channel, measurement, dt);
+			break;
+		case EHeadPoseFilter::KALMAN:
+			UpdateKalman(channel, measurement, dt);
+			break;
+		default:
+			channel.velocity = (measurement - channel.raw) / dt;
+			channel.value = measurement;
+			break;
+		}
+
+		channel.raw = measurement;
+	}
+}
+
+FVector HeadPoseFilter::GetFilteredPosition() const
+{
+	return FVector(channels[0].value, channels[1].value, channels[2].value);
+}
+
+FRotator HeadPoseFilter::GetFilteredRotation() const
+{
+	return FRotator(channels[3].value, channels[4].value, channels[5].value).GetNormalized();
+}
+
+void HeadPoseFilter::Predict(double targetTime, FVector& outPosition, FRotator& outRotation) const
+{
+	const double dt = FMath::Max(0.0, targetTime - lastTimestamp);
+
+	double predicted[NumChannels];
+	for (int32 i = 0; i < NumChannels; i++) {
+		predicted[i] = channels[i].value + channels[i].velocity * dt;
+	}
+
+	outPosition = FVector(predicted[0], predicted[1], predicted[2]);
+	outRotation = FRotator(predicted[3], predicted[4], predicted[5]).GetNormalized();
+}
+
+// One-Euro filter (Casiez et al.): an adaptive low-pass filter whose cutoff
+// rises with the speed of the signal, trading jitter at rest for low lag
+// during fast motion.
+void HeadPoseFilter::UpdateOneEuro(Channel& channel, double measurement, double dt) const
+{
+	const double derivative = (measurement - channel.value) / dt;
+	const double alphaDerivative = SmoothingFactor(settings.derivativeCutoff, dt);
+	channel.velocity += alphaDerivative * (derivative - channel.velocity);
+
+	const double cutoff = settings.minCutoff + settings.beta * FMath::Abs(channel.velocity);
+	const double alpha = SmoothingFactor(cutoff, dt);
+	channel.value += alpha * (measurement - channel.value);
+}
+
+// Constant-velocity Kalman filter with a [position, velocity] state and
+// white-noise acceleration as the process model.
+void HeadPoseFilter::UpdateKalman(Channel& channel, double measurement, double dt) const
+{
+	const double q = settings.processNoise;
+	const double r = settings.measurementNoise;
+	double& p00 = channel.variance[0];
+	double& p01 = channel.variance[1];
+	double& p11 = channel.variance[2];
+
+	// Predict
+	channel.value += channel.velocity * dt;
+	p00 += dt * (2.0 * p01 + dt * p11) + q * dt * dt * dt / 3.0;
+	p01 += dt * p11 + q * dt * dt / 2.0;
+	p11 += q * dt;
+
+	// Correct
+	const double s = p00 + r;
+	const double k0 = p00 / s;
+	const double k1 = p01 / s;
+	const double innovation = measurement - channel.value;
+
+	channel.value += k0 * innovation;
+	channel.velocity += k1 * innovation;
+
+	p11 -= k1 * p01;
+	p01 -= k0 * p01;
+	p00 -= k0 * p00;
+}
+
+// Runs the filter over the log in order. After each sample, the pose is
+// predicted `horizon` seconds ahead and compared against the logged pose at
+// that time, linearly interpolated between the two surrounding samples.
+float HeadPoseFilter::MeasurePredictionError(const HeadPoseFilterSettings& settings,
+											 const TArray<FHeadPoseSample>& log,
+											 float horizon, float& outRotationError)
+{
+	outRotationError = 0.0f;
+
+	HeadPoseFilter filter;
+	filter.Configure(settings);
+
+	double positionError = 0.0;
+	double rotationError = 0.0;
+	int32 count = 0;
+	int32 truth = 0;
+
+	for (int32 i = 0; i < log.Num(); i++) {
+		filter.Update(log[i].Position, log[i].Rotation, log[i].Time);
+
+		const float target = log[i].Time + horizon;
+		while ((truth + 1 < log.Num()) && (log[truth + 1].Time < target)) {
+			truth++;
+		}
+		if (truth + 1 >= log.Num()) {
+			break;
+		}
+
+		const FHeadPoseSample& a = log[truth];
+		const FHeadPoseSample& b = log[truth + 1];
+		const float span = b.Time - a.Time;
+		const float alpha = (span > 0.0f) ? FMath::Clamp((target - a.Time) / span, 0.0f, 1.0f) : 0.0f;
+
+		const FVector truePosition = FMath::Lerp(a.Position, b.Position, alpha);
+		const FRotator trueRotation = a.Rotation + (b.Rotation - a.Rotation).GetNormalized() * alpha;
+
+		FVector predictedPosition;
+		FRotator predictedRotation;
+		filter.Predict(target, predictedPosition, predictedRotation);
+
+		const FRotator delta = (predictedRotation - trueRotation).GetNormalized();
+		positionError += (predictedPosition - truePosition).SizeSquared();
+		rotationError += FVector(delta.Pitch, delta.Yaw, delta.Roll).SizeSquared();
+		count++;
+	}
+
+	if (count == 0) {
+		return 0.0f;
+	}
+
+	outRotationError = FMath::Sqrt(rotationError / count);
+	return FMath::Sqrt(positionError / count);
+}
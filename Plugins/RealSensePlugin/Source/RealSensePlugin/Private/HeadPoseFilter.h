@@ -0,0 +1,97 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+
+// Tuning parameters shared by the head pose filters.
+struct HeadPoseFilterSettings {
+	EHeadPoseFilter type;
+
+	// One-Euro filter: cutoff frequency (Hz) at rest, speed coefficient, and
+	// cutoff frequency (Hz) used to smooth the derivative.
+	float minCutoff;
+	float beta;
+	float derivativeCutoff;
+
+	// Kalman filter: acceleration noise density and measurement variance.
+	float processNoise;
+	float measurementNoise;
+
+	HeadPoseFilterSettings() : type(EHeadPoseFilter::ONE_EURO), minCutoff(1.0f), beta(0.01f),
+		derivativeCutoff(1.0f), processNoise(50.0f), measurementNoise(4.0f) {}
+};
+
+// Filters timestamped head poses and extrapolates them with a constant-velocity
+// model so that the pose can be evaluated at the time the frame will actually
+// be displayed rather than the time the camera captured it.
+//
+// Position and rotation are filtered as six independent channels. Rotation
+// channels are unwound before filtering so that crossing +/-180 degrees does
+// not produce a velocity spike.
+class HeadPoseFilter {
+public:
+	HeadPoseFilter();
+
+	void Configure(const HeadPoseFilterSettings& settings);
+
+	// Discards all filter state. The next sample re-initializes the filter.
+	void Reset();
+
+	// Feeds a new measurement captured at the given time (in seconds).
+	// Samples that are not newer than the previous one are ignored.
+	void Update(const FVector& position, const FRotator& rotation, double timestamp);
+
+	inline bool HasSamples() const { return bInitialized; }
+
+	inline double GetLastTimestamp() const { return lastTimestamp; }
+
+	FVector GetFilteredPosition() const;
+
+	FRotator GetFilteredRotation() const;
+
+	// Extrapolates the filtered pose to targetTime (in seconds) assuming
+	// constant velocity since the last measurement.
+	void Predict(double targetTime, FVector& outPosition, FRotator& outRotation) const;
+
+	// Replays a recorded pose log through a filter with the given settings and
+	// compares the pose predicted `horizon` seconds ahead against the logged
+	// pose at that time. Returns the RMS position error and writes the RMS
+	// rotation error (in degrees) to outRotationError.
+	static float MeasurePredictionError(const HeadPoseFilterSettings& settings,
+										const TArray<FHeadPoseSample>& log,
+										float horizon, float& outRotationError);
+
+private:
+	// State of a single filtered channel.
+	struct Channel {
+		double value;     // Filtered value
+		double velocity;  // Filtered derivative (units per second)
+		double raw;       // Last unwound measurement
+		double variance[3];  // Kalman covariance (p00, p01, p11)
+	};
+
+	static const int32 NumChannels = 6;
+
+	HeadPoseFilterSettings settings;
+	Channel channels[NumChannels];
+	bool bInitialized;
+	double lastTimestamp;
+
+	void UpdateOneEuro(Channel& channel, double measurement, double dt) const;
+
+	void UpdateKalman(Channel& channel, double measurement, double dt) const;
+};
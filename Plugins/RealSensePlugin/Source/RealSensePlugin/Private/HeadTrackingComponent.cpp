@@ -15,11 +15,26 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 #include "RealSensePluginPrivatePCH.h"
 #include "HeadTrackingComponent.h"
+#include "HeadPoseFilter.h"
 
 UHeadTrackingComponent::UHeadTrackingComponent(const class FObjectInitializer& ObjInit) 
 	: Super(ObjInit) 
 { 
 	m_feature = RealSenseFeature::HEAD_TRACKING;
+
+	HeadPoseFilterSettings defaults;
+	PoseFilter = defaults.type;
+	MinCutoff = defaults.minCutoff;
+	Beta = defaults.beta;
+	DerivativeCutoff = defaults.derivativeCutoff;
+	ProcessNoise = defaults.processNoise;
+	MeasurementNoise = defaults.measurementNoise;
+	DisplayLatency = 0.033f;
+	bRecordPoseLog = false;
+
+	poseFilter = std::make_shared<HeadPoseFilter>();
+	lastFrameNumber = 0;
+	poseLogStartTime = 0.0;
 }
 
 void UHeadTrackingComponent::InitializeComponent()
@@ -29,6 +44,11 @@ void UHeadTrackingComponent::InitializeComponent()
 	HeadCount = 0;
 	HeadPosition = FVector(0.0f, 0.0f, 0.0f);
 	HeadRotation = FRotator(0.0f, 0.0f, 0.0f);
+
+	FilteredHeadPosition = HeadPosition;
+	FilteredHeadRotation = HeadRotation;
+	PredictedHeadPosition = HeadPosition;
+	PredictedHeadRotation = HeadRotation;
 }
 
 void UHeadTrackingComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, 
@@ -41,4 +61,61 @@ void UHeadTrackingComponent::TickComponent(float DeltaTime, enum ELevelTick Tick
 	HeadCount = globalRealSenseSession->GetHeadCount();
 	HeadPosition = globalRealSenseSession->GetHeadPosition();
 	HeadRotation = globalRealSenseSession->GetHeadRotation();
+
+	poseFilter->Configure(GetFilterSettings());
+
+	// Only feed the filter once per camera frame, stamped with the time the
+	// frame was captured rather than the time it reached the game thread.
+	const uint64 FrameNumber = globalRealSenseSession->GetFrameNumber();
+	if ((HeadCount > 0) && (FrameNumber != lastFrameNumber)) {
+		const double Timestamp = globalRealSenseSession->GetFrameTimestamp();
+		poseFilter->Update(HeadPosition, HeadRotation, Timestamp);
+		lastFrameNumber = FrameNumber;
+
+		if (bRecordPoseLog) {
+			if (PoseLog.Num() == 0) {
+				poseLogStartTime = Timestamp;
+			}
+			FHeadPoseSample Sample;
+			Sample.Time = Timestamp - poseLogStartTime;
+			Sample.Position = HeadPosition;
+			Sample.Rotation = HeadRotation;
+			PoseLog.Add(Sample);
+		}
+	}
+
+	if (poseFilter->HasSamples()) {
+		FilteredHeadPosition = poseFilter->GetFilteredPosition();
+		FilteredHeadRotation = poseFilter->GetFilteredRotation();
+		poseFilter->Predict(FPlatformTime::Seconds() + DisplayLatency, 
+						   PredictedHeadPosition, PredictedHeadRotation);
+	}
+}
+
+void UHeadTrackingComponent::ResetPoseFilter()
+{
+	poseFilter->Reset();
+}
+
+void UHeadTrackingComponent::ClearPoseLog()
+{
+	PoseLog.Empty();
+}
+
+float UHeadTrackingComponent::MeasurePredictionError(const TArray<FHeadPoseSample>& Log, 
+													 float Horizon, float& RotationError)
+{
+	return HeadPoseFilter::MeasurePredictionError(GetFilterSettings(), Log, Horizon, RotationError);
+}
+
+HeadPoseFilterSettings UHeadTrackingComponent::GetFilterSettings() const
+{
+	HeadPoseFilterSettings Settings;
+	Settings.type = PoseFilter;
+	Settings.minCutoff = MinCutoff;
+	Settings.beta = Beta;
+	Settings.derivativeCutoff = DerivativeCutoff;
+	Settings.processNoise = ProcessNoise;
+	Settings.measurementNoise = MeasurementNoise;
+	return Settings;
 }
@@ -0,0 +1,103 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "OccupancyGridComponent.h"
+#include "RealSenseOccupancyGrid.h"
+
+UOccupancyGridComponent::UOccupancyGridComponent(const class FObjectInitializer& ObjInit) 
+	: Super(ObjInit) 
+{ 
+	m_feature = RealSenseFeature::OCCUPANCY_GRID;
+
+	occupancyGrid = std::make_shared<RealSenseOccupancyGrid>();
+}
+
+// Catches up with the grid of the camera processing thread. When the whole 
+// grid was copied, after it was configured, a single region covers it.
+void UOccupancyGridComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, 
+	                                        FActorComponentTickFunction *ThisTickFunction) 
+{
+	ChangedRegions.Reset();
+
+	if (globalRealSenseSession->IsCameraRunning() == false) {
+		return;
+	}
+
+	globalRealSenseSession->CopyOccupancyGrid(*occupancyGrid, changedBricks);
+	if (changedBricks.Num() == 0) {
+		return;
+	}
+
+	if (changedBricks.Num() == occupancyGrid->GetBrickCount()) {
+		const RealSenseOccupancySettings& Settings = occupancyGrid->GetSettings();
+		ChangedRegions.Add(FBox(Settings.boundsMin, Settings.boundsMax));
+	}
+	else {
+		for (int32 Brick : changedBricks) {
+			ChangedRegions.Add(occupancyGrid->GetBrickBounds(Brick));
+		}
+	}
+
+	OnOccupancyChanged.Broadcast();
+}
+
+void UOccupancyGridComponent::ConfigureOccupancyGrid(FBox Bounds, float VoxelSize, int32 PixelStep)
+{
+	globalRealSenseSession->ConfigureOccupancyGrid(Bounds, VoxelSize, PixelStep);
+}
+
+void UOccupancyGridComponent::SetOccupancyCameraPose(const FTransform& CameraToWorld)
+{
+	globalRealSenseSession->SetOccupancyCameraPose(CameraToWorld);
+}
+
+bool UOccupancyGridComponent::IsPointOccupied(FVector Point)
+{
+	return occupancyGrid->IsOccupied(Point);
+}
+
+bool UOccupancyGridComponent::OverlapBox(FBox Box)
+{
+	return occupancyGrid->OverlapsBox(Box);
+}
+
+bool UOccupancyGridComponent::OverlapSphere(FVector Center, float Radius)
+{
+	return occupancyGrid->OverlapsSphere(Center, Radius);
+}
+
+bool UOccupancyGridComponent::RaycastOccupancy(FVector Start, FVector End, FVector& HitLocation, FVector& HitNormal)
+{
+	const FVector Direction = End - Start;
+	float Distance;
+	if (occupancyGrid->Raycast(Start, Direction, Direction.Size(), Distance, HitNormal) == false) {
+		return false;
+	}
+
+	HitLocation = Start + Direction.GetSafeNormal() * Distance;
+	return true;
+}
+
+void UOccupancyGridComponent::GetOccupiedVoxels(TArray<FVector>& Centers)
+{
+	Centers.Reset();
+	occupancyGrid->GetOccupiedVoxels(Centers);
+}
+
+float UOccupancyGridComponent::GetVoxelSize()
+{
+	return occupancyGrid->GetSettings().voxelSize;
+}
@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "PlaneDetectionComponent.h"
+
+UPlaneDetectionComponent::UPlaneDetectionComponent(const class FObjectInitializer& ObjInit) 
+	: Super(ObjInit) 
+{ 
+	m_feature = RealSenseFeature::PLANE_DETECTION;
+
+	lastPlaneRevision = 0;
+}
+
+// Copies the planes and the mask only when the detector produced new ones,
+// reusing the allocations of Planes and PlaneMask.
+void UPlaneDetectionComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, 
+	                                         FActorComponentTickFunction *ThisTickFunction) 
+{
+	if (globalRealSenseSession->IsCameraRunning() == false) {
+		return;
+	}
+
+	const uint64 PlaneRevision = globalRealSenseSession->GetPlaneRevision();
+	if (PlaneRevision == lastPlaneRevision) {
+		return;
+	}
+	lastPlaneRevision = PlaneRevision;
+
+	const TArray<FDepthPlane>& SourcePlanes = globalRealSenseSession->GetPlanes();
+	Planes.Reset(SourcePlanes.Num());
+	Planes.Append(SourcePlanes);
+
+	const TArray<uint8>& SourceMask = globalRealSenseSession->GetPlaneMask();
+	PlaneMask.Reset(SourceMask.Num());
+	PlaneMask.Append(SourceMask);
+
+	OnPlanesUpdated.Broadcast();
+}
+
+void UPlaneDetectionComponent::ConfigurePlaneDetection(int32 MaxPlanes, float InlierDistance, float MaxNormalAngle, 
+													   int32 PixelStep)
+{
+	globalRealSenseSession->ConfigurePlaneDetection(MaxPlanes, InlierDistance, MaxNormalAngle, PixelStep);
+}
+
+bool UPlaneDetectionComponent::FindPlane(int32 Id, FDepthPlane& Plane)
+{
+	for (const FDepthPlane& Candidate : Planes) {
+		if (Candidate.Id == Id) {
+			Plane = Candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool UPlaneDetectionComponent::FindPlaneFacing(FVector Direction, float MaxAngle, FDepthPlane& Plane)
+{
+	const FVector Facing = Direction.GetSafeNormal();
+	const float MinCos = FMath::Cos(FMath::DegreesToRadians(MaxAngle));
+
+	const FDepthPlane* Best = nullptr;
+	for (const FDepthPlane& Candidate : Planes) {
+		if ((FVector::DotProduct(Candidate.Normal, Facing) >= MinCos) && 
+			((Best == nullptr) || (Candidate.InlierCount > Best->InlierCount))) {
+			Best = &Candidate;
+		}
+	}
+
+	if (Best == nullptr) {
+		return false;
+	}
+	Plane = *Best;
+	return true;
+}
@@ -0,0 +1,275 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseBlobTracker.h"
+
+RealSenseBlobTracker::RealSenseBlobTracker()
+{
+	nextId = 1;
+}
+
+// Matched blobs are recorded in 64-bit masks
+static const int32 MaxBlobs = 64;
+
+void RealSenseBlobTracker::Configure(const RealSenseBlobSettings& newSettings)
+{
+	settings = newSettings;
+	settings.minDepth = FMath::Max(settings.minDepth, 1);
+	settings.maxDepth = FMath::Max(settings.maxDepth, settings.minDepth);
+	settings.minArea = FMath::Max(settings.minArea, 1);
+	settings.maxBlobs = FMath::Clamp(settings.maxBlobs, 0, MaxBlobs);
+}
+
+void RealSenseBlobTracker::Reset()
+{
+	blobs.Reset();
+	nextId = 1;
+}
+
+// Runs of a row are joined to the runs of the previous row they overlap, 
+// extended by one pixel for diagonal neighbors. Both rows are sorted, so 
+// they are merged in a single sweep. The root with the lower index is kept,
+// so every root is the first run of its blob.
+void RealSenseBlobTracker::Update(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics)
+{
+	detected.Reset();
+	if (depth == nullptr) {
+		TrackBlobs();
+		return;
+	}
+
+	const int32 width = intrinsics.width;
+	const int32 height = intrinsics.height;
+	const uint32 minDepth = settings.minDepth;
+	const uint32 depthRange = settings.maxDepth - settings.minDepth;
+
+	runs.Reset();
+	parents.Reset();
+	int32 previousRowStart = 0;
+	int32 previousRowEnd = 0;
+
+	for (int32 y = 0; y < height; y++) {
+		const uint16* row = depth + y * width;
+		const int32 rowStart = runs.Num();
+
+		for (int32 x = 0; x < width; x++) {
+			// A single unsigned compare tests both ends of the depth range
+			if ((uint32)(row[x] - minDepth) > depthRange) {
+				continue;
+			}
+
+			Run run;
+			run.y = y;
+			run.first = x;
+			run.nearestX = x;
+			run.nearestDepth = row[x];
+			run.depthSum = 0;
+			for (; (x < width) && ((uint32)(row[x] - minDepth) <= depthRange); x++) {
+				run.depthSum += row[x];
+				if (row[x] < run.nearestDepth) {
+					run.nearestDepth = row[x];
+					run.nearestX = x;
+				}
+			}
+			run.last = x - 1;
+
+			const int32 index = runs.Add(run);
+			parents.Add(index);
+
+			for (int32 i = previousRowStart; i < previousRowEnd; i++) {
+				const Run& above = runs[i];
+				if (above.last < run.first - 1) {
+					previousRowStart = i + 1;
+					continue;
+				}
+				if (above.first > run.last + 1) {
+					break;
+				}
+
+				const int32 rootAbove = FindRoot(i);
+				const int32 root = FindRoot(index);
+				if (rootAbove < root) {
+					parents[root] = rootAbove;
+				}
+				else if (root < rootAbove) {
+					parents[rootAbove] = root;
+				}
+			}
+		}
+
+		previousRowStart = rowStart;
+		previousRowEnd = runs.Num();
+	}
+
+	sums.Reset();
+	rootSums.SetNumUninitialized(runs.Num());
+	for (int32 i = 0; i < runs.Num(); i++) {
+		const Run& run = runs[i];
+		const int32 root = FindRoot(i);
+		if (root == i) {
+			rootSums[i] = sums.Num();
+			BlobSums blob;
+			blob.x = 0;
+			blob.y = 0;
+			blob.depth = 0;
+			blob.area = 0;
+			blob.minX = run.first;
+			blob.minY = run.y;
+			blob.maxX = run.last;
+			blob.maxY = run.y;
+			blob.nearestX = run.nearestX;
+			blob.nearestY = run.y;
+			blob.nearestDepth = run.nearestDepth;
+			sums.Add(blob);
+		}
+
+		BlobSums& blob = sums[rootSums[root]];
+		const int32 length = run.last - run.first + 1;
+		blob.x += (int64)(run.first + run.last) * length / 2;
+		blob.y += (int64)run.y * length;
+		blob.depth += run.depthSum;
+		blob.area += length;
+		blob.minX = FMath::Min(blob.minX, run.first);
+		blob.maxX = FMath::Max(blob.maxX, run.last);
+		blob.maxY = run.y;
+		if (run.nearestDepth < blob.nearestDepth) {
+			blob.nearestDepth = run.nearestDepth;
+			blob.nearestX = run.nearestX;
+			blob.nearestY = run.y;
+		}
+	}
+
+	for (const BlobSums& blob : sums) {
+		if (blob.area < settings.minArea) {
+			continue;
+		}
+
+		// (first + last) * length is always even, so the x sum is exact
+		FDepthBlob result;
+		result.Area = blob.area;
+		result.Center = FVector2D((float)blob.x / blob.area, (float)blob.y / blob.area);
+		result.BoundsMin = FIntPoint(blob.minX, blob.minY);
+		result.BoundsMax = FIntPoint(blob.maxX, blob.maxY);
+		result.NearestPoint = FIntPoint(blob.nearestX, blob.nearestY);
+		result.NearestDepth = blob.nearestDepth;
+		result.MeanDepth = (float)blob.depth / blob.area;
+
+		const float forward = result.MeanDepth * 0.1f;
+		result.Position = FVector(forward, (result.Center.X - intrinsics.cx) / intrinsics.fx * forward, 
+								  -(result.Center.Y - intrinsics.cy) / intrinsics.fy * forward);
+		detected.Add(result);
+	}
+
+	detected.Sort([](const FDepthBlob& a, const FDepthBlob& b) { return a.Area > b.Area; });
+	if (detected.Num() > settings.maxBlobs) {
+		detected.SetNum(settings.maxBlobs);
+	}
+
+	TrackBlobs();
+}
+
+void RealSenseBlobTracker::TrackBlobs()
+{
+	struct Match {
+		float distanceSquared;
+		int32 previous;
+		int32 current;
+	};
+
+	const float maxDistanceSquared = settings.maxMatchDistance * settings.maxMatchDistance;
+	TArray<Match, TInlineAllocator<64>> matches;
+	for (int32 i = 0; i < blobs.Num(); i++) {
+		for (int32 j = 0; j < detected.Num(); j++) {
+			const float distanceSquared = FVector2D::DistSquared(blobs[i].Center, detected[j].Center);
+			if (distanceSquared <= maxDistanceSquared) {
+				Match match = { distanceSquared, i, j };
+				matches.Add(match);
+			}
+		}
+	}
+	matches.Sort([](const Match& a, const Match& b) { return a.distanceSquared < b.distanceSquared; });
+
+	uint64 previousMatched = 0;
+	uint64 currentMatched = 0;
+	for (const Match& match : matches) {
+		const uint64 previousBit = 1ull << match.previous;
+		const uint64 currentBit = 1ull << match.current;
+		if ((previousMatched & previousBit) || (currentMatched & currentBit)) {
+			continue;
+		}
+		previousMatched |= previousBit;
+		currentMatched |= currentBit;
+		detected[match.current].Id = blobs[match.previous].Id;
+		detected[match.current].Age = blobs[match.previous].Age + 1;
+	}
+
+	for (int32 j = 0; j < detected.Num(); j++) {
+		if ((currentMatched & (1ull << j)) == 0) {
+			detected[j].Id = nextId++;
+			detected[j].Age = 1;
+		}
+	}
+
+	Swap(blobs, detected);
+}
+
+FBlobTrackingBenchmarkResult RealSenseBlobTracker::RunSyntheticBenchmark(int32 width, int32 height, int32 frames)
+{
+	FBlobTrackingBenchmarkResult result;
+	result.Width = FMath::Max(width, 16);
+	result.Height = FMath::Max(height, 16);
+	result.Frames = FMath::Max(frames, 1);
+
+	const RealSenseCameraIntrinsics intrinsics = RealSenseCameraIntrinsics::FromFOV(result.Width, result.Height, 
+																					 70.0f, 55.0f);
+	TArray<uint16> depth;
+	depth.SetNumUninitialized(result.Width * result.Height);
+	FRandomStream random(7);
+	RealSenseBlobTracker tracker;
+
+	double totalMs = 0.0;
+	for (int32 frame = 0; frame < result.Frames; frame++) {
+		// Hands of a quarter of the image height, sweeping across the frame
+		const float radius = result.Height * 0.125f;
+		const float phase = 2.0f * PI * frame / 120.0f;
+		const FVector2D hands[2] = {
+			FVector2D(result.Width * (0.3f + 0.15f * FMath::Sin(phase)), result.Height * 0.5f),
+			FVector2D(result.Width * (0.7f - 0.15f * FMath::Sin(phase)), result.Height * (0.5f + 0.2f * FMath::Cos(phase)))
+		};
+
+		for (int32 y = 0; y < result.Height; y++) {
+			for (int32 x = 0; x < result.Width; x++) {
+				int32 d = 1500 + random.RandRange(-10, 10);
+				for (int32 hand = 0; hand < 2; hand++) {
+					if (FVector2D::DistSquared(FVector2D(x, y), hands[hand]) < radius * radius) {
+						d = 450 + hand * 100 + random.RandRange(-5, 5);
+					}
+				}
+				depth[y * result.Width + x] = (random.FRand() < 0.02f) ? 0 : (uint16)d;
+			}
+		}
+
+		const double start = FPlatformTime::Seconds();
+		tracker.Update(depth.GetData(), intrinsics);
+		const double ms = (FPlatformTime::Seconds() - start) * 1000.0;
+		totalMs += ms;
+		result.MaxMs = FMath::Max(result.MaxMs, (float)ms);
+	}
+
+	result.MeanMs = totalMs / result.Frames;
+	result.BlobCount = tracker.GetBlobs().Num();
+	return result;
+}
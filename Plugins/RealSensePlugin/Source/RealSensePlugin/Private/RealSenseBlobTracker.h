@@ -0,0 +1,114 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+#include "RealSenseFusion.h"
+
+// Tuning parameters of the blob tracker.
+struct RealSenseBlobSettings {
+	int32 minDepth;  // Depth range (mm) of the pixels that make up blobs
+	int32 maxDepth;
+	int32 minArea;  // Smallest blob kept, in pixels
+	int32 maxBlobs;  // Largest number of blobs kept, the largest ones first
+	float maxMatchDistance;  // Farthest a blob's center may move between frames (pixels) and keep its Id
+
+	RealSenseBlobSettings() : minDepth(150), maxDepth(700), minArea(150), maxBlobs(8), maxMatchDistance(48.0f) {}
+};
+
+// Finds the connected regions of a depth frame that lie within a near depth
+// range, and follows them from frame to frame.
+//
+// Pixels within the range are grouped into horizontal runs as the frame is 
+// read, and runs that touch a run of the previous row (including diagonally)
+// are joined with a union-find, so the frame is labeled in a single pass and
+// the union-find only holds one node per run. Per-run sums are then gathered
+// by root into the blob statistics. Blobs are matched to those of the 
+// previous frame greedily, closest centers first.
+class RealSenseBlobTracker {
+public:
+	RealSenseBlobTracker();
+
+	void Configure(const RealSenseBlobSettings& settings);
+
+	inline const RealSenseBlobSettings& GetSettings() const { return settings; }
+
+	// Forgets the tracked blobs. Ids start over from 1.
+	void Reset();
+
+	// Finds the blobs of a depth frame (mm) and matches them to the blobs of
+	// the previous frame.
+	void Update(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics);
+
+	// Blobs of the last frame, largest first
+	inline const TArray<FDepthBlob>& GetBlobs() const { return blobs; }
+
+	// Tracks two hands moving in front of a noisy wall, in synthetic depth 
+	// frames of the given size with some invalid pixels, and measures the 
+	// time of each update with the default settings.
+	static FBlobTrackingBenchmarkResult RunSyntheticBenchmark(int32 width, int32 height, int32 frames);
+
+private:
+	// Horizontal run of pixels within the depth range
+	struct Run {
+		int32 y;
+		int32 first;  // First and last pixel, inclusive
+		int32 last;
+		int32 nearestX;  // Nearest pixel of the run, and its depth
+		int32 nearestDepth;
+		int64 depthSum;
+	};
+
+	// Sums of the runs of one blob
+	struct BlobSums {
+		int64 x;
+		int64 y;
+		int64 depth;
+		int32 area;
+		int32 minX;
+		int32 minY;
+		int32 maxX;
+		int32 maxY;
+		int32 nearestX;
+		int32 nearestY;
+		int32 nearestDepth;
+	};
+
+	RealSenseBlobSettings settings;
+
+	TArray<Run> runs;
+	TArray<int32> parents;  // Union-find parent of each run
+	TArray<int32> rootSums;  // Index into sums of the blob of each root run
+	TArray<BlobSums> sums;
+
+	TArray<FDepthBlob> blobs;
+	TArray<FDepthBlob> detected;
+	int32 nextId;
+
+	// Returns the root of a run, halving the path to it along the way.
+	inline int32 FindRoot(int32 run)
+	{
+		while (parents[run] != run) {
+			parents[run] = parents[parents[run]];
+			run = parents[run];
+		}
+		return run;
+	}
+
+	// Gives the detected blobs the Ids of the previous blobs they match, or 
+	// new Ids, and makes them the current blobs.
+	void TrackBlobs();
+};
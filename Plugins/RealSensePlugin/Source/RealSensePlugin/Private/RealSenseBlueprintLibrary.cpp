@@ -16,6 +16,13 @@
 
 #include "RealSensePluginPrivatePCH.h"
 #include "RealSenseBlueprintLibrary.h"
+#include "RealSenseDeviceRegistry.h"
+#include "RealSenseImageKernels.h"
+#include "RealSenseFusion.h"
+#include "RealSenseMeshIO.h"
+#include "RealSenseMeshProcessing.h"
+#include "RealSenseMeshBVH.h"
+#include "RealSenseBlobTracker.h"
 
 URealSenseBlueprintLibrary::URealSenseBlueprintLibrary(const class FObjectInitializer& ObjInit) 
 	: Super(ObjInit) 
@@ -88,6 +95,17 @@ FString URealSenseBlueprintLibrary::ECameraModelToString(ECameraModel value)
 	}
 }
 
+// Waits for the RealSenseDeviceRegistry to finish enumerating devices and 
+// converts the results to Blueprint-exposed structures.
+TArray<FRealSenseDeviceInfo> URealSenseBlueprintLibrary::GetConnectedDevices()
+{
+	TArray<FRealSenseDeviceInfo> Devices;
+	for (const RealSenseDeviceDesc& Desc : RealSenseDeviceRegistry::Get().GetDevices()) {
+		Devices.Add(GetRealSenseDeviceInfo(Desc.info));
+	}
+	return Devices;
+}
+
 // Copies the data from the input Buffer into the PlatformData of the Texture object.
 // For convenience, this function returns a pointer to the input Texture that was 
 // modified.
@@ -147,8 +165,8 @@ UTexture2D* URealSenseBlueprintLibrary::DepthBufferToTexture(const TArray<int32>
 	return Texture;
 }
 
-// Finds all .OBJ files in the specified Directory, relative to the Content 
-// path of the game.
+// Finds all .OBJ, .PLY, and .STL files in the specified Directory, relative 
+// to the Content path of the game.
 TArray<FString> URealSenseBlueprintLibrary::GetMeshFiles(FString Directory)
 {
 	// Ensure that the directory ends with a trailing slash
@@ -156,13 +174,132 @@ TArray<FString> URealSenseBlueprintLibrary::GetMeshFiles(FString Directory)
 		Directory.Append("/");
 	}
 
-	// Get the absolute path of the game's Content directory and append the
-	// specified path to it, along with the filename.
-	FString Dir = FPaths::GameContentDir() + Directory + TEXT("*.obj");
-
 	IFileManager& FileManager = IFileManager::Get();
 	TArray<FString> MeshFiles;
-	FileManager.FindFiles(MeshFiles, *Dir, true, false);
+
+	const TCHAR* Extensions[] = { TEXT("*.obj"), TEXT("*.ply"), TEXT("*.stl") };
+	for (const TCHAR* Extension : Extensions) {
+		// Get the absolute path of the game's Content directory and append the
+		// specified path to it, along with the filename.
+		FString Dir = FPaths::GameContentDir() + Directory + Extension;
+
+		TArray<FString> Files;
+		FileManager.FindFiles(Files, *Dir, true, false);
+		MeshFiles.Append(Files);
+	}
 
 	return MeshFiles;
 }
+
+bool URealSenseBlueprintLibrary::SaveMeshFile(FString Filename, EScan3DFileFormat Format, const TArray<FVector>& Vertices, 
+											  const TArray<int32>& Triangles, const TArray<FColor>& Colors)
+{
+	Filename = FPaths::GameContentDir().Append(Filename);
+	return ::SaveMeshFile(Filename, Format, Vertices, Triangles, Colors);
+}
+
+void URealSenseBlueprintLibrary::ComputeMeshNormals(const TArray<FVector>& Vertices, const TArray<int32>& Triangles, 
+													TArray<FVector>& Normals, TArray<FVector>& Tangents)
+{
+	RealSenseMeshAdjacency Adjacency;
+	Adjacency.Build(Vertices.Num(), Triangles);
+	ComputeVertexNormals(Vertices, Triangles, Adjacency, Normals, Tangents);
+}
+
+TArray<FScanMeshLOD> URealSenseBlueprintLibrary::BuildMeshLODs(const TArray<FVector>& Vertices, const TArray<int32>& Triangles, 
+															   const TArray<FColor>& Colors, const TArray<float>& Ratios)
+{
+	RealSenseMeshAdjacency Adjacency;
+	Adjacency.Build(Vertices.Num(), Triangles);
+
+	TArray<FScanMeshLOD> LODs;
+	::BuildMeshLODs(Vertices, Triangles, Colors, Adjacency, Ratios, LODs);
+	return LODs;
+}
+
+TArray<FMeshFileBenchmarkResult> URealSenseBlueprintLibrary::BenchmarkMeshFiles(int32 VertexCount)
+{
+	const TArray<FMeshFileBenchmarkResult> Results = RunMeshFileBenchmark(FMath::Max(VertexCount, 9));
+
+	const TCHAR* Names[] = { TEXT("OBJ"), TEXT("PLY"), TEXT("STL") };
+	for (const FMeshFileBenchmarkResult& Result : Results) {
+		RS_LOG(Log, "Mesh file benchmark: %s writes in %.1f ms, reads in %.1f ms, %d KB, %d triangles",
+			   Names[(int32)Result.Format], Result.WriteMs, Result.ReadMs, Result.FileSizeKB, Result.TriangleCount)
+	}
+	return Results;
+}
+
+FMeshBVHBenchmarkResult URealSenseBlueprintLibrary::BenchmarkMeshBVH(int32 TriangleCount, int32 QueryCount)
+{
+	const FMeshBVHBenchmarkResult Result = RealSenseMeshBVH::RunSyntheticBenchmark(TriangleCount, QueryCount);
+
+	RS_LOG(Log, "Mesh BVH benchmark: %d triangles built in %.1f ms into %d nodes (%d KB); ray cast %.2f us (%.0f%% hits), "
+		   "closest point %.2f us, box overlap %.2f us", Result.TriangleCount, Result.BuildMs, Result.NodeCount, 
+		   Result.MemoryKB, Result.RaycastMicroseconds, Result.RaycastHitRatio * 100.0f, Result.ClosestPointMicroseconds,
+		   Result.OverlapMicroseconds)
+	return Result;
+}
+
+FBlobTrackingBenchmarkResult URealSenseBlueprintLibrary::BenchmarkBlobTracking(int32 Width, int32 Height, int32 Frames)
+{
+	const FBlobTrackingBenchmarkResult Result = RealSenseBlobTracker::RunSyntheticBenchmark(Width, Height, Frames);
+
+	RS_LOG(Log, "Blob tracking benchmark: %dx%d, %d frames, %.3f ms per frame on average, %.3f ms at most, %d blobs", 
+		   Result.Width, Result.Height, Result.Frames, Result.MeanMs, Result.MaxMs, Result.BlobCount)
+	return Result;
+}
+
+bool URealSenseBlueprintLibrary::CompositeSegmentedImage(const TArray<FSimpleColor>& Foreground, const TArray<uint8>& Mask, 
+														 const TArray<FSimpleColor>& Background, TArray<FSimpleColor>& Result)
+{
+	if ((Foreground.Num() != Mask.Num()) || (Foreground.Num() != Background.Num())) {
+		return false;
+	}
+
+	Result.SetNumUninitialized(Foreground.Num());
+	CompositeOverImage(reinterpret_cast<const uint8*>(Foreground.GetData()), Mask.GetData(), 
+					   reinterpret_cast<const uint8*>(Background.GetData()), Foreground.Num(), 
+					   reinterpret_cast<uint8*>(Result.GetData()));
+	return true;
+}
+
+bool URealSenseBlueprintLibrary::CompositeSegmentedImageOverColor(const TArray<FSimpleColor>& Foreground, 
+																  const TArray<uint8>& Mask, FColor Background, 
+																  TArray<FSimpleColor>& Result)
+{
+	if (Foreground.Num() != Mask.Num()) {
+		return false;
+	}
+
+	// FSimpleColor buffers hold BGRA bytes, which is also FColor's layout
+	const uint32 PackedBackground = Background.B | (Background.G << 8) | (Background.R << 16) | (Background.A << 24);
+
+	Result.SetNumUninitialized(Foreground.Num());
+	CompositeOverColor(reinterpret_cast<const uint8*>(Foreground.GetData()), Mask.GetData(), PackedBackground, 
+					   Foreground.Num(), reinterpret_cast<uint8*>(Result.GetData()));
+	return true;
+}
+
+TArray<uint8> URealSenseBlueprintLibrary::DecodeSegmentationRuns(const TArray<int32>& Runs, int32 NumPixels)
+{
+	TArray<uint8> Mask;
+	Mask.SetNumUninitialized(FMath::Max(NumPixels, 0));
+	DecodeMaskRuns(Runs, Mask.Num(), Mask.GetData());
+	return Mask;
+}
+
+FFusionBenchmarkResult URealSenseBlueprintLibrary::BenchmarkFusion(int32 Frames, int32 Width, int32 Height, 
+																   float VoxelSize, float TruncationDistance)
+{
+	RealSenseFusionSettings Settings;
+	Settings.voxelSize = VoxelSize;
+	Settings.truncation = TruncationDistance;
+
+	const FFusionBenchmarkResult Result = RealSenseFusionVolume::RunSyntheticBenchmark(Settings, Frames, 
+		FMath::Max(Width, 1), FMath::Max(Height, 1));
+
+	RS_LOG(Log, "Fusion benchmark: %.2f ms/frame integration, %.2f ms raycast, %.3f cm RMS error, %.1f%% coverage, %d blocks (%d KB)",
+		   Result.AverageIntegrationMs, Result.RaycastMs, Result.SurfaceRMSError, Result.Coverage * 100.0f, 
+		   Result.BlockCount, Result.MemoryKB)
+	return Result;
+}
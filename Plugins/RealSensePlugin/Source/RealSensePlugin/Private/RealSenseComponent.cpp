@@ -15,6 +15,7 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 #include "RealSensePluginPrivatePCH.h"
 #include "RealSenseComponent.h"
+#include "RealSenseUtils.h"
 
 // Specifies that this component should be initialized and can tick.
 URealSenseComponent::URealSenseComponent(const class FObjectInitializer& ObjInit) 
@@ -35,18 +36,21 @@ URealSenseComponent::URealSenseComponent(const class FObjectInitializer& ObjInit
 }
 
 // When initialized, this component will check if a RealSenseSessionManager actor 
-// exists in the scene. If the actor exists, this component stores a reference to 
-// it. If it does not, a new RealSenseSessionManager actor will be spawned, and a 
-// reference to it will be saved.
+// for its DeviceSerial exists in the scene. If the actor exists, this component 
+// stores a reference to it. If it does not, a new RealSenseSessionManager actor 
+// will be spawned for that device, and a reference to it will be saved.
 void URealSenseComponent::InitializeComponent() 
 {
 	if (globalRealSenseSession == nullptr) {
 		for (TActorIterator<ARealSenseSessionManager> Itr(GetWorld()); Itr; ++Itr) {
-			globalRealSenseSession = (ARealSenseSessionManager*)*Itr;
+			if (Itr->GetDeviceSerial() == DeviceSerial) {
+				globalRealSenseSession = (ARealSenseSessionManager*)*Itr;
+			}
 		}
 		if (globalRealSenseSession == nullptr) {
-			RS_LOG(Log, "Creating RealSenseSessionManager Actor")
+			RS_LOG(Log, "Creating RealSenseSessionManager Actor for device '%s'", *DeviceSerial)
 			globalRealSenseSession = GetWorld()->SpawnActor<ARealSenseSessionManager>(ARealSenseSessionManager::StaticClass());
+			globalRealSenseSession->SetDeviceSerial(DeviceSerial);
 		}
 	}
 
@@ -56,9 +60,22 @@ void URealSenseComponent::InitializeComponent()
 	}
 }
 
+// Queries the camera information once device discovery has finished. If it is
+// still running in the background, the query is deferred until the session 
+// manager reports that devices are ready, so BeginPlay never blocks on it.
+void URealSenseComponent::BeginPlay() 
+{
+	if (globalRealSenseSession->AreDevicesReady()) {
+		UpdateCameraInfo();
+	}
+	else {
+		globalRealSenseSession->OnDevicesReady.AddDynamic(this, &URealSenseComponent::UpdateCameraInfo);
+	}
+}
+
 // Queries the camera model, firmware, and field of view data from the RealSense 
 // camera.
-void URealSenseComponent::BeginPlay() 
+void URealSenseComponent::UpdateCameraInfo()
 {
 	CameraModel = globalRealSenseSession->GetCameraModel();
 	CameraFirmware = globalRealSenseSession->GetCameraFirmware();
@@ -95,6 +112,16 @@ bool URealSenseComponent::IsCameraRunning()
 	return globalRealSenseSession->IsCameraRunning();
 }
 
+void URealSenseComponent::SetCameraThreadOptions(ERealSenseThreadPriority Priority, int32 AffinityMask)
+{
+	globalRealSenseSession->SetCameraThreadOptions(Priority, (uint32)AffinityMask);
+}
+
+void URealSenseComponent::ConfigureProcessingBudget(bool bEnabled, float TargetFrameMs, float StageBudgetMs, int32 MaxInterval)
+{
+	globalRealSenseSession->ConfigureGovernor(bEnabled, TargetFrameMs, StageBudgetMs, MaxInterval);
+}
+
 FStreamResolution URealSenseComponent::GetColorCameraResolution() 
 {
 	return globalRealSenseSession->GetColorCameraResolution();
@@ -124,3 +151,17 @@ bool URealSenseComponent::IsStreamSetValid(EColorResolution ColorResolution,
 {
 	return globalRealSenseSession->IsStreamSetValid(ColorResolution, DepthResolution);
 }
+
+UTexture2D* URealSenseComponent::FindOrCreateTexture(int32 Width, int32 Height)
+{
+	for (UTexture2D* Texture : TextureCache) {
+		if (Texture && (Texture->GetSizeX() == Width) && (Texture->GetSizeY() == Height)) {
+			return Texture;
+		}
+	}
+
+	UTexture2D* Texture = UTexture2D::CreateTransient(Width, Height, PF_B8G8R8A8);
+	Texture->UpdateResource();
+	TextureCache.Add(Texture);
+	return Texture;
+}
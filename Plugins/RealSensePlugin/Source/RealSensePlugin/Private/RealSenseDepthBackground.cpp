@@ -0,0 +1,80 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseDepthBackground.h"
+
+RealSenseDepthBackground::RealSenseDepthBackground()
+{
+	width = 0;
+	height = 0;
+	frameCount = 0;
+}
+
+void RealSenseDepthBackground::Configure(const RealSenseBackgroundSettings& newSettings)
+{
+	settings = newSettings;
+	settings.learningFrames = FMath::Max(settings.learningFrames, 1);
+	settings.adaptationStep = FMath::Clamp(settings.adaptationStep, 0, 0xFFFF);
+	settings.absorbInterval = FMath::Max(settings.absorbInterval, 0);
+	settings.minBand = FMath::Clamp(settings.minBand, 1, 0x7FFF);
+	settings.bandScale = FMath::Clamp(settings.bandScale, 1, 8);
+	settings.openRadius = FMath::Clamp(settings.openRadius, 0, 16);
+	settings.unobservedFrames = FMath::Clamp(settings.unobservedFrames, 0, 0xFFFF);
+}
+
+void RealSenseDepthBackground::Reset()
+{
+	FMemory::Memzero(background.GetData(), background.Num() * sizeof(uint16));
+	FMemory::Memzero(deviation.GetData(), deviation.Num() * sizeof(uint16));
+	FMemory::Memzero(candidate.GetData(), candidate.Num() * sizeof(uint16));
+	frameCount = 0;
+}
+
+void RealSenseDepthBackground::Update(const uint16* depth, int32 newWidth, int32 newHeight)
+{
+	if ((newWidth != width) || (newHeight != height)) {
+		width = newWidth;
+		height = newHeight;
+		background.SetNumUninitialized(width * height);
+		deviation.SetNumUninitialized(width * height);
+		candidate.SetNumUninitialized(width * height);
+		foregroundMask.SetNumUninitialized(width * height);
+		Reset();
+	}
+
+	if (depth == nullptr) {
+		FMemory::Memzero(foregroundMask.GetData(), foregroundMask.Num());
+		return;
+	}
+
+	RealSenseBackgroundRates rates;
+	rates.backgroundStep = settings.adaptationStep;
+	rates.foregroundStep = ((settings.absorbInterval > 0) && (frameCount % settings.absorbInterval == 0)) ? 1 : 0;
+	rates.unobservedFrames = (uint16)settings.unobservedFrames;
+	rates.minBand = settings.minBand;
+	rates.bandScale = settings.bandScale;
+	rates.bLearning = IsLearning();
+
+	UpdateDepthBackground(depth, width * height, rates, background.GetData(), deviation.GetData(), 
+						  candidate.GetData(), foregroundMask.GetData());
+
+	if (settings.openRadius > 0) {
+		maskFilter.Open(foregroundMask.GetData(), width, height, settings.openRadius);
+	}
+
+	// Saturates rather than wrapping, so IsLearning() stays false
+	frameCount = (frameCount < MAX_int32) ? frameCount + 1 : frameCount;
+}
@@ -0,0 +1,86 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+#include "RealSenseImageKernels.h"
+#include "RealSenseMaskFilter.h"
+
+// Tuning parameters of the depth background model. Depths are in mm.
+struct RealSenseBackgroundSettings {
+	int32 learningFrames;  // Frames after a reset during which the background follows the depth
+	int32 adaptationStep;  // Largest change of the background per frame where nothing is in front of it
+	int32 absorbInterval;  // Frames per 1 mm change of the background behind foreground, 0 to never absorb
+	int32 minBand;  // Smallest distance in front of the background of a foreground pixel
+	int32 bandScale;  // Noise band, in absolute deviations of the pixel's depth, from 1 to 8
+	int32 openRadius;  // Radius of the opening that removes foreground specks, 0 to keep them
+	int32 unobservedFrames;  // Frames in a row a pixel without background must hold a depth to take it, 0 for never
+
+	RealSenseBackgroundSettings() : learningFrames(30), adaptationStep(2), absorbInterval(8), minBand(20), 
+		bandScale(4), openRadius(1), unobservedFrames(3600) {}
+};
+
+// Separates what is in front of a static depth background, for fixed 
+// installations where the camera does not move, without the 3D segmentation
+// of the middleware.
+//
+// Every pixel keeps two 16-bit values: a running approximate median of its 
+// depth, which moves toward each new depth by a few millimeters at most, and
+// of the absolute deviation of its depth from that median, which sets the 
+// width of its noise band. Both are updated with SSE2 eight pixels at a time
+// by UpdateDepthBackground(). Pixels more than the noise band in front of 
+// the background are foreground. The background behind foreground only moves
+// every absorbInterval frames, so that people standing still take minutes 
+// to fade into it while moved furniture eventually does. Pixels that had no
+// valid depth while learning, such as where the far background is out of 
+// range, have no background and are foreground. Only a depth they hold 
+// within minBand for unobservedFrames frames in a row, two minutes at 30 
+// frames per second by default, becomes their background, so that people 
+// walking through them are not learned. The depth they hold is kept in a 
+// third 16-bit value per pixel.
+class RealSenseDepthBackground {
+public:
+	RealSenseDepthBackground();
+
+	void Configure(const RealSenseBackgroundSettings& settings);
+
+	inline const RealSenseBackgroundSettings& GetSettings() const { return settings; }
+
+	// Forgets the background and learns it again from the next frames.
+	void Reset();
+
+	// Updates the background with a depth frame (mm) and computes its 
+	// foreground mask. The model is reset if the resolution changes.
+	void Update(const uint16* depth, int32 width, int32 height);
+
+	inline bool IsLearning() const { return frameCount < settings.learningFrames; }
+
+	// Foreground mask of the last frame (0 / 255), at depth resolution
+	inline const TArray<uint8>& GetForegroundMask() const { return foregroundMask; }
+
+private:
+	RealSenseBackgroundSettings settings;
+
+	TArray<uint16> background;
+	TArray<uint16> deviation;
+	TArray<uint16> candidate;
+	TArray<uint8> foregroundMask;
+	RealSenseMaskFilter maskFilter;
+
+	int32 width;
+	int32 height;
+	int32 frameCount;  // Frames since the last reset
+};
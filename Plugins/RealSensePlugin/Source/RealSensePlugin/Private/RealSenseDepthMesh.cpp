@@ -0,0 +1,220 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseDepthMesh.h"
+#include "ParallelFor.h"
+
+// Grid rows handed to a worker thread at a time
+static const int32 RowsPerTask = 16;
+
+// Writes the six indices of a grid quad, as two triangles wound clockwise as
+// seen from the camera, or six copies of its first corner if the quad is 
+// not drawn.
+static inline void WriteQuad(int32* indices, int32 topLeft, int32 gridWidth, bool bValid)
+{
+	const int32 topRight = topLeft + 1;
+	const int32 bottomLeft = topLeft + gridWidth;
+	const int32 bottomRight = bottomLeft + 1;
+
+	if (bValid) {
+		indices[0] = topLeft;
+		indices[1] = topRight;
+		indices[2] = bottomRight;
+		indices[3] = topLeft;
+		indices[4] = bottomRight;
+		indices[5] = bottomLeft;
+	}
+	else {
+		for (int32 i = 0; i < 6; i++) {
+			indices[i] = topLeft;
+		}
+	}
+}
+
+RealSenseDepthMesh::RealSenseDepthMesh()
+{
+	depthWidth = 0;
+	depthHeight = 0;
+	gridWidth = 0;
+	gridHeight = 0;
+	fovX = 0.0f;
+	fovY = 0.0f;
+}
+
+void RealSenseDepthMesh::Configure(const RealSenseDepthMeshSettings& newSettings)
+{
+	RealSenseDepthMeshSettings clamped = newSettings;
+	clamped.step = FMath::Max(clamped.step, 1);
+	if (clamped == settings) {
+		return;
+	}
+	const bool bStepChanged = (clamped.step != settings.step);
+	settings = clamped;
+
+	// Only the step changes the layout. The other settings take effect on the
+	// next update, which rewrites the quads whose validity changed.
+	if (bStepChanged) {
+		depthWidth = 0;
+		depthHeight = 0;
+	}
+}
+
+// Builds the pinhole rays from the fields of view, the UVs, and the index 
+// buffer with every quad degenerate. Quads are enabled by the next update.
+void RealSenseDepthMesh::BuildLayout(int32 width, int32 height, float horizontalFOV, float verticalFOV,
+									 TArray<FVector2D>& uvs, TArray<int32>& triangles)
+{
+	depthWidth = width;
+	depthHeight = height;
+	fovX = horizontalFOV;
+	fovY = verticalFOV;
+	gridWidth = (width - 1) / settings.step + 1;
+	gridHeight = (height - 1) / settings.step + 1;
+
+	const float focalX = (width * 0.5f) / FMath::Tan(FMath::DegreesToRadians(horizontalFOV * 0.5f));
+	const float focalY = (height * 0.5f) / FMath::Tan(FMath::DegreesToRadians(verticalFOV * 0.5f));
+	const float centerX = (width - 1) * 0.5f;
+	const float centerY = (height - 1) * 0.5f;
+
+	columnRays.SetNumUninitialized(gridWidth);
+	for (int32 i = 0; i < gridWidth; i++) {
+		columnRays[i] = (i * settings.step - centerX) / focalX;
+	}
+	rowRays.SetNumUninitialized(gridHeight);
+	for (int32 j = 0; j < gridHeight; j++) {
+		rowRays[j] = (j * settings.step - centerY) / focalY;
+	}
+
+	uvs.SetNumUninitialized(gridWidth * gridHeight);
+	for (int32 j = 0; j < gridHeight; j++) {
+		for (int32 i = 0; i < gridWidth; i++) {
+			uvs[j * gridWidth + i] = FVector2D((float)(i * settings.step) / FMath::Max(width - 1, 1), 
+											   (float)(j * settings.step) / FMath::Max(height - 1, 1));
+		}
+	}
+
+	const int32 quadCount = FMath::Max(gridWidth - 1, 0) * FMath::Max(gridHeight - 1, 0);
+	triangles.SetNumUninitialized(quadCount * 6);
+	quadValid.Init(0, quadCount);
+	vertexValid.Init(0, gridWidth * gridHeight);
+	for (int32 j = 0; j + 1 < gridHeight; j++) {
+		for (int32 i = 0; i + 1 < gridWidth; i++) {
+			WriteQuad(&triangles[(j * (gridWidth - 1) + i) * 6], j * gridWidth + i, gridWidth, false);
+		}
+	}
+}
+
+// Three parallel passes over the grid rows: positions, then quad validity 
+// and indices (which need the depth of the next row), then normals (which 
+// need the positions of the neighboring rows).
+bool RealSenseDepthMesh::Update(const uint16* depth, int32 width, int32 height, float horizontalFOV, float verticalFOV,
+								TArray<FVector>& vertices, TArray<FVector>& normals, TArray<FVector2D>& uvs, 
+								TArray<int32>& triangles)
+{
+	if ((depth == nullptr) || (width <= 0) || (height <= 0)) {
+		return false;
+	}
+
+	const int32 gridCount = ((width - 1) / settings.step + 1) * ((height - 1) / settings.step + 1);
+	bool bLayoutChanged = false;
+	if ((width != depthWidth) || (height != depthHeight) || (horizontalFOV != fovX) || (verticalFOV != fovY) ||
+		(uvs.Num() != gridCount)) {
+		BuildLayout(width, height, horizontalFOV, verticalFOV, uvs, triangles);
+		bLayoutChanged = true;
+	}
+
+	vertices.SetNumUninitialized(gridWidth * gridHeight);
+	normals.SetNumUninitialized(gridWidth * gridHeight);
+
+	const int32 step = settings.step;
+	const int32 maxDepth = (settings.maxDepth > 0) ? settings.maxDepth : 0xFFFF;
+	const float ratio = settings.discontinuityRatio;
+	const int32 numTasks = (gridHeight + RowsPerTask - 1) / RowsPerTask;
+
+	auto DepthAt = [&](int32 i, int32 j) -> int32 {
+		const int32 d = depth[(j * step) * width + i * step];
+		return (d <= maxDepth) ? d : 0;
+	};
+
+	// Positions: depth (mm) along X, lateral offsets along Y (right) and Z (up)
+	ParallelFor(numTasks, [&](int32 task) {
+		const int32 last = FMath::Min((task + 1) * RowsPerTask, gridHeight);
+		for (int32 j = task * RowsPerTask; j < last; j++) {
+			for (int32 i = 0; i < gridWidth; i++) {
+				const int32 index = j * gridWidth + i;
+				const float z = DepthAt(i, j) * 0.1f;
+				vertices[index] = FVector(z, columnRays[i] * z, -rowRays[j] * z);
+				vertexValid[index] = (z > 0.0f) ? 1 : 0;
+			}
+		}
+	});
+
+	// Quads
+	TArray<uint8> rowChanged;
+	rowChanged.SetNumZeroed(FMath::Max(gridHeight - 1, 0));
+
+	ParallelFor(numTasks, [&](int32 task) {
+		const int32 last = FMath::Min((task + 1) * RowsPerTask, gridHeight - 1);
+		for (int32 j = task * RowsPerTask; j < last; j++) {
+			for (int32 i = 0; i + 1 < gridWidth; i++) {
+				const int32 topLeft = j * gridWidth + i;
+				const float corners[4] = { vertices[topLeft].X, vertices[topLeft + 1].X,
+										   vertices[topLeft + gridWidth].X, vertices[topLeft + gridWidth + 1].X };
+				const float nearest = FMath::Min(FMath::Min(corners[0], corners[1]), FMath::Min(corners[2], corners[3]));
+				const float farthest = FMath::Max(FMath::Max(corners[0], corners[1]), FMath::Max(corners[2], corners[3]));
+				const uint8 bValid = ((nearest > 0.0f) && (farthest - nearest <= nearest * ratio)) ? 1 : 0;
+
+				const int32 quad = j * (gridWidth - 1) + i;
+				if (quadValid[quad] != bValid) {
+					quadValid[quad] = bValid;
+					WriteQuad(&triangles[quad * 6], topLeft, gridWidth, bValid != 0);
+					rowChanged[j] = 1;
+				}
+			}
+		}
+	});
+
+	// Normals from the central differences of the neighboring vertices, 
+	// falling back to one-sided differences next to invalid vertices
+	ParallelFor(numTasks, [&](int32 task) {
+		const int32 last = FMath::Min((task + 1) * RowsPerTask, gridHeight);
+		for (int32 j = task * RowsPerTask; j < last; j++) {
+			for (int32 i = 0; i < gridWidth; i++) {
+				const int32 index = j * gridWidth + i;
+				if (vertexValid[index] == 0) {
+					normals[index] = FVector(-1.0f, 0.0f, 0.0f);
+					continue;
+				}
+
+				const int32 left = ((i > 0) && vertexValid[index - 1]) ? index - 1 : index;
+				const int32 right = ((i + 1 < gridWidth) && vertexValid[index + 1]) ? index + 1 : index;
+				const int32 up = ((j > 0) && vertexValid[index - gridWidth]) ? index - gridWidth : index;
+				const int32 down = ((j + 1 < gridHeight) && vertexValid[index + gridWidth]) ? index + gridWidth : index;
+
+				const FVector alongRow = vertices[right] - vertices[left];
+				const FVector alongColumn = vertices[down] - vertices[up];
+				const FVector normal = FVector::CrossProduct(alongRow, alongColumn);
+				normals[index] = normal.IsNearlyZero() ? FVector(-1.0f, 0.0f, 0.0f) : normal.GetUnsafeNormal();
+			}
+		}
+	});
+
+	bool bTrianglesChanged = bLayoutChanged;
+	for (int32 j = 0; j < rowChanged.Num(); j++) {
+		bTrianglesChanged |= (rowChanged[j] != 0);
+	}
+	return bTrianglesChanged;
+}
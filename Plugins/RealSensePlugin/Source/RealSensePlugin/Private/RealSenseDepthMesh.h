@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+
+// Tuning parameters of the depth grid mesh.
+struct RealSenseDepthMeshSettings {
+	// Distance in depth pixels between neighboring grid vertices
+	int32 step;
+
+	// A grid quad is dropped when the depth of its corners differs by more 
+	// than this fraction of the nearest corner, which separates foreground 
+	// objects from the background instead of stretching skin between them.
+	float discontinuityRatio;
+
+	// Depth values (mm) beyond this distance are treated as invalid. 0 keeps all.
+	int32 maxDepth;
+
+	RealSenseDepthMeshSettings() : step(4), discontinuityRatio(0.05f), maxDepth(0) {}
+
+	bool operator==(const RealSenseDepthMeshSettings& other) const
+	{
+		return (step == other.step) && (discontinuityRatio == other.discontinuityRatio) && (maxDepth == other.maxDepth);
+	}
+};
+
+// Turns depth frames into a regular grid mesh in Unreal coordinates (cm, X 
+// forward from the camera, Y right, Z up), with per-vertex normals and UVs 
+// into the depth image.
+//
+// The vertex layout, UVs, and index buffer only depend on the depth 
+// resolution and the grid step, so they are written once and the arrays are
+// reused across frames: each Update() rewrites positions and normals only. 
+// Quads that are invalid or span a depth discontinuity keep their six index 
+// slots but are collapsed into degenerate triangles, and the index buffer is 
+// only touched when the set of valid quads changes. Rows are processed in 
+// parallel.
+class RealSenseDepthMesh {
+public:
+	RealSenseDepthMesh();
+
+	void Configure(const RealSenseDepthMeshSettings& settings);
+
+	// Updates the mesh arrays from a depth frame (mm) captured with the given
+	// fields of view (degrees). Returns true if uvs or triangles changed and 
+	// must be uploaded again along with the positions and normals.
+	bool Update(const uint16* depth, int32 width, int32 height, float horizontalFOV, float verticalFOV,
+				TArray<FVector>& vertices, TArray<FVector>& normals, TArray<FVector2D>& uvs, TArray<int32>& triangles);
+
+	inline int32 GetGridWidth() const { return gridWidth; }
+
+	inline int32 GetGridHeight() const { return gridHeight; }
+
+private:
+	RealSenseDepthMeshSettings settings;
+
+	// Layout the mesh arrays were last built for
+	int32 depthWidth;
+	int32 depthHeight;
+	int32 gridWidth;
+	int32 gridHeight;
+	float fovX;
+	float fovY;
+
+	// Lateral offsets (per mm of depth) of every grid column and row
+	TArray<float> columnRays;
+	TArray<float> rowRays;
+
+	// Validity of every grid vertex and quad in the current frame
+	TArray<uint8> vertexValid;
+	TArray<uint8> quadValid;
+
+	void BuildLayout(int32 width, int32 height, float horizontalFOV, float verticalFOV,
+					 TArray<FVector2D>& uvs, TArray<int32>& triangles);
+};
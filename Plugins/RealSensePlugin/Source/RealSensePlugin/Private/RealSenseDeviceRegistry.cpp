@@ -0,0 +1,107 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseDeviceRegistry.h"
+
+RealSenseDeviceRegistry& RealSenseDeviceRegistry::Get()
+{
+	static RealSenseDeviceRegistry registry;
+	return registry;
+}
+
+void RealSenseDeviceRegistry::BeginEnumeration()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	if (ready.valid() == false) {
+		ready = std::async(std::launch::async, [this]() { Enumerate(); }).share();
+	}
+}
+
+bool RealSenseDeviceRegistry::IsReady()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	return ready.valid() && 
+		   (ready.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+}
+
+std::shared_ptr<PXCSession> RealSenseDeviceRegistry::GetSession()
+{
+	Wait();
+	return session;
+}
+
+TArray<RealSenseDeviceDesc> RealSenseDeviceRegistry::GetDevices()
+{
+	Wait();
+	return devices;
+}
+
+// Creates the session and loops through its video capture modules to collect
+// every device whose model is supported by the plugin. Runs on a background
+// task; the results are only read once the shared future is ready.
+void RealSenseDeviceRegistry::Enumerate()
+{
+	const double startTime = FPlatformTime::Seconds();
+
+	session = std::shared_ptr<PXCSession>(PXCSession::CreateInstance(), 
+										  [](PXCSession* s) { if (s) s->Release(); });
+	if (session == nullptr) {
+		RS_LOG(Error, "Unable to create a RealSense session")
+		return;
+	}
+
+	PXCSession::ImplDesc desc1 = {};
+	desc1.group = PXCSession::IMPL_GROUP_SENSOR;
+	desc1.subgroup = PXCSession::IMPL_SUBGROUP_VIDEO_CAPTURE;
+	for (int m = 0; ; m++) {
+		PXCSession::ImplDesc desc2 = {};
+		if (session->QueryImpl(&desc1, m, &desc2) != PXC_STATUS_NO_ERROR) 
+			break;
+
+		PXCCapture* capture;
+		if (session->CreateImpl<PXCCapture>(&desc2, &capture) != PXC_STATUS_NO_ERROR) 
+			continue;
+
+		for (int j = 0; ; j++) {
+			RealSenseDeviceDesc desc = {};
+			if (capture->QueryDeviceInfo(j, &desc.info) != PXC_STATUS_NO_ERROR) 
+				break;
+
+			if (IsSupportedCameraModel(desc.info.model)) {
+				desc.implDesc = desc2;
+				desc.index = j;
+				devices.Add(desc);
+			}
+		}
+
+		capture->Release();
+	}
+
+	RS_LOG(Log, "Found %d RealSense device(s) in %.1f ms", devices.Num(), 
+		   (FPlatformTime::Seconds() - startTime) * 1000.0)
+}
+
+void RealSenseDeviceRegistry::Wait()
+{
+	BeginEnumeration();
+
+	std::shared_future<void> pending;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		pending = ready;
+	}
+	pending.wait();
+}
@@ -0,0 +1,75 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "AllowWindowsPlatformTypes.h"
+#include <future>
+#include <memory>
+#include <mutex>
+#include "HideWindowsPlatformTypes.h"
+
+#include "RealSenseTypes.h"
+#include "RealSenseUtils.h"
+#include "PXCSenseManager.h"
+
+// Describes a supported RealSense device found while enumerating the capture
+// modules of a PXCSession.
+struct RealSenseDeviceDesc {
+	PXCSession::ImplDesc implDesc;  // Capture module that exposes the device
+	int32 index;  // Index of the device within its capture module
+	PXCCapture::DeviceInfo info;
+};
+
+// Owns the PXCSession shared by every RealSenseImpl and the list of devices
+// connected to the machine.
+//
+// Creating the session and enumerating the capture modules takes a noticeable
+// amount of time, so nothing happens until the registry is first used. 
+// BeginEnumeration() starts the work on a background task; functions that need
+// the results block until that task has finished.
+class RealSenseDeviceRegistry {
+public:
+	static RealSenseDeviceRegistry& Get();
+
+	// Starts creating the session and enumerating devices on a background 
+	// task. Does nothing if enumeration has already been started.
+	void BeginEnumeration();
+
+	// Returns true once the background enumeration has finished.
+	bool IsReady();
+
+	// Returns the shared session, waiting for enumeration to finish if needed.
+	// May return null if the RealSense runtime is not installed.
+	std::shared_ptr<PXCSession> GetSession();
+
+	// Returns the supported devices, waiting for enumeration to finish if needed.
+	TArray<RealSenseDeviceDesc> GetDevices();
+
+private:
+	RealSenseDeviceRegistry() {}
+
+	// Body of the background task.
+	void Enumerate();
+
+	// Starts enumeration if needed and blocks until it has finished.
+	void Wait();
+
+	std::mutex mutex;
+	std::shared_future<void> ready;
+
+	std::shared_ptr<PXCSession> session;
+	TArray<RealSenseDeviceDesc> devices;
+};
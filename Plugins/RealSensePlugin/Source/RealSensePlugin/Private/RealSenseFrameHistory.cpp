@@ -0,0 +1,327 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseFrameHistory.h"
+#include "RealSenseImpl.h"
+#include "RealSenseImageKernels.h"
+
+// Slot images start on cache line boundaries
+static const int64 SlotAlignment = 64;
+
+static int64 AlignSlotSize(int64 size)
+{
+	return (size + SlotAlignment - 1) & ~(SlotAlignment - 1);
+}
+
+RealSenseFrameView::RealSenseFrameView()
+{
+	history = nullptr;
+	slot = -1;
+	number = 0;
+	timestamp = 0.0;
+	color = nullptr;
+	colorWidth = 0;
+	colorHeight = 0;
+	colorChannels = 0;
+	depth = nullptr;
+	depthWidth = 0;
+	depthHeight = 0;
+}
+
+RealSenseFrameView::RealSenseFrameView(RealSenseFrameView&& other) : RealSenseFrameView()
+{
+	*this = std::move(other);
+}
+
+// Takes over the pin of the other view, which becomes invalid.
+RealSenseFrameView& RealSenseFrameView::operator=(RealSenseFrameView&& other)
+{
+	if (this != &other) {
+		Release();
+		history = std::move(other.history);
+		slot = other.slot;
+		number = other.number;
+		timestamp = other.timestamp;
+		color = other.color;
+		colorWidth = other.colorWidth;
+		colorHeight = other.colorHeight;
+		colorChannels = other.colorChannels;
+		depth = other.depth;
+		depthWidth = other.depthWidth;
+		depthHeight = other.depthHeight;
+		other.color = nullptr;
+		other.depth = nullptr;
+	}
+	return *this;
+}
+
+void RealSenseFrameView::Release()
+{
+	if (history) {
+		history->Unpin(slot);
+		history.reset();
+		color = nullptr;
+		depth = nullptr;
+	}
+}
+
+std::shared_ptr<RealSenseFrameHistory> RealSenseFrameHistory::Create(int64 memoryBudget, int32 downsample)
+{
+	return std::shared_ptr<RealSenseFrameHistory>(new RealSenseFrameHistory(memoryBudget, downsample));
+}
+
+RealSenseFrameHistory::RealSenseFrameHistory(int64 memoryBudget, int32 downsample)
+{
+	this->memoryBudget = FMath::Clamp<int64>(memoryBudget, 0, (int64)MaxMemoryBudgetMB << 20);
+	this->downsample = FMath::Clamp(downsample, 1, 8);
+
+	sourceColorWidth = 0;
+	sourceColorHeight = 0;
+	sourceColorChannels = 0;
+	sourceDepthWidth = 0;
+	sourceDepthHeight = 0;
+	colorWidth = 0;
+	colorHeight = 0;
+	depthWidth = 0;
+	depthHeight = 0;
+	colorBytes = 0;
+	slotBytes = 0;
+
+	storage = nullptr;
+	slotCount = 0;
+	framesPublished = 0;
+	framesDropped = 0;
+}
+
+// Views own the history, so none is left by now.
+RealSenseFrameHistory::~RealSenseFrameHistory()
+{
+	FMemory::Free(storage);
+}
+
+void RealSenseFrameHistory::Allocate(int32 newColorWidth, int32 newColorHeight, int32 newColorChannels, 
+									 int32 newDepthWidth, int32 newDepthHeight)
+{
+	sourceColorWidth = newColorWidth;
+	sourceColorHeight = newColorHeight;
+	sourceColorChannels = newColorChannels;
+	sourceDepthWidth = newDepthWidth;
+	sourceDepthHeight = newDepthHeight;
+
+	colorWidth = newColorWidth / downsample;
+	colorHeight = newColorHeight / downsample;
+	depthWidth = newDepthWidth / downsample;
+	depthHeight = newDepthHeight / downsample;
+
+	colorBytes = AlignSlotSize((int64)colorWidth * colorHeight * newColorChannels);
+	slotBytes = colorBytes + AlignSlotSize((int64)depthWidth * depthHeight * sizeof(uint16));
+	slotCount = (slotBytes > 0) ? (int32)FMath::Min<int64>(memoryBudget / slotBytes, MAX_int32) : 0;
+
+	FMemory::Free(storage);
+	storage = (slotCount > 0) ? static_cast<uint8*>(FMemory::Malloc(slotCount * slotBytes, SlotAlignment)) : nullptr;
+
+	slots.Reset(slotCount);
+	slots.AddZeroed(slotCount);
+	order.Reset(slotCount);
+
+	if (slotCount == 0) {
+		RS_LOG(Warning, "Frame history budget of %d KB is too small for a single frame", (int32)(memoryBudget >> 10))
+	}
+	else {
+		RS_LOG(Log, "Frame history holds %d frames of color %dx%d and depth %dx%d", slotCount, colorWidth, colorHeight, depthWidth, depthHeight)
+	}
+}
+
+// Slots are filled in index order until the history is full, then the 
+// oldest frame that no view has pinned is overwritten. The slot leaves the order while it is written, so 
+// lookups cannot find it half written, and joins it again as the latest.
+void RealSenseFrameHistory::Publish(const RealSenseDataFrame& frame)
+{
+	const RealSenseImageBuffer<uint8>& colorImage = frame.colorImage;
+	const RealSenseImageBuffer<uint16>& depthImage = frame.depthImage;
+
+	int32 slot = -1;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if ((colorImage.GetWidth() != sourceColorWidth) || (colorImage.GetHeight() != sourceColorHeight) ||
+			(colorImage.GetChannels() != sourceColorChannels) || 
+			(depthImage.GetWidth() != sourceDepthWidth) || (depthImage.GetHeight() != sourceDepthHeight)) {
+			for (const Slot& pinned : slots) {
+				if (pinned.pins > 0) {
+					framesDropped++;
+					return;
+				}
+			}
+			Allocate(colorImage.GetWidth(), colorImage.GetHeight(), colorImage.GetChannels(), 
+					 depthImage.GetWidth(), depthImage.GetHeight());
+		}
+
+		if (order.Num() < slotCount) {
+			slot = order.Num();
+		}
+		for (int32 i = 0; (slot < 0) && (i < order.Num()); i++) {
+			if (slots[order[i]].pins == 0) {
+				slot = order[i];
+				order.RemoveAt(i, 1, false);
+			}
+		}
+		if (slot < 0) {
+			framesDropped++;
+			return;
+		}
+	}
+
+	uint8* data = storage + slot * slotBytes;
+	const bool bHasColor = (colorImage.Num() > 0) && (colorWidth > 0) && (colorHeight > 0);
+	const bool bHasDepth = (depthImage.Num() > 0) && (depthWidth > 0) && (depthHeight > 0);
+
+	if (bHasColor) {
+		DownsampleImage(colorImage.GetData(), colorImage.GetWidth(), colorImage.GetHeight(), 
+						colorImage.GetChannels(), downsample, data);
+	}
+	if (bHasDepth) {
+		DownsampleDepthNearest(depthImage.GetData(), depthImage.GetWidth(), depthImage.GetHeight(), 
+							   downsample, reinterpret_cast<uint16*>(data + colorBytes));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		Slot& stored = slots[slot];
+		stored.number = frame.number;
+		stored.timestamp = frame.timestamp;
+		stored.pins = 0;
+		stored.bHasColor = bHasColor;
+		stored.bHasDepth = bHasDepth;
+		order.Add(slot);
+	}
+
+	framesPublished++;
+}
+
+void RealSenseFrameHistory::Pin(int32 slot, RealSenseFrameView& outView)
+{
+	Slot& stored = slots[slot];
+	stored.pins++;
+
+	const uint8* data = storage + slot * slotBytes;
+
+	outView.history = shared_from_this();
+	outView.slot = slot;
+	outView.number = stored.number;
+	outView.timestamp = stored.timestamp;
+	outView.color = stored.bHasColor ? data : nullptr;
+	outView.colorWidth = stored.bHasColor ? colorWidth : 0;
+	outView.colorHeight = stored.bHasColor ? colorHeight : 0;
+	outView.colorChannels = stored.bHasColor ? sourceColorChannels : 0;
+	outView.depth = stored.bHasDepth ? reinterpret_cast<const uint16*>(data + colorBytes) : nullptr;
+	outView.depthWidth = stored.bHasDepth ? depthWidth : 0;
+	outView.depthHeight = stored.bHasDepth ? depthHeight : 0;
+}
+
+void RealSenseFrameHistory::Unpin(int32 slot)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	slots[slot].pins--;
+}
+
+// Frame numbers increase along the order, so the frame is binary searched.
+bool RealSenseFrameHistory::FindFrame(uint64 frameNumber, RealSenseFrameView& outView)
+{
+	outView.Release();
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	int32 low = 0;
+	int32 high = order.Num() - 1;
+	while (low <= high) {
+		const int32 middle = (low + high) / 2;
+		const uint64 number = slots[order[middle]].number;
+		if (number == frameNumber) {
+			Pin(order[middle], outView);
+			return true;
+		}
+		if (number < frameNumber) {
+			low = middle + 1;
+		}
+		else {
+			high = middle - 1;
+		}
+	}
+	return false;
+}
+
+// Finds the first frame not older than the given time, then picks whichever
+// of it and the frame before it is nearer.
+bool RealSenseFrameHistory::FindFrameAtTime(double time, RealSenseFrameView& outView)
+{
+	outView.Release();
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (order.Num() == 0) {
+		return false;
+	}
+
+	int32 low = 0;
+	int32 high = order.Num();
+	while (low < high) {
+		const int32 middle = (low + high) / 2;
+		if (slots[order[middle]].timestamp < time) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	int32 index = FMath::Min(low, order.Num() - 1);
+	if ((index > 0) && (time - slots[order[index - 1]].timestamp < FMath::Abs(slots[order[index]].timestamp - time))) {
+		index--;
+	}
+
+	Pin(order[index], outView);
+	return true;
+}
+
+bool RealSenseFrameHistory::FindFrameAgo(int32 framesAgo, RealSenseFrameView& outView)
+{
+	outView.Release();
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if ((framesAgo < 0) || (framesAgo >= order.Num())) {
+		return false;
+	}
+
+	Pin(order[order.Num() - 1 - framesAgo], outView);
+	return true;
+}
+
+int32 RealSenseFrameHistory::GetFrameCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return order.Num();
+}
+
+double RealSenseFrameHistory::GetDuration() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (order.Num() < 2) {
+		return 0.0;
+	}
+	return slots[order.Last()].timestamp - slots[order[0]].timestamp;
+}
@@ -0,0 +1,193 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "AllowWindowsPlatformTypes.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include "HideWindowsPlatformTypes.h"
+
+#include "RealSenseTypes.h"
+#include "RealSenseFrameSource.h"
+
+class RealSenseFrameHistory;
+
+// Read-only view of a frame stored in a RealSenseFrameHistory. The frame is
+// pinned while the view is valid, so the history never overwrites it and the
+// pointers stay valid without copying. The view shares the ownership of the
+// history, which lives on until its last view is released even if recording
+// is stopped. Views should be released promptly, since pinned slots are lost
+// to recording.
+class RealSenseFrameView {
+public:
+	RealSenseFrameView();
+
+	RealSenseFrameView(RealSenseFrameView&& other);
+
+	RealSenseFrameView& operator=(RealSenseFrameView&& other);
+
+	~RealSenseFrameView() { Release(); }
+
+	// Unpins the frame. The view is invalid afterwards.
+	void Release();
+
+	inline bool IsValid() const { return history != nullptr; }
+
+	inline uint64 GetFrameNumber() const { return number; }
+
+	inline double GetTimestamp() const { return timestamp; }
+
+	// Downsampled color image, with the channel layout of the camera frame, 
+	// or null if the frame had no color image
+	inline const uint8* GetColorBuffer() const { return color; }
+
+	inline int32 GetColorWidth() const { return colorWidth; }
+
+	inline int32 GetColorHeight() const { return colorHeight; }
+
+	inline int32 GetColorChannels() const { return colorChannels; }
+
+	// Downsampled depth image (mm), or null if the frame had no depth image
+	inline const uint16* GetDepthBuffer() const { return depth; }
+
+	inline int32 GetDepthWidth() const { return depthWidth; }
+
+	inline int32 GetDepthHeight() const { return depthHeight; }
+
+private:
+	friend class RealSenseFrameHistory;
+
+	std::shared_ptr<RealSenseFrameHistory> history;
+	int32 slot;
+	uint64 number;
+	double timestamp;
+	const uint8* color;
+	int32 colorWidth;
+	int32 colorHeight;
+	int32 colorChannels;
+	const uint16* depth;
+	int32 depthWidth;
+	int32 depthHeight;
+
+	RealSenseFrameView(const RealSenseFrameView&) = delete;
+	RealSenseFrameView& operator=(const RealSenseFrameView&) = delete;
+};
+
+// Keeps the most recent frames of the camera processing thread, downsampled,
+// in a ring that fits a fixed memory budget, for effects that look back in 
+// time (motion trails, rewind, depth N frames ago).
+//
+// The budget is allocated once, when the first frame arrives, and split into
+// as many slots as fit one downsampled color and depth image each. Publish()
+// downsamples each frame into the oldest slot that no view has pinned, out of
+// the history lock, so lookups are never held up by a copy. Color is box 
+// filtered. Depth keeps the nearest valid value of each block, so that thin 
+// foreground does not blend into the background behind it.
+//
+// Lookups return a RealSenseFrameView that reads the slot in place, so the
+// history is always owned by a std::shared_ptr, which Create() returns.
+class RealSenseFrameHistory : public IRealSenseFramePublisher, 
+							  public std::enable_shared_from_this<RealSenseFrameHistory> {
+public:
+	// Largest memory budget (MB) of a history
+	static const int32 MaxMemoryBudgetMB = 1024;
+
+	// memoryBudget is in bytes, at most MaxMemoryBudgetMB megabytes. Images 
+	// are downsampled by the given factor in both directions, from 1 (full 
+	// resolution) to 8.
+	static std::shared_ptr<RealSenseFrameHistory> Create(int64 memoryBudget, int32 downsample);
+
+	~RealSenseFrameHistory();
+
+	// Copies the frame into the history. If the resolution changed, the 
+	// history is cleared first. If every slot is pinned, the frame is dropped.
+	void Publish(const RealSenseDataFrame& frame) override;
+
+	// Finds the frame with the given number. Returns false if it is not, or
+	// no longer, in the history.
+	bool FindFrame(uint64 frameNumber, RealSenseFrameView& outView);
+
+	// Finds the frame whose timestamp (FPlatformTime::Seconds) is nearest to
+	// the given time. Returns false if the history is empty.
+	bool FindFrameAtTime(double time, RealSenseFrameView& outView);
+
+	// Finds the frame stored the given number of frames before the latest
+	// one (0 for the latest). Returns false if the history is not that long.
+	bool FindFrameAgo(int32 framesAgo, RealSenseFrameView& outView);
+
+	// Number of frames in the history, and the most it can hold
+	int32 GetFrameCount() const;
+
+	inline int32 GetCapacity() const { return slotCount; }
+
+	// Time span between the oldest and the latest frame (seconds)
+	double GetDuration() const;
+
+	inline uint64 GetFramesPublished() const { return framesPublished; }
+
+	inline uint64 GetFramesDropped() const { return framesDropped; }
+
+private:
+	friend class RealSenseFrameView;
+
+	RealSenseFrameHistory(int64 memoryBudget, int32 downsample);
+
+	struct Slot {
+		uint64 number;
+		double timestamp;
+		int32 pins;  // Number of views reading the slot
+		bool bHasColor;
+		bool bHasDepth;
+	};
+
+	// Sizes the slots for the given full-resolution images and clears the 
+	// history. Called with the lock held.
+	void Allocate(int32 colorWidth, int32 colorHeight, int32 colorChannels, int32 depthWidth, int32 depthHeight);
+
+	// Pins a stored slot into the view. Called with the lock held.
+	void Pin(int32 slot, RealSenseFrameView& outView);
+
+	void Unpin(int32 slot);
+
+	int64 memoryBudget;
+	int32 downsample;
+
+	// Full-resolution images the slots were sized for
+	int32 sourceColorWidth;
+	int32 sourceColorHeight;
+	int32 sourceColorChannels;
+	int32 sourceDepthWidth;
+	int32 sourceDepthHeight;
+
+	// Downsampled images held by each slot
+	int32 colorWidth;
+	int32 colorHeight;
+	int32 depthWidth;
+	int32 depthHeight;
+	int64 colorBytes;
+	int64 slotBytes;
+
+	uint8* storage;
+	int32 slotCount;
+	TArray<Slot> slots;
+	TArray<int32> order;  // Slots holding frames, oldest first
+
+	mutable std::mutex mutex;
+
+	std::atomic<uint64> framesPublished;
+	std::atomic<uint64> framesDropped;
+};
@@ -0,0 +1,180 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseFrameQueue.h"
+#include "RealSenseImpl.h"
+
+// Copies the images and per-frame results that are meaningful outside of the
+// camera thread. The destination buffers only grow, so steady-state copies 
+// never allocate.
+static void CopyFrame(const RealSenseDataFrame& src, RealSenseDataFrame& dst)
+{
+	dst.number = src.number;
+	dst.timestamp = src.timestamp;
+
+	dst.colorImage.SetDimensions(src.colorImage.GetWidth(), src.colorImage.GetHeight(), src.colorImage.GetChannels());
+	FMemory::Memcpy(dst.colorImage.GetData(), src.colorImage.GetData(), src.colorImage.Num());
+
+	dst.depthImage.SetDimensions(src.depthImage.GetWidth(), src.depthImage.GetHeight());
+	FMemory::Memcpy(dst.depthImage.GetData(), src.depthImage.GetData(), src.depthImage.Num() * sizeof(uint16));
+
+	dst.segmentationMask.SetDimensions(src.segmentationMask.GetWidth(), src.segmentationMask.GetHeight());
+	FMemory::Memcpy(dst.segmentationMask.GetData(), src.segmentationMask.GetData(), src.segmentationMask.Num());
+	dst.segmentationRuns = src.segmentationRuns;
+
+	dst.depthStats = src.depthStats;
+	dst.headCount = src.headCount;
+	dst.headPosition = src.headPosition;
+	dst.headRotation = src.headRotation;
+}
+
+RealSenseFrameQueue::RealSenseFrameQueue(EFrameDeliveryPolicy policy, int32 capacity)
+	: policy(policy)
+{
+	this->capacity = (policy == EFrameDeliveryPolicy::LATEST_ONLY) ? 1 : FMath::Max(capacity, 1);
+	bClosed = false;
+	bInterrupted = false;
+
+	queue.Reserve(this->capacity);
+	pool.Reserve(this->capacity + 1);
+
+	framesPublished = 0;
+	framesDelivered = 0;
+	framesDropped = 0;
+	maxDepth = 0;
+	blockedSeconds = 0.0;
+	startTime = FPlatformTime::Seconds();
+}
+
+RealSenseFrameQueue::~RealSenseFrameQueue()
+{
+	Close();
+}
+
+std::unique_ptr<RealSenseDataFrame> RealSenseFrameQueue::AllocateFrame()
+{
+	if (pool.Num() > 0) {
+		return pool.Pop(false);
+	}
+	return std::unique_ptr<RealSenseDataFrame>(new RealSenseDataFrame());
+}
+
+// When the queue is full, LATEST_ONLY and BOUNDED_QUEUE discard the oldest
+// queued frame, while LOSSLESS waits for the consumer to make room, or drops
+// the frame if the queue is interrupted. The copy itself is done outside of
+// the lock so that Pop() is never held up by it.
+void RealSenseFrameQueue::Publish(const RealSenseDataFrame& frame)
+{
+	std::unique_ptr<RealSenseDataFrame> copy;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (bClosed) {
+			return;
+		}
+		framesPublished++;
+
+		if ((policy == EFrameDeliveryPolicy::LOSSLESS) && (queue.Num() >= capacity)) {
+			const double blockStart = FPlatformTime::Seconds();
+			spaceAvailable.wait(lock, [this]() { return (queue.Num() < capacity) || bClosed || bInterrupted; });
+			blockedSeconds += FPlatformTime::Seconds() - blockStart;
+			if (bClosed) {
+				return;
+			}
+			if (queue.Num() >= capacity) {
+				framesDropped++;
+				return;
+			}
+		}
+
+		copy = AllocateFrame();
+	}
+
+	CopyFrame(frame, *copy);
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (queue.Num() >= capacity) {
+			pool.Push(std::move(queue[0]));
+			queue.RemoveAt(0, 1, false);
+			framesDropped++;
+		}
+		queue.Push(std::move(copy));
+		maxDepth = FMath::Max(maxDepth, queue.Num());
+	}
+	frameAvailable.notify_one();
+}
+
+bool RealSenseFrameQueue::Pop(std::unique_ptr<RealSenseDataFrame>& outFrame, double timeout)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	const bool bReady = frameAvailable.wait_for(lock, std::chrono::duration<double>(timeout), 
+												[this]() { return (queue.Num() > 0) || bClosed; });
+	if ((bReady == false) || (queue.Num() == 0)) {
+		return false;
+	}
+
+	outFrame = std::move(queue[0]);
+	queue.RemoveAt(0, 1, false);
+	framesDelivered++;
+
+	lock.unlock();
+	spaceAvailable.notify_one();
+	return true;
+}
+
+void RealSenseFrameQueue::Recycle(std::unique_ptr<RealSenseDataFrame> frame)
+{
+	if (frame) {
+		std::unique_lock<std::mutex> lock(mutex);
+		pool.Push(std::move(frame));
+	}
+}
+
+void RealSenseFrameQueue::SetInterrupted(bool bNewInterrupted)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		bInterrupted = bNewInterrupted;
+	}
+	spaceAvailable.notify_all();
+}
+
+void RealSenseFrameQueue::Close()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		bClosed = true;
+	}
+	frameAvailable.notify_all();
+	spaceAvailable.notify_all();
+}
+
+FFrameDeliveryStats RealSenseFrameQueue::GetStats() const
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	const double elapsed = FPlatformTime::Seconds() - startTime;
+
+	FFrameDeliveryStats stats;
+	stats.Policy = policy;
+	stats.FramesPublished = (int32)framesPublished;
+	stats.FramesDelivered = (int32)framesDelivered;
+	stats.FramesDropped = (int32)framesDropped;
+	stats.QueueDepth = queue.Num();
+	stats.MaxQueueDepth = maxDepth;
+	stats.DeliveredPerSecond = (elapsed > 0.0) ? (float)(framesDelivered / elapsed) : 0.0f;
+	stats.BlockedMs = (float)(blockedSeconds * 1000.0);
+	return stats;
+}
@@ -0,0 +1,95 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "AllowWindowsPlatformTypes.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include "HideWindowsPlatformTypes.h"
+
+#include "RealSenseTypes.h"
+#include "RealSenseFrameSource.h"
+
+// Delivers frames from the camera processing thread to one consumer (a 
+// recorder, an analytics thread, ...) according to an EFrameDeliveryPolicy.
+//
+// Frames are copied into a pool owned by the queue, so the consumer can keep 
+// a frame as long as it needs without holding up the camera. Popped frames 
+// must be handed back with Recycle() to avoid allocating new ones.
+//
+// Example usage (consumer thread):
+//   std::unique_ptr<RealSenseDataFrame> frame;
+//   while (queue->Pop(frame, 0.1)) {
+//       ... process frame ...
+//       queue->Recycle(std::move(frame));
+//   }
+class RealSenseFrameQueue : public IRealSenseFramePublisher {
+public:
+	// Capacity is the number of frames the queue can hold. It is ignored by
+	// LATEST_ONLY, which always holds a single frame.
+	RealSenseFrameQueue(EFrameDeliveryPolicy policy, int32 capacity);
+
+	~RealSenseFrameQueue();
+
+	// Called on the camera processing thread. With the LOSSLESS policy, this 
+	// blocks while the queue is full, unless the queue is interrupted.
+	void Publish(const RealSenseDataFrame& frame) override;
+
+	// Wakes up a blocked Publish(), which drops its frame, and keeps it from
+	// blocking until the queue is resumed. Frames are still delivered.
+	void SetInterrupted(bool bInterrupted) override;
+
+	// Waits up to timeout seconds for the next frame. Returns false if no 
+	// frame arrived in time or the queue was closed.
+	bool Pop(std::unique_ptr<RealSenseDataFrame>& outFrame, double timeout);
+
+	// Returns a popped frame to the pool.
+	void Recycle(std::unique_ptr<RealSenseDataFrame> frame);
+
+	// Wakes up a blocked Publish() and Pop() and rejects further frames. Must 
+	// be called before the queue is removed from its RealSenseImpl.
+	void Close();
+
+	inline EFrameDeliveryPolicy GetPolicy() const { return policy; }
+
+	FFrameDeliveryStats GetStats() const;
+
+private:
+	// Takes a frame from the pool, or allocates one if the pool is empty.
+	std::unique_ptr<RealSenseDataFrame> AllocateFrame();
+
+	EFrameDeliveryPolicy policy;
+	int32 capacity;
+	bool bClosed;
+	bool bInterrupted;
+
+	TArray<std::unique_ptr<RealSenseDataFrame>> queue;  // Oldest frame first
+	TArray<std::unique_ptr<RealSenseDataFrame>> pool;
+
+	mutable std::mutex mutex;
+	std::condition_variable frameAvailable;
+	std::condition_variable spaceAvailable;
+
+	// Statistics, guarded by mutex
+	uint64 framesPublished;
+	uint64 framesDelivered;
+	uint64 framesDropped;
+	int32 maxDepth;
+	double blockedSeconds;
+	double startTime;
+};
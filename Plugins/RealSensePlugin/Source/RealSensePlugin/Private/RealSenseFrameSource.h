@@ -0,0 +1,70 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "CoreMisc.h"
+
+struct RealSenseDataFrame;
+
+// Anything that delivers RealSense color and depth frames to the game thread:
+// a local camera (RealSenseImpl) or a remote one (RealSenseStreamClient).
+//
+// Frames are produced on a background thread. SwapFrames() loads the latest
+// frame into the foreground, and the getters read from that foreground frame
+// until the next call to SwapFrames().
+class IRealSenseFrameSource {
+public:
+	virtual ~IRealSenseFrameSource() {}
+
+	virtual void SwapFrames() = 0;
+
+	virtual uint64 GetFrameNumber() const = 0;
+
+	virtual double GetFrameTimestamp() const = 0;
+
+	virtual int32 GetColorImageWidth() const = 0;
+
+	virtual int32 GetColorImageHeight() const = 0;
+
+	virtual int32 GetDepthImageWidth() const = 0;
+
+	virtual int32 GetDepthImageHeight() const = 0;
+
+	virtual const uint8* GetColorBuffer() const = 0;
+
+	virtual const uint16* GetDepthBuffer() const = 0;
+
+	// Summed-area tables of the depth image (see BuildDepthSummedAreaTable), 
+	// or null if the source does not compute them.
+	virtual const uint64* GetDepthSumTable() const { return nullptr; }
+
+	virtual const uint32* GetDepthCountTable() const { return nullptr; }
+};
+
+// Receives every frame produced by the camera processing thread, right before
+// it is handed to the game thread. Publish() runs on the camera thread, so 
+// implementations must copy what they need and return quickly.
+class IRealSenseFramePublisher {
+public:
+	virtual ~IRealSenseFramePublisher() {}
+
+	virtual void Publish(const RealSenseDataFrame& frame) = 0;
+
+	// While interrupted, Publish() must not block. The camera thread is 
+	// stopped by interrupting every publisher before it is joined, and they 
+	// are resumed when it starts again.
+	virtual void SetInterrupted(bool bInterrupted) {}
+};
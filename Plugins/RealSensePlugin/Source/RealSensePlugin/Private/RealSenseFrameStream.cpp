@@ -0,0 +1,585 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseFrameStream.h"
+#include "RealSenseImpl.h"
+#include "Networking.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+// Weight of the newest sample in the exponential moving averages of the stats
+static const float StatsSmoothing = 0.1f;
+
+static float UpdateAverage(float average, float sample)
+{
+	return (average == 0.0f) ? sample : average + StatsSmoothing * (sample - average);
+}
+
+// Differences to the previous pixel are small on smooth surfaces, and zigzag
+// encoding maps small negative and positive differences to small unsigned 
+// values. Storing the low and high bytes in separate planes leaves the high
+// plane almost entirely zero, which zlib compresses very well.
+bool EncodeDepthImage(const uint16* depth, int32 width, int32 height, TArray<uint8>& scratch, TArray<uint8>& out)
+{
+	const int32 count = width * height;
+	scratch.SetNumUninitialized(count * 2);
+	uint8* lo = scratch.GetData();
+	uint8* hi = lo + count;
+
+	for (int32 y = 0; y < height; y++) {
+		const uint16* row = depth + y * width;
+		uint16 prev = 0;
+		for (int32 x = 0; x < width; x++) {
+			const int16 delta = (int16)(uint16)(row[x] - prev);
+			const uint16 zigzag = (uint16)((delta << 1) ^ (delta >> 15));
+			lo[y * width + x] = (uint8)(zigzag & 0xFF);
+			hi[y * width + x] = (uint8)(zigzag >> 8);
+			prev = row[x];
+		}
+	}
+
+	int32 compressedSize = FCompression::CompressMemoryBound(COMPRESS_ZLIB, scratch.Num());
+	out.SetNumUninitialized(compressedSize);
+	if (FCompression::CompressMemory(COMPRESS_ZLIB, out.GetData(), compressedSize, scratch.GetData(), scratch.Num()) == false) {
+		return false;
+	}
+	out.SetNum(compressedSize, false);
+	return true;
+}
+
+bool DecodeDepthImage(const uint8* data, int32 size, int32 width, int32 height, TArray<uint8>& scratch, uint16* depth)
+{
+	if ((width <= 0) || (height <= 0) || ((int64)width * height > MAX_int32 / 2)) {
+		return false;
+	}
+
+	const int32 count = width * height;
+	scratch.SetNumUninitialized(count * 2);
+	if (FCompression::UncompressMemory(COMPRESS_ZLIB, scratch.GetData(), scratch.Num(), data, size) == false) {
+		return false;
+	}
+
+	const uint8* lo = scratch.GetData();
+	const uint8* hi = lo + count;
+	for (int32 y = 0; y < height; y++) {
+		uint16* row = depth + y * width;
+		uint16 prev = 0;
+		for (int32 x = 0; x < width; x++) {
+			const uint16 zigzag = (uint16)(lo[y * width + x] | (hi[y * width + x] << 8));
+			const uint16 delta = (uint16)((zigzag >> 1) ^ (0 - (zigzag & 1)));
+			prev = (uint16)(prev + delta);
+			row[x] = prev;
+		}
+	}
+	return true;
+}
+
+// Sends the whole buffer, retrying partial sends. Returns false if the
+// connection failed.
+static bool SendAll(FSocket* socket, const uint8* data, int32 size)
+{
+	while (size > 0) {
+		int32 sent = 0;
+		if ((socket->Send(data, size, sent) == false) || (sent <= 0)) {
+			return false;
+		}
+		data += sent;
+		size -= sent;
+	}
+	return true;
+}
+
+RealSenseStreamServer::RealSenseStreamServer()
+{
+	listenSocket = nullptr;
+	bRunning = false;
+	bFramePending = false;
+	imageWrapperModule = nullptr;
+	jpegQuality = 85;
+
+	pendingFrame = std::unique_ptr<RealSenseDataFrame>(new RealSenseDataFrame());
+	sendFrame = std::unique_ptr<RealSenseDataFrame>(new RealSenseDataFrame());
+
+	framesPublished = 0;
+	framesSent = 0;
+	bytesSent = 0;
+	numClients = 0;
+	averageEncodeMs = 0.0f;
+	startTime = 0.0;
+}
+
+RealSenseStreamServer::~RealSenseStreamServer()
+{
+	Stop();
+}
+
+// Opens a listening socket on the given port (on all interfaces, so both 
+// loopback and LAN clients can connect) and starts the server thread.
+bool RealSenseStreamServer::Start(int32 port, int32 quality)
+{
+	if (bRunning) {
+		return true;
+	}
+
+	imageWrapperModule = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+	jpegQuality = FMath::Clamp(quality, 1, 100);
+
+	listenSocket = FTcpSocketBuilder(TEXT("RealSenseStreamServer"))
+		.AsReusable()
+		.BoundToPort(port)
+		.Listening(8);
+	if (listenSocket == nullptr) {
+		RS_LOG(Error, "Unable to listen on port %d", port)
+		return false;
+	}
+
+	startTime = FPlatformTime::Seconds();
+	bRunning = true;
+	serverThread = std::thread([this]() { ServerThread(); });
+
+	RS_LOG(Log, "Streaming frames on port %d", port)
+	return true;
+}
+
+void RealSenseStreamServer::Stop()
+{
+	if (bRunning) {
+		bRunning = false;
+		pendingCondition.notify_all();
+		serverThread.join();
+	}
+
+	ISocketSubsystem* socketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	for (FSocket* client : clients) {
+		client->Close();
+		socketSubsystem->DestroySocket(client);
+	}
+	clients.Empty();
+	numClients = 0;
+
+	if (listenSocket) {
+		listenSocket->Close();
+		socketSubsystem->DestroySocket(listenSocket);
+		listenSocket = nullptr;
+	}
+}
+
+// Copies the color and depth images into the pending frame. If the server 
+// thread has not picked up the previous pending frame yet, it is overwritten.
+// Frames published while no client is connected are ignored.
+void RealSenseStreamServer::Publish(const RealSenseDataFrame& frame)
+{
+	if ((bRunning == false) || (numClients == 0)) {
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(pendingMutex);
+		pendingFrame->number = frame.number;
+		pendingFrame->timestamp = frame.timestamp;
+
+		pendingFrame->colorImage.SetDimensions(frame.colorImage.GetWidth(), frame.colorImage.GetHeight(), 
+											   frame.colorImage.GetChannels());
+		FMemory::Memcpy(pendingFrame->colorImage.GetData(), frame.colorImage.GetData(), frame.colorImage.Num());
+
+		pendingFrame->depthImage.SetDimensions(frame.depthImage.GetWidth(), frame.depthImage.GetHeight());
+		FMemory::Memcpy(pendingFrame->depthImage.GetData(), frame.depthImage.GetData(), 
+						frame.depthImage.Num() * sizeof(uint16));
+
+		bFramePending = true;
+	}
+	framesPublished++;
+	pendingCondition.notify_one();
+}
+
+FRealSenseStreamStats RealSenseStreamServer::GetStats() const
+{
+	FRealSenseStreamStats stats;
+	const uint64 published = framesPublished;
+	const uint64 sent = framesSent;
+	const double elapsed = FPlatformTime::Seconds() - startTime;
+
+	stats.Connections = numClients;
+	stats.FramesTransferred = (int32)sent;
+	stats.FramesDropped = (int32)(published - sent);
+	stats.AverageCodecMs = averageEncodeMs;
+	stats.AverageLatencyMs = 0.0f;
+	stats.BandwidthMbps = (elapsed > 0.0) ? (float)(bytesSent * 8.0 / elapsed / 1000000.0) : 0.0f;
+	return stats;
+}
+
+// Accepts pending connections, then waits for the next frame, encodes it once,
+// and sends it to every client. Clients whose connection fails are dropped.
+void RealSenseStreamServer::ServerThread()
+{
+	while (bRunning) {
+		AcceptClients();
+
+		{
+			std::unique_lock<std::mutex> lock(pendingMutex);
+			pendingCondition.wait_for(lock, std::chrono::milliseconds(100), 
+									  [this]() { return bFramePending || (bRunning == false); });
+			if ((bFramePending == false) || (bRunning == false)) {
+				continue;
+			}
+			pendingFrame.swap(sendFrame);
+			bFramePending = false;
+		}
+
+		if (clients.Num() == 0) {
+			continue;
+		}
+
+		if (EncodeFrame(*sendFrame) == false) {
+			continue;
+		}
+
+		ISocketSubsystem* socketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+		for (int32 i = clients.Num() - 1; i >= 0; i--) {
+			if (SendAll(clients[i], packet.GetData(), packet.Num()) == false) {
+				RS_LOG(Log, "Stream client disconnected")
+				clients[i]->Close();
+				socketSubsystem->DestroySocket(clients[i]);
+				clients.RemoveAt(i);
+			}
+		}
+
+		numClients = clients.Num();
+		framesSent++;
+		bytesSent += packet.Num();
+	}
+}
+
+void RealSenseStreamServer::AcceptClients()
+{
+	bool bPending = false;
+	while (listenSocket->HasPendingConnection(bPending) && bPending) {
+		FSocket* client = listenSocket->Accept(TEXT("RealSenseStreamClient"));
+		if (client == nullptr) {
+			break;
+		}
+		client->SetNoDelay(true);
+		clients.Add(client);
+		RS_LOG(Log, "Stream client connected")
+	}
+	numClients = clients.Num();
+}
+
+// Builds the packet for one frame: header, JPEG color, compressed depth.
+bool RealSenseStreamServer::EncodeFrame(const RealSenseDataFrame& frame)
+{
+	const double encodeStart = FPlatformTime::Seconds();
+
+	RealSenseStreamHeader header = {};
+	header.magic = RealSenseStreamHeader::Magic;
+	header.version = RealSenseStreamHeader::Version;
+	header.frameNumber = frame.number;
+	header.timestamp = frame.timestamp;
+	header.colorWidth = frame.colorImage.GetWidth();
+	header.colorHeight = frame.colorImage.GetHeight();
+	header.depthWidth = frame.depthImage.GetWidth();
+	header.depthHeight = frame.depthImage.GetHeight();
+
+	const uint8* colorPayload = nullptr;
+	IImageWrapperPtr jpegWrapper;
+	if (frame.colorImage.Num() > 0) {
+		jpegWrapper = imageWrapperModule->CreateImageWrapper(EImageFormat::JPEG);
+		if (jpegWrapper.IsValid() && jpegWrapper->SetRaw(frame.colorImage.GetData(), frame.colorImage.Num(), 
+								header.colorWidth, header.colorHeight, ERGBFormat::BGRA, 8)) {
+			const TArray<uint8>& compressed = jpegWrapper->GetCompressed(jpegQuality);
+			colorPayload = compressed.GetData();
+			header.colorBytes = compressed.Num();
+		}
+	}
+
+	depthPayload.Reset();
+	if (frame.depthImage.Num() > 0) {
+		if (EncodeDepthImage(frame.depthImage.GetData(), header.depthWidth, header.depthHeight, 
+							 depthScratch, depthPayload) == false) {
+			return false;
+		}
+		header.depthBytes = depthPayload.Num();
+	}
+
+	packet.SetNumUninitialized(sizeof(header) + header.colorBytes + header.depthBytes);
+	uint8* out = packet.GetData();
+	FMemory::Memcpy(out, &header, sizeof(header));
+	out += sizeof(header);
+	if (header.colorBytes > 0) {
+		FMemory::Memcpy(out, colorPayload, header.colorBytes);
+		out += header.colorBytes;
+	}
+	if (header.depthBytes > 0) {
+		FMemory::Memcpy(out, depthPayload.GetData(), header.depthBytes);
+	}
+
+	averageEncodeMs = UpdateAverage(averageEncodeMs, (FPlatformTime::Seconds() - encodeStart) * 1000.0);
+	return true;
+}
+
+RealSenseStreamClient::RealSenseStreamClient()
+{
+	socket = nullptr;
+	bRunning = false;
+	bConnected = false;
+	imageWrapperModule = nullptr;
+
+	fgFrame = std::unique_ptr<RealSenseDataFrame>(new RealSenseDataFrame());
+	midFrame = std::unique_ptr<RealSenseDataFrame>(new RealSenseDataFrame());
+	bgFrame = std::unique_ptr<RealSenseDataFrame>(new RealSenseDataFrame());
+
+	framesReceived = 0;
+	framesDropped = 0;
+	bytesReceived = 0;
+	averageDecodeMs = 0.0f;
+	averageLatencyMs = 0.0f;
+	startTime = 0.0;
+}
+
+RealSenseStreamClient::~RealSenseStreamClient()
+{
+	Disconnect();
+}
+
+// Resolves the host, connects to it, and starts the receiving thread.
+bool RealSenseStreamClient::Connect(const FString& host, int32 port)
+{
+	Disconnect();
+
+	imageWrapperModule = &FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+	ISocketSubsystem* socketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+	TSharedRef<FInternetAddr> address = socketSubsystem->CreateInternetAddr();
+
+	bool bValid = false;
+	address->SetIp(*host, bValid);
+	if ((bValid == false) && (socketSubsystem->GetHostByName(TCHAR_TO_ANSI(*host), *address) != SE_NO_ERROR)) {
+		RS_LOG(Error, "Unable to resolve stream server '%s'", *host)
+		return false;
+	}
+	address->SetPort(port);
+
+	socket = socketSubsystem->CreateSocket(NAME_Stream, TEXT("RealSenseStreamClient"), false);
+	if ((socket == nullptr) || (socket->Connect(*address) == false)) {
+		RS_LOG(Error, "Unable to connect to stream server '%s:%d'", *host, port)
+		if (socket) {
+			socketSubsystem->DestroySocket(socket);
+			socket = nullptr;
+		}
+		return false;
+	}
+	socket->SetNoDelay(true);
+
+	startTime = FPlatformTime::Seconds();
+	bConnected = true;
+	bRunning = true;
+	clientThread = std::thread([this]() { ClientThread(); });
+	return true;
+}
+
+void RealSenseStreamClient::Disconnect()
+{
+	if (bRunning) {
+		bRunning = false;
+		clientThread.join();
+	}
+
+	if (socket) {
+		socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(socket);
+		socket = nullptr;
+	}
+	bConnected = false;
+}
+
+FRealSenseStreamStats RealSenseStreamClient::GetStats() const
+{
+	FRealSenseStreamStats stats;
+	const double elapsed = FPlatformTime::Seconds() - startTime;
+
+	stats.Connections = bConnected ? 1 : 0;
+	stats.FramesTransferred = (int32)framesReceived;
+	stats.FramesDropped = (int32)framesDropped;
+	stats.AverageCodecMs = averageDecodeMs;
+	stats.AverageLatencyMs = averageLatencyMs;
+	stats.BandwidthMbps = (elapsed > 0.0) ? (float)(bytesReceived * 8.0 / elapsed / 1000000.0) : 0.0f;
+	return stats;
+}
+
+// Reads exactly size bytes, waiting in short intervals so that Disconnect()
+// is never blocked for long.
+bool RealSenseStreamClient::ReceiveAll(uint8* data, int32 size)
+{
+	while (size > 0) {
+		if (bRunning == false) {
+			return false;
+		}
+		if (socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(100)) == false) {
+			continue;
+		}
+
+		int32 read = 0;
+		if ((socket->Recv(data, size, read) == false) || (read <= 0)) {
+			return false;
+		}
+		data += read;
+		size -= read;
+	}
+	return true;
+}
+
+// Checks a frame header received from the network against the largest 
+// images a camera produces, before anything is allocated for it. Sizes are 
+// computed in 64 bits so that no field can overflow the checks. Compressed 
+// depth may be slightly larger than raw depth, so it is allowed twice that.
+static bool IsValidHeader(const RealSenseStreamHeader& header)
+{
+	if ((header.magic != RealSenseStreamHeader::Magic) || (header.version != RealSenseStreamHeader::Version)) {
+		return false;
+	}
+
+	const int64 colorPixels = (int64)header.colorWidth * header.colorHeight;
+	const int64 depthPixels = (int64)header.depthWidth * header.depthHeight;
+	const int64 maxColorBytes = (int64)GetMaxColorImagePixels() * 4;
+	const int64 maxDepthBytes = (int64)GetMaxDepthImagePixels() * sizeof(uint16);
+
+	return (colorPixels <= GetMaxColorImagePixels()) && (depthPixels <= GetMaxDepthImagePixels()) &&
+		((int64)header.colorBytes <= maxColorBytes) && ((int64)header.depthBytes <= 2 * maxDepthBytes) &&
+		((header.colorBytes == 0) || (colorPixels > 0)) && ((header.depthBytes == 0) || (depthPixels > 0));
+}
+
+// Receives and decodes frames into the background frame, then swaps it with
+// the mid frame. A header that fails IsValidHeader() drops the connection, 
+// since the stream can no longer be trusted; a frame that fails to decode is
+// skipped and counted as dropped, like gaps in the frame numbers.
+void RealSenseStreamClient::ClientThread()
+{
+	uint64 lastFrameNumber = 0;
+
+	while (bRunning) {
+		RealSenseStreamHeader header;
+		if (ReceiveAll(reinterpret_cast<uint8*>(&header), sizeof(header)) == false) {
+			break;
+		}
+		if (IsValidHeader(header) == false) {
+			RS_LOG(Error, "Invalid frame received from stream server")
+			break;
+		}
+
+		payload.SetNumUninitialized((int32)header.colorBytes + (int32)header.depthBytes);
+		if (ReceiveAll(payload.GetData(), payload.Num()) == false) {
+			break;
+		}
+
+		if ((lastFrameNumber != 0) && (header.frameNumber > lastFrameNumber + 1)) {
+			framesDropped += header.frameNumber - lastFrameNumber - 1;
+		}
+		lastFrameNumber = header.frameNumber;
+
+		const double decodeStart = FPlatformTime::Seconds();
+
+		bgFrame->number = header.frameNumber;
+		bgFrame->timestamp = header.timestamp;
+
+		bool bDecoded = true;
+
+		bgFrame->colorImage.SetDimensions(header.colorWidth, header.colorHeight, 4);
+		if (header.colorBytes > 0) {
+			IImageWrapperPtr jpegWrapper = imageWrapperModule->CreateImageWrapper(EImageFormat::JPEG);
+			const TArray<uint8>* raw = nullptr;
+			if (jpegWrapper.IsValid() && 
+				jpegWrapper->SetCompressed(payload.GetData(), header.colorBytes) &&
+				jpegWrapper->GetRaw(ERGBFormat::BGRA, 8, raw) && 
+				(raw->Num() == bgFrame->colorImage.Num())) {
+				FMemory::Memcpy(bgFrame->colorImage.GetData(), raw->GetData(), raw->Num());
+			}
+			else {
+				bDecoded = false;
+			}
+		}
+
+		bgFrame->depthImage.SetDimensions(header.depthWidth, header.depthHeight);
+		if ((header.depthBytes > 0) && bDecoded) {
+			bDecoded = DecodeDepthImage(payload.GetData() + header.colorBytes, header.depthBytes, 
+										header.depthWidth, header.depthHeight, depthScratch, bgFrame->depthImage.GetData());
+		}
+
+		bytesReceived += sizeof(header) + payload.Num();
+		if (bDecoded == false) {
+			framesDropped++;
+			continue;
+		}
+
+		const double now = FPlatformTime::Seconds();
+		averageDecodeMs = UpdateAverage(averageDecodeMs, (now - decodeStart) * 1000.0);
+		averageLatencyMs = UpdateAverage(averageLatencyMs, (now - header.timestamp) * 1000.0);
+
+		framesReceived++;
+
+		std::unique_lock<std::mutex> lock(midFrameMutex);
+		bgFrame.swap(midFrame);
+	}
+
+	bConnected = false;
+}
+
+void RealSenseStreamClient::SwapFrames()
+{
+	std::unique_lock<std::mutex> lock(midFrameMutex);
+	if (fgFrame->number < midFrame->number) {
+		fgFrame.swap(midFrame);
+	}
+}
+
+uint64 RealSenseStreamClient::GetFrameNumber() const
+{
+	return fgFrame->number;
+}
+
+double RealSenseStreamClient::GetFrameTimestamp() const
+{
+	return fgFrame->timestamp;
+}
+
+int32 RealSenseStreamClient::GetColorImageWidth() const
+{
+	return fgFrame->colorImage.GetWidth();
+}
+
+int32 RealSenseStreamClient::GetColorImageHeight() const
+{
+	return fgFrame->colorImage.GetHeight();
+}
+
+int32 RealSenseStreamClient::GetDepthImageWidth() const
+{
+	return fgFrame->depthImage.GetWidth();
+}
+
+int32 RealSenseStreamClient::GetDepthImageHeight() const
+{
+	return fgFrame->depthImage.GetHeight();
+}
+
+const uint8* RealSenseStreamClient::GetColorBuffer() const
+{
+	return fgFrame->colorImage.GetData();
+}
+
+const uint16* RealSenseStreamClient::GetDepthBuffer() const
+{
+	return fgFrame->depthImage.GetData();
+}
@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "AllowWindowsPlatformTypes.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "HideWindowsPlatformTypes.h"
+
+#include "RealSenseTypes.h"
+#include "RealSenseFrameSource.h"
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+
+class FSocket;
+
+// Streams RealSense frames between processes or machines over TCP.
+//
+// Every frame is sent as a RealSenseStreamHeader followed by the JPEG-encoded
+// color image and the losslessly compressed depth image. Depth is compressed
+// by taking the difference to the previous pixel of the row, zigzag-encoding
+// the 16-bit differences, splitting them into low and high byte planes, and 
+// deflating the result with zlib.
+
+#pragma pack(push, 1)
+struct RealSenseStreamHeader {
+	static const uint32 Magic = 0x53465352;  // "RSFS"
+	static const uint16 Version = 1;
+
+	uint32 magic;
+	uint16 version;
+	uint16 reserved;
+	uint64 frameNumber;  // Sequence number of the frame on the camera thread
+	double timestamp;  // Capture time (FPlatformTime::Seconds) on the server
+	uint16 colorWidth;
+	uint16 colorHeight;
+	uint16 depthWidth;
+	uint16 depthHeight;
+	uint32 colorBytes;  // Size of the JPEG color payload
+	uint32 depthBytes;  // Size of the compressed depth payload
+};
+#pragma pack(pop)
+
+// Compresses width * height depth values into out. Returns false on failure.
+bool EncodeDepthImage(const uint16* depth, int32 width, int32 height, TArray<uint8>& scratch, TArray<uint8>& out);
+
+// Decompresses a depth payload produced by EncodeDepthImage into depth, which 
+// must hold width * height values. Returns false on failure.
+bool DecodeDepthImage(const uint8* data, int32 size, int32 width, int32 height, TArray<uint8>& scratch, uint16* depth);
+
+// Accepts TCP connections and sends every published frame to all connected 
+// clients. Encoding and sending happen on the server's own thread; if it 
+// falls behind, intermediate frames are dropped and only the latest frame 
+// is sent.
+class RealSenseStreamServer : public IRealSenseFramePublisher {
+public:
+	RealSenseStreamServer();
+
+	~RealSenseStreamServer();
+
+	// Must be called from the game thread, since it loads the ImageWrapper module.
+	bool Start(int32 port, int32 jpegQuality);
+
+	void Stop();
+
+	void Publish(const RealSenseDataFrame& frame) override;
+
+	FRealSenseStreamStats GetStats() const;
+
+private:
+	void ServerThread();
+
+	void AcceptClients();
+
+	bool EncodeFrame(const RealSenseDataFrame& frame);
+
+	FSocket* listenSocket;
+	TArray<FSocket*> clients;
+
+	std::thread serverThread;
+	std::atomic_bool bRunning;
+
+	// Latest published frame waiting to be sent
+	std::unique_ptr<RealSenseDataFrame> pendingFrame;
+	std::unique_ptr<RealSenseDataFrame> sendFrame;
+	bool bFramePending;
+	std::mutex pendingMutex;
+	std::condition_variable pendingCondition;
+
+	IImageWrapperModule* imageWrapperModule;
+	int32 jpegQuality;
+
+	TArray<uint8> packet;
+	TArray<uint8> depthScratch;
+	TArray<uint8> depthPayload;
+
+	// Statistics
+	std::atomic<uint64> framesPublished;
+	std::atomic<uint64> framesSent;
+	std::atomic<uint64> bytesSent;
+	std::atomic<int32> numClients;
+	std::atomic<float> averageEncodeMs;
+	double startTime;
+};
+
+// Connects to a RealSenseStreamServer and decodes the frames it sends into a
+// triple buffer, the same way RealSenseImpl does for a local camera.
+class RealSenseStreamClient : public IRealSenseFrameSource {
+public:
+	RealSenseStreamClient();
+
+	~RealSenseStreamClient();
+
+	// Must be called from the game thread, since it loads the ImageWrapper module.
+	bool Connect(const FString& host, int32 port);
+
+	void Disconnect();
+
+	inline bool IsConnected() const { return bConnected; }
+
+	FRealSenseStreamStats GetStats() const;
+
+	// IRealSenseFrameSource
+
+	void SwapFrames() override;
+
+	uint64 GetFrameNumber() const override;
+
+	double GetFrameTimestamp() const override;
+
+	int32 GetColorImageWidth() const override;
+
+	int32 GetColorImageHeight() const override;
+
+	int32 GetDepthImageWidth() const override;
+
+	int32 GetDepthImageHeight() const override;
+
+	const uint8* GetColorBuffer() const override;
+
+	const uint16* GetDepthBuffer() const override;
+
+private:
+	void ClientThread();
+
+	bool ReceiveAll(uint8* data, int32 size);
+
+	FSocket* socket;
+
+	std::thread clientThread;
+	std::atomic_bool bRunning;
+	std::atomic_bool bConnected;
+
+	std::unique_ptr<RealSenseDataFrame> fgFrame;
+	std::unique_ptr<RealSenseDataFrame> midFrame;
+	std::unique_ptr<RealSenseDataFrame> bgFrame;
+	std::mutex midFrameMutex;
+
+	IImageWrapperModule* imageWrapperModule;
+
+	TArray<uint8> payload;
+	TArray<uint8> depthScratch;
+
+	// Statistics
+	std::atomic<uint64> framesReceived;
+	std::atomic<uint64> framesDropped;
+	std::atomic<uint64> bytesReceived;
+	std::atomic<float> averageDecodeMs;
+	std::atomic<float> averageLatencyMs;
+	double startTime;
+};
@@ -0,0 +1,506 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseFusion.h"
+#include "ParallelFor.h"
+
+// Depth rows handed to a worker thread at a time
+static const int32 RowsPerTask = 16;
+
+// Distance in pixels between the depth samples used to allocate blocks. A 
+// block spans many pixels at any usable depth, so sparse samples find them all.
+static const int32 AllocationStride = 2;
+
+// Voxel coordinates are split into block coordinates and an offset within 
+// the block with shifts and masks, which also round negative coordinates down.
+static const int32 BlockShift = 3;
+static const int32 BlockMask = RealSenseFusionVolume::BlockSize - 1;
+
+static const float DistanceScale = 32767.0f;
+
+static inline int32 VoxelIndex(int32 x, int32 y, int32 z)
+{
+	return (z * RealSenseFusionVolume::BlockSize + y) * RealSenseFusionVolume::BlockSize + x;
+}
+
+RealSenseCameraIntrinsics RealSenseCameraIntrinsics::FromFOV(int32 width, int32 height, float horizontalFOV, float verticalFOV)
+{
+	RealSenseCameraIntrinsics intrinsics;
+	intrinsics.width = width;
+	intrinsics.height = height;
+	intrinsics.fx = (width * 0.5f) / FMath::Tan(FMath::DegreesToRadians(horizontalFOV * 0.5f));
+	intrinsics.fy = (height * 0.5f) / FMath::Tan(FMath::DegreesToRadians(verticalFOV * 0.5f));
+	intrinsics.cx = (width - 1) * 0.5f;
+	intrinsics.cy = (height - 1) * 0.5f;
+	return intrinsics;
+}
+
+RealSenseFusionVolume::RealSenseFusionVolume()
+{
+	Reset();
+}
+
+void RealSenseFusionVolume::Configure(const RealSenseFusionSettings& newSettings)
+{
+	settings = newSettings;
+	settings.voxelSize = FMath::Max(settings.voxelSize, 0.05f);
+	settings.truncation = FMath::Max(settings.truncation, settings.voxelSize);
+	settings.maxWeight = FMath::Clamp(settings.maxWeight, 1, 0xFFFF);
+	Reset();
+}
+
+void RealSenseFusionVolume::Reset()
+{
+	blockLookup.Empty();
+	blockCoordinates.Empty();
+	blocks.Empty();
+	visibleBlocks.Empty();
+	boundsMin = FVector(0.0f, 0.0f, 0.0f);
+	boundsMax = FVector(0.0f, 0.0f, 0.0f);
+}
+
+const RealSenseFusionVolume::Block* RealSenseFusionVolume::FindBlock(const FIntVector& coordinates) const
+{
+	const int32* index = blockLookup.Find(coordinates);
+	return index ? &blocks[*index] : nullptr;
+}
+
+const RealSenseFusionVolume::Voxel* RealSenseFusionVolume::FindVoxel(int32 x, int32 y, int32 z) const
+{
+	const Block* block = FindBlock(FIntVector(x >> BlockShift, y >> BlockShift, z >> BlockShift));
+	return block ? &block->voxels[VoxelIndex(x & BlockMask, y & BlockMask, z & BlockMask)] : nullptr;
+}
+
+SIZE_T RealSenseFusionVolume::GetAllocatedSize() const
+{
+	return blocks.GetAllocatedSize() + blockCoordinates.GetAllocatedSize() + blockLookup.GetAllocatedSize();
+}
+
+// Allocation: every depth sample marks the blocks crossed by its ray within
+// the truncation distance of the measured surface. Each worker collects the
+// blocks of its rows in its own set; the sets are merged and the new blocks
+// are added on the calling thread.
+//
+// Integration: every voxel of the marked blocks is projected into the depth
+// image, and the difference between the measured depth and the depth of the
+// voxel, clamped to the truncation distance, is averaged into the voxel. 
+// Voxels more than the truncation distance behind the surface are left 
+// alone, since they may be hidden. Blocks are independent, so they are 
+// updated in parallel.
+void RealSenseFusionVolume::Integrate(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics, 
+									  const FMatrix& cameraToWorld)
+{
+	if (depth == nullptr) {
+		return;
+	}
+
+	const FMatrix worldToCamera = cameraToWorld.Inverse();
+	const FVector origin = cameraToWorld.GetOrigin();
+	const float voxelSize = settings.voxelSize;
+	const float blockExtent = voxelSize * BlockSize;
+	const float truncation = settings.truncation;
+	const float maxDepth = settings.maxDepth;
+	const int32 width = intrinsics.width;
+	const int32 height = intrinsics.height;
+	const int32 numTasks = (height + RowsPerTask - 1) / RowsPerTask;
+
+	TArray<TSet<FIntVector>> touchedBlocks;
+	touchedBlocks.SetNum(numTasks);
+
+	ParallelFor(numTasks, [&](int32 task) {
+		TSet<FIntVector>& touched = touchedBlocks[task];
+		const int32 last = FMath::Min((task + 1) * RowsPerTask, height);
+
+		for (int32 v = task * RowsPerTask; v < last; v += AllocationStride) {
+			for (int32 u = 0; u < width; u += AllocationStride) {
+				const float d = depth[v * width + u] * 0.1f;
+				if ((d <= 0.0f) || (d > maxDepth)) {
+					continue;
+				}
+
+				const FVector direction = cameraToWorld.TransformVector(
+					FVector(1.0f, (u - intrinsics.cx) / intrinsics.fx, -(v - intrinsics.cy) / intrinsics.fy));
+				const float step = blockExtent * 0.5f / direction.Size();
+				const float end = d + truncation;
+
+				for (float t = FMath::Max(d - truncation, 0.0f); ; t += step) {
+					t = FMath::Min(t, end);
+					const FVector p = origin + direction * t;
+					touched.Add(FIntVector(FMath::FloorToInt(p.X / blockExtent), FMath::FloorToInt(p.Y / blockExtent), 
+										   FMath::FloorToInt(p.Z / blockExtent)));
+					if (t >= end) {
+						break;
+					}
+				}
+			}
+		}
+	});
+
+	TSet<FIntVector> allTouched;
+	for (const TSet<FIntVector>& touched : touchedBlocks) {
+		allTouched.Append(touched);
+	}
+
+	visibleBlocks.Reset();
+	for (const FIntVector& coordinates : allTouched) {
+		const int32* existing = blockLookup.Find(coordinates);
+		if (existing) {
+			visibleBlocks.Add(*existing);
+			continue;
+		}
+
+		const int32 index = blocks.AddZeroed(1);
+		blockCoordinates.Add(coordinates);
+		blockLookup.Add(coordinates, index);
+		visibleBlocks.Add(index);
+
+		const FVector blockMin(coordinates.X * blockExtent, coordinates.Y * blockExtent, coordinates.Z * blockExtent);
+		const FVector blockMax = blockMin + FVector(blockExtent, blockExtent, blockExtent);
+		boundsMin = (index == 0) ? blockMin : FVector(FMath::Min(boundsMin.X, blockMin.X), FMath::Min(boundsMin.Y, blockMin.Y), 
+													  FMath::Min(boundsMin.Z, blockMin.Z));
+		boundsMax = (index == 0) ? blockMax : FVector(FMath::Max(boundsMax.X, blockMax.X), FMath::Max(boundsMax.Y, blockMax.Y), 
+													  FMath::Max(boundsMax.Z, blockMax.Z));
+	}
+
+	const int32 maxWeight = settings.maxWeight;
+
+	ParallelFor(visibleBlocks.Num(), [&](int32 i) {
+		const int32 index = visibleBlocks[i];
+		const FIntVector& coordinates = blockCoordinates[index];
+		Block& block = blocks[index];
+
+		for (int32 z = 0; z < BlockSize; z++) {
+			for (int32 y = 0; y < BlockSize; y++) {
+				for (int32 x = 0; x < BlockSize; x++) {
+					const FVector world((coordinates.X * BlockSize + x + 0.5f) * voxelSize, 
+										(coordinates.Y * BlockSize + y + 0.5f) * voxelSize, 
+										(coordinates.Z * BlockSize + z + 0.5f) * voxelSize);
+					const FVector local = worldToCamera.TransformPosition(world);
+					if (local.X <= 0.0f) {
+						continue;
+					}
+
+					const int32 u = FMath::RoundToInt(intrinsics.cx + intrinsics.fx * local.Y / local.X);
+					const int32 v = FMath::RoundToInt(intrinsics.cy - intrinsics.fy * local.Z / local.X);
+					if ((u < 0) || (v < 0) || (u >= width) || (v >= height)) {
+						continue;
+					}
+
+					const float d = depth[v * width + u] * 0.1f;
+					if ((d <= 0.0f) || (d > maxDepth)) {
+						continue;
+					}
+
+					const float signedDistance = d - local.X;
+					if (signedDistance < -truncation) {
+						continue;
+					}
+
+					Voxel& voxel = block.voxels[VoxelIndex(x, y, z)];
+					const float sample = FMath::Min(signedDistance / truncation, 1.0f);
+					const float weight = voxel.weight;
+					const float fused = (voxel.distance / DistanceScale * weight + sample) / (weight + 1.0f);
+					voxel.distance = (int16)FMath::RoundToInt(fused * DistanceScale);
+					voxel.weight = (uint16)FMath::Min(voxel.weight + 1, maxWeight);
+				}
+			}
+		}
+	});
+}
+
+// The eight surrounding voxels usually share a block, in which case the 
+// block is looked up once instead of eight times.
+bool RealSenseFusionVolume::SampleDistance(const FVector& position, float& outDistance) const
+{
+	const float scale = 1.0f / settings.voxelSize;
+	const float gx = position.X * scale - 0.5f;
+	const float gy = position.Y * scale - 0.5f;
+	const float gz = position.Z * scale - 0.5f;
+	const int32 x0 = FMath::FloorToInt(gx);
+	const int32 y0 = FMath::FloorToInt(gy);
+	const int32 z0 = FMath::FloorToInt(gz);
+	const float fx = gx - x0;
+	const float fy = gy - y0;
+	const float fz = gz - z0;
+
+	const bool bSameBlock = ((x0 & BlockMask) < BlockMask) && ((y0 & BlockMask) < BlockMask) && ((z0 & BlockMask) < BlockMask);
+	const Block* block = nullptr;
+	if (bSameBlock) {
+		block = FindBlock(FIntVector(x0 >> BlockShift, y0 >> BlockShift, z0 >> BlockShift));
+		if (block == nullptr) {
+			return false;
+		}
+	}
+
+	float values[8];
+	for (int32 corner = 0; corner < 8; corner++) {
+		const int32 x = x0 + (corner & 1);
+		const int32 y = y0 + ((corner >> 1) & 1);
+		const int32 z = z0 + (corner >> 2);
+		const Voxel* voxel = block ? &block->voxels[VoxelIndex(x & BlockMask, y & BlockMask, z & BlockMask)] : FindVoxel(x, y, z);
+		if ((voxel == nullptr) || (voxel->weight == 0)) {
+			return false;
+		}
+		values[corner] = voxel->distance / DistanceScale;
+	}
+
+	const float x00 = FMath::Lerp(values[0], values[1], fx);
+	const float x10 = FMath::Lerp(values[2], values[3], fx);
+	const float x01 = FMath::Lerp(values[4], values[5], fx);
+	const float x11 = FMath::Lerp(values[6], values[7], fx);
+	outDistance = FMath::Lerp(FMath::Lerp(x00, x10, fy), FMath::Lerp(x01, x11, fy), fz);
+	return true;
+}
+
+bool RealSenseFusionVolume::SampleNormal(const FVector& position, FVector& outNormal) const
+{
+	const float h = settings.voxelSize;
+	float samples[6];
+	const FVector offsets[3] = { FVector(h, 0.0f, 0.0f), FVector(0.0f, h, 0.0f), FVector(0.0f, 0.0f, h) };
+	for (int32 axis = 0; axis < 3; axis++) {
+		if ((SampleDistance(position + offsets[axis], samples[axis * 2]) == false) ||
+			(SampleDistance(position - offsets[axis], samples[axis * 2 + 1]) == false)) {
+			return false;
+		}
+	}
+
+	const FVector gradient(samples[0] - samples[1], samples[2] - samples[3], samples[4] - samples[5]);
+	if (gradient.IsNearlyZero(1e-6f)) {
+		return false;
+	}
+	outNormal = gradient.GetSafeNormal();
+	return true;
+}
+
+// The ray is first clipped to the bounds of the allocated blocks. Steps are 
+// sized by the distance field where it is known, since the surface is at 
+// least that far away. Unallocated blocks are skipped half a block at a 
+// time; if such a step lands behind a surface, the ray backs up and 
+// approaches it again one voxel at a time.
+bool RealSenseFusionVolume::CastRay(const FVector& origin, const FVector& direction, float maxDepth, float& outDepth) const
+{
+	if (blocks.Num() == 0) {
+		return false;
+	}
+
+	const float length = direction.Size();
+	const float fineStep = settings.voxelSize / length;
+	const float coarseStep = settings.voxelSize * BlockSize * 0.5f / length;
+	const float blockExtent = settings.voxelSize * BlockSize;
+
+	float enter = fineStep;
+	float exit = maxDepth;
+	const float origins[3] = { origin.X, origin.Y, origin.Z };
+	const float directions[3] = { direction.X, direction.Y, direction.Z };
+	const float mins[3] = { boundsMin.X, boundsMin.Y, boundsMin.Z };
+	const float maxs[3] = { boundsMax.X, boundsMax.Y, boundsMax.Z };
+	for (int32 axis = 0; axis < 3; axis++) {
+		if (FMath::Abs(directions[axis]) < 1e-6f) {
+			if ((origins[axis] < mins[axis]) || (origins[axis] > maxs[axis])) {
+				return false;
+			}
+			continue;
+		}
+		const float t0 = (mins[axis] - origins[axis]) / directions[axis];
+		const float t1 = (maxs[axis] - origins[axis]) / directions[axis];
+		enter = FMath::Max(enter, FMath::Min(t0, t1));
+		exit = FMath::Min(exit, FMath::Max(t0, t1));
+	}
+	if (enter >= exit) {
+		return false;
+	}
+
+	float t = enter;
+	float lastStep = 0.0f;
+	float refineUntil = -1.0f;
+	bool bPreviousValid = false;
+	float previousT = 0.0f;
+	float previousDistance = 0.0f;
+
+	while (t < exit) {
+		const FVector p = origin + direction * t;
+
+		float distance;
+		if (SampleDistance(p, distance) == false) {
+			const FIntVector coordinates(FMath::FloorToInt(p.X / blockExtent), FMath::FloorToInt(p.Y / blockExtent), 
+										 FMath::FloorToInt(p.Z / blockExtent));
+			const bool bAllocated = (FindBlock(coordinates) != nullptr);
+			lastStep = (bAllocated || (t < refineUntil)) ? fineStep : coarseStep;
+			bPreviousValid = false;
+			t += lastStep;
+			continue;
+		}
+
+		if (distance < 0.0f) {
+			if (bPreviousValid && (previousDistance >= 0.0f)) {
+				outDepth = previousT + (t - previousT) * previousDistance / (previousDistance - distance);
+				return true;
+			}
+			if ((bPreviousValid == false) && (lastStep > fineStep) && (t > refineUntil)) {
+				refineUntil = t;
+				t += fineStep - lastStep;
+				lastStep = fineStep;
+				continue;
+			}
+		}
+
+		bPreviousValid = true;
+		previousT = t;
+		previousDistance = distance;
+		lastStep = FMath::Max(fineStep, distance * settings.truncation * 0.8f / length);
+		t += lastStep;
+	}
+
+	return false;
+}
+
+void RealSenseFusionVolume::RaycastPreview(const RealSenseCameraIntrinsics& intrinsics, const FMatrix& cameraToWorld, 
+										   uint8* bgra) const
+{
+	const FVector origin = cameraToWorld.GetOrigin();
+	const int32 width = intrinsics.width;
+	const int32 height = intrinsics.height;
+
+	ParallelFor((height + RowsPerTask - 1) / RowsPerTask, [&](int32 task) {
+		const int32 last = FMath::Min((task + 1) * RowsPerTask, height);
+		for (int32 v = task * RowsPerTask; v < last; v++) {
+			for (int32 u = 0; u < width; u++) {
+				const FVector direction = cameraToWorld.TransformVector(
+					FVector(1.0f, (u - intrinsics.cx) / intrinsics.fx, -(v - intrinsics.cy) / intrinsics.fy));
+
+				uint8 shade = 0;
+				float depth;
+				FVector normal;
+				if (CastRay(origin, direction, settings.maxDepth, depth) && SampleNormal(origin + direction * depth, normal)) {
+					const float lambert = FMath::Abs(FVector::DotProduct(normal, direction.GetSafeNormal()));
+					shade = (uint8)(40.0f + 215.0f * lambert);
+				}
+
+				uint8* pixel = bgra + (v * width + u) * 4;
+				pixel[0] = shade;
+				pixel[1] = shade;
+				pixel[2] = shade;
+				pixel[3] = 255;
+			}
+		}
+	});
+}
+
+// The camera orbits a sphere at a fixed distance and height, looking at its
+// center. Depth is rendered exactly and quantized to millimeters like real 
+// depth frames. The evaluation pose lies halfway between the first two frames.
+FFusionBenchmarkResult RealSenseFusionVolume::RunSyntheticBenchmark(const RealSenseFusionSettings& settings, 
+																	int32 frameCount, int32 width, int32 height)
+{
+	const FVector center(0.0f, 0.0f, 0.0f);
+	const float radius = 15.0f;
+	const float orbitRadius = 50.0f;
+	const float orbitHeight = 10.0f;
+	const RealSenseCameraIntrinsics intrinsics = RealSenseCameraIntrinsics::FromFOV(width, height, 60.0f, 45.0f);
+
+	auto OrbitPose = [&](float angle) -> FMatrix {
+		const FVector eye(center.X - orbitRadius * FMath::Cos(angle), center.Y - orbitRadius * FMath::Sin(angle), orbitHeight);
+		const FVector forward = (center - eye).GetSafeNormal();
+		const FVector right = FVector::CrossProduct(FVector(0.0f, 0.0f, 1.0f), forward).GetSafeNormal();
+		const FVector up = FVector::CrossProduct(forward, right);
+		return FMatrix(forward, right, up, eye);
+	};
+
+	auto RayDirection = [&](const FMatrix& pose, int32 u, int32 v) -> FVector {
+		return pose.TransformVector(FVector(1.0f, (u - intrinsics.cx) / intrinsics.fx, -(v - intrinsics.cy) / intrinsics.fy));
+	};
+
+	// Returns the camera depth (cm) of the sphere along the ray, or 0
+	auto IntersectSphere = [&](const FVector& origin, const FVector& direction) -> float {
+		const FVector offset = origin - center;
+		const float a = FVector::DotProduct(direction, direction);
+		const float b = 2.0f * FVector::DotProduct(offset, direction);
+		const float c = FVector::DotProduct(offset, offset) - radius * radius;
+		const float discriminant = b * b - 4.0f * a * c;
+		if (discriminant < 0.0f) {
+			return 0.0f;
+		}
+		const float t = (-b - FMath::Sqrt(discriminant)) / (2.0f * a);
+		return FMath::Max(t, 0.0f);
+	};
+
+	RealSenseFusionVolume volume;
+	volume.Configure(settings);
+
+	TArray<uint16> depth;
+	depth.SetNumUninitialized(width * height);
+	double integrationSeconds = 0.0;
+	frameCount = FMath::Max(frameCount, 1);
+
+	for (int32 frame = 0; frame < frameCount; frame++) {
+		const FMatrix pose = OrbitPose(2.0f * PI * frame / frameCount);
+		const FVector origin = pose.GetOrigin();
+		for (int32 v = 0; v < height; v++) {
+			for (int32 u = 0; u < width; u++) {
+				depth[v * width + u] = (uint16)FMath::RoundToInt(IntersectSphere(origin, RayDirection(pose, u, v)) * 10.0f);
+			}
+		}
+
+		const double start = FPlatformTime::Seconds();
+		volume.Integrate(depth.GetData(), intrinsics, pose);
+		integrationSeconds += FPlatformTime::Seconds() - start;
+	}
+
+	const FMatrix evaluationPose = OrbitPose(PI / frameCount);
+	const FVector origin = evaluationPose.GetOrigin();
+	TArray<double> rowError;
+	TArray<int32> rowHits;
+	TArray<int32> rowExpected;
+	rowError.SetNumZeroed(height);
+	rowHits.SetNumZeroed(height);
+	rowExpected.SetNumZeroed(height);
+
+	const double raycastStart = FPlatformTime::Seconds();
+	ParallelFor(height, [&](int32 v) {
+		for (int32 u = 0; u < width; u++) {
+			const FVector direction = RayDirection(evaluationPose, u, v);
+			if (IntersectSphere(origin, direction) > 0.0f) {
+				rowExpected[v]++;
+			}
+
+			float hitDepth;
+			if (volume.CastRay(origin, direction, settings.maxDepth, hitDepth)) {
+				const float error = (origin + direction * hitDepth - center).Size() - radius;
+				rowError[v] += error * error;
+				rowHits[v]++;
+			}
+		}
+	});
+	const double raycastSeconds = FPlatformTime::Seconds() - raycastStart;
+
+	double squaredError = 0.0;
+	int32 hits = 0;
+	int32 expected = 0;
+	for (int32 v = 0; v < height; v++) {
+		squaredError += rowError[v];
+		hits += rowHits[v];
+		expected += rowExpected[v];
+	}
+
+	FFusionBenchmarkResult result;
+	result.AverageIntegrationMs = (float)(integrationSeconds * 1000.0 / frameCount);
+	result.RaycastMs = (float)(raycastSeconds * 1000.0);
+	result.SurfaceRMSError = (hits > 0) ? (float)FMath::Sqrt(squaredError / hits) : 0.0f;
+	result.Coverage = (expected > 0) ? (float)hits / expected : 0.0f;
+	result.BlockCount = volume.GetBlockCount();
+	result.MemoryKB = (int32)(volume.GetAllocatedSize() / 1024);
+	return result;
+}
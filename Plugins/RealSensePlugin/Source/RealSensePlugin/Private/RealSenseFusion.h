@@ -0,0 +1,139 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+
+// Pinhole model of a depth camera in Unreal camera space (X forward, Y right,
+// Z up): a point P projects to pixel (cx + fx * P.Y / P.X, cy - fy * P.Z / P.X).
+struct RealSenseCameraIntrinsics {
+	int32 width;
+	int32 height;
+	float fx;
+	float fy;
+	float cx;
+	float cy;
+
+	// Builds the intrinsics of an image with the given fields of view (degrees)
+	// and the principal point at its center.
+	static RealSenseCameraIntrinsics FromFOV(int32 width, int32 height, float horizontalFOV, float verticalFOV);
+};
+
+// Tuning parameters of the fusion volume. Distances are in Unreal units (cm).
+struct RealSenseFusionSettings {
+	float voxelSize;  // Edge length of a voxel
+	float truncation;  // Distance from the surface beyond which the signed distance is clamped
+	float maxDepth;  // Depth values beyond this distance are ignored
+	int32 maxWeight;  // Cap on the number of frames averaged per voxel, so the volume keeps adapting
+
+	RealSenseFusionSettings() : voxelSize(0.5f), truncation(2.0f), maxDepth(150.0f), maxWeight(64) {}
+};
+
+// Truncated signed distance field (TSDF) built from depth frames and camera
+// poses, independent of the RealSense middleware.
+//
+// Space is split into blocks of 8x8x8 voxels that are only allocated where 
+// depth samples land, and found through a hash map of block coordinates, so
+// memory follows the observed surface rather than the bounding volume. Each 
+// voxel stores the signed distance to the nearest surface along the view 
+// ray, normalized by the truncation distance, and the number of frames 
+// averaged into it.
+//
+// Integrate() first allocates the blocks around every depth sample, then 
+// updates the voxels of those blocks in parallel. RaycastPreview() renders 
+// the zero crossing of the field from any pose, in parallel over rows.
+class RealSenseFusionVolume {
+public:
+	static const int32 BlockSize = 8;
+	static const int32 BlockVoxels = BlockSize * BlockSize * BlockSize;
+
+	struct Voxel {
+		int16 distance;  // Normalized signed distance scaled to [-32767, 32767]
+		uint16 weight;  // Number of frames averaged, 0 if never observed
+	};
+
+	struct Block {
+		Voxel voxels[BlockVoxels];  // Indexed by (z * BlockSize + y) * BlockSize + x
+	};
+
+	RealSenseFusionVolume();
+
+	// Applies new settings and clears the volume.
+	void Configure(const RealSenseFusionSettings& settings);
+
+	inline const RealSenseFusionSettings& GetSettings() const { return settings; }
+
+	// Frees every block.
+	void Reset();
+
+	// Fuses a depth frame (mm) taken by a camera with the given intrinsics 
+	// and camera-to-world transform into the volume.
+	void Integrate(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics, const FMatrix& cameraToWorld);
+
+	// Renders the fused surface as seen from the given camera into a BGRA 
+	// image of intrinsics.width x intrinsics.height, shaded by its normals.
+	void RaycastPreview(const RealSenseCameraIntrinsics& intrinsics, const FMatrix& cameraToWorld, uint8* bgra) const;
+
+	// Trilinearly interpolates the normalized signed distance at a world 
+	// position. Returns false if any of the surrounding voxels was never observed.
+	bool SampleDistance(const FVector& position, float& outDistance) const;
+
+	inline int32 GetBlockCount() const { return blocks.Num(); }
+
+	inline const FIntVector& GetBlockCoordinates(int32 index) const { return blockCoordinates[index]; }
+
+	inline const Block& GetBlock(int32 index) const { return blocks[index]; }
+
+	// Returns the block with the given block coordinates, or nullptr.
+	const Block* FindBlock(const FIntVector& coordinates) const;
+
+	// Returns the memory used by the blocks and the hash map, in bytes.
+	SIZE_T GetAllocatedSize() const;
+
+	// Fuses a synthetic sequence of a sphere seen from a camera orbiting 
+	// around it, then raycasts it from an unseen pose and compares the 
+	// surface against the exact sphere. Used to validate the volume and 
+	// measure its cost on the current machine.
+	static FFusionBenchmarkResult RunSyntheticBenchmark(const RealSenseFusionSettings& settings, int32 frameCount, 
+														int32 width, int32 height);
+
+private:
+	RealSenseFusionSettings settings;
+
+	TMap<FIntVector, int32> blockLookup;
+	TArray<FIntVector> blockCoordinates;
+	TArray<Block> blocks;
+
+	// Blocks touched by the frame being integrated
+	TArray<int32> visibleBlocks;
+
+	// Bounds of the allocated blocks in world space, used to clip rays
+	FVector boundsMin;
+	FVector boundsMax;
+
+	// Returns the voxel at the given global voxel coordinates, or nullptr if 
+	// its block is not allocated.
+	const Voxel* FindVoxel(int32 x, int32 y, int32 z) const;
+
+	// Marches along a ray from origin (direction scaled so that t is the 
+	// camera depth) and returns the depth of the first crossing from the 
+	// front to the back of a surface.
+	bool CastRay(const FVector& origin, const FVector& direction, float maxDepth, float& outDepth) const;
+
+	// Returns the normalized gradient of the distance field, or false if it
+	// cannot be estimated at that position.
+	bool SampleNormal(const FVector& position, FVector& outNormal) const;
+};
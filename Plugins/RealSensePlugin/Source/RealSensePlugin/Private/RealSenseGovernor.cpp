@@ -0,0 +1,160 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseGovernor.h"
+#include "RealSenseUtils.h"
+
+// Seconds between two evaluations of the stage rates
+static const double EvaluationPeriod = 0.25;
+
+// Weight of the newest sample in the smoothed stage costs and frame time
+static const float CostSmoothing = 0.1f;
+
+const TCHAR* GetRealSenseStageName(RealSenseStage stage)
+{
+	switch (stage) {
+	case RealSenseStage::FACE_TRACKING:
+		return TEXT("Face Tracking");
+	case RealSenseStage::SEGMENTATION:
+		return TEXT("Segmentation");
+	case RealSenseStage::SCAN_PREVIEW:
+		return TEXT("Scan Preview");
+	case RealSenseStage::OCCUPANCY_GRID:
+		return TEXT("Occupancy Grid");
+	case RealSenseStage::BLOB_TRACKING:
+		return TEXT("Blob Tracking");
+	case RealSenseStage::PLANE_DETECTION:
+		return TEXT("Plane Detection");
+	case RealSenseStage::DEPTH_BACKGROUND:
+		return TEXT("Depth Background");
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+RealSenseGovernor::RealSenseGovernor()
+{
+	for (int32 i = 0; i < NumStages; i++) {
+		intervals[i] = 1;
+		costs[i] = 0.0f;
+	}
+	gameFrameMs = 0.0f;
+	lastEvaluation = 0.0;
+}
+
+// Disabling the governor restores the full rate of every stage.
+void RealSenseGovernor::Configure(const RealSenseGovernorSettings& newSettings)
+{
+	std::unique_lock<std::mutex> lock(settingsMutex);
+	settings = newSettings;
+	settings.maxInterval = (int32)FMath::RoundUpToPowerOfTwo((uint32)FMath::Max(settings.maxInterval, 1));
+
+	if (settings.bEnabled == false) {
+		for (int32 i = 0; i < NumStages; i++) {
+			intervals[i] = 1;
+		}
+	}
+}
+
+void RealSenseGovernor::SetGameFrameTime(float ms)
+{
+	const float previous = gameFrameMs;
+	gameFrameMs = (previous == 0.0f) ? ms : previous + CostSmoothing * (ms - previous);
+}
+
+bool RealSenseGovernor::ShouldRun(RealSenseStage stage, uint64 frameNumber) const
+{
+	const int32 interval = intervals[(int32)stage];
+	return (frameNumber & (interval - 1)) == 0;
+}
+
+void RealSenseGovernor::RecordStageCost(RealSenseStage stage, double ms)
+{
+	std::atomic<float>& cost = costs[(int32)stage];
+	const float previous = cost;
+	cost = (previous == 0.0f) ? (float)ms : previous + CostSmoothing * ((float)ms - previous);
+}
+
+float RealSenseGovernor::GetTotalCost() const
+{
+	float total = 0.0f;
+	for (int32 i = 0; i < NumStages; i++) {
+		total += costs[i] / intervals[i];
+	}
+	return total;
+}
+
+// Changes at most one stage per evaluation, so that the effect of a change is
+// visible in the measurements before the next decision is made.
+void RealSenseGovernor::Update(double now)
+{
+	if (now - lastEvaluation < EvaluationPeriod) {
+		return;
+	}
+	lastEvaluation = now;
+
+	RealSenseGovernorSettings current;
+	{
+		std::unique_lock<std::mutex> lock(settingsMutex);
+		current = settings;
+	}
+	if (current.bEnabled == false) {
+		return;
+	}
+
+	const float frameMs = gameFrameMs;
+	const float totalCost = GetTotalCost();
+	const bool bOverBudget = (frameMs > current.targetFrameMs * 1.05f) || (totalCost > current.stageBudgetMs);
+	const bool bHasHeadroom = (frameMs < current.targetFrameMs * 0.85f) && (totalCost < current.stageBudgetMs * 0.7f);
+
+	if (bOverBudget) {
+		int32 slowest = -1;
+		float slowestCost = 0.0f;
+		for (int32 i = 0; i < NumStages; i++) {
+			const float perFrame = costs[i] / intervals[i];
+			if ((intervals[i] < current.maxInterval) && (perFrame > slowestCost)) {
+				slowest = i;
+				slowestCost = perFrame;
+			}
+		}
+
+		if (slowest >= 0) {
+			intervals[slowest] = intervals[slowest] * 2;
+			RS_LOG(Log, "Governor: running %s every %d frames (game %.1f ms, stages %.1f ms)", 
+				   GetRealSenseStageName((RealSenseStage)slowest), (int32)intervals[slowest], frameMs, totalCost)
+		}
+	}
+	else if (bHasHeadroom) {
+		// Restores the most reduced stage whose extra cost still fits the budget
+		int32 restore = -1;
+		for (int32 i = 0; i < NumStages; i++) {
+			if (intervals[i] <= 1) {
+				continue;
+			}
+			const float extraCost = costs[i] / intervals[i];
+			if ((totalCost + extraCost < current.stageBudgetMs) && 
+				((restore < 0) || (intervals[i] > intervals[restore]))) {
+				restore = i;
+			}
+		}
+
+		if (restore >= 0) {
+			intervals[restore] = intervals[restore] / 2;
+			RS_LOG(Log, "Governor: running %s every %d frames (game %.1f ms, stages %.1f ms)", 
+				   GetRealSenseStageName((RealSenseStage)restore), (int32)intervals[restore], frameMs, totalCost)
+		}
+	}
+}
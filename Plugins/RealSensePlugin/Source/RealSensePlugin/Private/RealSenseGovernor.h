@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "AllowWindowsPlatformTypes.h"
+#include <atomic>
+#include <mutex>
+#include "HideWindowsPlatformTypes.h"
+
+#include "CoreMisc.h"
+
+// Optional stages of the camera processing thread that the governor may run
+// at a reduced rate.
+enum class RealSenseStage : uint8 {
+	FACE_TRACKING = 0,
+	SEGMENTATION,
+	SCAN_PREVIEW,
+	OCCUPANCY_GRID,
+	BLOB_TRACKING,
+	PLANE_DETECTION,
+	DEPTH_BACKGROUND,
+	NUM_STAGES
+};
+
+struct RealSenseGovernorSettings {
+	bool bEnabled;
+	float targetFrameMs;  // Game frame time (ms) the governor tries to stay under
+	float stageBudgetMs;  // CPU time (ms) per camera frame allowed for the optional stages
+	int32 maxInterval;  // Lowest rate for a stage: once every maxInterval frames
+
+	RealSenseGovernorSettings() : bEnabled(false), targetFrameMs(16.6f), stageBudgetMs(8.0f), maxInterval(8) {}
+};
+
+// Adapts how often the optional camera stages run so that the camera 
+// processing thread stays within a CPU budget and backs off while the game 
+// thread is over its frame time target.
+//
+// Every stage runs once every N camera frames, where N is a power of two. 
+// The camera thread records the cost of each stage when it runs. A few times
+// per second the governor halves the rate of the stage with the highest 
+// per-frame cost while over budget, and doubles the rate of the slowest stage
+// again once there is enough headroom to afford it.
+class RealSenseGovernor {
+public:
+	RealSenseGovernor();
+
+	// Thread-safe. Applied at the next evaluation.
+	void Configure(const RealSenseGovernorSettings& settings);
+
+	// Thread-safe. Called by the game thread with its latest frame time.
+	void SetGameFrameTime(float ms);
+
+	// Returns true if the stage should run on the given camera frame.
+	bool ShouldRun(RealSenseStage stage, uint64 frameNumber) const;
+
+	// Records the CPU time (ms) of a stage that ran on the camera thread.
+	void RecordStageCost(RealSenseStage stage, double ms);
+
+	// Re-evaluates the stage rates if enough time has passed since the last 
+	// evaluation. Called once per camera frame.
+	void Update(double now);
+
+	// The following getters can be called from any thread.
+
+	inline int32 GetInterval(RealSenseStage stage) const { return intervals[(int32)stage]; }
+
+	inline float GetStageCost(RealSenseStage stage) const { return costs[(int32)stage]; }
+
+	// Returns the per-frame cost (ms) of the optional stages at their current rates.
+	float GetTotalCost() const;
+
+	inline float GetGameFrameTime() const { return gameFrameMs; }
+
+private:
+	static const int32 NumStages = (int32)RealSenseStage::NUM_STAGES;
+
+	RealSenseGovernorSettings settings;
+	mutable std::mutex settingsMutex;
+
+	std::atomic<int32> intervals[NumStages];
+	std::atomic<float> costs[NumStages];  // Smoothed cost (ms) of one run of each stage
+	std::atomic<float> gameFrameMs;
+
+	double lastEvaluation;
+};
+
+// Returns a readable name for the stage, for logging.
+const TCHAR* GetRealSenseStageName(RealSenseStage stage);
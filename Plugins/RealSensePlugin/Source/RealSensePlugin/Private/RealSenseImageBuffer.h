@@ -0,0 +1,88 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "CoreMisc.h"
+
+// Fixed-capacity image storage used by RealSenseDataFrame.
+//
+// The storage is allocated once, 64-byte aligned, for the largest image the 
+// buffer is expected to hold. Changing the image dimensions afterwards only 
+// updates the view (width, height, channels) and never reallocates or clears 
+// the storage, so switching stream profiles at runtime is free. If an image 
+// larger than the reserved capacity is requested, the storage grows once.
+template <typename T>
+class RealSenseImageBuffer {
+public:
+	static const uint32 Alignment = 64;
+
+	RealSenseImageBuffer() : data(nullptr), capacity(0), width(0), height(0), channels(1) {}
+
+	~RealSenseImageBuffer() { FMemory::Free(data); }
+
+	// Ensures that the storage can hold at least numElements elements. 
+	// Newly allocated storage is zeroed once.
+	void Reserve(int32 numElements)
+	{
+		if (numElements <= capacity) {
+			return;
+		}
+		FMemory::Free(data);
+		data = static_cast<T*>(FMemory::Malloc(numElements * sizeof(T), Alignment));
+		FMemory::Memzero(data, numElements * sizeof(T));
+		capacity = numElements;
+	}
+
+	// Sets the dimensions of the image view. The contents are undefined 
+	// afterwards: growing past the capacity replaces the storage with zeroed 
+	// memory, and a smaller view reinterprets the old pixels.
+	void SetDimensions(int32 newWidth, int32 newHeight, int32 newChannels = 1)
+	{
+		Reserve(newWidth * newHeight * newChannels);
+		width = newWidth;
+		height = newHeight;
+		channels = newChannels;
+	}
+
+	inline T* GetData() { return data; }
+
+	inline const T* GetData() const { return data; }
+
+	// Number of elements in the current view.
+	inline int32 Num() const { return width * height * channels; }
+
+	inline int32 GetCapacity() const { return capacity; }
+
+	inline int32 GetWidth() const { return width; }
+
+	inline int32 GetHeight() const { return height; }
+
+	inline int32 GetChannels() const { return channels; }
+
+	inline T& operator[](int32 index) { return data[index]; }
+
+	inline const T& operator[](int32 index) const { return data[index]; }
+
+private:
+	T* data;
+	int32 capacity;
+	int32 width;
+	int32 height;
+	int32 channels;
+
+	RealSenseImageBuffer(const RealSenseImageBuffer&) = delete;
+	RealSenseImageBuffer& operator=(const RealSenseImageBuffer&) = delete;
+};
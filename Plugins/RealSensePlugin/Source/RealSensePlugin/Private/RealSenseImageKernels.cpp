@@ -0,0 +1,547 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseImageKernels.h"
+
+#if RS_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+void RealSenseDepthStatistics::Reset()
+{
+	nearest = 0xFFFF;
+	sum = 0;
+	validCount = 0;
+	totalCount = 0;
+	FMemory::Memzero(histogram, sizeof(histogram));
+}
+
+FDepthStatistics RealSenseDepthStatistics::ToBlueprint() const
+{
+	FDepthStatistics result;
+	result.NearestDepth = (validCount > 0) ? nearest : 0;
+	result.MeanDepth = (validCount > 0) ? (float)((double)sum / validCount) : 0.0f;
+	result.ValidPixelRatio = (totalCount > 0) ? (float)validCount / totalCount : 0.0f;
+	result.HistogramBinSize = 1 << HistogramBinShift;
+	result.Histogram.SetNumUninitialized(NumHistogramBins);
+	for (int32 i = 0; i < NumHistogramBins; i++) {
+		result.Histogram[i] = histogram[i];
+	}
+	return result;
+}
+
+// The minimum, sum and valid count are computed eight pixels at a time. SSE2 
+// has no unsigned 16-bit minimum, so values are biased by 0x8000 and compared
+// as signed integers; zero (invalid) pixels are first forced to 0xFFFF so 
+// they never win. Histogram bins are computed with a vector shift and then 
+// counted from a small stack buffer while the pixels are still in L1.
+void AccumulateDepthStatistics(const uint16* depth, int32 count, RealSenseDepthStatistics& stats)
+{
+	const int32 lastBin = RealSenseDepthStatistics::NumHistogramBins - 1;
+	uint32 invalidCount = 0;
+	int32 i = 0;
+
+#if RS_SIMD_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16((short)0x8000);
+	const __m128i maxBin = _mm_set1_epi16((short)lastBin);
+	__m128i vmin = _mm_set1_epi16((short)0x7FFF);
+
+	// 32-bit lane sums and 16-bit lane counters are flushed every chunk so that
+	// they can never overflow.
+	const int32 chunkSize = 8 * 4096;
+	while (i + 8 <= count) {
+		const int32 chunkEnd = FMath::Min(count, i + chunkSize);
+		__m128i vsum = zero;
+		__m128i vinvalid = zero;
+
+		for (; i + 8 <= chunkEnd; i += 8) {
+			const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + i));
+			const __m128i isZero = _mm_cmpeq_epi16(d, zero);
+
+			vmin = _mm_min_epi16(vmin, _mm_xor_si128(_mm_or_si128(d, isZero), bias));
+			vsum = _mm_add_epi32(vsum, _mm_unpacklo_epi16(d, zero));
+			vsum = _mm_add_epi32(vsum, _mm_unpackhi_epi16(d, zero));
+			vinvalid = _mm_sub_epi16(vinvalid, isZero);
+
+			// d >> shift fits in a positive signed lane, clamped to the last bin
+			const __m128i bins = _mm_min_epi16(_mm_srli_epi16(d, RealSenseDepthStatistics::HistogramBinShift), maxBin);
+			alignas(16) uint16 binIndex[8];
+			_mm_store_si128(reinterpret_cast<__m128i*>(binIndex), bins);
+			for (int32 k = 0; k < 8; k++) {
+				stats.histogram[binIndex[k]]++;
+			}
+		}
+
+		alignas(16) uint32 sums[4];
+		alignas(16) uint16 invalids[8];
+		_mm_store_si128(reinterpret_cast<__m128i*>(sums), vsum);
+		_mm_store_si128(reinterpret_cast<__m128i*>(invalids), vinvalid);
+		stats.sum += (uint64)sums[0] + sums[1] + sums[2] + sums[3];
+		for (int32 k = 0; k < 8; k++) {
+			invalidCount += invalids[k];
+		}
+	}
+
+	alignas(16) uint16 mins[8];
+	_mm_store_si128(reinterpret_cast<__m128i*>(mins), _mm_xor_si128(vmin, bias));
+	for (int32 k = 0; k < 8; k++) {
+		stats.nearest = FMath::Min(stats.nearest, mins[k]);
+	}
+#endif
+
+	for (; i < count; i++) {
+		const uint16 d = depth[i];
+		if (d == 0) {
+			invalidCount++;
+		}
+		else if (d < stats.nearest) {
+			stats.nearest = d;
+		}
+		stats.sum += d;
+		stats.histogram[FMath::Min(d >> RealSenseDepthStatistics::HistogramBinShift, lastBin)]++;
+	}
+
+	// Invalid pixels were counted in the first bin; take them back out.
+	stats.histogram[0] -= invalidCount;
+	stats.validCount += count - invalidCount;
+	stats.totalCount += count;
+}
+
+// The running row sum makes each row inherently sequential, so this kernel 
+// has no SIMD path. It touches each pixel once and the previous table row is
+// still in cache when the next one is built.
+void BuildDepthSummedAreaTable(const uint16* depth, int32 width, int32 height, uint64* sums, uint32* counts)
+{
+	const int32 stride = width + 1;
+	FMemory::Memzero(sums, stride * sizeof(uint64));
+	FMemory::Memzero(counts, stride * sizeof(uint32));
+
+	for (int32 y = 0; y < height; y++) {
+		const uint16* row = depth + y * width;
+		const uint64* prevSums = sums + y * stride;
+		const uint32* prevCounts = counts + y * stride;
+		uint64* rowSums = sums + (y + 1) * stride;
+		uint32* rowCounts = counts + (y + 1) * stride;
+
+		uint64 rowSum = 0;
+		uint32 rowCount = 0;
+		rowSums[0] = 0;
+		rowCounts[0] = 0;
+		for (int32 x = 0; x < width; x++) {
+			rowSum += row[x];
+			rowCount += (row[x] != 0);
+			rowSums[x + 1] = prevSums[x + 1] + rowSum;
+			rowCounts[x + 1] = prevCounts[x + 1] + rowCount;
+		}
+	}
+}
+
+// Sixteen pixels per iteration: the alpha bytes are shifted down to the 
+// bottom of each 32-bit lane and narrowed twice with saturating packs, which
+// cannot saturate since every value is below 256.
+void ExtractAlphaMask(const uint8* bgra, int32 count, uint8* mask)
+{
+	int32 i = 0;
+
+#if RS_SIMD_SSE2
+	for (; i + 16 <= count; i += 16) {
+		const __m128i* src = reinterpret_cast<const __m128i*>(bgra + i * 4);
+		const __m128i a0 = _mm_srli_epi32(_mm_loadu_si128(src + 0), 24);
+		const __m128i a1 = _mm_srli_epi32(_mm_loadu_si128(src + 1), 24);
+		const __m128i a2 = _mm_srli_epi32(_mm_loadu_si128(src + 2), 24);
+		const __m128i a3 = _mm_srli_epi32(_mm_loadu_si128(src + 3), 24);
+		const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(mask + i), packed);
+	}
+#endif
+
+	for (; i < count; i++) {
+		mask[i] = bgra[i * 4 + 3];
+	}
+}
+
+void InsertAlphaMask(const uint8* mask, int32 count, uint8* bgra)
+{
+	int32 i = 0;
+
+#if RS_SIMD_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i colorBits = _mm_set1_epi32(0x00FFFFFF);
+	for (; i + 16 <= count; i += 16) {
+		__m128i* dst = reinterpret_cast<__m128i*>(bgra + i * 4);
+		const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + i));
+		const __m128i lo = _mm_unpacklo_epi8(zero, m);
+		const __m128i hi = _mm_unpackhi_epi8(zero, m);
+		const __m128i alpha[4] = { _mm_unpacklo_epi16(zero, lo), _mm_unpackhi_epi16(zero, lo), 
+								   _mm_unpacklo_epi16(zero, hi), _mm_unpackhi_epi16(zero, hi) };
+		for (int32 j = 0; j < 4; j++) {
+			const __m128i color = _mm_and_si128(_mm_loadu_si128(dst + j), colorBits);
+			_mm_storeu_si128(dst + j, _mm_or_si128(color, alpha[j]));
+		}
+	}
+#endif
+
+	for (; i < count; i++) {
+		bgra[i * 4 + 3] = mask[i];
+	}
+}
+
+static inline uint8 BlendChannel(uint32 f, uint32 b, uint32 m)
+{
+	// Exact rounded division by 255 of values below 65536
+	const uint32 t = f * m + b * (255 - m) + 128;
+	return (uint8)((t + (t >> 8)) >> 8);
+}
+
+#if RS_SIMD_SSE2
+// Blends four BGRA pixels with the coverage of four mask bytes, using the 
+// same exact division by 255 as BlendChannel in 16-bit lanes.
+static inline __m128i BlendPixels4(__m128i fg, __m128i bg, const uint8* mask)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi16(255);
+	const __m128i half = _mm_set1_epi16(128);
+
+	int32 coverage;
+	FMemory::Memcpy(&coverage, mask, sizeof(coverage));
+	__m128i m = _mm_cvtsi32_si128(coverage);
+	m = _mm_unpacklo_epi8(m, m);
+	m = _mm_unpacklo_epi16(m, m);  // Each mask byte repeated for the 4 channels of its pixel
+
+	const __m128i mLo = _mm_unpacklo_epi8(m, zero);
+	const __m128i mHi = _mm_unpackhi_epi8(m, zero);
+
+	__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(fg, zero), mLo),
+							   _mm_mullo_epi16(_mm_unpacklo_epi8(bg, zero), _mm_sub_epi16(full, mLo)));
+	__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(fg, zero), mHi),
+							   _mm_mullo_epi16(_mm_unpackhi_epi8(bg, zero), _mm_sub_epi16(full, mHi)));
+	lo = _mm_add_epi16(lo, half);
+	hi = _mm_add_epi16(hi, half);
+	lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+	hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+	return _mm_packus_epi16(lo, hi);
+}
+#endif
+
+void CompositeOverImage(const uint8* foreground, const uint8* mask, const uint8* background, int32 count, uint8* out)
+{
+	int32 i = 0;
+
+#if RS_SIMD_SSE2
+	const __m128i opaque = _mm_set1_epi32(0xFF000000);
+	for (; i + 4 <= count; i += 4) {
+		const __m128i fg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(foreground + i * 4));
+		const __m128i bg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(background + i * 4));
+		const __m128i blended = _mm_or_si128(BlendPixels4(fg, bg, mask + i), opaque);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), blended);
+	}
+#endif
+
+	for (; i < count; i++) {
+		for (int32 c = 0; c < 3; c++) {
+			out[i * 4 + c] = BlendChannel(foreground[i * 4 + c], background[i * 4 + c], mask[i]);
+		}
+		out[i * 4 + 3] = 0xFF;
+	}
+}
+
+void CompositeOverColor(const uint8* foreground, const uint8* mask, uint32 background, int32 count, uint8* out)
+{
+	int32 i = 0;
+
+#if RS_SIMD_SSE2
+	const __m128i opaque = _mm_set1_epi32(0xFF000000);
+	const __m128i bg = _mm_set1_epi32((int)background);
+	for (; i + 4 <= count; i += 4) {
+		const __m128i fg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(foreground + i * 4));
+		const __m128i blended = _mm_or_si128(BlendPixels4(fg, bg, mask + i), opaque);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 4), blended);
+	}
+#endif
+
+	for (; i < count; i++) {
+		for (int32 c = 0; c < 3; c++) {
+			out[i * 4 + c] = BlendChannel(foreground[i * 4 + c], (background >> (c * 8)) & 0xFF, mask[i]);
+		}
+		out[i * 4 + 3] = 0xFF;
+	}
+}
+
+// The sign bit of each mask byte is exactly the "at least 128" test, so 
+// _mm_movemask_epi8 classifies sixteen pixels at once and uniform blocks, 
+// which make up most of a mask, extend the current run in one step.
+void EncodeMaskRuns(const uint8* mask, int32 count, TArray<int32>& runs)
+{
+	runs.Reset();
+
+	bool bForeground = false;
+	int32 run = 0;
+	int32 i = 0;
+
+	while (i < count) {
+#if RS_SIMD_SSE2
+		if (i + 16 <= count) {
+			const int bits = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + i)));
+			if (bits == (bForeground ? 0xFFFF : 0)) {
+				run += 16;
+				i += 16;
+				continue;
+			}
+		}
+#endif
+		const bool bPixel = (mask[i] >= 128);
+		if (bPixel != bForeground) {
+			runs.Add(run);
+			run = 0;
+			bForeground = bPixel;
+		}
+		run++;
+		i++;
+	}
+
+	runs.Add(run);
+}
+
+void DecodeMaskRuns(const TArray<int32>& runs, int32 count, uint8* mask)
+{
+	int32 i = 0;
+	for (int32 r = 0; (r < runs.Num()) && (i < count); r++) {
+		const int32 length = FMath::Min(runs[r], count - i);
+		FMemory::Memset(mask + i, (r & 1) ? 0xFF : 0x00, length);
+		i += length;
+	}
+	if (i < count) {
+		FMemory::Memzero(mask + i, count - i);
+	}
+}
+
+#if RS_SIMD_SSE2
+// Unsigned 16-bit minimum, which SSE2 lacks
+static inline __m128i MinU16(__m128i a, __m128i b)
+{
+	return _mm_sub_epi16(a, _mm_subs_epu16(a, b));
+}
+#endif
+
+// The background moves toward the depth by at most the step of the pixel, 
+// and the deviation toward the distance between them by 1 mm, only where 
+// the pixel is background. Pixels whose background was never observed are
+// foreground outside of learning. They count in their deviation the frames 
+// in a row that their depth stays within minBand of their candidate, and 
+// start over from the new depth on a jump or an invalid depth, so that only
+// a depth held for unobservedFrames becomes their background.
+//
+// Everything is done with saturating unsigned 16-bit arithmetic, eight 
+// pixels at a time: subs_epu16(a, b) is max(a - b, 0), so the positive and
+// negative parts of d - bg come from two subtractions.
+void UpdateDepthBackground(const uint16* depth, int32 count, const RealSenseBackgroundRates& rates, 
+						   uint16* background, uint16* deviation, uint16* candidate, uint8* foreground)
+{
+	// Keeps deviation * bandScale within a signed 16-bit lane
+	const uint16 maxDeviation = 4095;
+	const uint16 bandScale = FMath::Min<uint16>(rates.bandScale, 8);
+	int32 i = 0;
+
+#if RS_SIMD_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i minBand = _mm_set1_epi16((short)FMath::Min<uint16>(rates.minBand, 0x7FFF));
+	const __m128i scale = _mm_set1_epi16((short)bandScale);
+	const __m128i deviationCap = _mm_set1_epi16((short)maxDeviation);
+	const __m128i backgroundStep = _mm_set1_epi16((short)rates.backgroundStep);
+	const __m128i foregroundStep = _mm_set1_epi16((short)rates.foregroundStep);
+	const __m128i learning = rates.bLearning ? _mm_set1_epi16(-1) : zero;
+	const __m128i unobservedFrames = _mm_set1_epi16((short)rates.unobservedFrames);
+	const __m128i absorbing = (rates.unobservedFrames > 0) ? _mm_set1_epi16(-1) : zero;
+
+	for (; i + 8 <= count; i += 8) {
+		const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(depth + i));
+		__m128i bg = _mm_loadu_si128(reinterpret_cast<const __m128i*>(background + i));
+		__m128i dev = _mm_loadu_si128(reinterpret_cast<const __m128i*>(deviation + i));
+		__m128i cand = _mm_loadu_si128(reinterpret_cast<const __m128i*>(candidate + i));
+
+		const __m128i invalid = _mm_cmpeq_epi16(d, zero);
+		const __m128i unknown = _mm_cmpeq_epi16(bg, zero);
+		const __m128i up = _mm_subs_epu16(d, bg);
+		const __m128i down = _mm_subs_epu16(bg, d);
+		const __m128i band = _mm_max_epi16(minBand, _mm_mullo_epi16(_mm_min_epi16(dev, deviationCap), scale));
+
+		const __m128i closer = _mm_xor_si128(_mm_cmpeq_epi16(_mm_subs_epu16(down, band), zero), _mm_set1_epi16(-1));
+		const __m128i isForeground = _mm_andnot_si128(_mm_or_si128(invalid, learning), _mm_or_si128(closer, unknown));
+
+		// Unobserved pixels with a valid depth outside of learning, whether 
+		// the depth stayed near their candidate, and those of them that held
+		// it for unobservedFrames frames
+		const __m128i counting = _mm_and_si128(isForeground, unknown);
+		const __m128i jump = _mm_or_si128(_mm_subs_epu16(d, cand), _mm_subs_epu16(cand, d));
+		const __m128i stable = _mm_andnot_si128(_mm_cmpeq_epi16(cand, zero), 
+												_mm_cmpeq_epi16(_mm_subs_epu16(jump, minBand), zero));
+		const __m128i count = _mm_or_si128(_mm_and_si128(stable, _mm_adds_epu16(dev, one)), _mm_andnot_si128(stable, one));
+		const __m128i absorb = _mm_and_si128(_mm_and_si128(counting, absorbing), 
+											 _mm_cmpeq_epi16(_mm_subs_epu16(unobservedFrames, count), zero));
+		const __m128i holding = _mm_andnot_si128(absorb, counting);
+		cand = _mm_and_si128(holding, _mm_or_si128(_mm_and_si128(stable, cand), _mm_andnot_si128(stable, d)));
+
+		// Per-pixel step: unlimited while learning or absorbing, none where invalid
+		__m128i step = _mm_or_si128(_mm_and_si128(isForeground, _mm_andnot_si128(unknown, foregroundStep)), 
+									_mm_andnot_si128(isForeground, backgroundStep));
+		step = _mm_andnot_si128(invalid, _mm_or_si128(_mm_or_si128(step, learning), absorb));
+		bg = _mm_sub_epi16(_mm_add_epi16(bg, MinU16(up, step)), MinU16(down, step));
+
+		const __m128i distance = _mm_or_si128(up, down);
+		const __m128i devStep = _mm_andnot_si128(_mm_or_si128(isForeground, invalid), one);
+		dev = _mm_sub_epi16(_mm_add_epi16(dev, MinU16(_mm_subs_epu16(distance, dev), devStep)), 
+							MinU16(_mm_subs_epu16(dev, distance), devStep));
+		dev = _mm_andnot_si128(_mm_and_si128(unknown, invalid), dev);
+		dev = _mm_or_si128(_mm_andnot_si128(counting, dev), _mm_and_si128(holding, count));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(background + i), bg);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(deviation + i), dev);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(candidate + i), cand);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(foreground + i), _mm_packs_epi16(isForeground, isForeground));
+	}
+#endif
+
+	for (; i < count; i++) {
+		const uint16 d = depth[i];
+		const uint16 bg = background[i];
+		const uint16 dev = deviation[i];
+		const uint16 cand = candidate[i];
+		candidate[i] = 0;
+		if (d == 0) {
+			foreground[i] = 0;
+			if (bg == 0) {
+				deviation[i] = 0;
+			}
+			continue;
+		}
+
+		const int32 band = FMath::Max<int32>(FMath::Min<uint16>(rates.minBand, 0x7FFF), 
+											 FMath::Min(dev, maxDeviation) * bandScale);
+		const bool bForeground = (rates.bLearning == false) && ((bg == 0) || (bg - d > band));
+		foreground[i] = bForeground ? 0xFF : 0x00;
+
+		if (bForeground && (bg == 0)) {
+			const bool bStable = (cand != 0) && (FMath::Abs(d - cand) <= FMath::Min<uint16>(rates.minBand, 0x7FFF));
+			const uint16 count = bStable ? (uint16)FMath::Min(dev + 1, 0xFFFF) : 1;
+			if ((rates.unobservedFrames > 0) && (count >= rates.unobservedFrames)) {
+				background[i] = d;
+				deviation[i] = 0;
+			}
+			else {
+				candidate[i] = bStable ? cand : d;
+				deviation[i] = count;
+			}
+			continue;
+		}
+
+		int32 step = bForeground ? ((bg == 0) ? 0 : rates.foregroundStep) : rates.backgroundStep;
+		if (rates.bLearning) {
+			step = 0xFFFF;
+		}
+		background[i] = (uint16)(bg + FMath::Clamp(d - bg, -step, step));
+
+		if (bForeground == false) {
+			const int32 distance = FMath::Abs(d - bg);
+			deviation[i] = (uint16)(dev + FMath::Clamp(distance - dev, -1, 1));
+		}
+	}
+}
+
+// 2x2 blocks of 4-channel pixels, the common case, are summed in 16-bit 
+// lanes four source pixels at a time: the rows are added, then each pixel 
+// is added to its right neighbor by shifting the register by one pixel.
+void DownsampleImage(const uint8* src, int32 width, int32 height, int32 channels, int32 factor, uint8* dst)
+{
+	const int32 outWidth = width / factor;
+	const int32 outHeight = height / factor;
+	const int32 area = factor * factor;
+
+	if (factor == 1) {
+		FMemory::Memcpy(dst, src, width * height * channels);
+		return;
+	}
+
+	for (int32 y = 0; y < outHeight; y++) {
+		const uint8* rows = src + y * factor * width * channels;
+		uint8* out = dst + y * outWidth * channels;
+		int32 x = 0;
+
+#if RS_SIMD_SSE2
+		if ((channels == 4) && (factor == 2)) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i rounding = _mm_set1_epi16(2);
+			const uint8* row0 = rows;
+			const uint8* row1 = rows + width * channels;
+			for (; x + 2 <= outWidth; x += 2) {
+				const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+				const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+				__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+				lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+				hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+				const __m128i sums = _mm_unpacklo_epi64(lo, hi);
+				const __m128i means = _mm_srli_epi16(_mm_add_epi16(sums, rounding), 2);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(out + x * 4), _mm_packus_epi16(means, means));
+			}
+		}
+#endif
+
+		for (; x < outWidth; x++) {
+			for (int32 c = 0; c < channels; c++) {
+				uint32 sum = 0;
+				for (int32 by = 0; by < factor; by++) {
+					const uint8* block = rows + (by * width + x * factor) * channels + c;
+					for (int32 bx = 0; bx < factor; bx++) {
+						sum += block[bx * channels];
+					}
+				}
+				out[x * channels + c] = (uint8)((sum + area / 2) / area);
+			}
+		}
+	}
+}
+
+// Subtracting 1 wraps invalid depth to 0xFFFF, so the nearest valid depth 
+// is a plain minimum, and adding 1 back wraps a block without any to 0.
+void DownsampleDepthNearest(const uint16* src, int32 width, int32 height, int32 factor, uint16* dst)
+{
+	const int32 outWidth = width / factor;
+	const int32 outHeight = height / factor;
+
+	if (factor == 1) {
+		FMemory::Memcpy(dst, src, width * height * sizeof(uint16));
+		return;
+	}
+
+	for (int32 y = 0; y < outHeight; y++) {
+		const uint16* rows = src + y * factor * width;
+		uint16* out = dst + y * outWidth;
+
+		for (int32 x = 0; x < outWidth; x++) {
+			uint16 nearest = 0xFFFF;
+			for (int32 by = 0; by < factor; by++) {
+				const uint16* block = rows + by * width + x * factor;
+				for (int32 bx = 0; bx < factor; bx++) {
+					nearest = FMath::Min<uint16>(nearest, (uint16)(block[bx] - 1));
+				}
+			}
+			out[x] = (uint16)(nearest + 1);
+		}
+	}
+}
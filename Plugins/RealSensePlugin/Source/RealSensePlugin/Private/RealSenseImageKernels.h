@@ -0,0 +1,114 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+
+// Pixel processing kernels used by the camera processing thread. Each kernel
+// has an SSE2 implementation and a scalar fallback for other platforms.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define RS_SIMD_SSE2 1
+#else
+#define RS_SIMD_SSE2 0
+#endif
+
+// Summary statistics of one depth frame, accumulated while the frame is copied
+// out of the SDK so that the game thread never has to touch the depth pixels.
+struct RealSenseDepthStatistics {
+	static const int32 NumHistogramBins = 16;
+	static const int32 HistogramBinShift = 8;  // Each bin covers 256 mm
+
+	uint16 nearest;  // Smallest non-zero depth (mm), 0xFFFF if there is none
+	uint64 sum;  // Sum of the non-zero depth values
+	uint32 validCount;  // Number of non-zero depth values
+	uint32 totalCount;  // Number of depth values
+	uint32 histogram[NumHistogramBins];  // Non-zero depth values per bin, last bin is open-ended
+
+	RealSenseDepthStatistics() { Reset(); }
+
+	void Reset();
+
+	// Converts the statistics to the Blueprint-exposed structure.
+	FDepthStatistics ToBlueprint() const;
+};
+
+// Accumulates count depth values into stats in a single pass.
+void AccumulateDepthStatistics(const uint16* depth, int32 count, RealSenseDepthStatistics& stats);
+
+// Builds the summed-area tables of a depth image. Both tables are 
+// (width + 1) x (height + 1): entry (x, y) holds the sum (in sums) and the 
+// number (in counts) of non-zero depth values in the rectangle [0, x) x [0, y),
+// so the sum and count of any rectangle can be read from four entries.
+void BuildDepthSummedAreaTable(const uint16* depth, int32 width, int32 height, uint64* sums, uint32* counts);
+
+// Copies the alpha channel of count BGRA pixels into an 8-bit mask.
+void ExtractAlphaMask(const uint8* bgra, int32 count, uint8* mask);
+
+// Replaces the alpha channel of count BGRA pixels with an 8-bit mask.
+void InsertAlphaMask(const uint8* mask, int32 count, uint8* bgra);
+
+// Blends count BGRA foreground pixels over a BGRA background image using the
+// 8-bit mask as coverage: out = (fg * m + bg * (255 - m)) / 255. The output 
+// is opaque. out may alias foreground or background.
+void CompositeOverImage(const uint8* foreground, const uint8* mask, const uint8* background, int32 count, uint8* out);
+
+// Same as CompositeOverImage, with a solid BGRA background color (packed as
+// B | G << 8 | R << 16 | A << 24).
+void CompositeOverColor(const uint8* foreground, const uint8* mask, uint32 background, int32 count, uint8* out);
+
+// Run-length encodes a mask, thresholded at 128, as alternating run lengths
+// of background and foreground pixels. The first run is always background 
+// and may be empty.
+void EncodeMaskRuns(const uint8* mask, int32 count, TArray<int32>& runs);
+
+// Expands runs produced by EncodeMaskRuns into a 0 / 255 mask of count pixels.
+// Pixels beyond the end of the runs are set to background.
+void DecodeMaskRuns(const TArray<int32>& runs, int32 count, uint8* mask);
+
+// Rates of one update of the depth background model, see UpdateDepthBackground.
+struct RealSenseBackgroundRates {
+	uint16 backgroundStep;  // Largest change (mm) of the background of background pixels
+	uint16 foregroundStep;  // Largest change (mm) of the background of foreground pixels
+	uint16 unobservedFrames;  // Frames a pixel without background must hold a depth to take it, 0 for never
+	uint16 minBand;  // Smallest distance (mm) in front of the background of a foreground pixel
+	uint16 bandScale;  // Width of the noise band in deviations, at most 8
+	bool bLearning;  // While learning, the background follows the depth and nothing is foreground
+};
+
+// Advances a per-pixel depth background model by one frame of count depth 
+// values (mm) and writes the 0 / 255 foreground mask of the frame. Each 
+// pixel keeps an approximate running median of its depth in background and
+// of its absolute deviation from it in deviation, both in mm and 0 where 
+// never observed. A pixel is foreground if its depth is more than 
+// max(minBand, bandScale * deviation) in front of its background, or if its
+// background was never observed. Such a pixel keeps the depth it currently 
+// holds in candidate, and in deviation the number of consecutive frames its
+// depth stayed within minBand of it. It takes the depth as background after
+// unobservedFrames of them. Depth values of 0 are never foreground, restart
+// the count of such pixels, and otherwise leave the model unchanged.
+void UpdateDepthBackground(const uint16* depth, int32 count, const RealSenseBackgroundRates& rates, 
+						   uint16* background, uint16* deviation, uint16* candidate, uint8* foreground);
+
+// Downsamples an image of 8-bit channels by factor in both directions, 
+// averaging each factor x factor block with rounding. The output is 
+// (width / factor) x (height / factor): pixels beyond the last full block 
+// are dropped.
+void DownsampleImage(const uint8* src, int32 width, int32 height, int32 channels, int32 factor, uint8* dst);
+
+// Downsamples a depth image by factor in both directions, keeping the 
+// nearest non-zero depth of each block, or 0 if the block has none. The 
+// output size is the same as DownsampleImage().
+void DownsampleDepthNearest(const uint16* src, int32 width, int32 height, int32 factor, uint16* dst);
@@ -15,15 +15,20 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 #include "RealSensePluginPrivatePCH.h"
 #include "RealSenseImpl.h"
-
-// Creates handles to the RealSense Session and SenseManager and iterates over 
-// all video capture devices to find a RealSense camera.
+#include "RealSenseMarchingCubes.h"
+#include "RealSenseMeshIO.h"
+
+// Creates a SenseManager from the shared RealSense Session and searches the
+// devices found by the RealSenseDeviceRegistry for the RealSense camera with 
+// the requested serial number (or the first one found if no serial number is 
+// given). The SenseManager is then restricted to that device so that several 
+// instances can stream from different cameras at the same time.
 //
 // Creates three RealSenseDataFrames (background, mid, and foreground) to 
 // share RealSense data between the camera processing thread and the main thread.
-RealSenseImpl::RealSenseImpl()
+RealSenseImpl::RealSenseImpl(const FString& serial)
 {
-	session = std::unique_ptr<PXCSession, RealSenseDeleter>(PXCSession::CreateInstance());
+	session = RealSenseDeviceRegistry::Get().GetSession();
 	assert(session != nullptr);
 
 	senseManager = std::unique_ptr<PXCSenseManager, RealSenseDeleter>(session->CreateSenseManager());
@@ -33,34 +38,26 @@ RealSenseImpl::RealSenseImpl()
 	device = std::unique_ptr<PXCCapture::Device, RealSenseDeleter>(nullptr);
 	deviceInfo = {};
 
-	// Loop through video capture devices to find a RealSense Camera
-	PXCSession::ImplDesc desc1 = {};
-	desc1.group = PXCSession::IMPL_GROUP_SENSOR;
-	desc1.subgroup = PXCSession::IMPL_SUBGROUP_VIDEO_CAPTURE;
-	for (int m = 0; ; m++) {
-		if (device)
-			break;
-
-		PXCSession::ImplDesc desc2 = {};
-		if (session->QueryImpl(&desc1, m, &desc2) != PXC_STATUS_NO_ERROR) 
-			break;
+	TArray<RealSenseDeviceDesc> devices = RealSenseDeviceRegistry::Get().GetDevices();
+	for (RealSenseDeviceDesc& desc : devices) {
+		if ((serial.IsEmpty() == false) && (serial != FString(desc.info.serial)))
+			continue;
 
 		PXCCapture* tmp;
-		if (session->CreateImpl<PXCCapture>(&desc2, &tmp) != PXC_STATUS_NO_ERROR) 
+		if (session->CreateImpl<PXCCapture>(&desc.implDesc, &tmp) != PXC_STATUS_NO_ERROR)
 			continue;
 		capture.reset(tmp);
 
-		for (int j = 0; ; j++) {
-			if (capture->QueryDeviceInfo(j, &deviceInfo) != PXC_STATUS_NO_ERROR) 
-				break;
+		deviceInfo = desc.info;
+		device = std::unique_ptr<PXCCapture::Device, RealSenseDeleter>(capture->CreateDevice(desc.index));
+		break;
+	}
 
-			if ((deviceInfo.model == PXCCapture::DeviceModel::DEVICE_MODEL_F200) ||
-				(deviceInfo.model == PXCCapture::DeviceModel::DEVICE_MODEL_R200) ||
-				(deviceInfo.model == PXCCapture::DeviceModel::DEVICE_MODEL_R200_ENHANCED) ||
-				(deviceInfo.model == PXCCapture::DeviceModel::DEVICE_MODEL_SR300)) {
-				device = std::unique_ptr<PXCCapture::Device, RealSenseDeleter>(capture->CreateDevice(j));
-			}
-		}
+	if (device) {
+		senseManager->QueryCaptureManager()->FilterByDeviceInfo(&deviceInfo);
+	}
+	else {
+		RS_LOG(Warning, "No RealSense device found matching serial '%s'", *serial)
 	}
 
 	p3DScan = std::unique_ptr<PXC3DScan, RealSenseDeleter>(nullptr);
@@ -70,8 +67,20 @@ RealSenseImpl::RealSenseImpl()
 	bCameraStreamingEnabled = false;
 	bScan3DEnabled = false;
 	bFaceEnabled = false;
+	bSeg3DEnabled = false;
+	bOccupancyEnabled = false;
+	bBlobTrackingEnabled = false;
+	bPlaneDetectionEnabled = false;
+	bDepthBackgroundEnabled = false;
+	bDepthSummedAreaTableEnabled = false;
+	segmentationOutput = ESegmentationOutput::COLOR_WITH_ALPHA;
+	segmentationOpenRadius = 0;
+	segmentationCloseRadius = 0;
+	segmentationFeatherWidth = 0;
 
 	bCameraThreadRunning = false;
+	cameraThreadPriority = ERealSenseThreadPriority::ABOVE_NORMAL;
+	cameraThreadAffinity = 0;
 
 	fgFrame = std::unique_ptr<RealSenseDataFrame>(new RealSenseDataFrame());
 	midFrame = std::unique_ptr<RealSenseDataFrame>(new RealSenseDataFrame());
@@ -104,6 +113,15 @@ RealSenseImpl::RealSenseImpl()
 	bReconstructEnabled = false;
 	bScanCompleted = false;
 	bScan3DImageSizeChanged = false;
+
+	scan3DBackend = EScan3DBackend::MIDDLEWARE;
+	activeScan3DBackend = EScan3DBackend::MIDDLEWARE;
+	bFusionScanning = false;
+	fusionCameraPose = FMatrix::Identity;
+	fusionVolume.Configure(RealSenseFusionSettings());
+
+	occupancyCameraPose = FMatrix::Identity;
+	occupancyGrid.Configure(RealSenseOccupancySettings());
 }
 
 // Terminate the camera thread and release the Core SDK handles.
@@ -112,21 +130,41 @@ RealSenseImpl::~RealSenseImpl()
 {
 	if (bCameraThreadRunning) {
 		bCameraThreadRunning = false;
-		cameraThread.join();
+		cameraThread.reset();
+	}
+
+	if (saveScanTask.valid()) {
+		saveScanTask.wait();
 	}
 }
 
+// Longest time the camera processing thread waits for a frame before it 
+// checks whether it should stop
+static const pxcI32 AcquireFrameTimeoutMs = 100;
+
 // Camera Processing Thread
 // Initialize the RealSense SenseManager and initiate camera processing loop:
 // Step 1: Acquire new camera frame
 // Step 2: Load shared settings
 // Step 3: Perform Core SDK and middleware processing and store results
 //         in background RealSenseDataFrame
-// Step 4: Swap the background and mid RealSenseDataFrames
+// Step 4: Hand the background RealSenseDataFrame to the frame publishers
+// Step 5: Swap the background and mid RealSenseDataFrames
+//
+// The optional stages (face tracking, segmentation, scan preview, occupancy
+// grid, blob tracking, plane detection, and depth background) only run on 
+// the frames chosen by the governor. On the other frames, the SDK module is
+// paused and the previous result is carried over.
 void RealSenseImpl::CameraThread()
 {
 	uint64 currentFrame = 0;
 
+	bool bFacePaused = false;
+	bool bSeg3DPaused = false;
+	int lastHeadCount = 0;
+	FVector lastHeadPosition = FVector::ZeroVector;
+	FRotator lastHeadRotation = FRotator::ZeroRotator;
+
 	fgFrame->number = 0;
 	midFrame->number = 0;
 	bgFrame->number = 0;
@@ -141,33 +179,139 @@ void RealSenseImpl::CameraThread()
 	}
 
 	while (bCameraThreadRunning == true) {
-		// Acquires new camera frame
-		status = senseManager->AcquireFrame(true);
-		assert(status == PXC_STATUS_NO_ERROR);
+		const uint64 nextFrame = currentFrame + 1;
+		const bool bRunFace = bFaceEnabled && governor.ShouldRun(RealSenseStage::FACE_TRACKING, nextFrame);
+		const bool bRunSeg3D = bSeg3DEnabled && governor.ShouldRun(RealSenseStage::SEGMENTATION, nextFrame);
+		const bool bRunScanPreview = governor.ShouldRun(RealSenseStage::SCAN_PREVIEW, nextFrame);
+		const bool bRunOccupancy = bOccupancyEnabled && governor.ShouldRun(RealSenseStage::OCCUPANCY_GRID, nextFrame);
+		const bool bBlobTracking = bBlobTrackingEnabled;
+		const bool bRunBlobTracking = bBlobTracking && governor.ShouldRun(RealSenseStage::BLOB_TRACKING, nextFrame);
+		const bool bPlaneDetection = bPlaneDetectionEnabled;
+		const bool bRunPlaneDetection = bPlaneDetection && governor.ShouldRun(RealSenseStage::PLANE_DETECTION, nextFrame);
+		const bool bDepthBackground = bDepthBackgroundEnabled;
+		const bool bRunDepthBackground = bDepthBackground && governor.ShouldRun(RealSenseStage::DEPTH_BACKGROUND, nextFrame);
+		if (bFaceEnabled) {
+			SetModulePaused(PXCFaceModule::CUID, bRunFace == false, bFacePaused);
+		}
+		if (bSeg3DEnabled) {
+			SetModulePaused(PXC3DSeg::CUID, bRunSeg3D == false, bSeg3DPaused);
+		}
+
+		// Acquires new camera frame. The timeout lets the loop notice a stop
+		// request even if the camera stops delivering frames.
+		status = senseManager->AcquireFrame(true, AcquireFrameTimeoutMs);
+		if (status == PXC_STATUS_EXEC_TIMEOUT) {
+			continue;
+		}
+		if (status < PXC_STATUS_NO_ERROR) {
+			RS_LOG_STATUS(status, "AcquireFrame failed")
+			FPlatformProcess::Sleep(AcquireFrameTimeoutMs / 1000.0f);
+			continue;
+		}
 
 		bgFrame->number = ++currentFrame;
+		bgFrame->timestamp = FPlatformTime::Seconds();
+
+		const bool bFusion = bScan3DEnabled && (activeScan3DBackend == EScan3DBackend::FUSION);
 
 		// Performs Core SDK and middleware processing and store results 
 		// in background RealSenseDataFrame
 
+		// In the COLOR_WITH_ALPHA mode the segmented image replaces the color
+		// image. In the mask modes only its alpha channel is kept, next to the
+		// regular color and depth images. MASK_RLE builds the mask in the 
+		// cache and only the runs reach the frame.
+		const ESegmentationOutput seg3DOutput = segmentationOutput;
+		const bool bSeg3DMask = bSeg3DEnabled && (seg3DOutput != ESegmentationOutput::COLOR_WITH_ALPHA);
+		const bool bSeg3DRuns = bSeg3DEnabled && (seg3DOutput == ESegmentationOutput::MASK_RLE);
+
 		if (bSeg3DEnabled)
 		{
-			PXCImage* segmentedImage = p3DSeg->AcquireSegmentedImage();
-			if (segmentedImage)
-			{
-				CopySegmentedImageToBuffer(segmentedImage, bgFrame->colorImage, colorResolution.width, colorResolution.height);
-				SAFE_RELEASE(segmentedImage);
+			if (bSeg3DRuns) {
+				bgFrame->segmentationMask.SetDimensions(0, 0);
+			}
+			else if (bSeg3DMask) {
+				bgFrame->segmentationMask.SetDimensions(colorResolution.width, colorResolution.height);
+			}
+			RealSenseImageBuffer<uint8>& segmentedOutput = bSeg3DRuns ? segmentedImageCache : 
+				(bSeg3DMask ? bgFrame->segmentationMask : bgFrame->colorImage);
+			const int32 segmentedSize = bSeg3DRuns ? colorResolution.width * colorResolution.height : segmentedOutput.Num();
+
+			if (bRunSeg3D) {
+				const double stageStart = FPlatformTime::Seconds();
+				PXCImage* segmentedImage = p3DSeg->AcquireSegmentedImage();
+				if (segmentedImage)
+				{
+					if (bSeg3DRuns) {
+						segmentedImageCache.SetDimensions(colorResolution.width, colorResolution.height);
+					}
+					if (bSeg3DMask) {
+						CopySegmentedMaskToBuffer(segmentedImage, segmentedOutput.GetData(), colorResolution.width, colorResolution.height);
+					}
+					else {
+						CopySegmentedImageToBuffer(segmentedImage, segmentedOutput.GetData(), colorResolution.width, colorResolution.height);
+					}
+					SAFE_RELEASE(segmentedImage);
+
+					CleanupSegmentation(segmentedOutput, bSeg3DMask);
+
+					if (bSeg3DRuns == false) {
+						segmentedImageCache.SetDimensions(segmentedSize, 1);
+						FMemory::Memcpy(segmentedImageCache.GetData(), segmentedOutput.GetData(), segmentedSize);
+					}
+				}
+				governor.RecordStageCost(RealSenseStage::SEGMENTATION, (FPlatformTime::Seconds() - stageStart) * 1000.0);
+			}
+			else if ((bSeg3DRuns == false) && (segmentedImageCache.Num() == segmentedSize)) {
+				FMemory::Memcpy(segmentedOutput.GetData(), segmentedImageCache.GetData(), segmentedSize);
+			}
+
+			if (bSeg3DRuns) {
+				if (segmentedImageCache.Num() == segmentedSize) {
+					EncodeMaskRuns(segmentedImageCache.GetData(), segmentedSize, bgFrame->segmentationRuns);
+				}
+				else {
+					bgFrame->segmentationRuns.Reset();
+				}
 			}
 		}
 
-		else if (bCameraStreamingEnabled) {
+		if (bSeg3DMask == false) {
+			bgFrame->segmentationMask.SetDimensions(0, 0);
+		}
+		if (bSeg3DRuns == false) {
+			bgFrame->segmentationRuns.Reset();
+		}
+
+		if (bCameraStreamingEnabled && ((bSeg3DEnabled == false) || bSeg3DMask)) {
 			PXCCapture::Sample* sample = senseManager->QuerySample();
 
-			CopyColorImageToBuffer(sample->color, bgFrame->colorImage, colorResolution.width, colorResolution.height);
-			CopyDepthImageToBuffer(sample->depth, bgFrame->depthImage, depthResolution.width, depthResolution.height);
+			CopyColorImageToBuffer(sample->color, bgFrame->colorImage.GetData(), colorResolution.width, colorResolution.height);
+			CopyDepthImageToBuffer(sample->depth, bgFrame->depthImage.GetData(), depthResolution.width, depthResolution.height, 
+								   &bgFrame->depthStats);
+
+			// The tables grow to their full size on the first frame after 
+			// they are enabled and are only emptied, not freed, afterwards
+			const bool bBuildTables = bDepthSummedAreaTableEnabled;
+			const int32 tableWidth = bBuildTables ? depthResolution.width + 1 : 0;
+			const int32 tableHeight = bBuildTables ? depthResolution.height + 1 : 0;
+			bgFrame->depthSumTable.SetDimensions(tableWidth, tableHeight);
+			bgFrame->depthCountTable.SetDimensions(tableWidth, tableHeight);
+			if (bBuildTables) {
+				BuildDepthSummedAreaTable(bgFrame->depthImage.GetData(), depthResolution.width, depthResolution.height,
+										  bgFrame->depthSumTable.GetData(), bgFrame->depthCountTable.GetData());
+			}
+		}
+		else if (bFusion || bOccupancyEnabled || bBlobTracking || bPlaneDetection || bDepthBackground) {
+			PXCCapture::Sample* sample = senseManager->QuerySample();
+			CopyDepthImageToBuffer(sample->depth, bgFrame->depthImage.GetData(), depthResolution.width, depthResolution.height, 
+								   &bgFrame->depthStats);
 		}
 
-		if (bScan3DEnabled) {
+		if (bFusion) {
+			UpdateFusion(bRunScanPreview);
+		}
+		else if (bScan3DEnabled && p3DScan) {
 			if (bScanStarted) {
 				PXC3DScan::Configuration config = p3DScan->QueryConfiguration();
 				config.startScan = true;
@@ -182,11 +326,22 @@ void RealSenseImpl::CameraThread()
 				bScanStopped = false;
 			}
 
-			PXCImage* scanImage = p3DScan->AcquirePreviewImage();
-			if (scanImage) {
-				UpdateScan3DImageSize(scanImage->QueryInfo());
-				CopyColorImageToBuffer(scanImage, bgFrame->scanImage, scan3DResolution.width, scan3DResolution.height);
-				scanImage->Release();
+			if (bRunScanPreview) {
+				const double stageStart = FPlatformTime::Seconds();
+				PXCImage* scanImage = p3DScan->AcquirePreviewImage();
+				if (scanImage) {
+					const PXCImage::ImageInfo info = scanImage->QueryInfo();
+					UpdateScan3DImageSize(info.width, info.height);
+					CopyColorImageToBuffer(scanImage, bgFrame->scanImage.GetData(), scan3DResolution.width, scan3DResolution.height);
+					scanImage->Release();
+
+					scanImageCache.SetDimensions(bgFrame->scanImage.Num(), 1);
+					FMemory::Memcpy(scanImageCache.GetData(), bgFrame->scanImage.GetData(), bgFrame->scanImage.Num());
+				}
+				governor.RecordStageCost(RealSenseStage::SCAN_PREVIEW, (FPlatformTime::Seconds() - stageStart) * 1000.0);
+			}
+			else if (scanImageCache.Num() == bgFrame->scanImage.Num()) {
+				FMemory::Memcpy(bgFrame->scanImage.GetData(), scanImageCache.GetData(), scanImageCache.Num());
 			}
 			
 			if (bReconstructEnabled) {
@@ -196,51 +351,213 @@ void RealSenseImpl::CameraThread()
 			}
 		}
 
-		if (bFaceEnabled) {
+		if (bRunOccupancy) {
+			UpdateOccupancyGrid();
+		}
+
+		if (bRunBlobTracking) {
+			const double stageStart = FPlatformTime::Seconds();
+			const RealSenseCameraIntrinsics intrinsics = RealSenseCameraIntrinsics::FromFOV(depthResolution.width, 
+				depthResolution.height, depthHorizontalFOV, depthVerticalFOV);
+			std::unique_lock<std::mutex> lock(blobTrackerMutex);
+			blobTracker.Update(bgFrame->depthImage.GetData(), intrinsics);
+			governor.RecordStageCost(RealSenseStage::BLOB_TRACKING, (FPlatformTime::Seconds() - stageStart) * 1000.0);
+		}
+
+		if (bBlobTracking) {
+			std::unique_lock<std::mutex> lock(blobTrackerMutex);
+			bgFrame->blobs = blobTracker.GetBlobs();
+		}
+		else {
+			bgFrame->blobs.Reset();
+		}
+
+		if (bRunPlaneDetection) {
+			const double stageStart = FPlatformTime::Seconds();
+			const RealSenseCameraIntrinsics intrinsics = RealSenseCameraIntrinsics::FromFOV(depthResolution.width, 
+				depthResolution.height, depthHorizontalFOV, depthVerticalFOV);
+			std::unique_lock<std::mutex> lock(planeDetectorMutex);
+			planeDetector.Update(bgFrame->depthImage.GetData(), intrinsics);
+			governor.RecordStageCost(RealSenseStage::PLANE_DETECTION, (FPlatformTime::Seconds() - stageStart) * 1000.0);
+		}
+
+		// Each of the three frames only copies the detector results when they
+		// changed since it last held them, so skipped stages copy nothing
+		if (bPlaneDetection) {
+			std::unique_lock<std::mutex> lock(planeDetectorMutex);
+			if (bgFrame->planeRevision != planeDetector.GetRevision()) {
+				bgFrame->planes = planeDetector.GetPlanes();
+				bgFrame->planeMask = planeDetector.GetPlaneMask();
+				bgFrame->planeRevision = planeDetector.GetRevision();
+			}
+		}
+		else if (bgFrame->planeRevision != 0) {
+			bgFrame->planes.Reset();
+			bgFrame->planeMask.Reset();
+			bgFrame->planeRevision = 0;
+		}
+
+		if (bRunDepthBackground) {
+			const double stageStart = FPlatformTime::Seconds();
+			std::unique_lock<std::mutex> lock(depthBackgroundMutex);
+			depthBackground.Update(bgFrame->depthImage.GetData(), depthResolution.width, depthResolution.height);
+			governor.RecordStageCost(RealSenseStage::DEPTH_BACKGROUND, (FPlatformTime::Seconds() - stageStart) * 1000.0);
+		}
+
+		if (bDepthBackground) {
+			std::unique_lock<std::mutex> lock(depthBackgroundMutex);
+			bgFrame->foregroundMask = depthBackground.GetForegroundMask();
+			bgFrame->bLearningBackground = depthBackground.IsLearning();
+		}
+		else {
+			bgFrame->foregroundMask.Reset();
+			bgFrame->bLearningBackground = false;
+		}
+
+		if (bRunFace) {
+			const double stageStart = FPlatformTime::Seconds();
 			faceData->Update();
-			bgFrame->headCount = faceData->QueryNumberOfDetectedFaces();
-			if (bgFrame->headCount > 0) {
+			lastHeadCount = faceData->QueryNumberOfDetectedFaces();
+			if (lastHeadCount > 0) {
 				PXCFaceData::Face* face = faceData->QueryFaceByIndex(0);
 				PXCFaceData::PoseData* poseData = face->QueryPose();
 
 				if (poseData) {
 					PXCFaceData::HeadPosition headPosition = {};
 					poseData->QueryHeadPosition(&headPosition);
-					bgFrame->headPosition = FVector(headPosition.headCenter.x, headPosition.headCenter.y, headPosition.headCenter.z);
+					lastHeadPosition = FVector(headPosition.headCenter.x, headPosition.headCenter.y, headPosition.headCenter.z);
 
 					PXCFaceData::PoseEulerAngles headRotation = {};
 					poseData->QueryPoseAngles(&headRotation);
-					bgFrame->headRotation = FRotator(headRotation.pitch, headRotation.yaw, headRotation.roll);
+					lastHeadRotation = FRotator(headRotation.pitch, headRotation.yaw, headRotation.roll);
 				}
 			}
+			governor.RecordStageCost(RealSenseStage::FACE_TRACKING, (FPlatformTime::Seconds() - stageStart) * 1000.0);
+		}
+
+		if (bFaceEnabled) {
+			bgFrame->headCount = lastHeadCount;
+			bgFrame->headPosition = lastHeadPosition;
+			bgFrame->headRotation = lastHeadRotation;
 		}
 		
 		senseManager->ReleaseFrame();
 
+		governor.Update(FPlatformTime::Seconds());
+
+		{
+			std::unique_lock<std::mutex> lockPublishers(framePublishersMutex);
+			for (IRealSenseFramePublisher* publisher : framePublishers) {
+				publisher->Publish(*bgFrame);
+			}
+		}
+
 		// Swaps background and mid RealSenseDataFrames
 		std::unique_lock<std::mutex> lockIntermediate(midFrameMutex);
 		bgFrame.swap(midFrame);
 	}
 }
 
-// If it is not already running, starts a new camera processing thread
+// Only calls into the SDK when the pause state actually changes.
+void RealSenseImpl::SetModulePaused(pxcUID cuid, bool bPaused, bool& bCurrentlyPaused)
+{
+	if (bPaused != bCurrentlyPaused) {
+		senseManager->PauseModule(cuid, bPaused);
+		bCurrentlyPaused = bPaused;
+	}
+}
+
+// Every logical core except those the platform pins the game and render 
+// threads to. Platforms that leave them unpinned report every core in their
+// masks (Windows, by default), in which case the thread may run on any core.
+static uint64 GetDefaultCameraThreadAffinity()
+{
+	const int32 cores = FMath::Clamp(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1, 64);
+	const uint64 allCores = (cores == 64) ? ~(uint64)0 : (((uint64)1 << cores) - 1);
+	const uint64 engineCores = FPlatformAffinity::GetMainGameMask() | FPlatformAffinity::GetRenderingThreadMask();
+	const uint64 freeCores = allCores & ~engineCores;
+	return (freeCores != 0) ? freeCores : allCores;
+}
+
+// If it is not already running, starts a new camera processing thread with
+// the configured priority and affinity. The thread is named after the device
+// so that several cameras can be told apart in the profiler.
 void RealSenseImpl::StartCamera() 
 {
 	if (bCameraThreadRunning == false) {
+		activeScan3DBackend = scan3DBackend.load();
 		EnableMiddleware();
+		SetPublishersInterrupted(false);
 		bCameraThreadRunning = true;
-		cameraThread = std::thread([this]() { CameraThread(); });
+
+		const uint64 affinity = (cameraThreadAffinity != 0) ? cameraThreadAffinity : GetDefaultCameraThreadAffinity();
+		const FString name = FString::Printf(TEXT("RealSenseCamera %s"), *GetDeviceSerial());
+		cameraThread = std::unique_ptr<RealSenseThread>(new RealSenseThread([this]() { CameraThread(); }, *name, 
+			GetEThreadPriority(cameraThreadPriority), affinity));
+
+		if (cameraThread->IsValid() == false) {
+			RS_LOG(Error, "Unable to create the camera processing thread")
+			bCameraThreadRunning = false;
+			cameraThread.reset();
+		}
+	}
+}
+
+void RealSenseImpl::SetSegmentationCleanup(int32 openRadius, int32 closeRadius, int32 featherWidth)
+{
+	segmentationOpenRadius = FMath::Max(openRadius, 0);
+	segmentationCloseRadius = FMath::Max(closeRadius, 0);
+	segmentationFeatherWidth = FMath::Max(featherWidth, 0);
+}
+
+// Cleans up a new segmentation result in place. In the mask modes the output
+// is the mask itself; otherwise the alpha channel of the segmented color 
+// image is extracted, cleaned up, and written back.
+void RealSenseImpl::CleanupSegmentation(RealSenseImageBuffer<uint8>& output, bool bIsMask)
+{
+	const int32 openRadius = segmentationOpenRadius;
+	const int32 closeRadius = segmentationCloseRadius;
+	const int32 featherWidth = segmentationFeatherWidth;
+	if ((openRadius == 0) && (closeRadius == 0) && (featherWidth == 0)) {
+		return;
+	}
+
+	const int32 width = colorResolution.width;
+	const int32 height = colorResolution.height;
+
+	uint8* mask = output.GetData();
+	if (bIsMask == false) {
+		segmentationCleanupMask.SetDimensions(width, height);
+		ExtractAlphaMask(output.GetData(), width * height, segmentationCleanupMask.GetData());
+		mask = segmentationCleanupMask.GetData();
 	}
+
+	segmentationFilter.Open(mask, width, height, openRadius);
+	segmentationFilter.Close(mask, width, height, closeRadius);
+	segmentationFilter.Feather(mask, width, height, featherWidth);
+
+	if (bIsMask == false) {
+		InsertAlphaMask(mask, width * height, output.GetData());
+	}
+}
+
+void RealSenseImpl::SetCameraThreadOptions(ERealSenseThreadPriority priority, uint64 affinityMask)
+{
+	cameraThreadPriority = priority;
+	cameraThreadAffinity = affinityMask;
 }
 
 // If there is a camera processing thread running, this function terminates it. 
-// Then it resets the SenseManager pipeline (by closing it and re-enabling the 
-// previously specified feature set).
+// The frame publishers are interrupted first, since a LOSSLESS frame queue 
+// whose consumer stopped popping would otherwise keep the thread from ever
+// finishing its frame. Then it resets the SenseManager pipeline (by closing 
+// it and re-enabling the previously specified feature set).
 void RealSenseImpl::StopCamera() 
 {
 	if (bCameraThreadRunning) {
 		bCameraThreadRunning = false;
-		cameraThread.join();
+		SetPublishersInterrupted(true);
+		cameraThread.reset();
 	}
 	senseManager->Close();
 }
@@ -254,9 +571,35 @@ void RealSenseImpl::SwapFrames()
 	}
 }
 
+// The list is only changed with both locks held, so SetPublishersInterrupted()
+// can read it with the list lock alone while a publisher blocks the camera 
+// thread, which holds framePublishersMutex.
+void RealSenseImpl::AddFramePublisher(IRealSenseFramePublisher* publisher)
+{
+	std::unique_lock<std::mutex> listLock(framePublishersListMutex);
+	std::unique_lock<std::mutex> lock(framePublishersMutex);
+	framePublishers.AddUnique(publisher);
+	publisher->SetInterrupted(bCameraThreadRunning == false);
+}
+
+void RealSenseImpl::RemoveFramePublisher(IRealSenseFramePublisher* publisher)
+{
+	std::unique_lock<std::mutex> listLock(framePublishersListMutex);
+	std::unique_lock<std::mutex> lock(framePublishersMutex);
+	framePublishers.Remove(publisher);
+}
+
+void RealSenseImpl::SetPublishersInterrupted(bool bInterrupted)
+{
+	std::unique_lock<std::mutex> listLock(framePublishersListMutex);
+	for (IRealSenseFramePublisher* publisher : framePublishers) {
+		publisher->SetInterrupted(bInterrupted);
+	}
+}
+
 void RealSenseImpl::EnableMiddleware()
 {
-	if (bScan3DEnabled) {
+	if (bScan3DEnabled && (activeScan3DBackend == EScan3DBackend::MIDDLEWARE)) {
 		senseManager->Enable3DScan();
 		p3DScan = std::unique_ptr<PXC3DScan, RealSenseDeleter>(senseManager->Query3DScan());
 	}
@@ -286,6 +629,18 @@ void RealSenseImpl::EnableFeature(RealSenseFeature feature)
 	case RealSenseFeature::SEGMENTATION_3D:
 		bSeg3DEnabled = true;
 		return;
+	case RealSenseFeature::OCCUPANCY_GRID:
+		bOccupancyEnabled = true;
+		return;
+	case RealSenseFeature::BLOB_TRACKING:
+		bBlobTrackingEnabled = true;
+		return;
+	case RealSenseFeature::PLANE_DETECTION:
+		bPlaneDetectionEnabled = true;
+		return;
+	case RealSenseFeature::DEPTH_BACKGROUND:
+		bDepthBackgroundEnabled = true;
+		return;
 	}
 }
 
@@ -304,36 +659,37 @@ void RealSenseImpl::DisableFeature(RealSenseFeature feature)
 	case RealSenseFeature::SEGMENTATION_3D:
 		bSeg3DEnabled = false;
 		return;
+	case RealSenseFeature::OCCUPANCY_GRID:
+		bOccupancyEnabled = false;
+		return;
+	case RealSenseFeature::BLOB_TRACKING:
+		bBlobTrackingEnabled = false;
+		return;
+	case RealSenseFeature::PLANE_DETECTION:
+		bPlaneDetectionEnabled = false;
+		return;
+	case RealSenseFeature::DEPTH_BACKGROUND:
+		bDepthBackgroundEnabled = false;
+		return;
 	}
 }
 
 // Returns the connceted device's model as a Blueprintable enum value.
 const ECameraModel RealSenseImpl::GetCameraModel() const
 {
-	switch (deviceInfo.model) {
-	case PXCCapture::DeviceModel::DEVICE_MODEL_F200:
-		return ECameraModel::F200;
-	case PXCCapture::DeviceModel::DEVICE_MODEL_R200:
-	case PXCCapture::DeviceModel::DEVICE_MODEL_R200_ENHANCED:
-		return ECameraModel::R200;
-	case PXCCapture::DeviceModel::DEVICE_MODEL_SR300:
-		return ECameraModel::SR300;
-	default:
-		return ECameraModel::Other;
-	}
+	return GetECameraModel(deviceInfo.model);
 }
 
 // Returns the connected camera's firmware version as a human-readable string.
 const FString RealSenseImpl::GetCameraFirmware() const
 {
-	return FString::Printf(TEXT("%d.%d.%d.%d"), deviceInfo.firmware[0], 
-												deviceInfo.firmware[1], 
-												deviceInfo.firmware[2], 
-												deviceInfo.firmware[3]);
+	return GetRealSenseDeviceInfo(deviceInfo).Firmware;
 }
 
 // Enables the color camera stream of the SenseManager using the specified resolution
-// and resizes the colorImage buffer of the RealSenseDataFrames to match.
+// and updates the dimensions of the colorImage buffer of the RealSenseDataFrames.
+// The buffers are sized for the largest supported color resolution the first 
+// time this is called, so later resolution changes never reallocate them.
 void RealSenseImpl::SetColorCameraResolution(EColorResolution resolution) 
 {
 	colorResolution = GetEColorResolutionValue(resolution);
@@ -346,14 +702,17 @@ void RealSenseImpl::SetColorCameraResolution(EColorResolution resolution)
 	assert(status == PXC_STATUS_NO_ERROR);
 
 	const uint8 bytesPerPixel = 4;
-	const uint32 colorImageSize = colorResolution.width * colorResolution.height * bytesPerPixel;
-	bgFrame->colorImage.SetNumZeroed(colorImageSize);
-	midFrame->colorImage.SetNumZeroed(colorImageSize);
-	fgFrame->colorImage.SetNumZeroed(colorImageSize);
+	const int32 maxColorImageSize = GetMaxColorImagePixels() * bytesPerPixel;
+	for (RealSenseDataFrame* frame : { bgFrame.get(), midFrame.get(), fgFrame.get() }) {
+		frame->colorImage.Reserve(maxColorImageSize);
+		frame->colorImage.SetDimensions(colorResolution.width, colorResolution.height, bytesPerPixel);
+	}
 }
 
 // Enables the depth camera stream of the SenseManager using the specified resolution
-// and resizes the depthImage buffer of the RealSenseDataFrames to match.
+// and updates the dimensions of the depthImage buffer of the RealSenseDataFrames.
+// The buffers are sized for the largest supported depth resolution the first 
+// time this is called, so later resolution changes never reallocate them.
 void RealSenseImpl::SetDepthCameraResolution(EDepthResolution resolution)
 {
 	depthResolution = GetEDepthResolutionValue(resolution);
@@ -365,10 +724,11 @@ void RealSenseImpl::SetDepthCameraResolution(EDepthResolution resolution)
 	assert(status == PXC_STATUS_NO_ERROR);
 
 	if (status == PXC_STATUS_NO_ERROR) {
-		const uint32 depthImageSize = depthResolution.width * depthResolution.height;
-		bgFrame->depthImage.SetNumZeroed(depthImageSize);
-		midFrame->depthImage.SetNumZeroed(depthImageSize);
-		fgFrame->depthImage.SetNumZeroed(depthImageSize);
+		const int32 maxDepthImageSize = GetMaxDepthImagePixels();
+		for (RealSenseDataFrame* frame : { bgFrame.get(), midFrame.get(), fgFrame.get() }) {
+			frame->depthImage.Reserve(maxDepthImageSize);
+			frame->depthImage.SetDimensions(depthResolution.width, depthResolution.height);
+		}
 	}
 }
 
@@ -410,6 +770,10 @@ bool RealSenseImpl::IsStreamSetValid(EColorResolution ColorResolution, EDepthRes
 // startScan flag to false to postpone the start of scanning.
 void RealSenseImpl::ConfigureScanning(EScan3DMode scanningMode, bool bSolidify, bool bTexture) 
 {
+	if ((activeScan3DBackend == EScan3DBackend::FUSION) || (p3DScan == nullptr)) {
+		return;
+	}
+
 	PXC3DScan::Configuration config = {};
 
 	config.mode = GetPXCScanningMode(scanningMode);
@@ -426,12 +790,28 @@ void RealSenseImpl::ConfigureScanning(EScan3DMode scanningMode, bool bSolidify,
 
 	status = p3DScan->SetConfiguration(config);
 	assert(status == PXC_STATUS_NO_ERROR);
+
+	// Reserve the preview buffers up front so the camera thread only has to
+	// update their dimensions when the preview size changes.
+	const uint8 bytesPerPixel = 4;
+	const int32 maxScanImageSize = GetMaxColorImagePixels() * bytesPerPixel;
+	for (RealSenseDataFrame* frame : { bgFrame.get(), midFrame.get(), fgFrame.get() }) {
+		frame->scanImage.Reserve(maxScanImageSize);
+	}
 }
 
 // Manually sets the 3D volume in which the 3D scanning module will collect
 // data and the voxel resolution to use while scanning.
 void RealSenseImpl::SetScanningVolume(FVector boundingBox, int32 resolution)
 {
+	if (activeScan3DBackend == EScan3DBackend::FUSION) {
+		RS_LOG(Warning, "The scanning volume only applies to the middleware, use ConfigureFusion() instead")
+		return;
+	}
+	if (p3DScan == nullptr) {
+		return;
+	}
+
 	PXC3DScan::Area area;
 	area.shape.width = boundingBox.X;
 	area.shape.height = boundingBox.Y;
@@ -447,7 +827,12 @@ void RealSenseImpl::SetScanningVolume(FVector boundingBox, int32 resolution)
 // to begin scanning.
 void RealSenseImpl::StartScanning() 
 {
-	bScanStarted = true;
+	if (activeScan3DBackend == EScan3DBackend::FUSION) {
+		bFusionScanning = true;
+	}
+	else {
+		bScanStarted = true;
+	}
 	bScanCompleted = false;
 }
 
@@ -456,41 +841,191 @@ void RealSenseImpl::StartScanning()
 // to stop scanning.
 void RealSenseImpl::StopScanning()
 {
-	bScanStopped = true;
+	if (activeScan3DBackend == EScan3DBackend::FUSION) {
+		bFusionScanning = false;
+	}
+	else {
+		bScanStopped = true;
+	}
 }
 
 // Stores the file format and filename to use for saving the scan and sets the
 // reconstructEnabled flag to true. On the next iteration of the camera processing
 // loop, it will load this flag and reconstruct the scanned data as a mesh file.
+//
+// The fusion backend extracts its mesh right away and writes it from a 
+// background task, so neither the game nor the camera thread waits on the disk.
 void RealSenseImpl::SaveScan(EScan3DFileFormat saveFileFormat, const FString& filename) 
 {
+	if (activeScan3DBackend == EScan3DBackend::FUSION) {
+		if (saveScanTask.valid()) {
+			saveScanTask.wait();
+		}
+
+		bScanCompleted = false;
+		ExtractFusionMesh(savedScanVertices, savedScanTriangles, savedScanColors);
+		saveScanTask = std::async(std::launch::async, [this, saveFileFormat, filename]() {
+			SaveMeshFile(filename, saveFileFormat, savedScanVertices, savedScanTriangles, savedScanColors);
+			bScanCompleted = true;
+		});
+		return;
+	}
+
 	scan3DFileFormat = GetPXCScanFileFormat(saveFileFormat);
 	scan3DFilename = filename;
 	bReconstructEnabled = true;
 }
 
-// The input ImageInfo object contains the wight and height of the preview image
-// provided by the 3D Scanning module. The image size can be changed automatically
-// by the middleware, so this function checks if the size has changed.
+void RealSenseImpl::ConfigureFusion(const RealSenseFusionSettings& settings)
+{
+	std::unique_lock<std::mutex> lock(fusionMutex);
+	fusionVolume.Configure(settings);
+}
+
+void RealSenseImpl::SetFusionCameraPose(const FMatrix& cameraToWorld)
+{
+	std::unique_lock<std::mutex> lock(fusionMutex);
+	fusionCameraPose = cameraToWorld;
+}
+
+void RealSenseImpl::ResetFusion()
+{
+	std::unique_lock<std::mutex> lock(fusionMutex);
+	fusionVolume.Reset();
+}
+
+// Holds the fusion lock for the duration of the extraction. UpdateFusion() 
+// only tries the lock, so the camera thread skips fusing while the mesh is 
+// built rather than changing the volume under it or waiting for it.
+void RealSenseImpl::ExtractFusionMesh(TArray<FVector>& vertices, TArray<int32>& triangles, TArray<FColor>& colors)
+{
+	std::unique_lock<std::mutex> lock(fusionMutex);
+	ExtractSurfaceMesh(fusionVolume, FColor::White, vertices, triangles, colors);
+}
+
+// Depth frames are fused while scanning. The preview replaces the middleware's
+// preview image: it is raycast from the current pose at the depth resolution
+// on the frames chosen by the governor, and carried over on the others. 
+// While the game thread holds the volume to extract a mesh, frames are 
+// neither fused nor raycast, so frame acquisition never waits on it.
+void RealSenseImpl::UpdateFusion(bool bRunPreview)
+{
+	const RealSenseCameraIntrinsics intrinsics = RealSenseCameraIntrinsics::FromFOV(depthResolution.width, 
+		depthResolution.height, depthHorizontalFOV, depthVerticalFOV);
+
+	UpdateScan3DImageSize(intrinsics.width, intrinsics.height);
+
+	std::unique_lock<std::mutex> lock(fusionMutex, std::try_to_lock);
+	if (lock.owns_lock() == false) {
+		bRunPreview = false;
+	}
+	else if (bFusionScanning) {
+		fusionVolume.Integrate(bgFrame->depthImage.GetData(), intrinsics, fusionCameraPose);
+	}
+
+	if (bRunPreview) {
+		const double stageStart = FPlatformTime::Seconds();
+		fusionVolume.RaycastPreview(intrinsics, fusionCameraPose, bgFrame->scanImage.GetData());
+
+		scanImageCache.SetDimensions(bgFrame->scanImage.Num(), 1);
+		FMemory::Memcpy(scanImageCache.GetData(), bgFrame->scanImage.GetData(), bgFrame->scanImage.Num());
+		governor.RecordStageCost(RealSenseStage::SCAN_PREVIEW, (FPlatformTime::Seconds() - stageStart) * 1000.0);
+	}
+	else if (scanImageCache.Num() == bgFrame->scanImage.Num()) {
+		FMemory::Memcpy(bgFrame->scanImage.GetData(), scanImageCache.GetData(), scanImageCache.Num());
+	}
+}
+
+// The input size is that of the preview image provided by the 3D Scanning 
+// module or raycast from the fusion volume. The image size can be changed 
+// automatically by the middleware, so this function checks if the size has changed.
 //
-// If true, sets the 3D scan resolution to reflect the new size and resizes the
-// scanImage buffer of the RealSenseDataFrames to match.
-void RealSenseImpl::UpdateScan3DImageSize(PXCImage::ImageInfo info) 
+// If true, sets the 3D scan resolution to reflect the new size and updates the
+// dimensions of the scanImage buffer of the RealSenseDataFrames. The buffers 
+// are sized for the largest color resolution, so they only grow if the 
+// middleware produces an even larger preview.
+void RealSenseImpl::UpdateScan3DImageSize(int32 width, int32 height) 
 {
-	if ((scan3DResolution.width == info.width) && 
-		(scan3DResolution.height == info.height)) {
+	if ((scan3DResolution.width == width) && 
+		(scan3DResolution.height == height)) {
 		bScan3DImageSizeChanged = false;
 		return;
 	}
 
-	scan3DResolution.width = info.width;
-	scan3DResolution.height = info.height;
+	scan3DResolution.width = width;
+	scan3DResolution.height = height;
 
 	const uint8 bytesPerPixel = 4;
-	const uint32 scanImageSize = scan3DResolution.width * scan3DResolution.height * bytesPerPixel;
-	bgFrame->scanImage.SetNumZeroed(scanImageSize);
-	midFrame->scanImage.SetNumZeroed(scanImageSize);
-	fgFrame->scanImage.SetNumZeroed(scanImageSize);
+	const int32 maxScanImageSize = GetMaxColorImagePixels() * bytesPerPixel;
+	for (RealSenseDataFrame* frame : { bgFrame.get(), midFrame.get(), fgFrame.get() }) {
+		frame->scanImage.Reserve(maxScanImageSize);
+		frame->scanImage.SetDimensions(scan3DResolution.width, scan3DResolution.height, bytesPerPixel);
+	}
 
 	bScan3DImageSizeChanged = true;
 }
+
+void RealSenseImpl::ConfigureOccupancyGrid(const RealSenseOccupancySettings& settings)
+{
+	std::unique_lock<std::mutex> lock(occupancyMutex);
+	occupancyGrid.Configure(settings);
+}
+
+void RealSenseImpl::SetOccupancyCameraPose(const FMatrix& cameraToWorld)
+{
+	std::unique_lock<std::mutex> lock(occupancyMutex);
+	occupancyCameraPose = cameraToWorld;
+}
+
+void RealSenseImpl::CopyOccupancyGrid(RealSenseOccupancyGrid& grid, TArray<int32>& outChangedBricks)
+{
+	std::unique_lock<std::mutex> lock(occupancyMutex);
+	grid.CopyFrom(occupancyGrid, outChangedBricks);
+}
+
+// The grid keeps the occupancy of the last frame it was updated with, so 
+// nothing needs to be carried over on the frames skipped by the governor.
+void RealSenseImpl::UpdateOccupancyGrid()
+{
+	const double stageStart = FPlatformTime::Seconds();
+	const RealSenseCameraIntrinsics intrinsics = RealSenseCameraIntrinsics::FromFOV(depthResolution.width, 
+		depthResolution.height, depthHorizontalFOV, depthVerticalFOV);
+
+	{
+		std::unique_lock<std::mutex> lock(occupancyMutex);
+		occupancyGrid.Update(bgFrame->depthImage.GetData(), intrinsics, occupancyCameraPose);
+	}
+
+	governor.RecordStageCost(RealSenseStage::OCCUPANCY_GRID, (FPlatformTime::Seconds() - stageStart) * 1000.0);
+}
+
+// Restarts tracking, since blobs found with other settings are not comparable.
+void RealSenseImpl::ConfigureBlobTracking(const RealSenseBlobSettings& settings)
+{
+	std::unique_lock<std::mutex> lock(blobTrackerMutex);
+	blobTracker.Configure(settings);
+	blobTracker.Reset();
+}
+
+// Restarts tracking, since planes found with other settings are not 
+// comparable.
+void RealSenseImpl::ConfigurePlaneDetection(const RealSensePlaneSettings& settings)
+{
+	std::unique_lock<std::mutex> lock(planeDetectorMutex);
+	planeDetector.Configure(settings);
+	planeDetector.Reset();
+}
+
+// Learning starts over, since the noise bands depend on the settings.
+void RealSenseImpl::ConfigureDepthBackground(const RealSenseBackgroundSettings& settings)
+{
+	std::unique_lock<std::mutex> lock(depthBackgroundMutex);
+	depthBackground.Configure(settings);
+	depthBackground.Reset();
+}
+
+void RealSenseImpl::LearnDepthBackground()
+{
+	std::unique_lock<std::mutex> lock(depthBackgroundMutex);
+	depthBackground.Reset();
+}
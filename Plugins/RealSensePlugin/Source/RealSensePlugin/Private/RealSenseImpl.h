@@ -24,6 +24,18 @@
 #include "RealSenseTypes.h"
 #include "RealSenseUtils.h"
 #include "RealSenseBlueprintLibrary.h"
+#include "RealSenseDeviceRegistry.h"
+#include "RealSenseImageBuffer.h"
+#include "RealSenseImageKernels.h"
+#include "RealSenseMaskFilter.h"
+#include "RealSenseFusion.h"
+#include "RealSenseOccupancyGrid.h"
+#include "RealSenseBlobTracker.h"
+#include "RealSensePlaneDetector.h"
+#include "RealSenseDepthBackground.h"
+#include "RealSenseFrameSource.h"
+#include "RealSenseGovernor.h"
+#include "RealSenseThread.h"
 #include "PXCSenseManager.h"
 
 // Stores all relevant data computed from one frame of RealSense camera data.
@@ -36,15 +48,27 @@
 //             Read data from foreground_frame
 struct RealSenseDataFrame {
 	uint64 number;  // Stores an ID for the frame based on its occurrence in time
-	TArray<uint8> colorImage;  // Container for the camera's raw color stream data
-	TArray<uint16> depthImage;  // Container for the camera's raw depth stream data
-	TArray<uint8> scanImage;  // Container for the scan preview image provided by the 3DScan middleware
+	double timestamp;  // Time (FPlatformTime::Seconds) at which the frame was acquired
+	RealSenseImageBuffer<uint8> colorImage;  // Container for the camera's raw color stream data
+	RealSenseImageBuffer<uint16> depthImage;  // Container for the camera's raw depth stream data
+	RealSenseImageBuffer<uint8> scanImage;  // Container for the scan preview image provided by the 3DScan middleware
+	RealSenseDepthStatistics depthStats;  // Statistics of depthImage, computed during ingest
+	RealSenseImageBuffer<uint64> depthSumTable;  // Summed-area table of depthImage, empty if disabled
+	RealSenseImageBuffer<uint32> depthCountTable;  // Summed-area table of valid depth pixels, empty if disabled
+	RealSenseImageBuffer<uint8> segmentationMask;  // Alpha of the segmented image, empty unless MASK is selected
+	TArray<int32> segmentationRuns;  // Run-length encoded alpha, empty unless MASK_RLE is selected
+	TArray<FDepthBlob> blobs;  // Near-range blobs of depthImage, empty unless blob tracking is enabled
+	TArray<FDepthPlane> planes;  // Planes of depthImage, empty unless plane detection is enabled
+	TArray<uint8> planeMask;  // Plane label of every depth pixel, see RealSensePlaneDetector::GetPlaneMask()
+	uint64 planeRevision;  // Detector revision that planes and planeMask were copied at, 0 if none
+	TArray<uint8> foregroundMask;  // Pixels of depthImage in front of the depth background, empty unless enabled
+	bool bLearningBackground;  // True while the depth background is being learned
 
 	int headCount;
 	FVector headPosition;
 	FRotator headRotation;
 
-	RealSenseDataFrame() : number(0), headCount(0) {}
+	RealSenseDataFrame() : number(0), timestamp(0.0), planeRevision(0), bLearningBackground(false), headCount(0) {}
 };
 
 // Implements the functionality of the Intel(R) RealSense(TM) SDK and associated
@@ -52,10 +76,15 @@ struct RealSenseDataFrame {
 //
 // NOTE: Some function declarations do not have a function comment because the 
 // comment is written in RealSenseSessionManager.h. 
-class RealSenseImpl {
+//
+// Each RealSenseImpl drives a single camera with its own processing thread
+// and set of data frames, so several cameras can be used side by side.
+class RealSenseImpl : public IRealSenseFrameSource {
 public:
-	// Creates a new RealSense Session and queries physical device information.
-	RealSenseImpl();
+	// Creates a SenseManager from the shared RealSense Session and queries 
+	// physical device information. If serial is empty, the first supported 
+	// device is used. Blocks until device enumeration has finished.
+	RealSenseImpl(const FString& serial = FString());
 
 	// Terminates the camera processing thread and releases handles to Core SDK objects.
 	~RealSenseImpl();
@@ -71,12 +100,34 @@ public:
 
 	void StopCamera();
 
+	// Sets the priority and the cores (0 selects the cores of the engine's 
+	// worker pool, away from the game and render threads) used by the camera
+	// processing thread. Takes effect the next time the camera is started.
+	void SetCameraThreadOptions(ERealSenseThreadPriority priority, uint64 affinityMask);
+
 	// Swaps the data frames to load the latest processed data into the 
 	// foreground frame.
-	void SwapFrames();
+	void SwapFrames() override;
 
 	inline bool IsCameraThreadRunning() const { return bCameraThreadRunning; }
 
+	inline uint64 GetFrameNumber() const override { return fgFrame->number; }
+
+	inline double GetFrameTimestamp() const override { return fgFrame->timestamp; }
+
+	// Registers a publisher that receives every processed frame on the camera
+	// processing thread. The publisher must be removed before it is destroyed.
+	void AddFramePublisher(IRealSenseFramePublisher* publisher);
+
+	void RemoveFramePublisher(IRealSenseFramePublisher* publisher);
+
+	// Returns the governor that adapts the rate of the optional processing 
+	// stages (face tracking, segmentation, scan preview, occupancy grid, blob
+	// tracking, plane detection, depth background) to the CPU budget.
+	inline RealSenseGovernor& GetGovernor() { return governor; }
+
+	inline const RealSenseGovernor& GetGovernor() const { return governor; }
+
 	// Core SDK Support
 
 	void EnableMiddleware();
@@ -85,7 +136,7 @@ public:
 
 	void DisableFeature(RealSenseFeature feature);
 
-	inline bool IsCameraConnected() const { return (senseManager->IsConnected() != 0); }
+	inline bool IsCameraConnected() const { return senseManager && (senseManager->IsConnected() != 0); }
 
 	inline float GetColorHorizontalFOV() const { return colorHorizontalFOV; }
 
@@ -99,27 +150,59 @@ public:
 
 	const FString GetCameraFirmware() const;
 
+	inline bool HasDevice() const { return (device != nullptr); }
+
+	inline FString GetDeviceSerial() const { return FString(deviceInfo.serial); }
+
 	inline FStreamResolution GetColorCameraResolution() const { return colorResolution; }
 
-	inline int32 GetColorImageWidth() const { return colorResolution.width; }
+	inline int32 GetColorImageWidth() const override { return colorResolution.width; }
 
-	inline int32 GetColorImageHeight() const { return colorResolution.height; }
+	inline int32 GetColorImageHeight() const override { return colorResolution.height; }
 
 	void SetColorCameraResolution(EColorResolution resolution);
 
 	inline FStreamResolution GetDepthCameraResolution() const { return depthResolution; }
 
-	inline int32 GetDepthImageWidth() const { return depthResolution.width; }
+	inline int32 GetDepthImageWidth() const override { return depthResolution.width; }
 
-	inline int32 GetDepthImageHeight() const { return depthResolution.height; }
+	inline int32 GetDepthImageHeight() const override { return depthResolution.height; }
 
 	void SetDepthCameraResolution(EDepthResolution resolution);
 
 	bool IsStreamSetValid(EColorResolution ColorResolution, EDepthResolution DepthResolution) const;
 
-	inline const uint8* GetColorBuffer() const { return fgFrame->colorImage.GetData(); }
+	inline const uint8* GetColorBuffer() const override { return fgFrame->colorImage.GetData(); }
+
+	inline const uint16* GetDepthBuffer() const override { return fgFrame->depthImage.GetData(); }
+
+	inline FDepthStatistics GetDepthStatistics() const { return fgFrame->depthStats.ToBlueprint(); }
+
+	inline void EnableDepthSummedAreaTable(bool bEnable) { bDepthSummedAreaTableEnabled = bEnable; }
+
+	inline void SetSegmentationOutput(ESegmentationOutput output) { segmentationOutput = output; }
+
+	inline ESegmentationOutput GetSegmentationOutput() const { return segmentationOutput; }
+
+	// Sets the cleanup applied to every new segmentation result on the camera
+	// thread: an opening and a closing with the given radii (in pixels) to 
+	// remove specks and fill holes, then an edge feather of the given width.
+	// Zero disables a step.
+	void SetSegmentationCleanup(int32 openRadius, int32 closeRadius, int32 featherWidth);
 
-	inline const uint16* GetDepthBuffer() const { return fgFrame->depthImage.GetData(); }
+	inline const RealSenseImageBuffer<uint8>& GetSegmentationMask() const { return fgFrame->segmentationMask; }
+
+	inline const TArray<int32>& GetSegmentationRuns() const { return fgFrame->segmentationRuns; }
+
+	inline const uint64* GetDepthSumTable() const override 
+	{ 
+		return (fgFrame->depthSumTable.Num() > 0) ? fgFrame->depthSumTable.GetData() : nullptr; 
+	}
+
+	inline const uint32* GetDepthCountTable() const override 
+	{ 
+		return (fgFrame->depthCountTable.Num() > 0) ? fgFrame->depthCountTable.GetData() : nullptr; 
+	}
 
 	// 3D Scanning Module Support 
 
@@ -133,7 +216,32 @@ public:
 
 	void SaveScan(EScan3DFileFormat saveFileFormat, const FString& filename);
 	
-	inline bool IsScanning() const { return (p3DScan->IsScanning() != 0); }
+	inline bool IsScanning() const 
+	{ 
+		return (activeScan3DBackend == EScan3DBackend::FUSION) ? bFusionScanning.load() : 
+			(p3DScan && (p3DScan->IsScanning() != 0)); 
+	}
+
+	// Selects the engine used by the 3D scanning functions. Takes effect on 
+	// the next StartCamera(), which latches it; until then the scanning 
+	// functions keep using the backend the camera was started with.
+	inline void SetScan3DBackend(EScan3DBackend backend) { scan3DBackend = backend; }
+
+	// Returns the backend selected for the next StartCamera().
+	inline EScan3DBackend GetScan3DBackend() const { return scan3DBackend; }
+
+	// Applies new settings to the fusion volume and clears it.
+	void ConfigureFusion(const RealSenseFusionSettings& settings);
+
+	// Sets the camera-to-world transform used for the depth frames fused 
+	// from now on. The camera is assumed static at the origin by default.
+	void SetFusionCameraPose(const FMatrix& cameraToWorld);
+
+	// Clears the fusion volume.
+	void ResetFusion();
+
+	// Extracts the surface of the fusion volume as a triangle mesh in world space.
+	void ExtractFusionMesh(TArray<FVector>& vertices, TArray<int32>& triangles, TArray<FColor>& colors);
 
 	inline FStreamResolution GetScan3DResolution() const { return scan3DResolution; }
 
@@ -149,17 +257,58 @@ public:
 
 	// Head Tracking Support
 
-	inline int GetHeadCount() const { return bgFrame->headCount; }
+	inline int GetHeadCount() const { return fgFrame->headCount; }
+
+	inline FVector GetHeadPosition() const { return fgFrame->headPosition; }
+
+	inline FRotator GetHeadRotation() const { return fgFrame->headRotation; }
+
+	// Occupancy Grid Support
+
+	// Applies new settings to the occupancy grid and clears it.
+	void ConfigureOccupancyGrid(const RealSenseOccupancySettings& settings);
+
+	// Sets the camera-to-world transform used to place the depth samples in 
+	// the occupancy grid. The camera is assumed static at the origin by default.
+	void SetOccupancyCameraPose(const FMatrix& cameraToWorld);
+
+	// Brings a copy of the occupancy grid up to date with the one built by the
+	// camera thread, see RealSenseOccupancyGrid::CopyFrom().
+	void CopyOccupancyGrid(RealSenseOccupancyGrid& grid, TArray<int32>& outChangedBricks);
 
-	inline FVector GetHeadPosition() const { return bgFrame->headPosition; }
+	// Blob Tracking Support
 
-	inline FRotator GetHeadRotation() const { return bgFrame->headRotation; }
+	void ConfigureBlobTracking(const RealSenseBlobSettings& settings);
+
+	inline const TArray<FDepthBlob>& GetBlobs() const { return fgFrame->blobs; }
+
+	// Plane Detection Support
+
+	void ConfigurePlaneDetection(const RealSensePlaneSettings& settings);
+
+	inline const TArray<FDepthPlane>& GetPlanes() const { return fgFrame->planes; }
+
+	inline const TArray<uint8>& GetPlaneMask() const { return fgFrame->planeMask; }
+
+	inline uint64 GetPlaneRevision() const { return fgFrame->planeRevision; }
+
+	// Depth Background Support
+
+	void ConfigureDepthBackground(const RealSenseBackgroundSettings& settings);
+
+	void LearnDepthBackground();
+
+	inline const TArray<uint8>& GetForegroundMask() const { return fgFrame->foregroundMask; }
+
+	inline bool IsLearningDepthBackground() const { return fgFrame->bLearningBackground; }
 
 private:
+	// Interrupts or resumes every frame publisher, see IRealSenseFramePublisher.
+	void SetPublishersInterrupted(bool bInterrupted);
+
 	// Core SDK handles
 
 	struct RealSenseDeleter {
-		void operator()(PXCSession* s) { s->Release(); }
 		void operator()(PXCSenseManager* sm) { sm->Release(); }
 		void operator()(PXCCapture* c) { c->Release(); }
 		void operator()(PXCCapture::Device* d) { d->Release(); }
@@ -168,7 +317,9 @@ private:
 		void operator()(PXC3DSeg* s) { ; }
 	};
 
-	std::unique_ptr<PXCSession, RealSenseDeleter> session;
+	// Shared by every RealSenseImpl and owned by the RealSenseDeviceRegistry.
+	// Declared first so that it outlives the handles created from it.
+	std::shared_ptr<PXCSession> session;
 	std::unique_ptr<PXCSenseManager, RealSenseDeleter> senseManager;
 	std::unique_ptr<PXCCapture, RealSenseDeleter> capture;
 	std::unique_ptr<PXCCapture::Device, RealSenseDeleter> device;
@@ -189,11 +340,22 @@ private:
 	std::atomic_bool bScan3DEnabled;
 	std::atomic_bool bFaceEnabled;
 	std::atomic_bool bSeg3DEnabled;
+	std::atomic_bool bOccupancyEnabled;
+	std::atomic_bool bBlobTrackingEnabled;
+	std::atomic_bool bPlaneDetectionEnabled;
+	std::atomic_bool bDepthBackgroundEnabled;
+	std::atomic_bool bDepthSummedAreaTableEnabled;
+	std::atomic<ESegmentationOutput> segmentationOutput;
+	std::atomic<int32> segmentationOpenRadius;
+	std::atomic<int32> segmentationCloseRadius;
+	std::atomic<int32> segmentationFeatherWidth;
 
 	// Camera processing members
 
-	std::thread cameraThread;
+	std::unique_ptr<RealSenseThread> cameraThread;
 	std::atomic_bool bCameraThreadRunning;
+	ERealSenseThreadPriority cameraThreadPriority;
+	uint64 cameraThreadAffinity;
 
 	std::unique_ptr<RealSenseDataFrame> fgFrame;
 	std::unique_ptr<RealSenseDataFrame> midFrame;
@@ -202,6 +364,23 @@ private:
 	// Mutex for locking access to the midFrame
 	std::mutex midFrameMutex;
 
+	RealSenseGovernor governor;
+
+	// Latest results of the optional stages, copied into frames on which the
+	// governor skips the stage
+	RealSenseImageBuffer<uint8> segmentedImageCache;
+	RealSenseImageBuffer<uint8> scanImageCache;
+
+	// Segmentation cleanup state, only used by the camera thread
+	RealSenseMaskFilter segmentationFilter;
+	RealSenseImageBuffer<uint8> segmentationCleanupMask;
+
+	// Receivers of every processed frame, the mutex held while they publish,
+	// and the mutex guarding changes to the list along with it
+	TArray<IRealSenseFramePublisher*> framePublishers;
+	std::mutex framePublishersMutex;
+	std::mutex framePublishersListMutex;
+
 	// Core SDK members
 
 	FStreamResolution colorResolution;
@@ -225,6 +404,46 @@ private:
 	std::atomic_bool bScanCompleted;
 	std::atomic_bool bScan3DImageSizeChanged;
 
+	// Volumetric fusion members
+
+	std::atomic<EScan3DBackend> scan3DBackend;
+	std::atomic<EScan3DBackend> activeScan3DBackend;  // Backend latched by StartCamera()
+	std::atomic_bool bFusionScanning;
+	RealSenseFusionVolume fusionVolume;
+	FMatrix fusionCameraPose;
+
+	// Mutex guarding fusionVolume and fusionCameraPose
+	std::mutex fusionMutex;
+
+	// Mesh of the fusion scan being saved, and the task writing it to disk
+	TArray<FVector> savedScanVertices;
+	TArray<int32> savedScanTriangles;
+	TArray<FColor> savedScanColors;
+	std::future<void> saveScanTask;
+
+	// Occupancy grid members
+
+	RealSenseOccupancyGrid occupancyGrid;
+	FMatrix occupancyCameraPose;
+
+	// Mutex guarding occupancyGrid and occupancyCameraPose
+	std::mutex occupancyMutex;
+
+	// Blob tracker, updated by the camera thread and reconfigured by the game
+	// thread
+	RealSenseBlobTracker blobTracker;
+	std::mutex blobTrackerMutex;
+
+	// Plane detector, updated by the camera thread and reconfigured by the 
+	// game thread
+	RealSensePlaneDetector planeDetector;
+	std::mutex planeDetectorMutex;
+
+	// Depth background model, updated by the camera thread and reconfigured
+	// by the game thread
+	RealSenseDepthBackground depthBackground;
+	std::mutex depthBackgroundMutex;
+
 	// Face Module members
 
 	PXCFaceConfiguration* faceConfig;
@@ -232,5 +451,19 @@ private:
 
 	// Helper Functions
 
-	void UpdateScan3DImageSize(PXCImage::ImageInfo info);
+	void UpdateScan3DImageSize(int32 width, int32 height);
+
+	// Fuses the depth image of the background frame and, if requested, 
+	// raycasts the fusion volume into its scan preview image.
+	void UpdateFusion(bool bRunPreview);
+
+	// Rebuilds the occupancy grid from the depth image of the background frame.
+	void UpdateOccupancyGrid();
+
+	// Pauses or resumes an SDK module for the next AcquireFrame().
+	void SetModulePaused(pxcUID cuid, bool bPaused, bool& bCurrentlyPaused);
+
+	// Applies the segmentation cleanup to a mask or to the alpha channel of 
+	// a segmented color image.
+	void CleanupSegmentation(RealSenseImageBuffer<uint8>& output, bool bIsMask);
 };
@@ -0,0 +1,286 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseMarchingCubes.h"
+#include "RealSenseFusion.h"
+#include "ParallelFor.h"
+
+// Cube corner i sits at voxel offset (i & 1, (i >> 1) & 1, (i >> 2) & 1). 
+// Edge e joins corners EdgeCorners[e][0] and EdgeCorners[e][1] and runs 
+// along axis e / 4 from the first corner.
+static const int32 EdgeCorners[12][2] = {
+	{ 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+	{ 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+	{ 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+};
+
+// Triangles of every cube configuration, as edge indices terminated by -1.
+// Bit i of a configuration is set when corner i is behind the surface.
+struct MarchingCubesTable {
+	int8 triangles[256][16];
+
+	MarchingCubesTable();
+};
+
+static int32 FindEdge(int32 a, int32 b)
+{
+	for (int32 e = 0; e < 12; e++) {
+		if (((EdgeCorners[e][0] == a) && (EdgeCorners[e][1] == b)) || 
+			((EdgeCorners[e][0] == b) && (EdgeCorners[e][1] == a))) {
+			return e;
+		}
+	}
+	return -1;
+}
+
+// Builds the table instead of listing it: the surface of a cube is traced 
+// face by face. Each face's corners are walked in a cycle oriented by its 
+// outward normal. A crossing edge is an entry when the walk goes from the 
+// front into the back of the surface, and an exit otherwise; every entry is
+// joined to the next exit. This separates back corners on ambiguous faces, 
+// and since neighboring cubes walk a shared face in opposite directions they
+// make the same choice, so the surface has no holes. Each crossing edge is 
+// an exit of one face and an entry of the other face it borders, so the 
+// segments chain into closed loops, which are split into triangle fans.
+MarchingCubesTable::MarchingCubesTable()
+{
+	int32 faces[6][4];
+	for (int32 axis = 0; axis < 3; axis++) {
+		const int32 u = (axis + 1) % 3;
+		const int32 v = (axis + 2) % 3;
+		for (int32 side = 0; side < 2; side++) {
+			int32* cycle = faces[axis * 2 + side];
+			const int32 square[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+			for (int32 k = 0; k < 4; k++) {
+				cycle[k] = (side << axis) | (square[k][0] << u) | (square[k][1] << v);
+			}
+			// (u, v, axis) is a right-handed frame, so this cycle turns 
+			// counterclockwise around +axis; reverse it for the side facing -axis
+			if (side == 0) {
+				Swap(cycle[1], cycle[3]);
+			}
+		}
+	}
+
+	// Faces bordering each edge, as a bit mask
+	int32 edgeFaces[12] = {};
+	for (int32 f = 0; f < 6; f++) {
+		for (int32 k = 0; k < 4; k++) {
+			edgeFaces[FindEdge(faces[f][k], faces[f][(k + 1) % 4])] |= (1 << f);
+		}
+	}
+
+	for (int32 config = 0; config < 256; config++) {
+		int32 next[12];
+		for (int32 e = 0; e < 12; e++) {
+			next[e] = -1;
+		}
+
+		for (int32 f = 0; f < 6; f++) {
+			int32 edges[4];
+			bool bEntry[4];
+			bool bCrossing[4];
+			for (int32 k = 0; k < 4; k++) {
+				const int32 a = faces[f][k];
+				const int32 b = faces[f][(k + 1) % 4];
+				const bool bInsideA = ((config >> a) & 1) != 0;
+				const bool bInsideB = ((config >> b) & 1) != 0;
+				edges[k] = FindEdge(a, b);
+				bCrossing[k] = (bInsideA != bInsideB);
+				bEntry[k] = bInsideB;
+			}
+			for (int32 k = 0; k < 4; k++) {
+				if ((bCrossing[k] == false) || (bEntry[k] == false)) {
+					continue;
+				}
+				for (int32 step = 1; step < 4; step++) {
+					const int32 j = (k + step) % 4;
+					if (bCrossing[j] && (bEntry[j] == false)) {
+						next[edges[k]] = edges[j];
+						break;
+					}
+				}
+			}
+		}
+
+		int32 count = 0;
+		bool bVisited[12] = {};
+		for (int32 start = 0; start < 12; start++) {
+			if ((next[start] < 0) || bVisited[start]) {
+				continue;
+			}
+
+			int32 loop[12];
+			int32 length = 0;
+			for (int32 e = start; bVisited[e] == false; e = next[e]) {
+				bVisited[e] = true;
+				loop[length++] = e;
+			}
+
+			// A fan diagonal between two edges of the same face would lie in 
+			// that face and clash with the neighboring cube, so pick an apex 
+			// that does not share a face with any vertex it is not adjacent to
+			int32 apex = 0;
+			for (int32 candidate = 0; candidate < length; candidate++) {
+				bool bClear = true;
+				for (int32 k = 2; k + 1 < length; k++) {
+					bClear &= ((edgeFaces[loop[candidate]] & edgeFaces[loop[(candidate + k) % length]]) == 0);
+				}
+				if (bClear) {
+					apex = candidate;
+					break;
+				}
+			}
+
+			for (int32 k = 1; k + 1 < length; k++) {
+				triangles[config][count++] = (int8)loop[apex];
+				triangles[config][count++] = (int8)loop[(apex + k) % length];
+				triangles[config][count++] = (int8)loop[(apex + k + 1) % length];
+			}
+		}
+
+		for (; count < 16; count++) {
+			triangles[config][count] = -1;
+		}
+	}
+}
+
+static const MarchingCubesTable& GetMarchingCubesTable()
+{
+	static const MarchingCubesTable table;
+	return table;
+}
+
+// Surface of one block
+struct BlockMesh {
+	TArray<FVector> vertices;
+	TArray<int32> triangles;
+};
+
+// Runs marching cubes over the cubes whose first corner lies in the block.
+// The far corners of the cubes on the upper faces of the block come from the
+// neighboring blocks; cubes that touch a voxel that was never observed are skipped.
+static void ExtractBlock(const RealSenseFusionVolume& volume, int32 index, TArray<int32>& edgeCache, BlockMesh& mesh)
+{
+	typedef RealSenseFusionVolume::Voxel Voxel;
+	typedef RealSenseFusionVolume::Block Block;
+	const int32 size = RealSenseFusionVolume::BlockSize;
+	const int32 cacheSize = size + 1;
+	const MarchingCubesTable& table = GetMarchingCubesTable();
+
+	const FIntVector& coordinates = volume.GetBlockCoordinates(index);
+	const Block* neighbors[8];
+	for (int32 n = 0; n < 8; n++) {
+		neighbors[n] = (n == 0) ? &volume.GetBlock(index) : 
+			volume.FindBlock(FIntVector(coordinates.X + (n & 1), coordinates.Y + ((n >> 1) & 1), coordinates.Z + (n >> 2)));
+	}
+
+	auto GetVoxel = [&](int32 x, int32 y, int32 z) -> const Voxel* {
+		const int32 n = (x >= size ? 1 : 0) | (y >= size ? 2 : 0) | (z >= size ? 4 : 0);
+		const Block* block = neighbors[n];
+		if (block == nullptr) {
+			return nullptr;
+		}
+		const Voxel& voxel = block->voxels[((z % size) * size + (y % size)) * size + (x % size)];
+		return (voxel.weight > 0) ? &voxel : nullptr;
+	};
+
+	const float voxelSize = volume.GetSettings().voxelSize;
+	const FVector origin((coordinates.X * size + 0.5f) * voxelSize, (coordinates.Y * size + 0.5f) * voxelSize, 
+						 (coordinates.Z * size + 0.5f) * voxelSize);
+
+	edgeCache.SetNumUninitialized(cacheSize * cacheSize * cacheSize * 3);
+	FMemory::Memset(edgeCache.GetData(), 0xFF, edgeCache.Num() * sizeof(int32));
+	mesh.vertices.Reset();
+	mesh.triangles.Reset();
+
+	for (int32 z = 0; z < size; z++) {
+		for (int32 y = 0; y < size; y++) {
+			for (int32 x = 0; x < size; x++) {
+				float distances[8];
+				int32 config = 0;
+				bool bObserved = true;
+				for (int32 corner = 0; corner < 8 && bObserved; corner++) {
+					const Voxel* voxel = GetVoxel(x + (corner & 1), y + ((corner >> 1) & 1), z + (corner >> 2));
+					bObserved = (voxel != nullptr);
+					if (bObserved) {
+						distances[corner] = voxel->distance;
+						config |= (voxel->distance < 0) ? (1 << corner) : 0;
+					}
+				}
+				if ((bObserved == false) || (config == 0) || (config == 255)) {
+					continue;
+				}
+
+				const int8* edges = table.triangles[config];
+				for (int32 i = 0; (i < 16) && (edges[i] >= 0); i++) {
+					const int32 e = edges[i];
+					const int32 a = EdgeCorners[e][0];
+					const int32 ax = x + (a & 1);
+					const int32 ay = y + ((a >> 1) & 1);
+					const int32 az = z + (a >> 2);
+					int32& cached = edgeCache[((az * cacheSize + ay) * cacheSize + ax) * 3 + e / 4];
+
+					if (cached < 0) {
+						const int32 b = EdgeCorners[e][1];
+						const float t = distances[a] / (distances[a] - distances[b]);
+						FVector position = origin + FVector(ax, ay, az) * voxelSize;
+						position[e / 4] += t * voxelSize;
+						cached = mesh.vertices.Add(position);
+					}
+					mesh.triangles.Add(cached);
+				}
+			}
+		}
+	}
+}
+
+void ExtractSurfaceMesh(const RealSenseFusionVolume& volume, FColor color, 
+						TArray<FVector>& vertices, TArray<int32>& triangles, TArray<FColor>& colors)
+{
+	const int32 blockCount = volume.GetBlockCount();
+	TArray<BlockMesh> meshes;
+	meshes.SetNum(blockCount);
+
+	ParallelFor(blockCount, [&](int32 index) {
+		TArray<int32> edgeCache;
+		ExtractBlock(volume, index, edgeCache, meshes[index]);
+	});
+
+	TArray<int32> vertexOffsets;
+	TArray<int32> triangleOffsets;
+	vertexOffsets.SetNumUninitialized(blockCount + 1);
+	triangleOffsets.SetNumUninitialized(blockCount + 1);
+	vertexOffsets[0] = 0;
+	triangleOffsets[0] = 0;
+	for (int32 i = 0; i < blockCount; i++) {
+		vertexOffsets[i + 1] = vertexOffsets[i] + meshes[i].vertices.Num();
+		triangleOffsets[i + 1] = triangleOffsets[i] + meshes[i].triangles.Num();
+	}
+
+	vertices.SetNumUninitialized(vertexOffsets[blockCount]);
+	triangles.SetNumUninitialized(triangleOffsets[blockCount]);
+	colors.Init(color, vertexOffsets[blockCount]);
+
+	ParallelFor(blockCount, [&](int32 i) {
+		const BlockMesh& mesh = meshes[i];
+		FMemory::Memcpy(&vertices[vertexOffsets[i]], mesh.vertices.GetData(), mesh.vertices.Num() * sizeof(FVector));
+		int32* out = &triangles[triangleOffsets[i]];
+		for (int32 k = 0; k < mesh.triangles.Num(); k++) {
+			out[k] = mesh.triangles[k] + vertexOffsets[i];
+		}
+	});
+}
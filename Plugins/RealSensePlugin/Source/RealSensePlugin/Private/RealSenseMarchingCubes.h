@@ -0,0 +1,30 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+
+class RealSenseFusionVolume;
+
+// Extracts the surface of a fusion volume (the zero crossing of its distance
+// field) as a triangle mesh in world space, using marching cubes over the 
+// allocated voxel blocks. Blocks are processed in parallel, each with its own
+// cache of edge vertices so that the cubes of a block share their vertices,
+// and the results are concatenated into the output arrays. Triangles are 
+// wound to face the observed side of the surface. Every vertex gets the given
+// color, since the volume does not store color.
+void ExtractSurfaceMesh(const RealSenseFusionVolume& volume, FColor color, 
+						TArray<FVector>& vertices, TArray<int32>& triangles, TArray<FColor>& colors);
@@ -0,0 +1,315 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseMaskFilter.h"
+#include "RealSenseImageKernels.h"
+#include "ParallelFor.h"
+
+#if RS_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+// Rows handed to a worker thread at a time
+static const int32 RowsPerTask = 32;
+
+// Columns handed to a worker thread at a time by the vertical distance pass
+static const int32 ColumnsPerTask = 128;
+
+template <bool bMax>
+static inline uint8 MinMax(uint8 a, uint8 b)
+{
+	return bMax ? FMath::Max(a, b) : FMath::Min(a, b);
+}
+
+// out[i] = min or max of a[i] and b[i], sixteen pixels at a time.
+template <bool bMax>
+static void MinMaxRows(const uint8* a, const uint8* b, uint8* out, int32 count)
+{
+	int32 i = 0;
+
+#if RS_SIMD_SSE2
+	for (; i + 16 <= count; i += 16) {
+		const __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+		const __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+		_mm_storeu_si128((__m128i*)(out + i), bMax ? _mm_max_epu8(va, vb) : _mm_min_epu8(va, vb));
+	}
+#endif
+
+	for (; i < count; i++) {
+		out[i] = MinMax<bMax>(a[i], b[i]);
+	}
+}
+
+void RealSenseMaskFilter::Erode(uint8* mask, int32 width, int32 height, int32 radius)
+{
+	MinMaxFilter<false>(mask, width, height, radius);
+}
+
+void RealSenseMaskFilter::Dilate(uint8* mask, int32 width, int32 height, int32 radius)
+{
+	MinMaxFilter<true>(mask, width, height, radius);
+}
+
+void RealSenseMaskFilter::Open(uint8* mask, int32 width, int32 height, int32 radius)
+{
+	MinMaxFilter<false>(mask, width, height, radius);
+	MinMaxFilter<true>(mask, width, height, radius);
+}
+
+void RealSenseMaskFilter::Close(uint8* mask, int32 width, int32 height, int32 radius)
+{
+	MinMaxFilter<true>(mask, width, height, radius);
+	MinMaxFilter<false>(mask, width, height, radius);
+}
+
+// van Herk / Gil-Werman: the signal is padded by radius identity values on 
+// both sides and cut into blocks of k = 2 * radius + 1 samples. Within each 
+// block, forward[p] holds the running min/max from the start of the block to
+// p and backward[p] the running min/max from p to the end of the block. Any 
+// window [p, p + k - 1] covers the end of one block and the start of the 
+// next (or exactly one block), so its min/max is op(backward[p], forward[p + k - 1]).
+//
+// The vertical pass applies this to whole rows at a time, so every step is a
+// vector min/max across the width of the image; blocks of rows are 
+// independent and are processed in parallel. The horizontal pass then runs 
+// the scalar recurrence on each row, with rows processed in parallel.
+template <bool bMax>
+void RealSenseMaskFilter::MinMaxFilter(uint8* mask, int32 width, int32 height, int32 radius)
+{
+	if ((radius <= 0) || (width <= 0) || (height <= 0)) {
+		return;
+	}
+
+	const uint8 identity = bMax ? 0 : 255;
+	const int32 k = 2 * radius + 1;
+
+	// Vertical pass
+	const int32 paddedHeight = height + 2 * radius;
+	forward.SetNumUninitialized(paddedHeight * width);
+	backward.SetNumUninitialized(paddedHeight * width);
+	identityRow.SetNumUninitialized(width);
+	FMemory::Memset(identityRow.GetData(), identity, width);
+
+	auto SourceRow = [&](int32 p) -> const uint8* {
+		const int32 y = p - radius;
+		return ((y >= 0) && (y < height)) ? mask + y * width : identityRow.GetData();
+	};
+
+	const int32 numBlocks = (paddedHeight + k - 1) / k;
+	ParallelFor(numBlocks, [&](int32 block) {
+		const int32 first = block * k;
+		const int32 last = FMath::Min(first + k, paddedHeight) - 1;
+
+		FMemory::Memcpy(&forward[first * width], SourceRow(first), width);
+		for (int32 p = first + 1; p <= last; p++) {
+			MinMaxRows<bMax>(&forward[(p - 1) * width], SourceRow(p), &forward[p * width], width);
+		}
+
+		FMemory::Memcpy(&backward[last * width], SourceRow(last), width);
+		for (int32 p = last - 1; p >= first; p--) {
+			MinMaxRows<bMax>(&backward[(p + 1) * width], SourceRow(p), &backward[p * width], width);
+		}
+	});
+
+	ParallelFor((height + RowsPerTask - 1) / RowsPerTask, [&](int32 task) {
+		const int32 last = FMath::Min((task + 1) * RowsPerTask, height);
+		for (int32 y = task * RowsPerTask; y < last; y++) {
+			MinMaxRows<bMax>(&backward[y * width], &forward[(y + k - 1) * width], mask + y * width, width);
+		}
+	});
+
+	// Horizontal pass
+	const int32 paddedWidth = width + 2 * radius;
+
+	ParallelFor((height + RowsPerTask - 1) / RowsPerTask, [&](int32 task) {
+		TArray<uint8> rowForward;
+		TArray<uint8> rowBackward;
+		rowForward.SetNumUninitialized(paddedWidth);
+		rowBackward.SetNumUninitialized(paddedWidth);
+
+		const int32 last = FMath::Min((task + 1) * RowsPerTask, height);
+		for (int32 y = task * RowsPerTask; y < last; y++) {
+			uint8* row = mask + y * width;
+			auto Source = [&](int32 p) -> uint8 {
+				const int32 x = p - radius;
+				return ((x >= 0) && (x < width)) ? row[x] : identity;
+			};
+
+			for (int32 p = 0; p < paddedWidth; p++) {
+				rowForward[p] = ((p % k) == 0) ? Source(p) : MinMax<bMax>(rowForward[p - 1], Source(p));
+			}
+			for (int32 p = paddedWidth - 1; p >= 0; p--) {
+				const bool bBlockEnd = ((p % k) == k - 1) || (p == paddedWidth - 1);
+				rowBackward[p] = bBlockEnd ? Source(p) : MinMax<bMax>(rowBackward[p + 1], Source(p));
+			}
+			for (int32 x = 0; x < width; x++) {
+				row[x] = MinMax<bMax>(rowBackward[x], rowForward[x + k - 1]);
+			}
+		}
+	});
+}
+
+// Computes d2[q] = min over i of ((q - i)^2 + g[i]^2) for a row of n pixels 
+// as the lower envelope of parabolas (Felzenszwalb and Huttenlocher). 
+// v and z must hold n and n + 1 entries.
+static void SquaredDistanceRow(const uint8* g, int32 n, int32* d2, int32* v, float* z)
+{
+	auto F = [g](int32 i) { return (int32)g[i] * g[i]; };
+
+	int32 k = 0;
+	v[0] = 0;
+	z[0] = -FLT_MAX;
+	z[1] = FLT_MAX;
+
+	for (int32 q = 1; q < n; q++) {
+		float s = (float)((F(q) + q * q) - (F(v[k]) + v[k] * v[k])) / (2 * (q - v[k]));
+		while (s <= z[k]) {
+			k--;
+			s = (float)((F(q) + q * q) - (F(v[k]) + v[k] * v[k])) / (2 * (q - v[k]));
+		}
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = FLT_MAX;
+	}
+
+	k = 0;
+	for (int32 q = 0; q < n; q++) {
+		while (z[k + 1] < q) {
+			k++;
+		}
+		d2[q] = (q - v[k]) * (q - v[k]) + F(v[k]);
+	}
+}
+
+// Exact Euclidean distance transform in two separable passes, computed for 
+// both sides of the edge at once and truncated at cap = featherWidth + 1:
+// pixels further than that from the other side are fully opaque or fully 
+// transparent anyway, and the truncation lets the vertical distances live in
+// bytes and be computed sixteen columns at a time with saturating adds. The
+// vertical pass runs in parallel over column strips, the horizontal pass 
+// (lower envelope of parabolas) in parallel over rows.
+void RealSenseMaskFilter::Feather(uint8* mask, int32 width, int32 height, int32 featherWidth)
+{
+	if ((featherWidth <= 1) || (width <= 0) || (height <= 0)) {
+		return;
+	}
+
+	featherWidth = FMath::Min(featherWidth, 254);
+	const uint8 cap = (uint8)(featherWidth + 1);
+	const int32 count = width * height;
+
+	distanceToBackground.SetNumUninitialized(count);
+	distanceToForeground.SetNumUninitialized(count);
+	uint8* toBackground = distanceToBackground.GetData();
+	uint8* toForeground = distanceToForeground.GetData();
+
+	// Vertical distances. Rows outside the image count as infinitely far.
+	ParallelFor((width + ColumnsPerTask - 1) / ColumnsPerTask, [&](int32 task) {
+		const int32 first = task * ColumnsPerTask;
+		const int32 last = FMath::Min(first + ColumnsPerTask, width);
+
+		for (int32 y = 0; y < height; y++) {
+			const int32 row = y * width;
+			const int32 previous = row - width;
+			int32 x = first;
+
+#if RS_SIMD_SSE2
+			const __m128i one = _mm_set1_epi8(1);
+			const __m128i vcap = _mm_set1_epi8((char)cap);
+			const __m128i half = _mm_set1_epi8((char)0x80);
+			for (; x + 16 <= last; x += 16) {
+				const __m128i m = _mm_loadu_si128((const __m128i*)(mask + row + x));
+				const __m128i fg = _mm_cmpeq_epi8(_mm_max_epu8(m, half), m);
+				const __m128i prevBg = (y > 0) ? _mm_loadu_si128((const __m128i*)(toBackground + previous + x)) : vcap;
+				const __m128i prevFg = (y > 0) ? _mm_loadu_si128((const __m128i*)(toForeground + previous + x)) : vcap;
+				const __m128i bg = _mm_and_si128(fg, _mm_min_epu8(_mm_adds_epu8(prevBg, one), vcap));
+				const __m128i fgd = _mm_andnot_si128(fg, _mm_min_epu8(_mm_adds_epu8(prevFg, one), vcap));
+				_mm_storeu_si128((__m128i*)(toBackground + row + x), bg);
+				_mm_storeu_si128((__m128i*)(toForeground + row + x), fgd);
+			}
+#endif
+
+			for (; x < last; x++) {
+				const bool bForeground = mask[row + x] >= 128;
+				const uint8 prevBg = (y > 0) ? toBackground[previous + x] : cap;
+				const uint8 prevFg = (y > 0) ? toForeground[previous + x] : cap;
+				toBackground[row + x] = bForeground ? (uint8)FMath::Min(prevBg + 1, (int32)cap) : 0;
+				toForeground[row + x] = bForeground ? 0 : (uint8)FMath::Min(prevFg + 1, (int32)cap);
+			}
+		}
+
+		for (int32 y = height - 2; y >= 0; y--) {
+			const int32 row = y * width;
+			const int32 next = row + width;
+			int32 x = first;
+
+#if RS_SIMD_SSE2
+			const __m128i one = _mm_set1_epi8(1);
+			for (; x + 16 <= last; x += 16) {
+				const __m128i bg = _mm_loadu_si128((const __m128i*)(toBackground + row + x));
+				const __m128i fg = _mm_loadu_si128((const __m128i*)(toForeground + row + x));
+				const __m128i nextBg = _mm_adds_epu8(_mm_loadu_si128((const __m128i*)(toBackground + next + x)), one);
+				const __m128i nextFg = _mm_adds_epu8(_mm_loadu_si128((const __m128i*)(toForeground + next + x)), one);
+				_mm_storeu_si128((__m128i*)(toBackground + row + x), _mm_min_epu8(bg, nextBg));
+				_mm_storeu_si128((__m128i*)(toForeground + row + x), _mm_min_epu8(fg, nextFg));
+			}
+#endif
+
+			for (; x < last; x++) {
+				toBackground[row + x] = (uint8)FMath::Min((int32)toBackground[row + x], toBackground[next + x] + 1);
+				toForeground[row + x] = (uint8)FMath::Min((int32)toForeground[row + x], toForeground[next + x] + 1);
+			}
+		}
+	});
+
+	// Horizontal pass and ramp. A foreground pixel at distance d from the 
+	// background sits d - 0.5 pixels inside the edge, a background pixel 
+	// d - 0.5 pixels outside of it.
+	const int32 capSquared = (int32)cap * cap;
+	const float rampScale = 1.0f / featherWidth;
+
+	ParallelFor((height + RowsPerTask - 1) / RowsPerTask, [&](int32 task) {
+		TArray<int32> rowBackground;
+		TArray<int32> rowForeground;
+		TArray<int32> v;
+		TArray<float> z;
+		rowBackground.SetNumUninitialized(width);
+		rowForeground.SetNumUninitialized(width);
+		v.SetNumUninitialized(width);
+		z.SetNumUninitialized(width + 1);
+
+		const int32 last = FMath::Min((task + 1) * RowsPerTask, height);
+		for (int32 y = task * RowsPerTask; y < last; y++) {
+			const int32 row = y * width;
+			SquaredDistanceRow(toBackground + row, width, rowBackground.GetData(), v.GetData(), z.GetData());
+			SquaredDistanceRow(toForeground + row, width, rowForeground.GetData(), v.GetData(), z.GetData());
+
+			for (int32 x = 0; x < width; x++) {
+				const bool bForeground = mask[row + x] >= 128;
+				const int32 d2 = bForeground ? rowBackground[x] : rowForeground[x];
+				if (d2 >= capSquared) {
+					mask[row + x] = bForeground ? 255 : 0;
+					continue;
+				}
+
+				const float inside = FMath::Sqrt((float)d2) - 0.5f;
+				const float alpha = 0.5f + (bForeground ? inside : -inside) * rampScale;
+				mask[row + x] = (uint8)FMath::RoundToInt(FMath::Clamp(alpha, 0.0f, 1.0f) * 255.0f);
+			}
+		}
+	});
+}
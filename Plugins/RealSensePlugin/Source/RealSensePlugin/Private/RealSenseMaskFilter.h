@@ -0,0 +1,59 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+
+// Morphological cleanup and edge feathering of 8-bit segmentation masks 
+// (0 = background, 255 = foreground). All operations work in place and reuse
+// the scratch buffers of the filter, so one filter should be kept per thread.
+//
+// Erosion and dilation use a (2 * radius + 1) square window, computed as a 
+// vertical and a horizontal pass of the van Herk / Gil-Werman running minimum
+// or maximum, which costs three comparisons per pixel and pass whatever the 
+// radius. Both passes are split across worker threads by rows.
+class RealSenseMaskFilter {
+public:
+	// Shrinks the foreground: every pixel becomes the minimum of its window.
+	void Erode(uint8* mask, int32 width, int32 height, int32 radius);
+
+	// Grows the foreground: every pixel becomes the maximum of its window.
+	void Dilate(uint8* mask, int32 width, int32 height, int32 radius);
+
+	// Erosion followed by dilation. Removes foreground specks smaller than 
+	// the window without moving the rest of the outline.
+	void Open(uint8* mask, int32 width, int32 height, int32 radius);
+
+	// Dilation followed by erosion. Fills background holes and notches 
+	// smaller than the window without moving the rest of the outline.
+	void Close(uint8* mask, int32 width, int32 height, int32 radius);
+
+	// Replaces the hard edge between foreground (>= 128) and background with
+	// a linear ramp featherWidth pixels wide, centered on the edge, based on 
+	// the Euclidean distance of every pixel to the other side. The image 
+	// border is not treated as an edge. featherWidth is clamped to 254.
+	void Feather(uint8* mask, int32 width, int32 height, int32 featherWidth);
+
+private:
+	template <bool bMax>
+	void MinMaxFilter(uint8* mask, int32 width, int32 height, int32 radius);
+
+	TArray<uint8> forward;  // Running min/max from the start of each block
+	TArray<uint8> backward;  // Running min/max to the end of each block
+	TArray<uint8> identityRow;  // Row of padding values outside the image
+	TArray<uint8> distanceToBackground;  // Vertical distances, capped to the feather width
+	TArray<uint8> distanceToForeground;
+};
@@ -0,0 +1,635 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseMeshBVH.h"
+#include "ParallelFor.h"
+
+// Triangles handed to a worker thread at a time when preparing the build
+static const int32 TrianglesPerTask = 4096;
+
+// Leaves hold at most this many triangles
+static const int32 MaxLeafTriangles = 8;
+
+// Bins per axis evaluated for each split
+static const int32 NumBins = 16;
+
+// Cost of visiting a node relative to testing a triangle
+static const float TraversalCost = 1.0f;
+
+// The top of the tree is split until there are about this many subtrees to 
+// build in parallel, each of at least MinSubtreeTriangles triangles
+static const int32 TargetSubtrees = 64;
+static const int32 MinSubtreeTriangles = 4096;
+
+// Half the surface area of a box, which is all the heuristic needs
+static inline float GetHalfArea(const FVector& boundsMin, const FVector& boundsMax)
+{
+	const FVector size = boundsMax - boundsMin;
+	return size.X * size.Y + size.Y * size.Z + size.Z * size.X;
+}
+
+RealSenseMeshBVH::RealSenseMeshBVH()
+{
+	vertices = nullptr;
+	triangles = nullptr;
+}
+
+void RealSenseMeshBVH::Reset()
+{
+	vertices = nullptr;
+	triangles = nullptr;
+	nodes.Empty();
+	leafTriangles.Empty();
+}
+
+void RealSenseMeshBVH::Rebind(const TArray<FVector>& inVertices, const TArray<int32>& inTriangles)
+{
+	vertices = &inVertices;
+	triangles = &inTriangles;
+}
+
+SIZE_T RealSenseMeshBVH::GetAllocatedSize() const
+{
+	return nodes.GetAllocatedSize() + leafTriangles.GetAllocatedSize();
+}
+
+void RealSenseMeshBVH::Build(const TArray<FVector>& inVertices, const TArray<int32>& inTriangles)
+{
+	Reset();
+	vertices = &inVertices;
+	triangles = &inTriangles;
+
+	const int32 vertexCount = inVertices.Num();
+	const int32 triangleCount = inTriangles.Num() / 3;
+	const int32 numTasks = (triangleCount + TrianglesPerTask - 1) / TrianglesPerTask;
+
+	// Triangles with out-of-range indices are left out of the tree
+	TArray<uint8> bValid;
+	triangleBounds.SetNumUninitialized(triangleCount);
+	centroids.SetNumUninitialized(triangleCount);
+	bValid.SetNumUninitialized(triangleCount);
+	ParallelFor(numTasks, [&](int32 task) {
+		const int32 last = FMath::Min((task + 1) * TrianglesPerTask, triangleCount);
+		for (int32 t = task * TrianglesPerTask; t < last; t++) {
+			const int32* corners = &inTriangles[t * 3];
+			bValid[t] = ((uint32)corners[0] < (uint32)vertexCount) && ((uint32)corners[1] < (uint32)vertexCount) && 
+						((uint32)corners[2] < (uint32)vertexCount);
+			if (bValid[t]) {
+				FVector a, b, c;
+				GetTriangle(t, a, b, c);
+				triangleBounds[t].Min = a.ComponentMin(b).ComponentMin(c);
+				triangleBounds[t].Max = a.ComponentMax(b).ComponentMax(c);
+				centroids[t] = (triangleBounds[t].Min + triangleBounds[t].Max) * 0.5f;
+			}
+		}
+	});
+
+	leafTriangles.Reserve(triangleCount);
+	for (int32 t = 0; t < triangleCount; t++) {
+		if (bValid[t]) {
+			leafTriangles.Add(t);
+		}
+	}
+
+	if (leafTriangles.Num() > 0) {
+		const int32 deferBelow = FMath::Max(leafTriangles.Num() / TargetSubtrees, MinSubtreeTriangles);
+		TArray<PendingSubtree> pending;
+		nodes.AddUninitialized(1);
+		BuildNode(nodes, 0, 0, leafTriangles.Num(), deferBelow, &pending);
+
+		TArray<TArray<Node>> subtrees;
+		subtrees.SetNum(pending.Num());
+		ParallelFor(pending.Num(), [&](int32 i) {
+			subtrees[i].AddUninitialized(1);
+			BuildNode(subtrees[i], 0, pending[i].first, pending[i].count, 0, nullptr);
+		});
+
+		// Splices each subtree in: its root replaces the placeholder node and
+		// the rest is appended, with child indices offset accordingly
+		for (int32 i = 0; i < pending.Num(); i++) {
+			const TArray<Node>& subtree = subtrees[i];
+			const int32 offset = nodes.Num() - 1;
+			for (int32 k = 0; k < subtree.Num(); k++) {
+				Node node = subtree[k];
+				if (node.count == 0) {
+					node.index += offset;
+				}
+				if (k == 0) {
+					nodes[pending[i].node] = node;
+				}
+				else {
+					nodes.Add(node);
+				}
+			}
+		}
+	}
+
+	triangleBounds.Empty();
+	centroids.Empty();
+}
+
+// Splits at the bin boundary with the lowest surface area cost over all 
+// three axes, or makes a leaf if no split is cheaper than testing every 
+// triangle. Ranges whose centroids all coincide are split in half.
+void RealSenseMeshBVH::BuildNode(TArray<Node>& outNodes, int32 node, int32 first, int32 count, 
+								 int32 deferBelow, TArray<PendingSubtree>* pending)
+{
+	const int32* range = leafTriangles.GetData() + first;
+
+	FVector boundsMin(MAX_flt), boundsMax(-MAX_flt);
+	FVector centroidMin(MAX_flt), centroidMax(-MAX_flt);
+	for (int32 i = 0; i < count; i++) {
+		const FBox& bounds = triangleBounds[range[i]];
+		boundsMin = boundsMin.ComponentMin(bounds.Min);
+		boundsMax = boundsMax.ComponentMax(bounds.Max);
+		centroidMin = centroidMin.ComponentMin(centroids[range[i]]);
+		centroidMax = centroidMax.ComponentMax(centroids[range[i]]);
+	}
+
+	outNodes[node].boundsMin = boundsMin;
+	outNodes[node].boundsMax = boundsMax;
+	outNodes[node].index = first;
+	outNodes[node].count = count;
+
+	if (count <= MaxLeafTriangles) {
+		return;
+	}
+	if ((pending != nullptr) && (count < deferBelow)) {
+		PendingSubtree subtree = { node, first, count };
+		pending->Add(subtree);
+		return;
+	}
+
+	int32 bestAxis = -1;
+	int32 bestSplit = 0;
+	float bestCost = MAX_flt;
+	const FVector centroidExtent = centroidMax - centroidMin;
+
+	for (int32 axis = 0; axis < 3; axis++) {
+		if (centroidExtent[axis] <= 0.0f) {
+			continue;
+		}
+
+		int32 binCounts[NumBins] = {};
+		FVector binMin[NumBins];
+		FVector binMax[NumBins];
+		for (int32 b = 0; b < NumBins; b++) {
+			binMin[b] = FVector(MAX_flt);
+			binMax[b] = FVector(-MAX_flt);
+		}
+
+		const float scale = NumBins * (1.0f - KINDA_SMALL_NUMBER) / centroidExtent[axis];
+		for (int32 i = 0; i < count; i++) {
+			const int32 b = FMath::Min((int32)((centroids[range[i]][axis] - centroidMin[axis]) * scale), NumBins - 1);
+			const FBox& bounds = triangleBounds[range[i]];
+			binCounts[b]++;
+			binMin[b] = binMin[b].ComponentMin(bounds.Min);
+			binMax[b] = binMax[b].ComponentMax(bounds.Max);
+		}
+
+		// Sweeps from the right to get the cost of every right-hand side, 
+		// then from the left to combine it with every left-hand side
+		float rightCosts[NumBins];
+		FVector sweepMin(MAX_flt), sweepMax(-MAX_flt);
+		int32 sweepCount = 0;
+		for (int32 b = NumBins - 1; b > 0; b--) {
+			sweepMin = sweepMin.ComponentMin(binMin[b]);
+			sweepMax = sweepMax.ComponentMax(binMax[b]);
+			sweepCount += binCounts[b];
+			rightCosts[b] = (sweepCount > 0) ? sweepCount * GetHalfArea(sweepMin, sweepMax) : 0.0f;
+		}
+
+		sweepMin = FVector(MAX_flt);
+		sweepMax = FVector(-MAX_flt);
+		sweepCount = 0;
+		for (int32 b = 0; b < NumBins - 1; b++) {
+			sweepMin = sweepMin.ComponentMin(binMin[b]);
+			sweepMax = sweepMax.ComponentMax(binMax[b]);
+			sweepCount += binCounts[b];
+			if ((sweepCount == 0) || (sweepCount == count)) {
+				continue;
+			}
+			const float cost = sweepCount * GetHalfArea(sweepMin, sweepMax) + rightCosts[b + 1];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = b + 1;
+			}
+		}
+	}
+
+	int32 leftCount = 0;
+	if (bestAxis >= 0) {
+		const float parentArea = GetHalfArea(boundsMin, boundsMax);
+		const float splitCost = TraversalCost + ((parentArea > 0.0f) ? bestCost / parentArea : 0.0f);
+		if ((splitCost >= count) && (count <= MaxLeafTriangles * 4)) {
+			return;
+		}
+
+		// Partitions the range in place around the chosen bin boundary
+		const float scale = NumBins * (1.0f - KINDA_SMALL_NUMBER) / centroidExtent[bestAxis];
+		int32* partition = leafTriangles.GetData() + first;
+		int32 left = 0;
+		int32 right = count - 1;
+		while (left <= right) {
+			const int32 b = FMath::Min((int32)((centroids[partition[left]][bestAxis] - centroidMin[bestAxis]) * scale), NumBins - 1);
+			if (b < bestSplit) {
+				left++;
+			}
+			else {
+				Swap(partition[left], partition[right]);
+				right--;
+			}
+		}
+		leftCount = left;
+	}
+	else {
+		leftCount = count / 2;
+	}
+
+	const int32 children = outNodes.AddUninitialized(2);
+	outNodes[node].index = children;
+	outNodes[node].count = 0;
+	BuildNode(outNodes, children, first, leftCount, deferBelow, pending);
+	BuildNode(outNodes, children + 1, first + leftCount, count - leftCount, deferBelow, pending);
+}
+
+// Returns the distance along the ray at which it enters the box, or a 
+// negative value if it misses the box before maxDistance.
+static inline float IntersectBox(const RealSenseMeshBVH::Node& node, const FVector& origin, 
+								 const FVector& inverseDirection, float maxDistance)
+{
+	const FVector t0 = (node.boundsMin - origin) * inverseDirection;
+	const FVector t1 = (node.boundsMax - origin) * inverseDirection;
+	const FVector tMin = t0.ComponentMin(t1);
+	const FVector tMax = t0.ComponentMax(t1);
+	const float enter = FMath::Max(FMath::Max(tMin.X, tMin.Y), FMath::Max(tMin.Z, 0.0f));
+	const float exit = FMath::Min(FMath::Min(tMax.X, tMax.Y), FMath::Min(tMax.Z, maxDistance));
+	return (enter <= exit) ? enter : -1.0f;
+}
+
+// Moller-Trumbore ray-triangle intersection, from either side
+static inline bool IntersectTriangle(const FVector& origin, const FVector& direction, const FVector& a, 
+									 const FVector& b, const FVector& c, float& outDistance)
+{
+	const FVector edge1 = b - a;
+	const FVector edge2 = c - a;
+	const FVector p = FVector::CrossProduct(direction, edge2);
+	const float det = FVector::DotProduct(edge1, p);
+	if (FMath::Abs(det) < 1e-12f) {
+		return false;
+	}
+
+	const float inverse = 1.0f / det;
+	const FVector s = origin - a;
+	const float u = FVector::DotProduct(s, p) * inverse;
+	if ((u < 0.0f) || (u > 1.0f)) {
+		return false;
+	}
+
+	const FVector q = FVector::CrossProduct(s, edge1);
+	const float v = FVector::DotProduct(direction, q) * inverse;
+	if ((v < 0.0f) || (u + v > 1.0f)) {
+		return false;
+	}
+
+	outDistance = FVector::DotProduct(edge2, q) * inverse;
+	return outDistance >= 0.0f;
+}
+
+// Visits the nearer child first and skips nodes entered beyond the nearest hit so far.
+bool RealSenseMeshBVH::Raycast(const FVector& origin, const FVector& direction, float maxDistance, RayHit& outHit) const
+{
+	const float length = direction.Size();
+	if (IsEmpty() || (length <= 0.0f)) {
+		return false;
+	}
+
+	const FVector unitDirection = direction / length;
+	const FVector inverseDirection((unitDirection.X != 0.0f) ? 1.0f / unitDirection.X : BIG_NUMBER, 
+								   (unitDirection.Y != 0.0f) ? 1.0f / unitDirection.Y : BIG_NUMBER, 
+								   (unitDirection.Z != 0.0f) ? 1.0f / unitDirection.Z : BIG_NUMBER);
+
+	float nearest = maxDistance;
+	int32 hitTriangle = -1;
+
+	if (IntersectBox(nodes[0], origin, inverseDirection, nearest) < 0.0f) {
+		return false;
+	}
+
+	TArray<int32, TInlineAllocator<64>> stack;
+	stack.Add(0);
+	while (stack.Num() > 0) {
+		const Node& node = nodes[stack.Pop(false)];
+
+		if (node.count > 0) {
+			for (int32 i = 0; i < node.count; i++) {
+				const int32 triangle = leafTriangles[node.index + i];
+				FVector a, b, c;
+				GetTriangle(triangle, a, b, c);
+				float distance;
+				if (IntersectTriangle(origin, unitDirection, a, b, c, distance) && (distance < nearest)) {
+					nearest = distance;
+					hitTriangle = triangle;
+				}
+			}
+			continue;
+		}
+
+		const float leftDistance = IntersectBox(nodes[node.index], origin, inverseDirection, nearest);
+		const float rightDistance = IntersectBox(nodes[node.index + 1], origin, inverseDirection, nearest);
+		if ((leftDistance >= 0.0f) && (rightDistance >= 0.0f)) {
+			const bool bLeftFirst = (leftDistance <= rightDistance);
+			stack.Add(bLeftFirst ? node.index + 1 : node.index);
+			stack.Add(bLeftFirst ? node.index : node.index + 1);
+		}
+		else if (leftDistance >= 0.0f) {
+			stack.Add(node.index);
+		}
+		else if (rightDistance >= 0.0f) {
+			stack.Add(node.index + 1);
+		}
+	}
+
+	if (hitTriangle < 0) {
+		return false;
+	}
+
+	FVector a, b, c;
+	GetTriangle(hitTriangle, a, b, c);
+	outHit.distance = nearest;
+	outHit.triangle = hitTriangle;
+	outHit.position = origin + unitDirection * nearest;
+	outHit.normal = FVector::CrossProduct(b - a, c - a).GetSafeNormal();
+	return true;
+}
+
+// Returns the point of triangle abc closest to p (Ericson, "Real-Time 
+// Collision Detection", 5.1.5).
+static FVector GetClosestPointOnTriangle(const FVector& p, const FVector& a, const FVector& b, const FVector& c)
+{
+	const FVector ab = b - a;
+	const FVector ac = c - a;
+	const FVector ap = p - a;
+	const float d1 = FVector::DotProduct(ab, ap);
+	const float d2 = FVector::DotProduct(ac, ap);
+	if ((d1 <= 0.0f) && (d2 <= 0.0f)) {
+		return a;
+	}
+
+	const FVector bp = p - b;
+	const float d3 = FVector::DotProduct(ab, bp);
+	const float d4 = FVector::DotProduct(ac, bp);
+	if ((d3 >= 0.0f) && (d4 <= d3)) {
+		return b;
+	}
+
+	const float vc = d1 * d4 - d3 * d2;
+	if ((vc <= 0.0f) && (d1 >= 0.0f) && (d3 <= 0.0f)) {
+		return a + ab * (d1 / (d1 - d3));
+	}
+
+	const FVector cp = p - c;
+	const float d5 = FVector::DotProduct(ab, cp);
+	const float d6 = FVector::DotProduct(ac, cp);
+	if ((d6 >= 0.0f) && (d5 <= d6)) {
+		return c;
+	}
+
+	const float vb = d5 * d2 - d1 * d6;
+	if ((vb <= 0.0f) && (d2 >= 0.0f) && (d6 <= 0.0f)) {
+		return a + ac * (d2 / (d2 - d6));
+	}
+
+	const float va = d3 * d6 - d5 * d4;
+	if ((va <= 0.0f) && ((d4 - d3) >= 0.0f) && ((d5 - d6) >= 0.0f)) {
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+
+	const float denominator = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+static inline float GetBoxDistanceSquared(const RealSenseMeshBVH::Node& node, const FVector& point)
+{
+	const FVector clamped = point.ComponentMax(node.boundsMin).ComponentMin(node.boundsMax);
+	return (clamped - point).SizeSquared();
+}
+
+// Visits the child whose box is nearer first and skips boxes farther than 
+// the closest point found so far.
+bool RealSenseMeshBVH::FindClosestPoint(const FVector& point, float maxDistance, FVector& outPoint, int32& outTriangle) const
+{
+	if (IsEmpty()) {
+		return false;
+	}
+
+	float nearest = maxDistance * maxDistance;
+	int32 nearestTriangle = -1;
+
+	TArray<int32, TInlineAllocator<64>> stack;
+	stack.Add(0);
+	while (stack.Num() > 0) {
+		const Node& node = nodes[stack.Pop(false)];
+		if (GetBoxDistanceSquared(node, point) > nearest) {
+			continue;
+		}
+
+		if (node.count > 0) {
+			for (int32 i = 0; i < node.count; i++) {
+				const int32 triangle = leafTriangles[node.index + i];
+				FVector a, b, c;
+				GetTriangle(triangle, a, b, c);
+				const FVector candidate = GetClosestPointOnTriangle(point, a, b, c);
+				const float distance = (candidate - point).SizeSquared();
+				if (distance <= nearest) {
+					nearest = distance;
+					nearestTriangle = triangle;
+					outPoint = candidate;
+				}
+			}
+			continue;
+		}
+
+		const float leftDistance = GetBoxDistanceSquared(nodes[node.index], point);
+		const float rightDistance = GetBoxDistanceSquared(nodes[node.index + 1], point);
+		const bool bLeftFirst = (leftDistance <= rightDistance);
+		stack.Add(bLeftFirst ? node.index + 1 : node.index);
+		stack.Add(bLeftFirst ? node.index : node.index + 1);
+	}
+
+	outTriangle = nearestTriangle;
+	return nearestTriangle >= 0;
+}
+
+// Separating axis test between a triangle and a box given by its center and
+// half size (Akenine-Moller, "Fast 3D Triangle-Box Overlap Testing"): the 
+// box axes, the triangle normal, and the nine cross products of their edges.
+static bool TriangleOverlapsBox(const FVector& center, const FVector& extent, 
+								const FVector& a, const FVector& b, const FVector& c)
+{
+	const FVector v[3] = { a - center, b - center, c - center };
+	const FVector edges[3] = { v[1] - v[0], v[2] - v[1], v[0] - v[2] };
+
+	for (int32 e = 0; e < 3; e++) {
+		for (int32 axisIndex = 0; axisIndex < 3; axisIndex++) {
+			FVector boxAxis(0.0f, 0.0f, 0.0f);
+			boxAxis[axisIndex] = 1.0f;
+			const FVector axis = FVector::CrossProduct(edges[e], boxAxis);
+
+			const float p0 = FVector::DotProduct(v[0], axis);
+			const float p1 = FVector::DotProduct(v[1], axis);
+			const float p2 = FVector::DotProduct(v[2], axis);
+			const float radius = extent.X * FMath::Abs(axis.X) + extent.Y * FMath::Abs(axis.Y) + 
+								 extent.Z * FMath::Abs(axis.Z);
+			if ((FMath::Min3(p0, p1, p2) > radius) || (FMath::Max3(p0, p1, p2) < -radius)) {
+				return false;
+			}
+		}
+	}
+
+	const FVector normal = FVector::CrossProduct(edges[0], edges[1]);
+	const float offset = FVector::DotProduct(normal, v[0]);
+	const float radius = extent.X * FMath::Abs(normal.X) + extent.Y * FMath::Abs(normal.Y) + 
+						 extent.Z * FMath::Abs(normal.Z);
+	return FMath::Abs(offset) <= radius;
+}
+
+void RealSenseMeshBVH::FindOverlappingTriangles(const FBox& box, TArray<int32>& outTriangles) const
+{
+	if (IsEmpty()) {
+		return;
+	}
+
+	const FVector center = box.GetCenter();
+	const FVector extent = box.GetExtent();
+
+	TArray<int32, TInlineAllocator<64>> stack;
+	stack.Add(0);
+	while (stack.Num() > 0) {
+		const Node& node = nodes[stack.Pop(false)];
+		if ((node.boundsMin.X > box.Max.X) || (node.boundsMax.X < box.Min.X) || 
+			(node.boundsMin.Y > box.Max.Y) || (node.boundsMax.Y < box.Min.Y) || 
+			(node.boundsMin.Z > box.Max.Z) || (node.boundsMax.Z < box.Min.Z)) {
+			continue;
+		}
+
+		if (node.count == 0) {
+			stack.Add(node.index);
+			stack.Add(node.index + 1);
+			continue;
+		}
+
+		for (int32 i = 0; i < node.count; i++) {
+			const int32 triangle = leafTriangles[node.index + i];
+			FVector a, b, c;
+			GetTriangle(triangle, a, b, c);
+
+			// Triangles whose bounds are inside the box need no further test
+			const FVector triangleMin = a.ComponentMin(b).ComponentMin(c);
+			const FVector triangleMax = a.ComponentMax(b).ComponentMax(c);
+			if ((triangleMin.X > box.Max.X) || (triangleMax.X < box.Min.X) || 
+				(triangleMin.Y > box.Max.Y) || (triangleMax.Y < box.Min.Y) || 
+				(triangleMin.Z > box.Max.Z) || (triangleMax.Z < box.Min.Z)) {
+				continue;
+			}
+			if (((triangleMin.X >= box.Min.X) && (triangleMax.X <= box.Max.X) && 
+				 (triangleMin.Y >= box.Min.Y) && (triangleMax.Y <= box.Max.Y) && 
+				 (triangleMin.Z >= box.Min.Z) && (triangleMax.Z <= box.Max.Z)) || 
+				TriangleOverlapsBox(center, extent, a, b, c)) {
+				outTriangles.Add(triangle);
+			}
+		}
+	}
+}
+
+// The mesh is a latitude-longitude sphere of radius 50 cm with 1 cm bumps.
+// Rays are cast from a sphere of radius 100 cm towards random points near 
+// the center, closest points are looked up from random points within 10 cm
+// of the surface, and overlaps are tested with 5 cm boxes on the surface.
+FMeshBVHBenchmarkResult RealSenseMeshBVH::RunSyntheticBenchmark(int32 triangleCount, int32 queryCount)
+{
+	const int32 side = FMath::Max(FMath::CeilToInt(FMath::Sqrt(triangleCount * 0.5f)), 3);
+	TArray<FVector> vertices;
+	TArray<int32> triangles;
+	vertices.Reserve(side * side);
+	triangles.Reserve((side - 1) * side * 6);
+
+	for (int32 row = 0; row < side; row++) {
+		const float theta = PI * (row + 0.5f) / side;
+		for (int32 column = 0; column < side; column++) {
+			const float phi = 2.0f * PI * column / side;
+			const float radius = 50.0f + FMath::Sin(theta * 12.0f) * FMath::Sin(phi * 12.0f);
+			vertices.Add(FVector(FMath::Sin(theta) * FMath::Cos(phi), FMath::Sin(theta) * FMath::Sin(phi), 
+								 FMath::Cos(theta)) * radius);
+		}
+	}
+
+	for (int32 row = 0; row + 1 < side; row++) {
+		for (int32 column = 0; column < side; column++) {
+			const int32 a = row * side + column;
+			const int32 b = row * side + (column + 1) % side;
+			triangles.Add(a);
+			triangles.Add(a + side);
+			triangles.Add(b);
+			triangles.Add(b);
+			triangles.Add(a + side);
+			triangles.Add(b + side);
+		}
+	}
+
+	FMeshBVHBenchmarkResult result;
+	result.TriangleCount = triangles.Num() / 3;
+
+	RealSenseMeshBVH bvh;
+	const double buildStart = FPlatformTime::Seconds();
+	bvh.Build(vertices, triangles);
+	result.BuildMs = (FPlatformTime::Seconds() - buildStart) * 1000.0;
+	result.NodeCount = bvh.GetNodeCount();
+	result.MemoryKB = (int32)(bvh.GetAllocatedSize() / 1024);
+
+	const int32 queries = FMath::Max(queryCount, 1);
+	FRandomStream random(1);
+	int32 hits = 0;
+
+	double start = FPlatformTime::Seconds();
+	for (int32 i = 0; i < queries; i++) {
+		const FVector origin = random.GetUnitVector() * 100.0f;
+		const FVector target = random.GetUnitVector() * 10.0f;
+		RayHit hit;
+		hits += bvh.Raycast(origin, target - origin, 200.0f, hit) ? 1 : 0;
+	}
+	result.RaycastMicroseconds = (FPlatformTime::Seconds() - start) * 1e6 / queries;
+	result.RaycastHitRatio = (float)hits / queries;
+
+	start = FPlatformTime::Seconds();
+	for (int32 i = 0; i < queries; i++) {
+		FVector closest;
+		int32 triangle;
+		bvh.FindClosestPoint(random.GetUnitVector() * random.FRandRange(40.0f, 60.0f), 20.0f, closest, triangle);
+	}
+	result.ClosestPointMicroseconds = (FPlatformTime::Seconds() - start) * 1e6 / queries;
+
+	TArray<int32> overlapping;
+	start = FPlatformTime::Seconds();
+	for (int32 i = 0; i < queries; i++) {
+		overlapping.Reset();
+		bvh.FindOverlappingTriangles(FBox::BuildAABB(random.GetUnitVector() * 50.0f, FVector(2.5f)), overlapping);
+	}
+	result.OverlapMicroseconds = (FPlatformTime::Seconds() - start) * 1e6 / queries;
+
+	return result;
+}
@@ -0,0 +1,111 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+
+// Bounding volume hierarchy over the triangles of a mesh, for ray casts, 
+// closest point, and box overlap queries in the space of the mesh.
+//
+// The tree is built top-down with the surface area heuristic evaluated over
+// a few bins per axis. The top levels are built on the calling thread until 
+// there are enough independent subtrees, which are then built in parallel 
+// and spliced in. Nodes are 32 bytes, with the two children of a node next 
+// to each other, and leaves refer to runs of a reordered triangle list.
+//
+// The BVH keeps pointers to the vertex and index arrays it was built from, 
+// which must not change until it is rebuilt or reset. Arrays that are moved
+// elsewhere must be handed back to it with Rebind().
+class RealSenseMeshBVH {
+public:
+	struct Node {
+		FVector boundsMin;
+		int32 index;  // First child for inner nodes, first triangle for leaves
+		FVector boundsMax;
+		int32 count;  // Number of triangles in a leaf, 0 for inner nodes
+	};
+
+	struct RayHit {
+		float distance;  // Along the normalized direction
+		int32 triangle;
+		FVector position;
+		FVector normal;  // Unit normal on the front side of the triangle
+	};
+
+	RealSenseMeshBVH();
+
+	void Build(const TArray<FVector>& vertices, const TArray<int32>& triangles);
+
+	void Reset();
+
+	// Points the tree at arrays with the same contents as those it was built
+	// from, such as after they were moved into another object.
+	void Rebind(const TArray<FVector>& vertices, const TArray<int32>& triangles);
+
+	inline bool IsEmpty() const { return nodes.Num() == 0; }
+
+	inline int32 GetNodeCount() const { return nodes.Num(); }
+
+	SIZE_T GetAllocatedSize() const;
+
+	// Finds the nearest triangle hit by the ray within maxDistance, from 
+	// either side. The direction does not need to be normalized.
+	bool Raycast(const FVector& origin, const FVector& direction, float maxDistance, RayHit& outHit) const;
+
+	// Finds the point of the mesh closest to the given point within maxDistance.
+	bool FindClosestPoint(const FVector& point, float maxDistance, FVector& outPoint, int32& outTriangle) const;
+
+	// Appends the triangles that intersect the box.
+	void FindOverlappingTriangles(const FBox& box, TArray<int32>& outTriangles) const;
+
+	// Builds a bumpy sphere of about triangleCount triangles, then measures 
+	// the time to build the BVH and to answer random queries against it.
+	static FMeshBVHBenchmarkResult RunSyntheticBenchmark(int32 triangleCount, int32 queryCount);
+
+private:
+	const TArray<FVector>* vertices;
+	const TArray<int32>* triangles;
+
+	TArray<Node> nodes;
+
+	// Triangles in leaf order
+	TArray<int32> leafTriangles;
+
+	// Bounds and centroids of the triangles, only kept while building
+	TArray<FBox> triangleBounds;
+	TArray<FVector> centroids;
+
+	// A subtree left to be built in parallel
+	struct PendingSubtree {
+		int32 node;
+		int32 first;
+		int32 count;
+	};
+
+	// Builds the subtree of the triangles leafTriangles[first, first + count)
+	// into outNodes[node], appending its descendants to outNodes. Subtrees 
+	// with fewer than deferBelow triangles are added to pending instead.
+	void BuildNode(TArray<Node>& outNodes, int32 node, int32 first, int32 count, 
+				   int32 deferBelow, TArray<PendingSubtree>* pending);
+
+	inline void GetTriangle(int32 triangle, FVector& a, FVector& b, FVector& c) const
+	{
+		const int32* corners = triangles->GetData() + triangle * 3;
+		a = (*vertices)[corners[0]];
+		b = (*vertices)[corners[1]];
+		c = (*vertices)[corners[2]];
+	}
+};
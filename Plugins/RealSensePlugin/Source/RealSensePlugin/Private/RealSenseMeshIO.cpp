@@ -0,0 +1,587 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseMeshIO.h"
+#include "RealSenseUtils.h"
+#include "PlatformFilemanager.h"
+
+// Size of the buffer that records are written into; the file is written 
+// each time it fills up
+static const int32 WriteBufferSize = 4 * 1024 * 1024;
+
+// Size in bytes of a PLY vertex (float x, y, z and uchar red, green, blue)
+// and face (uchar count and three int indices) record
+static const int32 PLYPositionSize = 3 * sizeof(float);
+static const int32 PLYColorSize = 3;
+static const int32 PLYFaceSize = 1 + 3 * sizeof(int32);
+
+// Marks the PLY and STL files written by SaveMeshFile(), in the PLY comments
+// and at the start of the STL header
+static const ANSICHAR UnitsMark[] = "RealSense scan, units are centimeters";
+static const int32 UnitsMarkLength = sizeof(UnitsMark) - 1;
+
+// Size in bytes of the header, triangle count and triangle records of a binary STL file
+static const int32 STLHeaderSize = 80;
+static const int32 STLTriangleSize = 12 * sizeof(float) + sizeof(uint16);
+
+// Writes a file through a large buffer.
+class BufferedFileWriter {
+public:
+	explicit BufferedFileWriter(const FString& filename) 
+		: handle(FPlatformFileManager::Get().GetPlatformFile().OpenWrite(*filename)), bFailed(handle == nullptr)
+	{
+		buffer.Reserve(WriteBufferSize);
+	}
+
+	~BufferedFileWriter() 
+	{
+		delete handle;
+	}
+
+	inline bool IsOpen() const { return handle != nullptr; }
+
+	// Returns room for a record of size bytes at the end of the buffer, 
+	// writing the buffer out first if the record does not fit.
+	inline uint8* Append(int32 size)
+	{
+		if (buffer.Num() + size > WriteBufferSize) {
+			Flush();
+		}
+		return buffer.GetData() + buffer.AddUninitialized(size);
+	}
+
+	inline void Write(const void* data, int32 size)
+	{
+		FMemory::Memcpy(Append(size), data, size);
+	}
+
+	void Flush()
+	{
+		if ((handle != nullptr) && (buffer.Num() > 0)) {
+			bFailed |= (handle->Write(buffer.GetData(), buffer.Num()) == false);
+		}
+		buffer.Reset();
+	}
+
+	// Writes out the rest of the buffer and closes the file. Returns false 
+	// if any write failed.
+	bool Close()
+	{
+		Flush();
+		delete handle;
+		handle = nullptr;
+		return (bFailed == false);
+	}
+
+private:
+	IFileHandle* handle;
+	TArray<uint8> buffer;
+	bool bFailed;
+};
+
+static void WriteText(BufferedFileWriter& writer, const FString& text)
+{
+	FTCHARToUTF8 converter(*text);
+	writer.Write(converter.Get(), converter.Length());
+}
+
+static void WriteMeshPLY(BufferedFileWriter& writer, const TArray<FVector>& vertices, 
+						 const TArray<int32>& triangles, const TArray<FColor>& colors)
+{
+	const bool bColors = (colors.Num() > 0);
+	const int32 faceCount = triangles.Num() / 3;
+
+	FString header = FString::Printf(TEXT("ply\nformat binary_little_endian 1.0\ncomment %s\n"), ANSI_TO_TCHAR(UnitsMark));
+	header += FString::Printf(TEXT("element vertex %d\nproperty float x\nproperty float y\nproperty float z\n"), vertices.Num());
+	if (bColors) {
+		header += TEXT("property uchar red\nproperty uchar green\nproperty uchar blue\n");
+	}
+	if (faceCount > 0) {
+		header += FString::Printf(TEXT("element face %d\nproperty list uchar int vertex_indices\n"), faceCount);
+	}
+	header += TEXT("end_header\n");
+	WriteText(writer, header);
+
+	const int32 vertexSize = PLYPositionSize + (bColors ? PLYColorSize : 0);
+	for (int32 i = 0; i < vertices.Num(); i++) {
+		uint8* record = writer.Append(vertexSize);
+		FMemory::Memcpy(record, &vertices[i], PLYPositionSize);
+		if (bColors) {
+			record[PLYPositionSize + 0] = colors[i].R;
+			record[PLYPositionSize + 1] = colors[i].G;
+			record[PLYPositionSize + 2] = colors[i].B;
+		}
+	}
+
+	for (int32 i = 0; i < faceCount; i++) {
+		uint8* record = writer.Append(PLYFaceSize);
+		record[0] = 3;
+		FMemory::Memcpy(record + 1, &triangles[i * 3], 3 * sizeof(int32));
+	}
+}
+
+static void WriteMeshSTL(BufferedFileWriter& writer, const TArray<FVector>& vertices, const TArray<int32>& triangles)
+{
+	uint8* header = writer.Append(STLHeaderSize);
+	FMemory::Memzero(header, STLHeaderSize);
+	FMemory::Memcpy(header, UnitsMark, UnitsMarkLength);
+
+	const uint32 triangleCount = triangles.Num() / 3;
+	writer.Write(&triangleCount, sizeof(triangleCount));
+
+	for (uint32 i = 0; i < triangleCount; i++) {
+		const FVector& a = vertices[triangles[i * 3 + 0]];
+		const FVector& b = vertices[triangles[i * 3 + 1]];
+		const FVector& c = vertices[triangles[i * 3 + 2]];
+		const FVector normal = FVector::CrossProduct(b - a, c - a).GetSafeNormal();
+
+		uint8* record = writer.Append(STLTriangleSize);
+		FMemory::Memcpy(record, &normal, sizeof(FVector));
+		FMemory::Memcpy(record + 1 * sizeof(FVector), &a, sizeof(FVector));
+		FMemory::Memcpy(record + 2 * sizeof(FVector), &b, sizeof(FVector));
+		FMemory::Memcpy(record + 3 * sizeof(FVector), &c, sizeof(FVector));
+		FMemory::Memzero(record + 4 * sizeof(FVector), sizeof(uint16));
+	}
+}
+
+// Matches the middleware's output: vertices with colors in camera space 
+// (X right, Y down, Z forward) in meters, and 1-based face indices.
+static void WriteMeshOBJ(BufferedFileWriter& writer, const TArray<FVector>& vertices, 
+						 const TArray<int32>& triangles, const TArray<FColor>& colors)
+{
+	const bool bColors = (colors.Num() > 0);
+	ANSICHAR line[128];
+
+	for (int32 i = 0; i < vertices.Num(); i++) {
+		const FVector& v = vertices[i];
+		const FColor color = bColors ? colors[i] : FColor::White;
+		const int32 length = FCStringAnsi::Sprintf(line, "v %.5f %.5f %.5f %.3f %.3f %.3f\n", 
+			v.Y * 0.01f, -v.Z * 0.01f, v.X * 0.01f, color.R / 255.0f, color.G / 255.0f, color.B / 255.0f);
+		writer.Write(line, length);
+	}
+
+	for (int32 i = 0; i + 2 < triangles.Num(); i += 3) {
+		const int32 length = FCStringAnsi::Sprintf(line, "f %d %d %d\n", 
+			triangles[i] + 1, triangles[i + 1] + 1, triangles[i + 2] + 1);
+		writer.Write(line, length);
+	}
+}
+
+bool SaveMeshFile(const FString& filename, EScan3DFileFormat format, const TArray<FVector>& vertices, 
+				  const TArray<int32>& triangles, const TArray<FColor>& colors)
+{
+	if (((colors.Num() > 0) && (colors.Num() != vertices.Num())) || (triangles.Num() % 3 != 0)) {
+		RS_LOG(Warning, "Cannot save %s: the mesh arrays do not match", *filename)
+		return false;
+	}
+
+	for (int32 index : triangles) {
+		if ((index < 0) || (index >= vertices.Num())) {
+			RS_LOG(Warning, "Cannot save %s: a triangle refers to a missing vertex", *filename)
+			return false;
+		}
+	}
+
+	if ((format == EScan3DFileFormat::STL) && (triangles.Num() == 0)) {
+		RS_LOG(Warning, "Cannot save %s: STL files cannot store point clouds", *filename)
+		return false;
+	}
+
+	BufferedFileWriter writer(filename);
+	if (writer.IsOpen() == false) {
+		RS_LOG(Warning, "Cannot open %s for writing", *filename)
+		return false;
+	}
+
+	switch (format) {
+	case EScan3DFileFormat::PLY:
+		WriteMeshPLY(writer, vertices, triangles, colors);
+		break;
+	case EScan3DFileFormat::STL:
+		WriteMeshSTL(writer, vertices, triangles);
+		break;
+	default:
+		WriteMeshOBJ(writer, vertices, triangles, colors);
+		break;
+	}
+
+	if (writer.Close() == false) {
+		RS_LOG(Warning, "Failed to write %s", *filename)
+		return false;
+	}
+	return true;
+}
+
+// Property of a PLY element. List properties store a count of countSize 
+// bytes followed by that many values of size bytes.
+struct PLYProperty {
+	FString name;
+	FString type;
+	int32 size;
+	int32 countSize;
+	bool bList;
+};
+
+struct PLYElement {
+	FString name;
+	int32 count;
+	TArray<PLYProperty> properties;
+};
+
+// Returns the size in bytes of a PLY scalar type, or 0 if unknown.
+static int32 GetPLYTypeSize(const FString& type)
+{
+	if ((type == TEXT("char")) || (type == TEXT("uchar")) || (type == TEXT("int8")) || (type == TEXT("uint8"))) {
+		return 1;
+	}
+	if ((type == TEXT("short")) || (type == TEXT("ushort")) || (type == TEXT("int16")) || (type == TEXT("uint16"))) {
+		return 2;
+	}
+	if ((type == TEXT("int")) || (type == TEXT("uint")) || (type == TEXT("int32")) || (type == TEXT("uint32")) || 
+		(type == TEXT("float")) || (type == TEXT("float32"))) {
+		return 4;
+	}
+	if ((type == TEXT("double")) || (type == TEXT("float64"))) {
+		return 8;
+	}
+	return 0;
+}
+
+// Reads an unsigned integer of 1, 2 or 4 bytes.
+static inline uint32 ReadUnsigned(const uint8* data, int32 size)
+{
+	switch (size) {
+	case 1:
+		return data[0];
+	case 2:
+		return *reinterpret_cast<const uint16*>(data);
+	default:
+		return *reinterpret_cast<const uint32*>(data);
+	}
+}
+
+// Parses the header into its elements and returns the offset of the data, 
+// or -1 if the header is invalid or the data is not binary little-endian.
+// bMarked tells whether the file carries the mark of SaveMeshFile().
+static int32 ParsePLYHeader(const TArray<uint8>& data, TArray<PLYElement>& elements, bool& bMarked)
+{
+	bMarked = false;
+
+	const ANSICHAR endTag[] = "end_header\n";
+	const int32 endLength = sizeof(endTag) - 1;
+
+	int32 lineStart = 0;
+	bool bBinary = false;
+	for (int32 i = 0; i < data.Num(); i++) {
+		if (data[i] != '\n') {
+			continue;
+		}
+
+		const int32 lineLength = i + 1 - lineStart;
+		if ((lineLength == endLength) && (FMemory::Memcmp(&data[lineStart], endTag, endLength) == 0)) {
+			return bBinary ? (i + 1) : -1;
+		}
+
+		TArray<ANSICHAR> text;
+		text.Append(reinterpret_cast<const ANSICHAR*>(&data[lineStart]), lineLength - 1);
+		text.Add('\0');
+		lineStart = i + 1;
+
+		TArray<FString> tokens;
+		FString(text.GetData()).ParseIntoArrayWS(tokens);
+		if (tokens.Num() == 0) {
+			continue;
+		}
+
+		if (tokens[0] == TEXT("comment")) {
+			bMarked |= (FCStringAnsi::Strstr(text.GetData(), UnitsMark) != nullptr);
+		}
+		else if (tokens[0] == TEXT("format")) {
+			bBinary = (tokens.Num() > 1) && (tokens[1] == TEXT("binary_little_endian"));
+		}
+		else if ((tokens[0] == TEXT("element")) && (tokens.Num() > 2)) {
+			PLYElement& element = elements[elements.AddDefaulted()];
+			element.name = tokens[1];
+			element.count = FCString::Atoi(*tokens[2]);
+			if ((element.count < 0) || (tokens[2].IsNumeric() == false)) {
+				return -1;
+			}
+		}
+		else if ((tokens[0] == TEXT("property")) && (elements.Num() > 0)) {
+			PLYProperty property;
+			property.bList = (tokens.Num() > 4) && (tokens[1] == TEXT("list"));
+			property.countSize = property.bList ? GetPLYTypeSize(tokens[2]) : 0;
+			property.type = property.bList ? tokens[3] : tokens[1];
+			property.name = tokens.Last();
+			property.size = GetPLYTypeSize(property.type);
+			if ((property.size == 0) || (property.bList && (property.countSize == 0))) {
+				return -1;
+			}
+			elements.Last().properties.Add(property);
+		}
+	}
+
+	return -1;
+}
+
+bool LoadMeshPLY(const FString& filename, TArray<FVector>& vertices, TArray<int32>& triangles, TArray<FColor>& colors)
+{
+	TArray<uint8> data;
+	if (FFileHelper::LoadFileToArray(data, *filename) == false) {
+		return false;
+	}
+
+	TArray<PLYElement> elements;
+	bool bMarked = false;
+	int32 offset = ParsePLYHeader(data, elements, bMarked);
+	if (offset < 0) {
+		RS_LOG(Warning, "%s is not a binary little-endian PLY file", *filename)
+		return false;
+	}
+
+	vertices.Reset();
+	triangles.Reset();
+	colors.Reset();
+
+	const uint8* cursor = data.GetData() + offset;
+	const uint8* end = data.GetData() + data.Num();
+
+	for (const PLYElement& element : elements) {
+		if (element.name == TEXT("vertex")) {
+			// Vertex records have a fixed size; find where each known property sits
+			int32 stride = 0;
+			int32 positionOffsets[3] = { -1, -1, -1 };
+			int32 colorOffsets[3] = { -1, -1, -1 };
+			const TCHAR* positionNames[3] = { TEXT("x"), TEXT("y"), TEXT("z") };
+			const TCHAR* colorNames[3] = { TEXT("red"), TEXT("green"), TEXT("blue") };
+			for (const PLYProperty& property : element.properties) {
+				if (property.bList) {
+					return false;
+				}
+				for (int32 k = 0; k < 3; k++) {
+					if ((property.name == positionNames[k]) && (property.size == 4) && property.type.StartsWith(TEXT("float"))) {
+						positionOffsets[k] = stride;
+					}
+					if ((property.name == colorNames[k]) && (property.size == 1)) {
+						colorOffsets[k] = stride;
+					}
+				}
+				stride += property.size;
+			}
+
+			if ((positionOffsets[0] < 0) || (positionOffsets[1] < 0) || (positionOffsets[2] < 0) || 
+				(end - cursor < (int64)stride * element.count)) {
+				return false;
+			}
+
+			const bool bColors = (colorOffsets[0] >= 0) && (colorOffsets[1] >= 0) && (colorOffsets[2] >= 0);
+			vertices.SetNumUninitialized(element.count);
+			colors.SetNumUninitialized(element.count);
+			for (int32 i = 0; i < element.count; i++, cursor += stride) {
+				vertices[i] = FVector(*reinterpret_cast<const float*>(cursor + positionOffsets[0]), 
+									  *reinterpret_cast<const float*>(cursor + positionOffsets[1]), 
+									  *reinterpret_cast<const float*>(cursor + positionOffsets[2]));
+				colors[i] = bColors ? FColor(cursor[colorOffsets[0]], cursor[colorOffsets[1]], cursor[colorOffsets[2]]) : 
+									  FColor::White;
+			}
+			continue;
+		}
+
+		// Other elements are walked record by record, reading the polygons of
+		// faces and skipping everything else. Each record holds at least its 
+		// scalars and list counts, which bounds the count by the data left.
+		int32 minRecordSize = 0;
+		for (const PLYProperty& property : element.properties) {
+			minRecordSize += property.bList ? property.countSize : property.size;
+		}
+		if ((minRecordSize == 0) || ((int64)minRecordSize * element.count > end - cursor)) {
+			if (element.count == 0) {
+				continue;
+			}
+			return false;
+		}
+
+		const bool bFace = (element.name == TEXT("face"));
+		if (bFace) {
+			triangles.Reserve(element.count * 3);
+		}
+		for (int32 i = 0; i < element.count; i++) {
+			for (const PLYProperty& property : element.properties) {
+				if (property.bList == false) {
+					cursor += property.size;
+					continue;
+				}
+
+				if (end - cursor < property.countSize) {
+					return false;
+				}
+				const int64 count = ReadUnsigned(cursor, property.countSize);
+				cursor += property.countSize;
+				if (end - cursor < count * property.size) {
+					return false;
+				}
+
+				if (bFace && (property.size <= 4) && 
+					((property.name == TEXT("vertex_indices")) || (property.name == TEXT("vertex_index")))) {
+					const int32 first = ReadUnsigned(cursor, property.size);
+					for (int64 k = 1; k + 1 < count; k++) {
+						triangles.Add(first);
+						triangles.Add(ReadUnsigned(cursor + k * property.size, property.size));
+						triangles.Add(ReadUnsigned(cursor + (k + 1) * property.size, property.size));
+					}
+				}
+				cursor += count * property.size;
+			}
+			if (cursor > end) {
+				return false;
+			}
+		}
+	}
+
+	for (int32 index : triangles) {
+		if ((index < 0) || (index >= vertices.Num())) {
+			RS_LOG(Warning, "%s has faces referring to missing vertices", *filename)
+			return false;
+		}
+	}
+
+	if (bMarked == false) {
+		for (FVector& vertex : vertices) {
+			vertex = ConvertMiddlewareVertex(vertex);
+		}
+	}
+	return true;
+}
+
+bool LoadMeshSTL(const FString& filename, TArray<FVector>& vertices, TArray<int32>& triangles, TArray<FColor>& colors)
+{
+	TArray<uint8> data;
+	if (FFileHelper::LoadFileToArray(data, *filename) == false) {
+		return false;
+	}
+
+	const int64 triangleCount = (data.Num() >= STLHeaderSize + 4) ? 
+		*reinterpret_cast<const uint32*>(&data[STLHeaderSize]) : -1;
+	if ((triangleCount < 0) || (STLHeaderSize + 4 + triangleCount * STLTriangleSize > data.Num())) {
+		RS_LOG(Warning, "%s is not a binary STL file", *filename)
+		return false;
+	}
+
+	const bool bMarked = (FMemory::Memcmp(data.GetData(), UnitsMark, UnitsMarkLength) == 0);
+	const int32 vertexCount = (int32)triangleCount * 3;
+	vertices.SetNumUninitialized(vertexCount);
+	triangles.SetNumUninitialized(vertexCount);
+	colors.Init(FColor::White, vertexCount);
+
+	const uint8* record = &data[STLHeaderSize + 4];
+	for (int32 i = 0; i < vertexCount; i += 3, record += STLTriangleSize) {
+		// Skip the normal, then copy the three corners
+		FMemory::Memcpy(&vertices[i], record + sizeof(FVector), 3 * sizeof(FVector));
+		triangles[i + 0] = i + 0;
+		triangles[i + 1] = i + 1;
+		triangles[i + 2] = i + 2;
+	}
+
+	if (bMarked == false) {
+		for (FVector& vertex : vertices) {
+			vertex = ConvertMiddlewareVertex(vertex);
+		}
+	}
+	return true;
+}
+
+EScan3DFileFormat GetMeshFileFormat(const FString& filename)
+{
+	const FString extension = FPaths::GetExtension(filename);
+	if (extension.Equals(TEXT("ply"), ESearchCase::IgnoreCase)) {
+		return EScan3DFileFormat::PLY;
+	}
+	if (extension.Equals(TEXT("stl"), ESearchCase::IgnoreCase)) {
+		return EScan3DFileFormat::STL;
+	}
+	return EScan3DFileFormat::OBJ;
+}
+
+// The mesh is a latitude-longitude sphere of radius 50 cm, colored by position.
+TArray<FMeshFileBenchmarkResult> RunMeshFileBenchmark(int32 vertexCount)
+{
+	const int32 side = FMath::Max(FMath::CeilToInt(FMath::Sqrt((float)vertexCount)), 3);
+	const float radius = 50.0f;
+
+	TArray<FVector> vertices;
+	TArray<int32> triangles;
+	TArray<FColor> colors;
+	vertices.Reserve(side * side);
+	colors.Reserve(side * side);
+	triangles.Reserve((side - 1) * side * 6);
+
+	for (int32 row = 0; row < side; row++) {
+		const float theta = PI * (row + 0.5f) / side;
+		for (int32 column = 0; column < side; column++) {
+			const float phi = 2.0f * PI * column / side;
+			const FVector direction(FMath::Sin(theta) * FMath::Cos(phi), FMath::Sin(theta) * FMath::Sin(phi), FMath::Cos(theta));
+			vertices.Add(direction * radius);
+			colors.Add(FColor((uint8)(127.5f + direction.X * 127.5f), (uint8)(127.5f + direction.Y * 127.5f), 
+							  (uint8)(127.5f + direction.Z * 127.5f)));
+		}
+	}
+
+	for (int32 row = 0; row + 1 < side; row++) {
+		for (int32 column = 0; column < side; column++) {
+			const int32 a = row * side + column;
+			const int32 b = row * side + (column + 1) % side;
+			triangles.Add(a);
+			triangles.Add(a + side);
+			triangles.Add(b);
+			triangles.Add(b);
+			triangles.Add(a + side);
+			triangles.Add(b + side);
+		}
+	}
+
+	const EScan3DFileFormat formats[] = { EScan3DFileFormat::OBJ, EScan3DFileFormat::PLY, EScan3DFileFormat::STL };
+	const TCHAR* extensions[] = { TEXT("obj"), TEXT("ply"), TEXT("stl") };
+
+	TArray<FMeshFileBenchmarkResult> results;
+	for (int32 i = 0; i < ARRAY_COUNT(formats); i++) {
+		const FString filename = FPaths::GameSavedDir() + TEXT("RealSenseMeshBenchmark.") + extensions[i];
+
+		FMeshFileBenchmarkResult result;
+		result.Format = formats[i];
+
+		const double writeStart = FPlatformTime::Seconds();
+		if (SaveMeshFile(filename, formats[i], vertices, triangles, colors) == false) {
+			continue;
+		}
+		const double readStart = FPlatformTime::Seconds();
+
+		TArray<FVector> loadedVertices;
+		TArray<int32> loadedTriangles;
+		TArray<FColor> loadedColors;
+		LoadMeshFile(filename, loadedVertices, loadedTriangles, loadedColors);
+		const double readEnd = FPlatformTime::Seconds();
+
+		result.WriteMs = (readStart - writeStart) * 1000.0;
+		result.ReadMs = (readEnd - readStart) * 1000.0;
+		result.FileSizeKB = (int32)(IFileManager::Get().FileSize(*filename) / 1024);
+		result.TriangleCount = loadedTriangles.Num() / 3;
+		IFileManager::Get().Delete(*filename);
+
+		results.Add(result);
+	}
+
+	return results;
+}
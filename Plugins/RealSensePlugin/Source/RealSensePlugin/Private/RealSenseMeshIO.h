@@ -0,0 +1,62 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+
+// Readers and writers for scanned meshes and point clouds. 
+//
+// Binary PLY and STL files store positions in Unreal units and world space,
+// as given, and are marked as such in their header. Files without the mark 
+// are taken to come from the 3D Scanning middleware, which writes all of its
+// formats in RealSense camera space, in meters, and are converted with 
+// ConvertMiddlewareVertex(). OBJ files are always written in the middleware's
+// layout and space, so that LoadMeshFile() reads both the same way. 
+//
+// Writers stream their records through a large buffer so that the file is
+// written in a few large calls, and readers load the whole file in a single
+// read before parsing it. Binary data is little-endian.
+
+// Writes a triangle mesh, or a point cloud if triangles is empty, in the 
+// given format. Colors may be empty; otherwise they must match the vertices.
+// STL has no vertex colors and cannot store a point cloud. Returns false if 
+// the arrays do not match, a triangle refers to a missing vertex, or the file
+// could not be written.
+bool SaveMeshFile(const FString& filename, EScan3DFileFormat format, const TArray<FVector>& vertices, 
+				  const TArray<int32>& triangles, const TArray<FColor>& colors);
+
+// Converts a vertex of a mesh file written by the 3D Scanning middleware to
+// Unreal space, the same way for every file format.
+FVector ConvertMiddlewareVertex(const FVector& v);
+
+// Reads a binary PLY file with float x, y, z and optional uchar red, green, 
+// blue vertex properties. Polygons are split into triangle fans. Returns 
+// false if the file is malformed or its faces refer to missing vertices.
+bool LoadMeshPLY(const FString& filename, TArray<FVector>& vertices, TArray<int32>& triangles, TArray<FColor>& colors);
+
+// Reads a binary STL file. STL does not share vertices between triangles, so
+// every triangle gets its own three vertices, colored white. Returns false
+// if the file is malformed.
+bool LoadMeshSTL(const FString& filename, TArray<FVector>& vertices, TArray<int32>& triangles, TArray<FColor>& colors);
+
+// Returns the file format matching the extension of the filename, or OBJ 
+// if it is not recognized.
+EScan3DFileFormat GetMeshFileFormat(const FString& filename);
+
+// Writes and reads back a synthetic colored mesh of about vertexCount 
+// vertices in every supported format, and measures the time spent and the
+// size of the files. The files are written to the Saved directory and deleted.
+TArray<FMeshFileBenchmarkResult> RunMeshFileBenchmark(int32 vertexCount);
@@ -0,0 +1,415 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseMeshProcessing.h"
+#include "ParallelFor.h"
+
+// Vertices or triangles handed to a worker thread at a time
+static const int32 ItemsPerTask = 4096;
+
+// Runs body(first, last) over [0, count) in parallel, in ranges of ItemsPerTask.
+template <typename Body>
+static void ParallelForRanges(int32 count, const Body& body)
+{
+	const int32 numTasks = (count + ItemsPerTask - 1) / ItemsPerTask;
+	ParallelFor(numTasks, [&](int32 task) {
+		body(task * ItemsPerTask, FMath::Min((task + 1) * ItemsPerTask, count));
+	});
+}
+
+// Counts the triangles of each vertex, turns the counts into offsets, and 
+// fills the lists in triangle order. Linear and memory-bound, so it is not
+// worth splitting across threads.
+void RealSenseMeshAdjacency::Build(int32 vertexCount, const TArray<int32>& triangles)
+{
+	const int32 triangleCount = triangles.Num() / 3;
+
+	offsets.SetNumZeroed(vertexCount + 1);
+	for (int32 t = 0; t < triangleCount; t++) {
+		const int32* corners = &triangles[t * 3];
+		if (((uint32)corners[0] < (uint32)vertexCount) && ((uint32)corners[1] < (uint32)vertexCount) && 
+			((uint32)corners[2] < (uint32)vertexCount)) {
+			offsets[corners[0] + 1]++;
+			offsets[corners[1] + 1]++;
+			offsets[corners[2] + 1]++;
+		}
+	}
+
+	for (int32 v = 0; v < vertexCount; v++) {
+		offsets[v + 1] += offsets[v];
+	}
+
+	TArray<int32> cursor;
+	cursor.SetNumUninitialized(vertexCount);
+	if (vertexCount > 0) {
+		FMemory::Memcpy(cursor.GetData(), offsets.GetData(), vertexCount * sizeof(int32));
+	}
+
+	vertexTriangles.SetNumUninitialized(offsets[vertexCount]);
+	for (int32 t = 0; t < triangleCount; t++) {
+		const int32* corners = &triangles[t * 3];
+		if (((uint32)corners[0] < (uint32)vertexCount) && ((uint32)corners[1] < (uint32)vertexCount) && 
+			((uint32)corners[2] < (uint32)vertexCount)) {
+			vertexTriangles[cursor[corners[0]]++] = t;
+			vertexTriangles[cursor[corners[1]]++] = t;
+			vertexTriangles[cursor[corners[2]]++] = t;
+		}
+	}
+}
+
+// Builds a tangent perpendicular to a unit normal that varies continuously 
+// everywhere except across normals pointing straight down (Duff et al., 
+// "Building an Orthonormal Basis, Revisited").
+static inline FVector GetBasisTangent(const FVector& normal)
+{
+	const float sign = (normal.Z >= 0.0f) ? 1.0f : -1.0f;
+	const float a = -1.0f / (sign + normal.Z);
+	const float b = normal.X * normal.Y * a;
+	return FVector(1.0f + sign * normal.X * normal.X * a, sign * b, -sign * normal.X);
+}
+
+// First computes the cross product of two edges of every triangle, whose 
+// length is twice its area, then sums those around each vertex through the
+// adjacency, so every vertex is written by exactly one thread.
+void ComputeVertexNormals(const TArray<FVector>& vertices, const TArray<int32>& triangles, 
+						  const RealSenseMeshAdjacency& adjacency, TArray<FVector>& normals, TArray<FVector>& tangents)
+{
+	const int32 vertexCount = FMath::Min(vertices.Num(), adjacency.GetVertexCount());
+	const int32 triangleCount = triangles.Num() / 3;
+
+	TArray<FVector> faceNormals;
+	faceNormals.SetNumUninitialized(triangleCount);
+	ParallelForRanges(triangleCount, [&](int32 first, int32 last) {
+		for (int32 t = first; t < last; t++) {
+			const int32* corners = &triangles[t * 3];
+			if (((uint32)corners[0] < (uint32)vertexCount) && ((uint32)corners[1] < (uint32)vertexCount) && 
+				((uint32)corners[2] < (uint32)vertexCount)) {
+				const FVector& a = vertices[corners[0]];
+				faceNormals[t] = FVector::CrossProduct(vertices[corners[1]] - a, vertices[corners[2]] - a);
+			}
+		}
+	});
+
+	normals.SetNumUninitialized(vertices.Num());
+	tangents.SetNumUninitialized(vertices.Num());
+	ParallelForRanges(vertices.Num(), [&](int32 first, int32 last) {
+		for (int32 v = first; v < last; v++) {
+			FVector sum(0.0f, 0.0f, 0.0f);
+			if (v < vertexCount) {
+				const int32* vertexTriangles = adjacency.GetTriangles(v);
+				const int32 count = adjacency.GetTriangleCount(v);
+				for (int32 i = 0; i < count; i++) {
+					sum += faceNormals[vertexTriangles[i]];
+				}
+			}
+
+			const FVector normal = sum.IsNearlyZero(SMALL_NUMBER) ? FVector(0.0f, 0.0f, 1.0f) : sum.GetUnsafeNormal();
+			normals[v] = normal;
+			tangents[v] = GetBasisTangent(normal);
+		}
+	});
+}
+
+// Sum of squared distances to a set of planes, as the upper half of a 
+// symmetric 4x4 matrix: xx, xy, xz, xw, yy, yz, yw, zz, zw, ww.
+struct PlaneQuadric {
+	double q[10];
+
+	inline void Reset()
+	{
+		FMemory::Memzero(q, sizeof(q));
+	}
+
+	// Adds the plane n.p + d = 0 with the given weight.
+	inline void AddPlane(const FVector& n, float d, float weight)
+	{
+		q[0] += weight * n.X * n.X;
+		q[1] += weight * n.X * n.Y;
+		q[2] += weight * n.X * n.Z;
+		q[3] += weight * n.X * d;
+		q[4] += weight * n.Y * n.Y;
+		q[5] += weight * n.Y * n.Z;
+		q[6] += weight * n.Y * d;
+		q[7] += weight * n.Z * n.Z;
+		q[8] += weight * n.Z * d;
+		q[9] += weight * d * d;
+	}
+
+	inline void Add(const PlaneQuadric& other)
+	{
+		for (int32 i = 0; i < 10; i++) {
+			q[i] += other.q[i];
+		}
+	}
+
+	// Finds the point with the least error. Returns false if the planes do 
+	// not pin down a point, such as on a flat or cylindrical patch.
+	bool Minimize(FVector& outPoint) const
+	{
+		const double c00 = q[4] * q[7] - q[5] * q[5];
+		const double c01 = q[2] * q[5] - q[1] * q[7];
+		const double c02 = q[1] * q[5] - q[2] * q[4];
+		const double det = q[0] * c00 + q[1] * c01 + q[2] * c02;
+
+		const double trace = q[0] + q[4] + q[7];
+		if (FMath::Abs(det) <= 1e-4 * trace * trace * trace) {
+			return false;
+		}
+
+		const double c11 = q[0] * q[7] - q[2] * q[2];
+		const double c12 = q[1] * q[2] - q[0] * q[5];
+		const double c22 = q[0] * q[4] - q[1] * q[1];
+		const double inverse = -1.0 / det;
+		outPoint.X = (c00 * q[3] + c01 * q[6] + c02 * q[8]) * inverse;
+		outPoint.Y = (c01 * q[3] + c11 * q[6] + c12 * q[8]) * inverse;
+		outPoint.Z = (c02 * q[3] + c12 * q[6] + c22 * q[8]) * inverse;
+		return true;
+	}
+};
+
+// Shared input of the levels of detail
+struct MeshLODSource {
+	const TArray<FVector>& vertices;
+	const TArray<int32>& triangles;
+	const TArray<FColor>& colors;
+	TArray<PlaneQuadric> quadrics;
+	FBox bounds;
+	float area;
+
+	MeshLODSource(const TArray<FVector>& inVertices, const TArray<int32>& inTriangles, const TArray<FColor>& inColors)
+		: vertices(inVertices), triangles(inTriangles), colors(inColors), bounds(ForceInit), area(0.0f) {}
+};
+
+// Clusters the vertices on a grid of the given cell size and writes the 
+// resulting mesh, without normals.
+static void ClusterVertices(const MeshLODSource& source, float cellSize, FScanMeshLOD& lod)
+{
+	const int32 vertexCount = source.vertices.Num();
+	const FVector origin = source.bounds.Min;
+	const FVector extent = source.bounds.GetSize();
+	const int64 cellsX = FMath::FloorToInt(extent.X / cellSize) + 1;
+	const int64 cellsY = FMath::FloorToInt(extent.Y / cellSize) + 1;
+
+	TArray<int64> cells;
+	cells.SetNumUninitialized(vertexCount);
+	ParallelForRanges(vertexCount, [&](int32 first, int32 last) {
+		for (int32 v = first; v < last; v++) {
+			const FVector offset = (source.vertices[v] - origin) / cellSize;
+			cells[v] = FMath::FloorToInt(offset.X) + cellsX * (FMath::FloorToInt(offset.Y) + 
+					   cellsY * (int64)FMath::FloorToInt(offset.Z));
+		}
+	});
+
+	// Numbers the clusters in order of their first vertex
+	TMap<int64, int32> clusterLookup;
+	clusterLookup.Reserve(vertexCount / 4);
+	TArray<int32> clusterOf;
+	clusterOf.SetNumUninitialized(vertexCount);
+	for (int32 v = 0; v < vertexCount; v++) {
+		int32* cluster = clusterLookup.Find(cells[v]);
+		clusterOf[v] = (cluster != nullptr) ? *cluster : clusterLookup.Add(cells[v], clusterLookup.Num());
+	}
+	const int32 clusterCount = clusterLookup.Num();
+
+	TArray<PlaneQuadric> quadrics;
+	TArray<FVector> sums;
+	TArray<FIntVector> colorSums;
+	TArray<int32> counts;
+	quadrics.SetNumZeroed(clusterCount);
+	sums.SetNumZeroed(clusterCount);
+	colorSums.SetNumZeroed(clusterCount);
+	counts.SetNumZeroed(clusterCount);
+	const bool bColors = (source.colors.Num() == vertexCount);
+	for (int32 v = 0; v < vertexCount; v++) {
+		const int32 c = clusterOf[v];
+		quadrics[c].Add(source.quadrics[v]);
+		sums[c] += source.vertices[v];
+		counts[c]++;
+		if (bColors) {
+			colorSums[c] += FIntVector(source.colors[v].R, source.colors[v].G, source.colors[v].B);
+		}
+	}
+
+	// Places each cluster at its best fit, kept within its cell so that 
+	// nearly parallel planes cannot throw it far away
+	lod.Vertices.SetNumUninitialized(clusterCount);
+	lod.Colors.SetNumUninitialized(bColors ? clusterCount : 0);
+	ParallelForRanges(clusterCount, [&](int32 first, int32 last) {
+		for (int32 c = first; c < last; c++) {
+			const FVector mean = sums[c] / counts[c];
+			FVector position;
+			if (quadrics[c].Minimize(position)) {
+				const FVector cellMin(origin.X + FMath::FloorToFloat((mean.X - origin.X) / cellSize) * cellSize,
+									  origin.Y + FMath::FloorToFloat((mean.Y - origin.Y) / cellSize) * cellSize,
+									  origin.Z + FMath::FloorToFloat((mean.Z - origin.Z) / cellSize) * cellSize);
+				position = position.BoundToBox(cellMin, cellMin + FVector(cellSize));
+			}
+			else {
+				position = mean;
+			}
+			lod.Vertices[c] = position;
+			if (bColors) {
+				lod.Colors[c] = FColor(colorSums[c].X / counts[c], colorSums[c].Y / counts[c], colorSums[c].Z / counts[c]);
+			}
+		}
+	});
+
+	// Remaps the triangles, dropping those that collapsed and duplicates 
+	// left by merging. Each triangle is rotated to start at its lowest index
+	// so duplicates match; opposite windings are different triangles.
+	const int32 triangleCount = source.triangles.Num() / 3;
+	TArray<FIntVector> remapped;
+	remapped.SetNumUninitialized(triangleCount);
+	ParallelForRanges(triangleCount, [&](int32 first, int32 last) {
+		for (int32 t = first; t < last; t++) {
+			const int32* corners = &source.triangles[t * 3];
+			if (((uint32)corners[0] >= (uint32)vertexCount) || ((uint32)corners[1] >= (uint32)vertexCount) || 
+				((uint32)corners[2] >= (uint32)vertexCount)) {
+				remapped[t] = FIntVector(-1, -1, -1);
+				continue;
+			}
+
+			const int32 a = clusterOf[corners[0]];
+			const int32 b = clusterOf[corners[1]];
+			const int32 c = clusterOf[corners[2]];
+			if ((a == b) || (b == c) || (a == c)) {
+				remapped[t] = FIntVector(-1, -1, -1);
+			}
+			else if ((a < b) && (a < c)) {
+				remapped[t] = FIntVector(a, b, c);
+			}
+			else if (b < c) {
+				remapped[t] = FIntVector(b, c, a);
+			}
+			else {
+				remapped[t] = FIntVector(c, a, b);
+			}
+		}
+	});
+
+	TSet<FIntVector> kept;
+	lod.Triangles.Reset();
+	for (const FIntVector& triangle : remapped) {
+		if (triangle.X < 0) {
+			continue;
+		}
+		bool bDuplicate = false;
+		kept.Add(triangle, &bDuplicate);
+		if (bDuplicate == false) {
+			lod.Triangles.Add(triangle.X);
+			lod.Triangles.Add(triangle.Y);
+			lod.Triangles.Add(triangle.Z);
+		}
+	}
+}
+
+// A surface of area A covered by cells of size s has about A / s^2 clusters
+// and twice as many triangles, which gives the first cell size. The cell 
+// size is then corrected from the triangle count reached, a few times at most.
+static void BuildMeshLOD(const MeshLODSource& source, float ratio, FScanMeshLOD& lod)
+{
+	const int32 target = FMath::Max(FMath::RoundToInt(ratio * source.triangles.Num() / 3), 1);
+	float cellSize = FMath::Sqrt(2.0f * source.area / target);
+	if (cellSize <= 0.0f) {
+		return;
+	}
+
+	static const int32 MaxAttempts = 4;
+	for (int32 attempt = 0; attempt < MaxAttempts; attempt++) {
+		ClusterVertices(source, cellSize, lod);
+
+		const float reached = FMath::Max(lod.Triangles.Num() / 3, 1);
+		if (FMath::Abs(reached - target) <= 0.1f * target) {
+			break;
+		}
+		cellSize *= FMath::Clamp(FMath::Sqrt(reached / target), 0.5f, 2.0f);
+	}
+
+	RealSenseMeshAdjacency adjacency;
+	adjacency.Build(lod.Vertices.Num(), lod.Triangles);
+	ComputeVertexNormals(lod.Vertices, lod.Triangles, adjacency, lod.Normals, lod.Tangents);
+}
+
+void BuildMeshLODs(const TArray<FVector>& vertices, const TArray<int32>& triangles, const TArray<FColor>& colors, 
+				   const RealSenseMeshAdjacency& adjacency, const TArray<float>& ratios, TArray<FScanMeshLOD>& lods)
+{
+	lods.Reset();
+	lods.SetNum(ratios.Num());
+
+	const int32 vertexCount = FMath::Min(vertices.Num(), adjacency.GetVertexCount());
+	const int32 triangleCount = triangles.Num() / 3;
+	if ((vertexCount == 0) || (triangleCount == 0)) {
+		return;
+	}
+
+	MeshLODSource source(vertices, triangles, colors);
+	source.bounds = FBox(vertices.GetData(), vertices.Num());
+
+	// Unit normal, offset, and area of every triangle
+	TArray<FVector4> planes;
+	planes.SetNumUninitialized(triangleCount);
+	ParallelForRanges(triangleCount, [&](int32 first, int32 last) {
+		for (int32 t = first; t < last; t++) {
+			const int32* corners = &triangles[t * 3];
+			if (((uint32)corners[0] >= (uint32)vertexCount) || ((uint32)corners[1] >= (uint32)vertexCount) || 
+				((uint32)corners[2] >= (uint32)vertexCount)) {
+				planes[t] = FVector4(0.0f, 0.0f, 0.0f, 0.0f);
+				continue;
+			}
+			const FVector& a = vertices[corners[0]];
+			const FVector cross = FVector::CrossProduct(vertices[corners[1]] - a, vertices[corners[2]] - a);
+			const float doubleArea = cross.Size();
+			const FVector normal = (doubleArea > 0.0f) ? cross / doubleArea : FVector::ZeroVector;
+			planes[t] = FVector4(normal, doubleArea * 0.5f);
+		}
+	});
+
+	for (const FVector4& plane : planes) {
+		source.area += plane.W;
+	}
+
+	// Every vertex carries the planes of its triangles, weighted by area
+	source.quadrics.SetNumUninitialized(vertices.Num());
+	ParallelForRanges(vertices.Num(), [&](int32 first, int32 last) {
+		for (int32 v = first; v < last; v++) {
+			PlaneQuadric& quadric = source.quadrics[v];
+			quadric.Reset();
+			if (v >= vertexCount) {
+				continue;
+			}
+			const int32* vertexTriangles = adjacency.GetTriangles(v);
+			const int32 count = adjacency.GetTriangleCount(v);
+			for (int32 i = 0; i < count; i++) {
+				const FVector4& plane = planes[vertexTriangles[i]];
+				const FVector normal(plane.X, plane.Y, plane.Z);
+				const float d = -FVector::DotProduct(normal, vertices[triangles[vertexTriangles[i] * 3]]);
+				quadric.AddPlane(normal, d, plane.W);
+			}
+		}
+	});
+
+	ParallelFor(ratios.Num(), [&](int32 level) {
+		if (ratios[level] >= 1.0f) {
+			lods[level].Vertices = vertices;
+			lods[level].Triangles = triangles;
+			lods[level].Colors = colors;
+			ComputeVertexNormals(vertices, triangles, adjacency, lods[level].Normals, lods[level].Tangents);
+		}
+		else if (ratios[level] > 0.0f) {
+			BuildMeshLOD(source, ratios[level], lods[level]);
+		}
+	});
+}
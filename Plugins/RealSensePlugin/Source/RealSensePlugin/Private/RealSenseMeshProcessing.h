@@ -0,0 +1,61 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+
+// Triangles around each vertex of a mesh, in compressed sparse row form: the
+// triangles using vertex v are listed in one array, from offsets[v] to 
+// offsets[v + 1]. Built once per mesh and shared by the processing stages, 
+// which gather over it in parallel instead of scattering into shared data.
+class RealSenseMeshAdjacency {
+public:
+	// Indexes the triangles of the mesh. Triangles with out-of-range indices
+	// are left out.
+	void Build(int32 vertexCount, const TArray<int32>& triangles);
+
+	inline int32 GetVertexCount() const { return FMath::Max(offsets.Num() - 1, 0); }
+
+	inline int32 GetTriangleCount(int32 vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
+
+	// Returns the triangles using the vertex, as indices of their first 
+	// corner divided by three.
+	inline const int32* GetTriangles(int32 vertex) const { return vertexTriangles.GetData() + offsets[vertex]; }
+
+private:
+	TArray<int32> offsets;
+	TArray<int32> vertexTriangles;
+};
+
+// Computes vertex normals as the area-weighted average of the normals of the
+// triangles around each vertex. Triangles face the side from which their 
+// corners run clockwise, as Unreal renders them. Scans have no texture 
+// coordinates, so each tangent is taken from a continuous orthonormal basis 
+// around the normal. Vertices without triangles get +Z normals.
+void ComputeVertexNormals(const TArray<FVector>& vertices, const TArray<int32>& triangles, 
+						  const RealSenseMeshAdjacency& adjacency, TArray<FVector>& normals, TArray<FVector>& tangents);
+
+// Builds reduced levels of detail of a mesh, one for each ratio of its 
+// triangle count in (0, 1), by vertex clustering: the vertices falling in the
+// same cell of a grid are merged into one placed where it best fits the 
+// planes of their triangles (Lindstrom, "Out-of-Core Simplification of Large
+// Polygonal Models"), and triangles that collapse are dropped. The cell size 
+// of each level is tuned to reach its triangle count.
+//
+// The plane quadrics of the vertices are gathered once over the shared 
+// adjacency, then the levels are built in parallel. Colors may be empty.
+void BuildMeshLODs(const TArray<FVector>& vertices, const TArray<int32>& triangles, const TArray<FColor>& colors, 
+				   const RealSenseMeshAdjacency& adjacency, const TArray<float>& ratios, TArray<FScanMeshLOD>& lods);
@@ -0,0 +1,458 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseOccupancyGrid.h"
+
+// Upper bound on the number of bricks, 32 MB of occupancy bits. Coarser 
+// voxels are used for volumes that would need more.
+static const int32 MaxBricks = 1 << 22;
+
+RealSenseOccupancyGrid::RealSenseOccupancyGrid()
+{
+	voxelCount = FIntVector(0, 0, 0);
+	brickCount = FIntVector(0, 0, 0);
+	revision = 0;
+	logBaseRevision = 0;
+}
+
+// Rounds the volume up to whole bricks. Every brick is stamped with a new 
+// revision so that copies of the grid are cleared as well. The change log 
+// restarts there, so copies compare every brick once.
+void RealSenseOccupancyGrid::Configure(const RealSenseOccupancySettings& newSettings)
+{
+	settings = newSettings;
+	settings.voxelSize = FMath::Max(settings.voxelSize, 0.1f);
+	settings.pixelStep = FMath::Max(settings.pixelStep, 1);
+
+	const FVector size = (settings.boundsMax - settings.boundsMin).ComponentMax(FVector(settings.voxelSize));
+	for (;;) {
+		const float brickExtent = settings.voxelSize * BrickSize;
+		brickCount = FIntVector(FMath::Max(FMath::CeilToInt(size.X / brickExtent), 1), 
+								FMath::Max(FMath::CeilToInt(size.Y / brickExtent), 1), 
+								FMath::Max(FMath::CeilToInt(size.Z / brickExtent), 1));
+		if ((int64)brickCount.X * brickCount.Y * brickCount.Z <= MaxBricks) {
+			break;
+		}
+		settings.voxelSize *= 1.25f;
+		RS_LOG(Warning, "Occupancy grid too large, using voxels of %.2f", settings.voxelSize)
+	}
+
+	voxelCount = FIntVector(brickCount.X * BrickSize, brickCount.Y * BrickSize, brickCount.Z * BrickSize);
+	settings.boundsMax = settings.boundsMin + FVector(voxelCount.X, voxelCount.Y, voxelCount.Z) * settings.voxelSize;
+
+	const int32 numBricks = brickCount.X * brickCount.Y * brickCount.Z;
+	revision++;
+	bricks.Init(0, numBricks);
+	nextBricks.Init(0, numBricks);
+	brickRevisions.Init(revision, numBricks);
+	occupiedBricks.Reset();
+	nextOccupiedBricks.Reset();
+	changeLog.Reset();
+	logBaseRevision = revision;
+}
+
+void RealSenseOccupancyGrid::Reset()
+{
+	if (occupiedBricks.Num() == 0) {
+		return;
+	}
+
+	revision++;
+	for (int32 brick : occupiedBricks) {
+		bricks[brick] = 0;
+		MarkChanged(brick, revision);
+	}
+	occupiedBricks.Reset();
+	TrimChangeLog();
+}
+
+void RealSenseOccupancyGrid::TrimChangeLog()
+{
+	const int32 maxChanges = FMath::Max(bricks.Num() / 8, 4096);
+	if (changeLog.Num() <= maxChanges) {
+		return;
+	}
+
+	// Whole revisions are dropped, so the log stays complete after its base
+	int32 count = changeLog.Num() / 2;
+	logBaseRevision = changeLog[count - 1].revision;
+	while ((count < changeLog.Num()) && (changeLog[count].revision == logBaseRevision)) {
+		count++;
+	}
+	changeLog.RemoveAt(0, count, false);
+}
+
+// The samples are binned into nextBricks, which is all zero between updates.
+// Only the bricks occupied before or after this frame can differ, so those 
+// are the only ones compared and, once the two sets of bricks are swapped, 
+// the only ones cleared for the next update.
+void RealSenseOccupancyGrid::Update(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics, 
+									const FMatrix& cameraToWorld)
+{
+	if ((depth == nullptr) || (bricks.Num() == 0)) {
+		return;
+	}
+
+	const int32 width = intrinsics.width;
+	const int32 height = intrinsics.height;
+	const int32 step = settings.pixelStep;
+	const float inverseVoxelSize = 1.0f / settings.voxelSize;
+
+	// The camera ray of pixel (u, v) is axisX + axisY * a(u) + axisZ * b(v), 
+	// all in voxel units relative to the corner of the grid
+	const FVector origin = (cameraToWorld.GetOrigin() - settings.boundsMin) * inverseVoxelSize;
+	const FVector axisX = cameraToWorld.TransformVector(FVector(1.0f, 0.0f, 0.0f)) * inverseVoxelSize * 0.1f;
+	const FVector axisY = cameraToWorld.TransformVector(FVector(0.0f, 1.0f, 0.0f)) * inverseVoxelSize * 0.1f;
+	const FVector axisZ = cameraToWorld.TransformVector(FVector(0.0f, 0.0f, 1.0f)) * inverseVoxelSize * 0.1f;
+
+	for (int32 v = 0; v < height; v += step) {
+		const FVector rowDirection = axisX - axisZ * ((v - intrinsics.cy) / intrinsics.fy);
+		const uint16* row = depth + v * width;
+
+		for (int32 u = 0; u < width; u += step) {
+			if (row[u] == 0) {
+				continue;
+			}
+
+			const FVector p = origin + (rowDirection + axisY * ((u - intrinsics.cx) / intrinsics.fx)) * row[u];
+			const int32 x = FMath::FloorToInt(p.X);
+			const int32 y = FMath::FloorToInt(p.Y);
+			const int32 z = FMath::FloorToInt(p.Z);
+			if (((uint32)x >= (uint32)voxelCount.X) || ((uint32)y >= (uint32)voxelCount.Y) || 
+				((uint32)z >= (uint32)voxelCount.Z)) {
+				continue;
+			}
+
+			const int32 brick = GetBrickIndex(x, y, z);
+			if (nextBricks[brick] == 0) {
+				nextOccupiedBricks.Add(brick);
+			}
+			nextBricks[brick] |= GetVoxelBit(x, y, z);
+		}
+	}
+
+	const uint32 nextRevision = revision + 1;
+	bool bChanged = false;
+	for (int32 brick : nextOccupiedBricks) {
+		if (nextBricks[brick] != bricks[brick]) {
+			MarkChanged(brick, nextRevision);
+			bChanged = true;
+		}
+	}
+	for (int32 brick : occupiedBricks) {
+		if (nextBricks[brick] == 0) {
+			MarkChanged(brick, nextRevision);
+			bChanged = true;
+		}
+	}
+
+	Swap(bricks, nextBricks);
+	Swap(occupiedBricks, nextOccupiedBricks);
+	for (int32 brick : nextOccupiedBricks) {
+		nextBricks[brick] = 0;
+	}
+	nextOccupiedBricks.Reset();
+
+	if (bChanged) {
+		revision = nextRevision;
+		TrimChangeLog();
+	}
+}
+
+void RealSenseOccupancyGrid::CopyFrom(const RealSenseOccupancyGrid& source, TArray<int32>& outChangedBricks)
+{
+	outChangedBricks.Reset();
+
+	const bool bSameLayout = (voxelCount == source.voxelCount) && (settings.voxelSize == source.settings.voxelSize) && 
+							 (settings.boundsMin == source.settings.boundsMin);
+	if (bSameLayout == false) {
+		settings = source.settings;
+		voxelCount = source.voxelCount;
+		brickCount = source.brickCount;
+		bricks = source.bricks;
+		brickRevisions = source.brickRevisions;
+		nextBricks.Init(0, bricks.Num());
+		occupiedBricks = source.occupiedBricks;
+		nextOccupiedBricks.Reset();
+		revision = source.revision;
+		changeLog.Reset();
+		logBaseRevision = revision;
+
+		outChangedBricks.SetNumUninitialized(bricks.Num());
+		for (int32 brick = 0; brick < bricks.Num(); brick++) {
+			outChangedBricks[brick] = brick;
+		}
+		return;
+	}
+
+	if (revision == source.revision) {
+		return;
+	}
+
+	// A brick logged more than once is copied at its first entry, which 
+	// brings it to its latest revision and skips the later entries.
+	const uint32* sourceRevisions = source.brickRevisions.GetData();
+	if (revision >= source.logBaseRevision) {
+		for (const BrickChange& change : source.changeLog) {
+			const int32 brick = change.brick;
+			if ((change.revision > revision) && (brickRevisions[brick] != sourceRevisions[brick])) {
+				bricks[brick] = source.bricks[brick];
+				brickRevisions[brick] = sourceRevisions[brick];
+				outChangedBricks.Add(brick);
+			}
+		}
+	}
+	else {
+		for (int32 brick = 0; brick < bricks.Num(); brick++) {
+			if (sourceRevisions[brick] > revision) {
+				bricks[brick] = source.bricks[brick];
+				brickRevisions[brick] = sourceRevisions[brick];
+				outChangedBricks.Add(brick);
+			}
+		}
+	}
+	occupiedBricks = source.occupiedBricks;
+	revision = source.revision;
+
+	// A copy keeps no log of its own
+	changeLog.Reset();
+	logBaseRevision = revision;
+}
+
+FBox RealSenseOccupancyGrid::GetBrickBounds(int32 brick) const
+{
+	const int32 x = brick % brickCount.X;
+	const int32 y = (brick / brickCount.X) % brickCount.Y;
+	const int32 z = brick / (brickCount.X * brickCount.Y);
+	const float brickExtent = settings.voxelSize * BrickSize;
+	const FVector boxMin = settings.boundsMin + FVector(x, y, z) * brickExtent;
+	return FBox(boxMin, boxMin + FVector(brickExtent));
+}
+
+bool RealSenseOccupancyGrid::IsOccupied(const FVector& position) const
+{
+	const FVector p = (position - settings.boundsMin) / settings.voxelSize;
+	const int32 x = FMath::FloorToInt(p.X);
+	const int32 y = FMath::FloorToInt(p.Y);
+	const int32 z = FMath::FloorToInt(p.Z);
+	if (((uint32)x >= (uint32)voxelCount.X) || ((uint32)y >= (uint32)voxelCount.Y) || 
+		((uint32)z >= (uint32)voxelCount.Z)) {
+		return false;
+	}
+	return (bricks[GetBrickIndex(x, y, z)] & GetVoxelBit(x, y, z)) != 0;
+}
+
+bool RealSenseOccupancyGrid::GetVoxelRange(const FVector& boxMin, const FVector& boxMax, 
+										   FIntVector& outMin, FIntVector& outMax) const
+{
+	const FVector localMin = (boxMin - settings.boundsMin) / settings.voxelSize;
+	const FVector localMax = (boxMax - settings.boundsMin) / settings.voxelSize;
+	for (int32 axis = 0; axis < 3; axis++) {
+		const int32 first = FMath::FloorToInt(localMin[axis]);
+		const int32 last = FMath::FloorToInt(localMax[axis]);
+		if ((last < 0) || (first >= voxelCount[axis]) || (first > last)) {
+			return false;
+		}
+		outMin[axis] = FMath::Max(first, 0);
+		outMax[axis] = FMath::Min(last, voxelCount[axis] - 1);
+	}
+	return true;
+}
+
+// Builds the mask from one pattern per axis: the selected columns repeated 
+// in every row, the selected rows repeated in every slice, and the selected
+// slices.
+uint64 RealSenseOccupancyGrid::GetBrickMask(const FIntVector& brick, const FIntVector& rangeMin, const FIntVector& rangeMax)
+{
+	uint64 axisMasks[3];
+	for (int32 axis = 0; axis < 3; axis++) {
+		const int32 first = FMath::Max(rangeMin[axis] - brick[axis] * BrickSize, 0);
+		const int32 last = FMath::Min(rangeMax[axis] - brick[axis] * BrickSize, BrickSize - 1);
+		axisMasks[axis] = ((1ull << (last + 1)) - 1) & ~((1ull << first) - 1);
+	}
+
+	uint64 rows = 0;
+	uint64 slices = 0;
+	for (int32 i = 0; i < BrickSize; i++) {
+		if (axisMasks[1] & (1ull << i)) {
+			rows |= 0xFull << (i * BrickSize);
+		}
+		if (axisMasks[2] & (1ull << i)) {
+			slices |= 0xFFFFull << (i * BrickSize * BrickSize);
+		}
+	}
+
+	return (axisMasks[0] * 0x1111111111111111ull) & (rows * 0x0001000100010001ull) & slices;
+}
+
+// Whole bricks are tested at once against the part of the range they cover.
+bool RealSenseOccupancyGrid::OverlapsBox(const FBox& box) const
+{
+	FIntVector rangeMin, rangeMax;
+	if (GetVoxelRange(box.Min, box.Max, rangeMin, rangeMax) == false) {
+		return false;
+	}
+
+	for (int32 z = rangeMin.Z / BrickSize; z <= rangeMax.Z / BrickSize; z++) {
+		for (int32 y = rangeMin.Y / BrickSize; y <= rangeMax.Y / BrickSize; y++) {
+			for (int32 x = rangeMin.X / BrickSize; x <= rangeMax.X / BrickSize; x++) {
+				const uint64 brick = bricks[(z * brickCount.Y + y) * brickCount.X + x];
+				if ((brick != 0) && ((brick & GetBrickMask(FIntVector(x, y, z), rangeMin, rangeMax)) != 0)) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// Narrows the search to the occupied voxels within the bounds of the sphere,
+// then tests each one's box against the sphere.
+bool RealSenseOccupancyGrid::OverlapsSphere(const FVector& center, float radius) const
+{
+	FIntVector rangeMin, rangeMax;
+	if (GetVoxelRange(center - FVector(radius), center + FVector(radius), rangeMin, rangeMax) == false) {
+		return false;
+	}
+
+	const float voxelSize = settings.voxelSize;
+	const float radiusSquared = radius * radius;
+
+	for (int32 z = rangeMin.Z / BrickSize; z <= rangeMax.Z / BrickSize; z++) {
+		for (int32 y = rangeMin.Y / BrickSize; y <= rangeMax.Y / BrickSize; y++) {
+			for (int32 x = rangeMin.X / BrickSize; x <= rangeMax.X / BrickSize; x++) {
+				uint64 bits = bricks[(z * brickCount.Y + y) * brickCount.X + x];
+				if (bits == 0) {
+					continue;
+				}
+				bits &= GetBrickMask(FIntVector(x, y, z), rangeMin, rangeMax);
+
+				for (int32 bit = 0; bits != 0; bit++, bits >>= 1) {
+					if ((bits & 1) == 0) {
+						continue;
+					}
+					const FVector voxelMin = settings.boundsMin + FVector(x * BrickSize + bit % BrickSize, 
+						y * BrickSize + (bit / BrickSize) % BrickSize, z * BrickSize + bit / (BrickSize * BrickSize)) * voxelSize;
+					const FVector closest = center.ComponentMax(voxelMin).ComponentMin(voxelMin + FVector(voxelSize));
+					if ((closest - center).SizeSquared() <= radiusSquared) {
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// Clips the ray to the grid, then steps from voxel to voxel through the 
+// nearest face (Amanatides and Woo, "A Fast Voxel Traversal Algorithm").
+bool RealSenseOccupancyGrid::Raycast(const FVector& origin, const FVector& direction, float maxDistance, 
+									 float& outDistance, FVector& outNormal) const
+{
+	const float length = direction.Size();
+	if ((bricks.Num() == 0) || (length <= 0.0f)) {
+		return false;
+	}
+
+	const FVector unitDirection = direction / length;
+	float enter = 0.0f;
+	float exit = maxDistance;
+	int32 enterAxis = -1;
+	for (int32 axis = 0; axis < 3; axis++) {
+		if (unitDirection[axis] == 0.0f) {
+			if ((origin[axis] < settings.boundsMin[axis]) || (origin[axis] > settings.boundsMax[axis])) {
+				return false;
+			}
+			continue;
+		}
+		const float t0 = (settings.boundsMin[axis] - origin[axis]) / unitDirection[axis];
+		const float t1 = (settings.boundsMax[axis] - origin[axis]) / unitDirection[axis];
+		if (FMath::Min(t0, t1) > enter) {
+			enter = FMath::Min(t0, t1);
+			enterAxis = axis;
+		}
+		exit = FMath::Min(exit, FMath::Max(t0, t1));
+	}
+	if (enter > exit) {
+		return false;
+	}
+
+	const float voxelSize = settings.voxelSize;
+	const FVector start = (origin + unitDirection * enter - settings.boundsMin) / voxelSize;
+	int32 voxel[3];
+	int32 step[3];
+	float next[3];
+	float delta[3];
+	for (int32 axis = 0; axis < 3; axis++) {
+		voxel[axis] = FMath::Clamp(FMath::FloorToInt(start[axis]), 0, voxelCount[axis] - 1);
+		if (unitDirection[axis] == 0.0f) {
+			step[axis] = 0;
+			next[axis] = MAX_flt;
+			delta[axis] = MAX_flt;
+			continue;
+		}
+		step[axis] = (unitDirection[axis] > 0.0f) ? 1 : -1;
+		const float boundary = settings.boundsMin[axis] + (voxel[axis] + ((step[axis] > 0) ? 1 : 0)) * voxelSize;
+		next[axis] = (boundary - origin[axis]) / unitDirection[axis];
+		delta[axis] = voxelSize / FMath::Abs(unitDirection[axis]);
+	}
+
+	float t = enter;
+	for (;;) {
+		if (bricks[GetBrickIndex(voxel[0], voxel[1], voxel[2])] & GetVoxelBit(voxel[0], voxel[1], voxel[2])) {
+			outDistance = t;
+			if (enterAxis >= 0) {
+				outNormal = FVector(0.0f, 0.0f, 0.0f);
+				outNormal[enterAxis] = -(float)step[enterAxis];
+			}
+			else {
+				outNormal = -unitDirection;
+			}
+			return true;
+		}
+
+		const int32 axis = (next[0] < next[1]) ? ((next[0] < next[2]) ? 0 : 2) : ((next[1] < next[2]) ? 1 : 2);
+		t = next[axis];
+		voxel[axis] += step[axis];
+		if ((t > exit) || ((uint32)voxel[axis] >= (uint32)voxelCount[axis])) {
+			return false;
+		}
+		next[axis] += delta[axis];
+		enterAxis = axis;
+	}
+}
+
+void RealSenseOccupancyGrid::GetOccupiedVoxels(TArray<FVector>& outCenters) const
+{
+	const float voxelSize = settings.voxelSize;
+	for (int32 brick : occupiedBricks) {
+		const FVector brickMin = GetBrickBounds(brick).Min;
+		uint64 bits = bricks[brick];
+		for (int32 bit = 0; bits != 0; bit++, bits >>= 1) {
+			if (bits & 1) {
+				outCenters.Add(brickMin + FVector(bit % BrickSize + 0.5f, (bit / BrickSize) % BrickSize + 0.5f, 
+												  bit / (BrickSize * BrickSize) + 0.5f) * voxelSize);
+			}
+		}
+	}
+}
+
+SIZE_T RealSenseOccupancyGrid::GetAllocatedSize() const
+{
+	return bricks.GetAllocatedSize() + nextBricks.GetAllocatedSize() + brickRevisions.GetAllocatedSize() + 
+		   occupiedBricks.GetAllocatedSize() + nextOccupiedBricks.GetAllocatedSize() + 
+		   changeLog.GetAllocatedSize();
+}
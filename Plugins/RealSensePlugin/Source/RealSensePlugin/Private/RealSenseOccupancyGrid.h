@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+#include "RealSenseFusion.h"
+
+// Tuning parameters of the occupancy grid. Distances are in Unreal units (cm).
+struct RealSenseOccupancySettings {
+	FVector boundsMin;  // Corner of the grid volume, in world space
+	FVector boundsMax;  // Opposite corner, rounded up to whole bricks
+	float voxelSize;  // Edge length of a voxel
+	int32 pixelStep;  // Distance in depth pixels between the samples binned into the grid
+
+	RealSenseOccupancySettings() : boundsMin(0.0f, -125.0f, -100.0f), boundsMax(250.0f, 125.0f, 100.0f), 
+		voxelSize(4.0f), pixelStep(2) {}
+};
+
+// Voxels of a fixed volume that contain depth samples of the latest frame,
+// for cheap collision and visibility tests against the live scene.
+//
+// Occupancy is stored one bit per voxel in bricks of 4x4x4 voxels, each a 
+// single uint64, so that a brick is tested, compared, or copied in one 
+// operation. Every Update() bins the samples of a new depth frame into a 
+// cleared copy of the bricks, then only compares the bricks touched by this
+// frame or the previous one. Bricks that changed are stamped with the new 
+// revision and logged, which lets copies of the grid catch up by copying 
+// just those, without scanning the grid.
+class RealSenseOccupancyGrid {
+public:
+	static const int32 BrickSize = 4;
+
+	RealSenseOccupancyGrid();
+
+	// Applies new settings and clears the grid.
+	void Configure(const RealSenseOccupancySettings& settings);
+
+	inline const RealSenseOccupancySettings& GetSettings() const { return settings; }
+
+	// Clears every voxel.
+	void Reset();
+
+	// Replaces the occupancy with the samples of a depth frame (mm) taken by
+	// a camera with the given intrinsics and camera-to-world transform.
+	void Update(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics, const FMatrix& cameraToWorld);
+
+	// Incremented by every Update() that changes the grid
+	inline uint32 GetRevision() const { return revision; }
+
+	// Makes this grid a copy of source, copying only the bricks that changed
+	// since this grid was last copied, and writes their indices to 
+	// outChangedBricks. The cost is that of the changes, read from the change
+	// log of source. A grid with other settings is copied entirely, and one 
+	// that fell behind the log is compared brick by brick.
+	void CopyFrom(const RealSenseOccupancyGrid& source, TArray<int32>& outChangedBricks);
+
+	inline int32 GetBrickCount() const { return bricks.Num(); }
+
+	inline uint64 GetBrick(int32 brick) const { return bricks[brick]; }
+
+	// Returns the world space bounds of a brick.
+	FBox GetBrickBounds(int32 brick) const;
+
+	// Returns true if the voxel containing the position is occupied.
+	bool IsOccupied(const FVector& position) const;
+
+	// Returns true if any occupied voxel intersects the box.
+	bool OverlapsBox(const FBox& box) const;
+
+	// Returns true if any occupied voxel intersects the sphere.
+	bool OverlapsSphere(const FVector& center, float radius) const;
+
+	// Walks the voxels along the ray and returns the distance to the first 
+	// occupied one within maxDistance, with the normal of the face the ray 
+	// entered it through. The direction does not need to be normalized.
+	bool Raycast(const FVector& origin, const FVector& direction, float maxDistance, 
+				 float& outDistance, FVector& outNormal) const;
+
+	// Appends the world space centers of the occupied voxels.
+	void GetOccupiedVoxels(TArray<FVector>& outCenters) const;
+
+	// Returns the memory used by the grid, in bytes.
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	RealSenseOccupancySettings settings;
+
+	// Size of the grid in voxels and in bricks
+	FIntVector voxelCount;
+	FIntVector brickCount;
+
+	// Occupancy bits, indexed by (z * BrickSize + y) * BrickSize + x within
+	// a brick, and bricks indexed by (z * brickCount.Y + y) * brickCount.X + x
+	TArray<uint64> bricks;
+
+	// Revision at which each brick last changed
+	TArray<uint32> brickRevisions;
+	uint32 revision;
+
+	// Bricks changed by every revision after logBaseRevision, oldest first
+	struct BrickChange {
+		uint32 revision;
+		int32 brick;
+	};
+	TArray<BrickChange> changeLog;
+	uint32 logBaseRevision;
+
+	// Bricks being filled by Update(), all zero outside of it
+	TArray<uint64> nextBricks;
+
+	// Non-empty bricks of the current and of the next occupancy
+	TArray<int32> occupiedBricks;
+	TArray<int32> nextOccupiedBricks;
+
+	inline int32 GetBrickIndex(int32 x, int32 y, int32 z) const
+	{
+		return ((z / BrickSize) * brickCount.Y + (y / BrickSize)) * brickCount.X + (x / BrickSize);
+	}
+
+	static inline uint64 GetVoxelBit(int32 x, int32 y, int32 z)
+	{
+		return 1ull << (((z % BrickSize) * BrickSize + (y % BrickSize)) * BrickSize + (x % BrickSize));
+	}
+
+	// Converts a box to the inclusive range of voxels it touches, clipped to 
+	// the grid. Returns false if the box is outside the grid.
+	bool GetVoxelRange(const FVector& boxMin, const FVector& boxMax, FIntVector& outMin, FIntVector& outMax) const;
+
+	// Stamps a brick with the revision that changed it and logs the change.
+	inline void MarkChanged(int32 brick, uint32 changeRevision)
+	{
+		brickRevisions[brick] = changeRevision;
+		changeLog.Add({ changeRevision, brick });
+	}
+
+	// Drops the older half of the change log once it outgrows the point 
+	// where scanning the grid would be as cheap.
+	void TrimChangeLog();
+
+	// Returns the bits of a brick whose voxels lie within the voxel range.
+	static uint64 GetBrickMask(const FIntVector& brick, const FIntVector& rangeMin, const FIntVector& rangeMax);
+};
@@ -0,0 +1,406 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSensePlaneDetector.h"
+#include "ParallelFor.h"
+
+// Matched planes are recorded in 32-bit masks, and labeled in an 8-bit mask
+static const int32 MaxPlanes = 32;
+
+// Number of samples the hypotheses are scored against
+static const int32 ScoreSamples = 1024;
+
+// Rows of the depth frame labeled per task
+static const int32 RowsPerTask = 16;
+
+RealSensePlaneDetector::RealSensePlaneDetector() : random(0x504c414e)
+{
+	nextId = 1;
+	revision = 0;
+}
+
+void RealSensePlaneDetector::Configure(const RealSensePlaneSettings& newSettings)
+{
+	settings = newSettings;
+	settings.maxPlanes = FMath::Clamp(settings.maxPlanes, 0, MaxPlanes);
+	settings.minInliers = FMath::Max(settings.minInliers, 3);
+	settings.inlierDistance = FMath::Max(settings.inlierDistance, 0.01f);
+	settings.maxNormalAngle = FMath::Clamp(settings.maxNormalAngle, 0.0f, 90.0f);
+	settings.hypotheses = FMath::Max(settings.hypotheses, 1);
+	settings.pixelStep = FMath::Max(settings.pixelStep, 1);
+}
+
+void RealSensePlaneDetector::Reset()
+{
+	planes.Reset();
+	previousPlanes.Reset();
+	nextId = 1;
+	revision++;
+}
+
+void RealSensePlaneDetector::Update(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics)
+{
+	Swap(planes, previousPlanes);
+	planes.Reset();
+	revision++;
+
+	if (depth == nullptr) {
+		planeMask.Reset();
+		TrackPlanes();
+		return;
+	}
+
+	SamplePoints(depth, intrinsics);
+
+	const float cosMaxAngle = FMath::Cos(FMath::DegreesToRadians(settings.maxNormalAngle));
+	while (planes.Num() < settings.maxPlanes) {
+		Hypothesis plane;
+		if (FindPlane(plane) == false) {
+			break;
+		}
+
+		// Refit to the inliers of the hypothesis, then once more to the 
+		// inliers of the refit plane, which are usually more numerous
+		FVector center;
+		GatherInliers(plane, cosMaxAngle);
+		if ((inliers.Num() < settings.minInliers) || (FitPlane(plane, center) == false)) {
+			break;
+		}
+		GatherInliers(plane, cosMaxAngle);
+		if ((inliers.Num() < settings.minInliers) || (FitPlane(plane, center) == false)) {
+			break;
+		}
+
+		FDepthPlane& result = planes[planes.AddDefaulted()];
+		result.Normal = plane.normal;
+		result.Distance = plane.distance;
+		result.Center = center;
+		Swap(available, outliers);
+	}
+
+	TrackPlanes();
+	LabelPixels(depth, intrinsics);
+}
+
+// Samples the depth frame into a point cloud, then estimates the normal of
+// every sample from the cross product of the vectors between its opposite 
+// neighbors. Samples missing a neighbor get no normal and are left out of 
+// the search.
+void RealSensePlaneDetector::SamplePoints(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics)
+{
+	const int32 step = settings.pixelStep;
+	const int32 columns = (intrinsics.width + step - 1) / step;
+	const int32 rows = (intrinsics.height + step - 1) / step;
+
+	points.SetNumUninitialized(columns * rows);
+	normals.SetNumUninitialized(columns * rows);
+
+	ParallelFor(rows, [&](int32 y) {
+		const int32 v = y * step;
+		const uint16* row = depth + v * intrinsics.width;
+		const float b = (intrinsics.cy - v) / intrinsics.fy;
+
+		for (int32 x = 0; x < columns; x++) {
+			const int32 u = x * step;
+			const float forward = row[u] * 0.1f;
+			points[y * columns + x] = FVector(forward, forward * (u - intrinsics.cx) / intrinsics.fx, forward * b);
+		}
+	});
+
+	ParallelFor(rows, [&](int32 y) {
+		for (int32 x = 0; x < columns; x++) {
+			const int32 i = y * columns + x;
+			normals[i] = FVector::ZeroVector;
+
+			if ((x == 0) || (y == 0) || (x == columns - 1) || (y == rows - 1) || (points[i].X == 0.0f)) {
+				continue;
+			}
+
+			const FVector& left = points[i - 1];
+			const FVector& right = points[i + 1];
+			const FVector& up = points[i - columns];
+			const FVector& down = points[i + columns];
+			if ((left.X == 0.0f) || (right.X == 0.0f) || (up.X == 0.0f) || (down.X == 0.0f)) {
+				continue;
+			}
+
+			FVector normal = FVector::CrossProduct(right - left, up - down);
+			if (FVector::DotProduct(normal, points[i]) > 0.0f) {
+				normal = -normal;
+			}
+			normals[i] = normal.GetSafeNormal();
+		}
+	});
+
+	available.Reset();
+	for (int32 i = 0; i < normals.Num(); i++) {
+		if (normals[i].IsZero() == false) {
+			available.Add(i);
+		}
+	}
+}
+
+// Scores the planes of the previous frame and settings.hypotheses random 
+// hypotheses against the same random subset of the available samples, and
+// returns the best one if it is estimated to hold enough samples.
+bool RealSensePlaneDetector::FindPlane(Hypothesis& outPlane)
+{
+	const int32 count = available.Num();
+	if (count < settings.minInliers) {
+		return false;
+	}
+
+	// The subset is copied out so that scoring streams through it
+	const int32 subsetSize = FMath::Min(count, ScoreSamples);
+	subsetPoints.SetNumUninitialized(subsetSize);
+	subsetNormals.SetNumUninitialized(subsetSize);
+	for (int32 i = 0; i < subsetSize; i++) {
+		const int32 sample = available[(subsetSize == count) ? i : random.RandHelper(count)];
+		subsetPoints[i] = points[sample];
+		subsetNormals[i] = normals[sample];
+	}
+
+	hypotheses.Reset();
+	for (const FDepthPlane& plane : previousPlanes) {
+		Hypothesis hypothesis = { plane.Normal, plane.Distance };
+		hypotheses.Add(hypothesis);
+	}
+	for (int32 i = 0; i < settings.hypotheses; i++) {
+		const int32 sample = available[random.RandHelper(count)];
+		Hypothesis hypothesis = { normals[sample], FVector::DotProduct(normals[sample], points[sample]) };
+		hypotheses.Add(hypothesis);
+	}
+
+	const float cosMaxAngle = FMath::Cos(FMath::DegreesToRadians(settings.maxNormalAngle));
+	scores.SetNumUninitialized(hypotheses.Num());
+	ParallelFor(hypotheses.Num(), [&](int32 h) {
+		const Hypothesis& hypothesis = hypotheses[h];
+		const float inlierDistance = settings.inlierDistance;
+		int32 score = 0;
+		for (int32 i = 0; i < subsetSize; i++) {
+			const float distance = FVector::DotProduct(hypothesis.normal, subsetPoints[i]) - hypothesis.distance;
+			score += (FMath::Abs(distance) < inlierDistance) & 
+				(FVector::DotProduct(hypothesis.normal, subsetNormals[i]) > cosMaxAngle);
+		}
+		scores[h] = score;
+	});
+
+	int32 best = 0;
+	for (int32 h = 1; h < scores.Num(); h++) {
+		if (scores[h] > scores[best]) {
+			best = h;
+		}
+	}
+
+	if ((int64)scores[best] * count < (int64)settings.minInliers * subsetSize) {
+		return false;
+	}
+
+	outPlane = hypotheses[best];
+	return true;
+}
+
+// Splits the available samples into the inliers of the plane and the rest.
+void RealSensePlaneDetector::GatherInliers(const Hypothesis& plane, float cosMaxAngle)
+{
+	inliers.Reset();
+	outliers.Reset();
+	for (int32 sample : available) {
+		const float distance = FVector::DotProduct(plane.normal, points[sample]) - plane.distance;
+		if ((FMath::Abs(distance) < settings.inlierDistance) && 
+			(FVector::DotProduct(plane.normal, normals[sample]) > cosMaxAngle)) {
+			inliers.Add(sample);
+		}
+		else {
+			outliers.Add(sample);
+		}
+	}
+}
+
+// Least-squares fit of a plane to the inliers. The normal is the cross 
+// product of two rows of their covariance, solved along the axis whose 
+// minor determinant is largest for stability. It is flipped if needed to 
+// keep the orientation of the plane being refit, which faces the camera.
+bool RealSensePlaneDetector::FitPlane(Hypothesis& plane, FVector& outCenter) const
+{
+	FVector sum = FVector::ZeroVector;
+	for (int32 sample : inliers) {
+		sum += points[sample];
+	}
+	outCenter = sum / inliers.Num();
+
+	double xx = 0.0, xy = 0.0, xz = 0.0, yy = 0.0, yz = 0.0, zz = 0.0;
+	for (int32 sample : inliers) {
+		const FVector r = points[sample] - outCenter;
+		xx += r.X * r.X;
+		xy += r.X * r.Y;
+		xz += r.X * r.Z;
+		yy += r.Y * r.Y;
+		yz += r.Y * r.Z;
+		zz += r.Z * r.Z;
+	}
+
+	const double detX = yy * zz - yz * yz;
+	const double detY = xx * zz - xz * xz;
+	const double detZ = xx * yy - xy * xy;
+	const double detMax = FMath::Max3(detX, detY, detZ);
+	if (detMax <= 0.0) {
+		return false;
+	}
+
+	FVector normal;
+	if (detMax == detX) {
+		normal = FVector(detX, xz * yz - xy * zz, xy * yz - xz * yy);
+	}
+	else if (detMax == detY) {
+		normal = FVector(xz * yz - xy * zz, detY, xy * xz - yz * xx);
+	}
+	else {
+		normal = FVector(xy * yz - xz * yy, xy * xz - yz * xx, detZ);
+	}
+
+	normal = normal.GetSafeNormal();
+	if (normal.IsZero()) {
+		return false;
+	}
+	if (FVector::DotProduct(normal, plane.normal) < 0.0f) {
+		normal = -normal;
+	}
+
+	plane.normal = normal;
+	plane.distance = FVector::DotProduct(normal, outCenter);
+	return true;
+}
+
+// Matches the planes found to those of the previous frame greedily, in the
+// order they were found. Planes match if their normals are within 
+// maxNormalAngle and their distances within a few inlierDistance.
+void RealSensePlaneDetector::TrackPlanes()
+{
+	const float cosMaxAngle = FMath::Cos(FMath::DegreesToRadians(settings.maxNormalAngle));
+	const float maxDistance = settings.inlierDistance * 4.0f;
+
+	uint32 matched = 0;
+	for (FDepthPlane& plane : planes) {
+		int32 best = INDEX_NONE;
+		float bestCos = cosMaxAngle;
+		for (int32 i = 0; i < previousPlanes.Num(); i++) {
+			const float cosAngle = FVector::DotProduct(plane.Normal, previousPlanes[i].Normal);
+			if (((matched & (1u << i)) == 0) && (cosAngle > bestCos) && 
+				(FMath::Abs(plane.Distance - previousPlanes[i].Distance) < maxDistance)) {
+				best = i;
+				bestCos = cosAngle;
+			}
+		}
+
+		if (best != INDEX_NONE) {
+			matched |= 1u << best;
+			plane.Id = previousPlanes[best].Id;
+			plane.Age = previousPlanes[best].Age + 1;
+		}
+		else {
+			plane.Id = nextId++;
+			plane.Age = 1;
+		}
+	}
+}
+
+// Labels every pixel with the nearest plane within inlierDistance, in 
+// parallel over blocks of rows. The signed distance of pixel (u, v) at 
+// depth d to a plane is d * (rowTerm(v) + normal.Y * a(u)) - distance, where
+// a(u) is the ray slope of column u, so each plane costs two multiply-adds 
+// per pixel. Inlier counts are summed per task and then per plane.
+void RealSensePlaneDetector::LabelPixels(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics)
+{
+	const int32 width = intrinsics.width;
+	const int32 height = intrinsics.height;
+	const int32 planeCount = planes.Num();
+
+	planeMask.SetNumUninitialized(width * height);
+	if (planeCount == 0) {
+		FMemory::Memzero(planeMask.GetData(), planeMask.Num());
+		return;
+	}
+
+	TArray<float> slopes;
+	slopes.SetNumUninitialized(width);
+	for (int32 u = 0; u < width; u++) {
+		slopes[u] = (u - intrinsics.cx) / intrinsics.fx;
+	}
+
+	const int32 taskCount = (height + RowsPerTask - 1) / RowsPerTask;
+	TArray<int32> counts;
+	counts.SetNumZeroed(taskCount * planeCount);
+
+	ParallelFor(taskCount, [&](int32 task) {
+		// Raw pointers, since the byte stores to the mask would otherwise force
+		// the array data pointers to be reloaded on every pixel
+		TArray<float> rowBuffers;
+		rowBuffers.SetNumUninitialized(width * 2);
+		float* rowDepths = rowBuffers.GetData();
+		float* nearest = rowDepths + width;
+		const float* slopeData = slopes.GetData();
+		int32* taskCounts = &counts[task * planeCount];
+
+		const int32 last = FMath::Min((task + 1) * RowsPerTask, height);
+		for (int32 v = task * RowsPerTask; v < last; v++) {
+			const uint16* row = depth + v * width;
+			uint8* labels = planeMask.GetData() + v * width;
+			const float b = (intrinsics.cy - v) / intrinsics.fy;
+
+			// Pixels without depth start with a nearest distance of zero so 
+			// that they are never labeled
+			for (int32 u = 0; u < width; u++) {
+				rowDepths[u] = row[u] * 0.1f;
+				nearest[u] = (row[u] != 0) ? settings.inlierDistance : 0.0f;
+				labels[u] = 0;
+			}
+
+			// One plane at a time over the whole row, so the inner loop is 
+			// branch-free and vectorizes
+			for (int32 p = 0; p < planeCount; p++) {
+				const float rowTerm = planes[p].Normal.X + planes[p].Normal.Z * b;
+				const float slopeTerm = planes[p].Normal.Y;
+				const float distance = planes[p].Distance;
+				const uint8 label = p + 1;
+				for (int32 u = 0; u < width; u++) {
+					const float pixelDistance = FMath::Abs(rowDepths[u] * (rowTerm + slopeTerm * slopeData[u]) - distance);
+					const bool bNearer = pixelDistance < nearest[u];
+					labels[u] = bNearer ? label : labels[u];
+					nearest[u] = bNearer ? pixelDistance : nearest[u];
+				}
+			}
+
+			// Counted one plane at a time too, as incrementing a histogram 
+			// indexed by label stalls on runs of equal labels
+			for (int32 p = 0; p < planeCount; p++) {
+				const uint8 label = p + 1;
+				int32 count = 0;
+				for (int32 u = 0; u < width; u++) {
+					count += (labels[u] == label);
+				}
+				taskCounts[p] += count;
+			}
+		}
+	});
+
+	for (int32 p = 0; p < planeCount; p++) {
+		planes[p].InlierCount = 0;
+		for (int32 task = 0; task < taskCount; task++) {
+			planes[p].InlierCount += counts[task * planeCount + p];
+		}
+	}
+}
@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseTypes.h"
+#include "RealSenseFusion.h"
+
+// Tuning parameters of the plane detector. Distances are in Unreal units (cm).
+struct RealSensePlaneSettings {
+	int32 maxPlanes;  // Largest number of planes kept, the largest ones first
+	int32 minInliers;  // Fewest samples a plane must hold to be kept
+	float inlierDistance;  // Farthest a point may lie from a plane and belong to it
+	float maxNormalAngle;  // Largest angle (degrees) between a sample's normal and a plane's normal
+	int32 hypotheses;  // Number of random planes scored per plane found
+	int32 pixelStep;  // Distance in depth pixels between the samples of the point cloud
+
+	RealSensePlaneSettings() : maxPlanes(4), minInliers(400), inlierDistance(1.5f), maxNormalAngle(20.0f), 
+		hypotheses(64), pixelStep(4) {}
+};
+
+// Finds the dominant planes of a depth frame with RANSAC, and follows them 
+// from frame to frame.
+//
+// The depth frame is sampled every pixelStep pixels into a point cloud with 
+// a normal per point, from the cross product of its neighbors. A hypothesis
+// is then the plane through a single point with that point's normal, so one
+// sample is enough and most hypotheses drawn on a plane are close to it. The
+// hypotheses are scored in parallel against a random subset of the points,
+// counting the points that are near the plane and share its orientation. The
+// best one is refit to all its inliers by least squares, its inliers are 
+// removed, and the search repeats for the next plane.
+//
+// The planes of the previous frame are scored along with the random 
+// hypotheses, so a plane that is still there keeps winning over noisier 
+// candidates, and planes matched to the previous frame keep their Id.
+//
+// Finally, every pixel of the depth frame is labeled with the nearest plane
+// within inlierDistance, in parallel over rows.
+class RealSensePlaneDetector {
+public:
+	RealSensePlaneDetector();
+
+	void Configure(const RealSensePlaneSettings& settings);
+
+	inline const RealSensePlaneSettings& GetSettings() const { return settings; }
+
+	// Forgets the tracked planes. Ids start over from 1.
+	void Reset();
+
+	// Finds the planes of a depth frame (mm) and matches them to the planes 
+	// of the previous frame.
+	void Update(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics);
+
+	// Planes of the last frame, in the order they were found, which is 
+	// roughly largest first
+	inline const TArray<FDepthPlane>& GetPlanes() const { return planes; }
+
+	// Label of every pixel of the last frame: 0 if the pixel is on no plane,
+	// otherwise 1 + the index of its plane in GetPlanes()
+	inline const TArray<uint8>& GetPlaneMask() const { return planeMask; }
+
+	// Increased by every Update() and Reset(), so that copies of the planes
+	// and the mask are only made when they changed
+	inline uint64 GetRevision() const { return revision; }
+
+private:
+	// Plane as Dot(normal, P) == distance
+	struct Hypothesis {
+		FVector normal;
+		float distance;
+	};
+
+	RealSensePlaneSettings settings;
+
+	TArray<FVector> points;  // Sampled point cloud, in Unreal units
+	TArray<FVector> normals;  // Normal of every sample, zero if it could not be estimated
+	TArray<int32> available;  // Samples with a normal that no plane has taken yet
+	TArray<FVector> subsetPoints;  // Samples the hypotheses are scored against
+	TArray<FVector> subsetNormals;
+	TArray<int32> inliers;  // Samples of the plane being fit, and the other available samples
+	TArray<int32> outliers;
+	TArray<Hypothesis> hypotheses;
+	TArray<int32> scores;
+
+	TArray<FDepthPlane> planes;
+	TArray<FDepthPlane> previousPlanes;
+	TArray<uint8> planeMask;
+	int32 nextId;
+	uint64 revision;
+	FRandomStream random;
+
+	void SamplePoints(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics);
+
+	bool FindPlane(Hypothesis& outPlane);
+
+	void GatherInliers(const Hypothesis& plane, float cosMaxAngle);
+
+	bool FitPlane(Hypothesis& plane, FVector& outCenter) const;
+
+	void TrackPlanes();
+
+	void LabelPixels(const uint16* depth, const RealSenseCameraIntrinsics& intrinsics);
+};
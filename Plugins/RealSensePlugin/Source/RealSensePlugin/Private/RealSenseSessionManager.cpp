@@ -15,9 +15,37 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 #include "RealSensePluginPrivatePCH.h"
 #include "RealSenseSessionManager.h"
-
-// Initialized the feature set to 0 (no features enabled) and creates a new
-// RealSenseImpl object.
+#include "RealSenseImpl.h"
+#include "RealSenseDepthMesh.h"
+#include "RealSenseFrameStream.h"
+#include "RealSenseSharedMemoryPublisher.h"
+#include "RealSenseFrameQueue.h"
+#include "RealSenseFrameHistory.h"
+
+#include "AllowWindowsPlatformTypes.h"
+#include <algorithm>
+#include "HideWindowsPlatformTypes.h"
+
+DECLARE_STATS_GROUP(TEXT("RealSense"), STATGROUP_RealSense, STATCAT_Advanced);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Face Tracking (ms)"), STAT_RealSenseFaceTrackingMs, STATGROUP_RealSense);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Segmentation (ms)"), STAT_RealSenseSegmentationMs, STATGROUP_RealSense);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Scan Preview (ms)"), STAT_RealSenseScanPreviewMs, STATGROUP_RealSense);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Occupancy Grid (ms)"), STAT_RealSenseOccupancyGridMs, STATGROUP_RealSense);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Blob Tracking (ms)"), STAT_RealSenseBlobTrackingMs, STATGROUP_RealSense);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Plane Detection (ms)"), STAT_RealSensePlaneDetectionMs, STATGROUP_RealSense);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Depth Background (ms)"), STAT_RealSenseDepthBackgroundMs, STATGROUP_RealSense);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Optional Stages per Frame (ms)"), STAT_RealSenseStageTotalMs, STATGROUP_RealSense);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Face Tracking Interval"), STAT_RealSenseFaceTrackingInterval, STATGROUP_RealSense);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Segmentation Interval"), STAT_RealSenseSegmentationInterval, STATGROUP_RealSense);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Scan Preview Interval"), STAT_RealSenseScanPreviewInterval, STATGROUP_RealSense);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Occupancy Grid Interval"), STAT_RealSenseOccupancyGridInterval, STATGROUP_RealSense);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Blob Tracking Interval"), STAT_RealSenseBlobTrackingInterval, STATGROUP_RealSense);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Plane Detection Interval"), STAT_RealSensePlaneDetectionInterval, STATGROUP_RealSense);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Depth Background Interval"), STAT_RealSenseDepthBackgroundInterval, STATGROUP_RealSense);
+
+// Initialized the feature set to 0 (no features enabled). The RealSenseImpl 
+// object is only created on first use, so that constructing the class default 
+// object or placing the actor in the editor never touches the RealSense SDK.
 ARealSenseSessionManager::ARealSenseSessionManager(const class FObjectInitializer& Init)
 	: Super(Init)
 {
@@ -25,7 +53,18 @@ ARealSenseSessionManager::ARealSenseSessionManager(const class FObjectInitialize
 
 	RealSenseFeatureSet = 0;
 
-	impl = std::unique_ptr<RealSenseImpl>(new RealSenseImpl());
+	bDevicesReady = false;
+}
+
+// Kicks off device discovery on a background task as soon as the actor is 
+// part of a game world, so that it overlaps with the rest of level startup.
+void ARealSenseSessionManager::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	if (GetWorld() && GetWorld()->IsGameWorld()) {
+		RealSenseDeviceRegistry::Get().BeginEnumeration();
+	}
 }
 
 void ARealSenseSessionManager::BeginPlay() 
@@ -33,37 +72,95 @@ void ARealSenseSessionManager::BeginPlay()
 	Super::BeginPlay();
 }
 
+// Closes the frame queues so that a lossless queue cannot keep the camera 
+// processing thread blocked while the RealSenseImpl is shutting it down.
+void ARealSenseSessionManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for (const std::shared_ptr<RealSenseFrameQueue>& Queue : frameQueues) {
+		Queue->Close();
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+// Creates the RealSenseImpl for the requested device and applies the current
+// feature set to it. Blocks until device discovery has finished.
+RealSenseImpl* ARealSenseSessionManager::GetImpl() const
+{
+	if (impl == nullptr) {
+		impl = std::make_shared<RealSenseImpl>(DeviceSerial);
+
+		const RealSenseFeature Features[] = { CAMERA_STREAMING, SCAN_3D, HEAD_TRACKING, SEGMENTATION_3D, OCCUPANCY_GRID,
+											  BLOB_TRACKING, PLANE_DETECTION, DEPTH_BACKGROUND };
+		for (RealSenseFeature Feature : Features) {
+			if (RealSenseFeatureSet & Feature) {
+				impl->EnableFeature(Feature);
+			}
+		}
+	}
+	return impl.get();
+}
+
+bool ARealSenseSessionManager::AreDevicesReady() const
+{
+	return bDevicesReady;
+}
+
 // Grab a new frame of RealSense data and process it based on the current
 // set of enabled features.
 void ARealSenseSessionManager::Tick(float DeltaTime) 
 {
 	Super::Tick(DeltaTime);
 
-	if (impl->IsCameraThreadRunning() == false) {
+	if ((bDevicesReady == false) && RealSenseDeviceRegistry::Get().IsReady()) {
+		bDevicesReady = true;
+		OnDevicesReady.Broadcast();
+	}
+
+	if (IsCameraRunning() == false) {
 		return;
 	}
 
-	// Grab the next frame of RealSense data
-	impl->SwapFrames();
+	UpdateGovernorStats(DeltaTime);
+
+	// Grab the next frame of RealSense data, either from the local camera or 
+	// from a stream server
+	IRealSenseFrameSource* source = GetFrameSource();
+	source->SwapFrames();
 
 	if (RealSenseFeatureSet & RealSenseFeature::CAMERA_STREAMING) {
 		// Update the ColorBuffer
 		const uint8 bytesPerPixel = 4;
-		const uint32 ColorImageSize = impl->GetColorImageWidth() * impl->GetColorImageHeight() * bytesPerPixel;
-		FMemory::Memcpy(ColorBuffer.GetData(), impl->GetColorBuffer(), ColorImageSize);
+		const int32 ColorImageSize = source->GetColorImageWidth() * source->GetColorImageHeight();
+		ColorBuffer.SetNumUninitialized(ColorImageSize);
+		FMemory::Memcpy(ColorBuffer.GetData(), source->GetColorBuffer(), ColorImageSize * bytesPerPixel);
 
 		// Update the DepthBuffer
-		DepthBuffer.Empty();
-		const uint32 DepthImageSize = impl->GetDepthImageWidth() * impl->GetDepthImageHeight();
-		for (auto it = impl->GetDepthBuffer(), end = it + DepthImageSize; it != end; it++) {
-			DepthBuffer.Add(*it);
+		const int32 DepthImageSize = source->GetDepthImageWidth() * source->GetDepthImageHeight();
+		DepthBuffer.SetNumUninitialized(DepthImageSize);
+		const uint16* Depth = source->GetDepthBuffer();
+		int32* Out = DepthBuffer.GetData();
+		for (int32 i = 0; i < DepthImageSize; i++) {
+			Out[i] = Depth[i];
 		}
 	}
 
+	if (source != impl.get()) {
+		return;
+	}
+
+	if (RealSenseFeatureSet & RealSenseFeature::SEGMENTATION_3D) {
+		const RealSenseImageBuffer<uint8>& Mask = impl->GetSegmentationMask();
+		SegmentationMask.SetNumUninitialized(Mask.Num());
+		FMemory::Memcpy(SegmentationMask.GetData(), Mask.GetData(), Mask.Num());
+		SegmentationRuns = impl->GetSegmentationRuns();
+	}
+
 	if (RealSenseFeatureSet & RealSenseFeature::SCAN_3D) {
 		const uint8 bytesPerPixel = 4;
 		const uint32 Scan3DImageSize = impl->GetScan3DImageWidth() * impl->GetScan3DImageHeight();
 		if (impl->HasScan3DImageSizeChanged()) {
+			ScanBuffer.Reserve(GetMaxColorImagePixels());
 			ScanBuffer.SetNumUninitialized(Scan3DImageSize);
 		}
 	
@@ -74,191 +171,723 @@ void ARealSenseSessionManager::Tick(float DeltaTime)
 	}
 }
 
+// Feeds the game frame time to the governor and publishes its decisions, 
+// visible with "stat RealSense".
+void ARealSenseSessionManager::UpdateGovernorStats(float DeltaTime)
+{
+	if (impl == nullptr) {
+		return;
+	}
+
+	RealSenseGovernor& Governor = impl->GetGovernor();
+	Governor.SetGameFrameTime(DeltaTime * 1000.0f);
+
+	SET_FLOAT_STAT(STAT_RealSenseFaceTrackingMs, Governor.GetStageCost(RealSenseStage::FACE_TRACKING));
+	SET_FLOAT_STAT(STAT_RealSenseSegmentationMs, Governor.GetStageCost(RealSenseStage::SEGMENTATION));
+	SET_FLOAT_STAT(STAT_RealSenseScanPreviewMs, Governor.GetStageCost(RealSenseStage::SCAN_PREVIEW));
+	SET_FLOAT_STAT(STAT_RealSenseOccupancyGridMs, Governor.GetStageCost(RealSenseStage::OCCUPANCY_GRID));
+	SET_FLOAT_STAT(STAT_RealSenseBlobTrackingMs, Governor.GetStageCost(RealSenseStage::BLOB_TRACKING));
+	SET_FLOAT_STAT(STAT_RealSensePlaneDetectionMs, Governor.GetStageCost(RealSenseStage::PLANE_DETECTION));
+	SET_FLOAT_STAT(STAT_RealSenseDepthBackgroundMs, Governor.GetStageCost(RealSenseStage::DEPTH_BACKGROUND));
+	SET_FLOAT_STAT(STAT_RealSenseStageTotalMs, Governor.GetTotalCost());
+	SET_DWORD_STAT(STAT_RealSenseFaceTrackingInterval, Governor.GetInterval(RealSenseStage::FACE_TRACKING));
+	SET_DWORD_STAT(STAT_RealSenseSegmentationInterval, Governor.GetInterval(RealSenseStage::SEGMENTATION));
+	SET_DWORD_STAT(STAT_RealSenseScanPreviewInterval, Governor.GetInterval(RealSenseStage::SCAN_PREVIEW));
+	SET_DWORD_STAT(STAT_RealSenseOccupancyGridInterval, Governor.GetInterval(RealSenseStage::OCCUPANCY_GRID));
+	SET_DWORD_STAT(STAT_RealSenseBlobTrackingInterval, Governor.GetInterval(RealSenseStage::BLOB_TRACKING));
+	SET_DWORD_STAT(STAT_RealSensePlaneDetectionInterval, Governor.GetInterval(RealSenseStage::PLANE_DETECTION));
+	SET_DWORD_STAT(STAT_RealSenseDepthBackgroundInterval, Governor.GetInterval(RealSenseStage::DEPTH_BACKGROUND));
+}
+
+void ARealSenseSessionManager::ConfigureGovernor(bool bEnabled, float TargetFrameMs, float StageBudgetMs, int32 MaxInterval)
+{
+	RealSenseGovernorSettings Settings;
+	Settings.bEnabled = bEnabled;
+	Settings.targetFrameMs = TargetFrameMs;
+	Settings.stageBudgetMs = StageBudgetMs;
+	Settings.maxInterval = MaxInterval;
+	GetImpl()->GetGovernor().Configure(Settings);
+}
+
+// Discards the RealSenseImpl of the previous device. The one for the new 
+// device is created on first use.
+void ARealSenseSessionManager::SetDeviceSerial(const FString& Serial)
+{
+	if ((Serial == DeviceSerial) || IsCameraRunning()) {
+		return;
+	}
+
+	DeviceSerial = Serial;
+	StopStreamServer();
+	StopSharedMemoryPublisher();
+	StopFrameHistory();
+	while (frameQueues.Num() > 0) {
+		DestroyFrameQueue(frameQueues.Last());
+	}
+	impl.reset();
+}
+
+FString ARealSenseSessionManager::GetConnectedDeviceSerial() const
+{
+	return GetImpl()->HasDevice() ? GetImpl()->GetDeviceSerial() : FString();
+}
+
+// Records the feature in the feature set. If the RealSenseImpl has not been
+// created yet, the feature set is applied to it when it is.
 void ARealSenseSessionManager::EnableFeature(RealSenseFeature feature)
 {
 	RealSenseFeatureSet |= feature;
-	impl->EnableFeature(feature);
+	if (impl) {
+		impl->EnableFeature(feature);
+	}
 }
 
 void ARealSenseSessionManager::DisableFeature(RealSenseFeature feature)
 {
 	RealSenseFeatureSet &= ~feature;
-	impl->DisableFeature(feature);
+	if (impl) {
+		impl->DisableFeature(feature);
+	}
 }
 
 bool ARealSenseSessionManager::IsCameraConnected() const
 { 
-	return impl->IsCameraConnected(); 
+	return GetImpl()->IsCameraConnected(); 
 }
 
 bool ARealSenseSessionManager::IsCameraRunning() const
 {
-	return impl->IsCameraThreadRunning();
+	return (impl && impl->IsCameraThreadRunning()) || (streamClient && streamClient->IsConnected());
+}
+
+IRealSenseFrameSource* ARealSenseSessionManager::GetFrameSource() const
+{
+	if (streamClient && streamClient->IsConnected()) {
+		return streamClient.get();
+	}
+	return GetImpl();
+}
+
+uint64 ARealSenseSessionManager::GetFrameNumber() const
+{
+	return GetFrameSource()->GetFrameNumber();
+}
+
+double ARealSenseSessionManager::GetFrameTimestamp() const
+{
+	return GetFrameSource()->GetFrameTimestamp();
+}
+
+void ARealSenseSessionManager::SetCameraThreadOptions(ERealSenseThreadPriority Priority, int64 AffinityMask)
+{
+	GetImpl()->SetCameraThreadOptions(Priority, (uint64)AffinityMask);
 }
 
 void ARealSenseSessionManager::StartCamera() 
 { 
-	impl->StartCamera(); 
+	GetImpl()->StartCamera(); 
 }
 
 void ARealSenseSessionManager::StopCamera() 
 { 
-	impl->StopCamera(); 
+	if (impl) {
+		impl->StopCamera();
+	}
 }
 
 int32 ARealSenseSessionManager::GetColorImageWidth() const
 { 
-	return impl->GetColorImageWidth(); 
+	return GetImpl()->GetColorImageWidth(); 
 }
 
 int32 ARealSenseSessionManager::GetColorImageHeight() const
 { 
-	return impl->GetColorImageHeight(); 
+	return GetImpl()->GetColorImageHeight(); 
 }
 
 int32 ARealSenseSessionManager::GetDepthImageWidth() const
 { 
-	return impl->GetDepthImageWidth(); 
+	return GetImpl()->GetDepthImageWidth(); 
 }
 
 int32 ARealSenseSessionManager::GetDepthImageHeight() const
 { 
-	return impl->GetDepthImageHeight(); 
+	return GetImpl()->GetDepthImageHeight(); 
 }
 
 int32 ARealSenseSessionManager::GetScan3DImageWidth() const
 { 
-	return impl->GetScan3DImageWidth(); 
+	return GetImpl()->GetScan3DImageWidth(); 
 }
 
 int32 ARealSenseSessionManager::GetScan3DImageHeight() const
 { 
-	return impl->GetScan3DImageHeight(); 
+	return GetImpl()->GetScan3DImageHeight(); 
 }
 
 float ARealSenseSessionManager::GetColorHorizontalFOV() const
 {	
-	return impl->GetColorHorizontalFOV(); 
+	return GetImpl()->GetColorHorizontalFOV(); 
 }
 
 float ARealSenseSessionManager::GetColorVerticalFOV() const
 { 
-	return impl->GetColorVerticalFOV(); 
+	return GetImpl()->GetColorVerticalFOV(); 
 }
 
 float ARealSenseSessionManager::GetDepthHorizontalFOV() const
 {	
-	return impl->GetDepthHorizontalFOV(); 
+	return GetImpl()->GetDepthHorizontalFOV(); 
 }
 
 float ARealSenseSessionManager::GetDepthVerticalFOV() const
 { 
-	return impl->GetDepthVerticalFOV(); 
+	return GetImpl()->GetDepthVerticalFOV(); 
 }
 
 ECameraModel ARealSenseSessionManager::GetCameraModel() const 
 { 
-	return impl->GetCameraModel(); 
+	return GetImpl()->GetCameraModel(); 
 }
 
 FString ARealSenseSessionManager::GetCameraFirmware() const
 { 
-	return impl->GetCameraFirmware(); 
+	return GetImpl()->GetCameraFirmware(); 
 }
 
-// Sets the color camera resolution and resizes the ColorBuffer to match
+// Sets the color camera resolution and resizes the ColorBuffer to match.
+// The ColorBuffer reserves room for the largest color resolution, so changing
+// the resolution again later does not reallocate it.
 void ARealSenseSessionManager::SetColorCameraResolution(EColorResolution resolution)
 {
-	impl->SetColorCameraResolution(resolution);
-	ColorBuffer.SetNumUninitialized(impl->GetColorImageWidth() * impl->GetColorImageHeight());
+	GetImpl()->SetColorCameraResolution(resolution);
+	ColorBuffer.Reserve(GetMaxColorImagePixels());
+	ColorBuffer.SetNumUninitialized(GetImpl()->GetColorImageWidth() * GetImpl()->GetColorImageHeight());
 }
 
+// Sets the depth camera resolution and resizes the DepthBuffer to match.
+// The DepthBuffer reserves room for the largest depth resolution, so changing
+// the resolution again later does not reallocate it.
 void ARealSenseSessionManager::SetDepthCameraResolution(EDepthResolution resolution) 
 { 
-	impl->SetDepthCameraResolution(resolution); 
+	GetImpl()->SetDepthCameraResolution(resolution); 
+	DepthBuffer.Reserve(GetMaxDepthImagePixels());
+	DepthBuffer.SetNumUninitialized(GetImpl()->GetDepthImageWidth() * GetImpl()->GetDepthImageHeight());
 }
 
 FStreamResolution ARealSenseSessionManager::GetColorCameraResolution() const
 {
-	return impl->GetColorCameraResolution();
+	return GetImpl()->GetColorCameraResolution();
 }
 
 FStreamResolution ARealSenseSessionManager::GetDepthCameraResolution() const
 {
-	return impl->GetDepthCameraResolution();
+	return GetImpl()->GetDepthCameraResolution();
 }
 
 bool ARealSenseSessionManager::IsStreamSetValid(EColorResolution ColorResolution, EDepthResolution DepthResolution) const
 {
-	return impl->IsStreamSetValid(ColorResolution, DepthResolution);
+	return GetImpl()->IsStreamSetValid(ColorResolution, DepthResolution);
 }
 
-TArray<FSimpleColor> ARealSenseSessionManager::GetColorBuffer() const
+const TArray<FSimpleColor>& ARealSenseSessionManager::GetColorBuffer() const
 { 
 	return ColorBuffer; 
 }
 
-TArray<int32> ARealSenseSessionManager::GetDepthBuffer() const
+const TArray<int32>& ARealSenseSessionManager::GetDepthBuffer() const
 { 
 	return DepthBuffer; 
 }
 
-TArray<FSimpleColor> ARealSenseSessionManager::GetScanBuffer() const 
+int32 ARealSenseSessionManager::GetDepthAt(int32 X, int32 Y) const
+{
+	if (IsCameraRunning() == false) {
+		return 0;
+	}
+
+	const IRealSenseFrameSource* source = GetFrameSource();
+	const int32 Width = source->GetDepthImageWidth();
+	const int32 Height = source->GetDepthImageHeight();
+	if ((X < 0) || (Y < 0) || (X >= Width) || (Y >= Height)) {
+		return 0;
+	}
+	return source->GetDepthBuffer()[Y * Width + X];
+}
+
+// Uses the summed-area tables for the mean when the frame source provides 
+// them. Otherwise the valid depth values of the rectangle are scanned, and
+// for the median gathered into a scratch buffer and partially sorted.
+float ARealSenseSessionManager::GetDepthInRect(int32 X, int32 Y, int32 Width, int32 Height, 
+											  EDepthRegionStatistic Statistic) const
+{
+	if (IsCameraRunning() == false) {
+		return 0.0f;
+	}
+
+	const IRealSenseFrameSource* source = GetFrameSource();
+	const int32 ImageWidth = source->GetDepthImageWidth();
+	const int32 ImageHeight = source->GetDepthImageHeight();
+
+	const int32 MinX = FMath::Clamp(X, 0, ImageWidth);
+	const int32 MinY = FMath::Clamp(Y, 0, ImageHeight);
+	const int32 MaxX = FMath::Clamp(X + Width, 0, ImageWidth);
+	const int32 MaxY = FMath::Clamp(Y + Height, 0, ImageHeight);
+	if ((MinX >= MaxX) || (MinY >= MaxY)) {
+		return 0.0f;
+	}
+
+	const uint64* Sums = source->GetDepthSumTable();
+	const uint32* Counts = source->GetDepthCountTable();
+	if ((Statistic == EDepthRegionStatistic::MEAN) && Sums && Counts) {
+		const int32 Stride = ImageWidth + 1;
+		const uint64 Sum = Sums[MaxY * Stride + MaxX] - Sums[MinY * Stride + MaxX] 
+						 - Sums[MaxY * Stride + MinX] + Sums[MinY * Stride + MinX];
+		const uint32 Count = Counts[MaxY * Stride + MaxX] - Counts[MinY * Stride + MaxX] 
+						   - Counts[MaxY * Stride + MinX] + Counts[MinY * Stride + MinX];
+		return (Count > 0) ? (float)((double)Sum / Count) : 0.0f;
+	}
+
+	const uint16* Depth = source->GetDepthBuffer();
+	uint16 Nearest = 0xFFFF;
+	uint64 Sum = 0;
+	DepthQueryScratch.Reset();
+
+	for (int32 Row = MinY; Row < MaxY; Row++) {
+		const uint16* RowDepth = Depth + Row * ImageWidth;
+		for (int32 Col = MinX; Col < MaxX; Col++) {
+			const uint16 Value = RowDepth[Col];
+			if (Value == 0) {
+				continue;
+			}
+			Nearest = FMath::Min(Nearest, Value);
+			Sum += Value;
+			DepthQueryScratch.Add(Value);
+		}
+	}
+
+	const int32 Count = DepthQueryScratch.Num();
+	if (Count == 0) {
+		return 0.0f;
+	}
+
+	switch (Statistic) {
+	case EDepthRegionStatistic::MIN:
+		return Nearest;
+	case EDepthRegionStatistic::MEDIAN: {
+		uint16* Begin = DepthQueryScratch.GetData();
+		std::nth_element(Begin, Begin + Count / 2, Begin + Count);
+		return Begin[Count / 2];
+	}
+	default:
+		return (float)((double)Sum / Count);
+	}
+}
+
+void ARealSenseSessionManager::GetDepthAtPoints(const TArray<FIntPoint>& Points, TArray<int32>& OutDepths) const
+{
+	OutDepths.SetNumZeroed(Points.Num());
+	if (IsCameraRunning() == false) {
+		return;
+	}
+
+	const IRealSenseFrameSource* source = GetFrameSource();
+	const int32 Width = source->GetDepthImageWidth();
+	const int32 Height = source->GetDepthImageHeight();
+	const uint16* Depth = source->GetDepthBuffer();
+
+	for (int32 i = 0; i < Points.Num(); i++) {
+		const FIntPoint& Point = Points[i];
+		if ((Point.X >= 0) && (Point.Y >= 0) && (Point.X < Width) && (Point.Y < Height)) {
+			OutDepths[i] = Depth[Point.Y * Width + Point.X];
+		}
+	}
+}
+
+bool ARealSenseSessionManager::UpdateDepthMesh(RealSenseDepthMesh& Mesh, TArray<FVector>& Vertices, TArray<FVector>& Normals, 
+											   TArray<FVector2D>& UV, TArray<int32>& Triangles) const
+{
+	if (IsCameraRunning() == false) {
+		return false;
+	}
+
+	const IRealSenseFrameSource* source = GetFrameSource();
+	return Mesh.Update(source->GetDepthBuffer(), source->GetDepthImageWidth(), source->GetDepthImageHeight(),
+					   GetDepthHorizontalFOV(), GetDepthVerticalFOV(), Vertices, Normals, UV, Triangles);
+}
+
+void ARealSenseSessionManager::EnableDepthSummedAreaTable(bool bEnable)
+{
+	GetImpl()->EnableDepthSummedAreaTable(bEnable);
+}
+
+std::shared_ptr<RealSenseFrameQueue> ARealSenseSessionManager::CreateFrameQueue(EFrameDeliveryPolicy Policy, int32 Capacity)
+{
+	std::shared_ptr<RealSenseFrameQueue> Queue = std::make_shared<RealSenseFrameQueue>(Policy, Capacity);
+	frameQueues.Add(Queue);
+	GetImpl()->AddFramePublisher(Queue.get());
+	return Queue;
+}
+
+// Closes the queue first, since a lossless queue may be blocking the camera
+// processing thread inside Publish() while it holds the publisher list.
+void ARealSenseSessionManager::DestroyFrameQueue(const std::shared_ptr<RealSenseFrameQueue>& Queue)
+{
+	if (Queue == nullptr) {
+		return;
+	}
+
+	std::shared_ptr<RealSenseFrameQueue> Removed = Queue;
+	Removed->Close();
+	GetImpl()->RemoveFramePublisher(Removed.get());
+	frameQueues.Remove(Removed);
+}
+
+TArray<FFrameDeliveryStats> ARealSenseSessionManager::GetFrameQueueStats() const
+{
+	TArray<FFrameDeliveryStats> Stats;
+	for (const std::shared_ptr<RealSenseFrameQueue>& Queue : frameQueues) {
+		Stats.Add(Queue->GetStats());
+	}
+	return Stats;
+}
+
+// Creates the stream server and registers it with the local camera, which 
+// hands it every processed frame from the camera processing thread.
+bool ARealSenseSessionManager::StartStreamServer(int32 Port, int32 JpegQuality)
+{
+	StopStreamServer();
+
+	streamServer = std::make_shared<RealSenseStreamServer>();
+	if (streamServer->Start(Port, JpegQuality) == false) {
+		streamServer.reset();
+		return false;
+	}
+	GetImpl()->AddFramePublisher(streamServer.get());
+	return true;
+}
+
+void ARealSenseSessionManager::StopStreamServer()
+{
+	if (streamServer) {
+		GetImpl()->RemoveFramePublisher(streamServer.get());
+		streamServer.reset();
+	}
+}
+
+bool ARealSenseSessionManager::ConnectToStreamServer(const FString& Host, int32 Port)
+{
+	streamClient = std::make_shared<RealSenseStreamClient>();
+	if (streamClient->Connect(Host, Port) == false) {
+		streamClient.reset();
+		return false;
+	}
+	return true;
+}
+
+void ARealSenseSessionManager::DisconnectFromStreamServer()
+{
+	streamClient.reset();
+}
+
+FRealSenseStreamStats ARealSenseSessionManager::GetStreamStats() const
+{
+	if (streamClient) {
+		return streamClient->GetStats();
+	}
+	if (streamServer) {
+		return streamServer->GetStats();
+	}
+	return FRealSenseStreamStats();
+}
+
+bool ARealSenseSessionManager::StartSharedMemoryPublisher(const FString& Name)
+{
+	StopSharedMemoryPublisher();
+
+	sharedMemoryPublisher = std::make_shared<RealSenseSharedMemoryPublisher>();
+	if (sharedMemoryPublisher->Create(Name) == false) {
+		sharedMemoryPublisher.reset();
+		return false;
+	}
+	GetImpl()->AddFramePublisher(sharedMemoryPublisher.get());
+	return true;
+}
+
+void ARealSenseSessionManager::StopSharedMemoryPublisher()
+{
+	if (sharedMemoryPublisher) {
+		GetImpl()->RemoveFramePublisher(sharedMemoryPublisher.get());
+		sharedMemoryPublisher.reset();
+	}
+}
+
+void ARealSenseSessionManager::StartFrameHistory(int32 MemoryBudgetMB, int32 Downsample)
+{
+	StopFrameHistory();
+
+	const int64 MemoryBudget = (int64)FMath::Clamp(MemoryBudgetMB, 1, RealSenseFrameHistory::MaxMemoryBudgetMB) << 20;
+	frameHistory = RealSenseFrameHistory::Create(MemoryBudget, Downsample);
+	GetImpl()->AddFramePublisher(frameHistory.get());
+}
+
+void ARealSenseSessionManager::StopFrameHistory()
+{
+	if (frameHistory) {
+		GetImpl()->RemoveFramePublisher(frameHistory.get());
+
+		// Views still reading the history keep it alive until released
+		frameHistory.reset();
+	}
+}
+
+// Finds the frame nearest to the given time before the latest frame. 
+static bool FindHistoryFrame(RealSenseFrameHistory* History, float SecondsAgo, RealSenseFrameView& View)
+{
+	if ((History == nullptr) || (History->FindFrameAgo(0, View) == false)) {
+		return false;
+	}
+	const double Time = View.GetTimestamp() - FMath::Max(SecondsAgo, 0.0f);
+	return History->FindFrameAtTime(Time, View);
+}
+
+bool ARealSenseSessionManager::GetHistoryDepthFrame(float SecondsAgo, TArray<int32>& Depth, int32& Width, int32& Height) const
+{
+	RealSenseFrameView View;
+	if ((FindHistoryFrame(frameHistory.get(), SecondsAgo, View) == false) || (View.GetDepthBuffer() == nullptr)) {
+		return false;
+	}
+
+	Width = View.GetDepthWidth();
+	Height = View.GetDepthHeight();
+	const int32 DepthImageSize = Width * Height;
+	Depth.SetNumUninitialized(DepthImageSize);
+	const uint16* Source = View.GetDepthBuffer();
+	int32* Out = Depth.GetData();
+	for (int32 i = 0; i < DepthImageSize; i++) {
+		Out[i] = Source[i];
+	}
+	return true;
+}
+
+bool ARealSenseSessionManager::GetHistoryColorFrame(float SecondsAgo, TArray<FSimpleColor>& Color, int32& Width, int32& Height) const
+{
+	RealSenseFrameView View;
+	if ((FindHistoryFrame(frameHistory.get(), SecondsAgo, View) == false) || 
+		(View.GetColorBuffer() == nullptr) || (View.GetColorChannels() != sizeof(FSimpleColor))) {
+		return false;
+	}
+
+	Width = View.GetColorWidth();
+	Height = View.GetColorHeight();
+	Color.SetNumUninitialized(Width * Height);
+	FMemory::Memcpy(Color.GetData(), View.GetColorBuffer(), Width * Height * sizeof(FSimpleColor));
+	return true;
+}
+
+void ARealSenseSessionManager::SetSegmentationOutput(ESegmentationOutput Output)
+{
+	GetImpl()->SetSegmentationOutput(Output);
+}
+
+void ARealSenseSessionManager::SetSegmentationCleanup(int32 OpenRadius, int32 CloseRadius, int32 FeatherWidth)
+{
+	GetImpl()->SetSegmentationCleanup(OpenRadius, CloseRadius, FeatherWidth);
+}
+
+const TArray<uint8>& ARealSenseSessionManager::GetSegmentationMask() const
+{
+	return SegmentationMask;
+}
+
+const TArray<int32>& ARealSenseSessionManager::GetSegmentationRuns() const
+{
+	return SegmentationRuns;
+}
+
+FDepthStatistics ARealSenseSessionManager::GetDepthStatistics() const
+{
+	return GetImpl()->GetDepthStatistics();
+}
+
+const TArray<FSimpleColor>& ARealSenseSessionManager::GetScanBuffer() const 
 { 
 	return ScanBuffer; 
 }
 
 void ARealSenseSessionManager::ConfigureScanning(EScan3DMode ScanningMode, bool bSolidify, bool bTexture)
 {
-	impl->ConfigureScanning(ScanningMode, bSolidify, bTexture);
+	GetImpl()->ConfigureScanning(ScanningMode, bSolidify, bTexture);
 }
 
 void ARealSenseSessionManager::StartScanning()
 {
-	impl->StartScanning();
+	GetImpl()->StartScanning();
 }
 
 void ARealSenseSessionManager::StopScanning()
 {
-	impl->StopScanning();
+	GetImpl()->StopScanning();
 }
 
 void ARealSenseSessionManager::SaveScan(EScan3DFileFormat SaveFileFormat, FString Filename)
 {
-	impl->SaveScan(SaveFileFormat, Filename);
+	GetImpl()->SaveScan(SaveFileFormat, Filename);
 }
 
 void ARealSenseSessionManager::SetScanningVolume(FVector BoundingBox, int32 Resolution)
 {
-	impl->SetScanningVolume(BoundingBox, Resolution);
+	GetImpl()->SetScanningVolume(BoundingBox, Resolution);
+}
+
+void ARealSenseSessionManager::SetScan3DBackend(EScan3DBackend Backend)
+{
+	GetImpl()->SetScan3DBackend(Backend);
+}
+
+void ARealSenseSessionManager::ConfigureFusion(float VoxelSize, float TruncationDistance, float MaxDepth)
+{
+	RealSenseFusionSettings Settings;
+	Settings.voxelSize = VoxelSize;
+	Settings.truncation = TruncationDistance;
+	Settings.maxDepth = MaxDepth;
+	GetImpl()->ConfigureFusion(Settings);
+}
+
+void ARealSenseSessionManager::SetFusionCameraPose(const FTransform& CameraToWorld)
+{
+	GetImpl()->SetFusionCameraPose(CameraToWorld.ToMatrixNoScale());
+}
+
+void ARealSenseSessionManager::ResetFusion()
+{
+	GetImpl()->ResetFusion();
+}
+
+void ARealSenseSessionManager::ExtractFusionMesh(TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FColor>& Colors)
+{
+	GetImpl()->ExtractFusionMesh(Vertices, Triangles, Colors);
 }
 
 bool ARealSenseSessionManager::IsScanning() const
 {
-	return impl->IsScanning();
+	return GetImpl()->IsScanning();
 }
 
 bool ARealSenseSessionManager::HasScan3DImageSizeChanged() const
 {
-	return impl->HasScan3DImageSizeChanged();
+	return GetImpl()->HasScan3DImageSizeChanged();
 }
 
 bool ARealSenseSessionManager::HasScanCompleted() const
 {
-	return impl->HasScanCompleted();
+	return GetImpl()->HasScanCompleted();
 }
 
 int ARealSenseSessionManager::GetHeadCount() const
 {
-	return impl->GetHeadCount();
+	return GetImpl()->GetHeadCount();
 }
 
 FVector ARealSenseSessionManager::GetHeadPosition() const
 {
-	return impl->GetHeadPosition();
+	return GetImpl()->GetHeadPosition();
 }
 
 FRotator ARealSenseSessionManager::GetHeadRotation() const
 {
-	return impl->GetHeadRotation();
-}
\ No newline at end of file
+	return GetImpl()->GetHeadRotation();
+}
+
+void ARealSenseSessionManager::ConfigureOccupancyGrid(const FBox& Bounds, float VoxelSize, int32 PixelStep)
+{
+	RealSenseOccupancySettings Settings;
+	Settings.boundsMin = Bounds.Min;
+	Settings.boundsMax = Bounds.Max;
+	Settings.voxelSize = VoxelSize;
+	Settings.pixelStep = PixelStep;
+	GetImpl()->ConfigureOccupancyGrid(Settings);
+}
+
+void ARealSenseSessionManager::SetOccupancyCameraPose(const FTransform& CameraToWorld)
+{
+	GetImpl()->SetOccupancyCameraPose(CameraToWorld.ToMatrixNoScale());
+}
+
+void ARealSenseSessionManager::CopyOccupancyGrid(RealSenseOccupancyGrid& Grid, TArray<int32>& ChangedBricks) const
+{
+	GetImpl()->CopyOccupancyGrid(Grid, ChangedBricks);
+}
+
+void ARealSenseSessionManager::ConfigureBlobTracking(int32 MinDepth, int32 MaxDepth, int32 MinArea, int32 MaxBlobs, 
+													 float MaxMatchDistance)
+{
+	RealSenseBlobSettings Settings;
+	Settings.minDepth = MinDepth;
+	Settings.maxDepth = MaxDepth;
+	Settings.minArea = MinArea;
+	Settings.maxBlobs = MaxBlobs;
+	Settings.maxMatchDistance = MaxMatchDistance;
+	GetImpl()->ConfigureBlobTracking(Settings);
+}
+
+const TArray<FDepthBlob>& ARealSenseSessionManager::GetBlobs() const
+{
+	return GetImpl()->GetBlobs();
+}
+
+void ARealSenseSessionManager::ConfigurePlaneDetection(int32 MaxPlanes, float InlierDistance, float MaxNormalAngle, 
+													   int32 PixelStep)
+{
+	RealSensePlaneSettings Settings;
+	Settings.maxPlanes = MaxPlanes;
+	Settings.inlierDistance = InlierDistance;
+	Settings.maxNormalAngle = MaxNormalAngle;
+	Settings.pixelStep = PixelStep;
+	GetImpl()->ConfigurePlaneDetection(Settings);
+}
+
+const TArray<FDepthPlane>& ARealSenseSessionManager::GetPlanes() const
+{
+	return GetImpl()->GetPlanes();
+}
+
+const TArray<uint8>& ARealSenseSessionManager::GetPlaneMask() const
+{
+	return GetImpl()->GetPlaneMask();
+}
+
+uint64 ARealSenseSessionManager::GetPlaneRevision() const
+{
+	return GetImpl()->GetPlaneRevision();
+}
+
+void ARealSenseSessionManager::ConfigureDepthBackground(int32 LearningFrames, int32 AdaptationStep, int32 AbsorbInterval, 
+														int32 MinBand, int32 BandScale, int32 OpenRadius, 
+														int32 UnobservedFrames)
+{
+	RealSenseBackgroundSettings Settings;
+	Settings.learningFrames = LearningFrames;
+	Settings.adaptationStep = AdaptationStep;
+	Settings.absorbInterval = AbsorbInterval;
+	Settings.minBand = MinBand;
+	Settings.bandScale = BandScale;
+	Settings.openRadius = OpenRadius;
+	Settings.unobservedFrames = UnobservedFrames;
+	GetImpl()->ConfigureDepthBackground(Settings);
+}
+
+void ARealSenseSessionManager::LearnDepthBackground()
+{
+	GetImpl()->LearnDepthBackground();
+}
+
+const TArray<uint8>& ARealSenseSessionManager::GetForegroundMask() const
+{
+	return GetImpl()->GetForegroundMask();
+}
+
+bool ARealSenseSessionManager::IsLearningDepthBackground() const
+{
+	return GetImpl()->IsLearningDepthBackground();
+}
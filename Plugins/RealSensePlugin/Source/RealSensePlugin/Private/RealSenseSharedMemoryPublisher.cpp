@@ -0,0 +1,162 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RealSensePluginPrivatePCH.h"
+#include "RealSenseSharedMemoryPublisher.h"
+#include "RealSenseImpl.h"
+
+using namespace RealSenseSharedMemory;
+
+RealSenseSharedMemoryPublisher::RealSenseSharedMemoryPublisher()
+{
+	region = nullptr;
+	header = nullptr;
+	base = nullptr;
+	nextSlot = 0;
+	sequence = 0;
+	framesPublished = 0;
+	framesDropped = 0;
+}
+
+RealSenseSharedMemoryPublisher::~RealSenseSharedMemoryPublisher()
+{
+	Destroy();
+}
+
+// Maps the region and writes the header describing its layout. All slots 
+// start out empty with an even sequence number and no readers.
+bool RealSenseSharedMemoryPublisher::Create(const FString& name)
+{
+	Destroy();
+
+	const uint32 maxColorBytes = GetMaxColorImagePixels() * 4;
+	const uint32 maxDepthBytes = GetMaxDepthImagePixels() * sizeof(uint16);
+	const uint32 regionSize = GetRegionSize(maxColorBytes, maxDepthBytes);
+
+	region = FPlatformMemory::MapNamedSharedMemoryRegion(name, true, 
+		(uint32)FPlatformMemory::ESharedMemoryAccess::Read | (uint32)FPlatformMemory::ESharedMemoryAccess::Write, regionSize);
+	if (region == nullptr) {
+		RS_LOG(Error, "Unable to create shared memory region '%s'", *name)
+		return false;
+	}
+
+	base = static_cast<uint8*>(region->GetAddress());
+	FMemory::Memzero(base, regionSize);
+
+	header = reinterpret_cast<RealSenseSharedHeader*>(base);
+	header->magic = Magic;
+	header->version = Version;
+	header->numSlots = NumSlots;
+	header->colorOffset = AlignSize(sizeof(RealSenseSharedSlot));
+	header->depthOffset = header->colorOffset + AlignSize(maxColorBytes);
+	header->slotSize = header->depthOffset + AlignSize(maxDepthBytes);
+	header->maxColorBytes = maxColorBytes;
+	header->maxDepthBytes = maxDepthBytes;
+	header->latestSequence = 0;
+	header->latestSlot = 0;
+	header->writerAlive = 1;
+
+	nextSlot = 1;
+	sequence = 0;
+
+	RS_LOG(Log, "Publishing frames to shared memory region '%s' (%u bytes)", *name, regionSize)
+	return true;
+}
+
+void RealSenseSharedMemoryPublisher::Destroy()
+{
+	if (region) {
+		header->writerAlive = 0;
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(region);
+		region = nullptr;
+		header = nullptr;
+		base = nullptr;
+	}
+}
+
+RealSenseSharedSlot* RealSenseSharedMemoryPublisher::GetSlot(uint32 index) const
+{
+	return reinterpret_cast<RealSenseSharedSlot*>(base + GetSlotOffset(*header, index));
+}
+
+// Tries the slots in round-robin order, skipping the latest one. A slot is 
+// claimed by making its sequence number odd; if a reader pinned it in the 
+// meantime, the claim is undone and the next slot is tried.
+int32 RealSenseSharedMemoryPublisher::AcquireWriteSlot()
+{
+	const uint32 latest = header->latestSlot;
+
+	for (uint32 i = 0; i < NumSlots; i++) {
+		const uint32 index = (nextSlot + i) % NumSlots;
+		if ((index == latest) && (header->latestSequence != 0)) {
+			continue;
+		}
+
+		RealSenseSharedSlot* slot = GetSlot(index);
+		if (slot->readers != 0) {
+			continue;
+		}
+
+		const uint64 previous = slot->sequence;
+		slot->sequence = previous + 1;
+		if (slot->readers != 0) {
+			slot->sequence = previous;
+			continue;
+		}
+
+		nextSlot = (index + 1) % NumSlots;
+		return index;
+	}
+	return -1;
+}
+
+void RealSenseSharedMemoryPublisher::Publish(const RealSenseDataFrame& frame)
+{
+	if (header == nullptr) {
+		return;
+	}
+
+	const int32 colorBytes = frame.colorImage.Num();
+	const int32 depthBytes = frame.depthImage.Num() * sizeof(uint16);
+	if ((colorBytes > (int32)header->maxColorBytes) || (depthBytes > (int32)header->maxDepthBytes)) {
+		framesDropped++;
+		return;
+	}
+
+	const int32 index = AcquireWriteSlot();
+	if (index < 0) {
+		framesDropped++;
+		return;
+	}
+
+	RealSenseSharedSlot* slot = GetSlot(index);
+	uint8* data = reinterpret_cast<uint8*>(slot);
+
+	slot->frameNumber = frame.number;
+	slot->timestamp = frame.timestamp;
+	slot->colorWidth = frame.colorImage.GetWidth();
+	slot->colorHeight = frame.colorImage.GetHeight();
+	slot->depthWidth = frame.depthImage.GetWidth();
+	slot->depthHeight = frame.depthImage.GetHeight();
+	FMemory::Memcpy(data + header->colorOffset, frame.colorImage.GetData(), colorBytes);
+	FMemory::Memcpy(data + header->depthOffset, frame.depthImage.GetData(), depthBytes);
+
+	// Completes the slot, then publishes it as the latest frame
+	slot->sequence = slot->sequence + 1;
+	header->latestSlot = index;
+	header->latestSequence = ++sequence;
+
+	framesPublished++;
+}
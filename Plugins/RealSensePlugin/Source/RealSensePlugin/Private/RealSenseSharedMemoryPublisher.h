@@ -0,0 +1,66 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "AllowWindowsPlatformTypes.h"
+#include <atomic>
+#include "HideWindowsPlatformTypes.h"
+
+#include "RealSenseFrameSource.h"
+#include "RealSenseSharedMemory.h"
+
+// Publishes every frame processed by the camera thread into a named 
+// shared-memory ring, so that other processes can read the camera without 
+// opening it themselves. See RealSenseSharedMemory.h for the layout and 
+// RealSenseSharedMemoryReader.h for the reading side.
+class RealSenseSharedMemoryPublisher : public IRealSenseFramePublisher {
+public:
+	RealSenseSharedMemoryPublisher();
+
+	~RealSenseSharedMemoryPublisher();
+
+	// Creates the named region, sized for the largest supported color and 
+	// depth resolutions. Returns false if the region could not be created.
+	bool Create(const FString& name);
+
+	void Destroy();
+
+	// Copies the color and depth images into a free slot and makes it the 
+	// latest one. If every other slot is pinned by readers, the frame is 
+	// dropped.
+	void Publish(const RealSenseDataFrame& frame) override;
+
+	inline uint64 GetFramesPublished() const { return framesPublished; }
+
+	inline uint64 GetFramesDropped() const { return framesDropped; }
+
+private:
+	RealSenseSharedMemory::RealSenseSharedSlot* GetSlot(uint32 index) const;
+
+	// Returns the index of a slot that is not the latest one and has no 
+	// readers, marked as being written, or -1 if there is none.
+	int32 AcquireWriteSlot();
+
+	FPlatformMemory::FSharedMemoryRegion* region;
+	RealSenseSharedMemory::RealSenseSharedHeader* header;
+	uint8* base;
+
+	uint32 nextSlot;
+	uint64 sequence;
+
+	std::atomic<uint64> framesPublished;
+	std::atomic<uint64> framesDropped;
+};
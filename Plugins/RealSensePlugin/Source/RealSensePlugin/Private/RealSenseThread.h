@@ -0,0 +1,84 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "AllowWindowsPlatformTypes.h"
+#include <functional>
+#include "HideWindowsPlatformTypes.h"
+
+#include "CoreMisc.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+
+// Runs a function on an engine thread, so that the thread shows up by name in
+// the profiler and can be given a priority and a set of cores. The function 
+// is expected to return on its own once its owner asks it to stop; 
+// WaitForCompletion() only waits for that to happen.
+class RealSenseThread : public FRunnable {
+public:
+	RealSenseThread(std::function<void()> body, const TCHAR* name, EThreadPriority priority, uint64 affinityMask)
+		: body(body)
+	{
+		thread = FRunnableThread::Create(this, name, 0, priority, affinityMask);
+	}
+
+	~RealSenseThread()
+	{
+		WaitForCompletion();
+	}
+
+	// Returns false if the thread could not be created.
+	inline bool IsValid() const { return (thread != nullptr); }
+
+	void WaitForCompletion()
+	{
+		if (thread) {
+			thread->WaitForCompletion();
+			delete thread;
+			thread = nullptr;
+		}
+	}
+
+	uint32 Run() override
+	{
+		body();
+		return 0;
+	}
+
+private:
+	std::function<void()> body;
+	FRunnableThread* thread;
+
+	RealSenseThread(const RealSenseThread&) = delete;
+	RealSenseThread& operator=(const RealSenseThread&) = delete;
+};
+
+// Converts the Blueprint thread priority to the engine's.
+inline EThreadPriority GetEThreadPriority(ERealSenseThreadPriority priority)
+{
+	switch (priority) {
+	case ERealSenseThreadPriority::LOWEST:
+		return TPri_Lowest;
+	case ERealSenseThreadPriority::BELOW_NORMAL:
+		return TPri_BelowNormal;
+	case ERealSenseThreadPriority::ABOVE_NORMAL:
+		return TPri_AboveNormal;
+	case ERealSenseThreadPriority::HIGHEST:
+		return TPri_Highest;
+	default:
+		return TPri_Normal;
+	}
+}
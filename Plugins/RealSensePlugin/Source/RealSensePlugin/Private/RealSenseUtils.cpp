@@ -15,6 +15,8 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 #include "RealSensePluginPrivatePCH.h"
 #include "RealSenseUtils.h"
+#include "RealSenseImageKernels.h"
+#include "RealSenseMeshIO.h"
 
 DEFINE_LOG_CATEGORY(RealSensePlugin);
 
@@ -47,6 +49,42 @@ uint8 ConvertDepthValueTo8Bit(int32 depth, int32 width)
 	return (255 * ((max_depth - depth) / max_depth));
 }
 
+bool IsSupportedCameraModel(PXCCapture::DeviceModel model)
+{
+	return ((model == PXCCapture::DeviceModel::DEVICE_MODEL_F200) ||
+			(model == PXCCapture::DeviceModel::DEVICE_MODEL_R200) ||
+			(model == PXCCapture::DeviceModel::DEVICE_MODEL_R200_ENHANCED) ||
+			(model == PXCCapture::DeviceModel::DEVICE_MODEL_SR300));
+}
+
+ECameraModel GetECameraModel(PXCCapture::DeviceModel model)
+{
+	switch (model) {
+	case PXCCapture::DeviceModel::DEVICE_MODEL_F200:
+		return ECameraModel::F200;
+	case PXCCapture::DeviceModel::DEVICE_MODEL_R200:
+	case PXCCapture::DeviceModel::DEVICE_MODEL_R200_ENHANCED:
+		return ECameraModel::R200;
+	case PXCCapture::DeviceModel::DEVICE_MODEL_SR300:
+		return ECameraModel::SR300;
+	default:
+		return ECameraModel::Other;
+	}
+}
+
+FRealSenseDeviceInfo GetRealSenseDeviceInfo(const PXCCapture::DeviceInfo& info)
+{
+	FRealSenseDeviceInfo result;
+	result.SerialNumber = FString(info.serial);
+	result.Name = FString(info.name);
+	result.CameraModel = GetECameraModel(info.model);
+	result.Firmware = FString::Printf(TEXT("%d.%d.%d.%d"), info.firmware[0], 
+														  info.firmware[1], 
+														  info.firmware[2], 
+														  info.firmware[3]);
+	return result;
+}
+
 PXCImage::PixelFormat GetPXCPixelFormat(ERealSensePixelFormat format)
 {
 	switch (format) {
@@ -76,6 +114,10 @@ PXC3DScan::FileFormat GetPXCScanFileFormat(EScan3DFileFormat format)
 	switch (format) {
 	case EScan3DFileFormat::OBJ:
 		return PXC3DScan::FileFormat::OBJ;
+	case EScan3DFileFormat::PLY:
+		return PXC3DScan::FileFormat::PLY;
+	case EScan3DFileFormat::STL:
+		return PXC3DScan::FileFormat::STL;
 	default:
 		return PXC3DScan::FileFormat::OBJ;
 	}
@@ -137,9 +179,29 @@ FStreamResolution GetEDepthResolutionValue(EDepthResolution res)
 	}
 }
 
+int32 GetMaxColorImagePixels()
+{
+	int32 maxPixels = 0;
+	for (uint8 i = (uint8)EColorResolution::RES1; i <= (uint8)EColorResolution::RES6; i++) {
+		FStreamResolution res = GetEColorResolutionValue((EColorResolution)i);
+		maxPixels = FMath::Max(maxPixels, res.width * res.height);
+	}
+	return maxPixels;
+}
+
+int32 GetMaxDepthImagePixels()
+{
+	int32 maxPixels = 0;
+	for (uint8 i = (uint8)EDepthResolution::RES1; i <= (uint8)EDepthResolution::RES11; i++) {
+		FStreamResolution res = GetEDepthResolutionValue((EDepthResolution)i);
+		maxPixels = FMath::Max(maxPixels, res.width * res.height);
+	}
+	return maxPixels;
+}
+
 // Original function borrowed from RSSDK sp_glut_utils.h
 // Copies the data from the PXCImage into the input data buffer.
-void CopyColorImageToBuffer(PXCImage* image, TArray<uint8>& data, const uint32 width, const uint32 height)
+void CopyColorImageToBuffer(PXCImage* image, uint8* data, const uint32 width, const uint32 height)
 {
 	assert(image != nullptr);
 
@@ -167,7 +229,7 @@ void CopyColorImageToBuffer(PXCImage* image, TArray<uint8>& data, const uint32 w
 
 // Original function borrowed from RSSDK sp_glut_utils.h
 // Copies the data from the PXCImage into the input data buffer.
-void CopySegmentedImageToBuffer(PXCImage* image, TArray<uint8>& data, const uint32 width, const uint32 height)
+void CopySegmentedImageToBuffer(PXCImage* image, uint8* data, const uint32 width, const uint32 height)
 {
 	assert(image != nullptr);
 
@@ -194,9 +256,30 @@ void CopySegmentedImageToBuffer(PXCImage* image, TArray<uint8>& data, const uint
 	image->ReleaseAccess(&imageData);
 }
 
+// Extracts the alpha channel of each row straight from the SDK image, so the
+// full RGBA image is never copied.
+void CopySegmentedMaskToBuffer(PXCImage* image, uint8* mask, const uint32 width, const uint32 height)
+{
+	assert(image != nullptr);
+
+	PXCImage::ImageData imageData;
+	pxcStatus result = image->AcquireAccess(PXCImage::ACCESS_READ, PXCImage::PIXEL_FORMAT_RGB32, &imageData);
+	if (result != PXC_STATUS_NO_ERROR) {
+		return;
+	}
+
+	for (uint32 y = 0; y < height; ++y) {
+		const pxcBYTE* color = imageData.planes[0] + (imageData.pitches[0] * y);
+		ExtractAlphaMask(color, width, mask + (width * y));
+	}
+
+	image->ReleaseAccess(&imageData);
+}
+
 // Original function borrowed from RSSDK sp_glut_utils.h
 // Copies the data from the PXCImage into the input data buffer.
-void CopyDepthImageToBuffer(PXCImage* image, TArray<uint16>& data, const uint32 width, const uint32 height)
+void CopyDepthImageToBuffer(PXCImage* image, uint16* data, const uint32 width, const uint32 height, 
+							RealSenseDepthStatistics* stats)
 {
 	assert(image != nullptr);
 
@@ -208,24 +291,40 @@ void CopyDepthImageToBuffer(PXCImage* image, TArray<uint16>& data, const uint32
 
 	const uint32 numBytes = width * sizeof(uint16);
 
-	uint32 i = 0;
+	if (stats) {
+		stats->Reset();
+	}
+
 	for (uint32 y = 0; y < height; ++y) {
 		// depth points to one row of depth image data.
 		const pxcBYTE* depth = imageData.planes[0] + (imageData.pitches[0] * y);
-		for (uint32 x = 0; x < width; ++x, depth += 2) {
-			data[i++] = *depth;
+		uint16* row = data + (width * y);
+		FMemory::Memcpy(row, depth, numBytes);
+
+		// Accumulate statistics while the row is still in cache.
+		if (stats) {
+			AccumulateDepthStatistics(row, width, *stats);
 		}
 	}
 
 	image->ReleaseAccess(&imageData);
 }
 
-void LoadMeshFile(const FString& filename, TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FColor>& Colors)
+// Matches the scale the plugin has always loaded the middleware's OBJ 
+// files at.
+FVector ConvertMiddlewareVertex(const FVector& v)
+{
+	return ConvertRSVectorToUnreal(v) * 150;
+}
+
+// Reads the OBJ files written by the 3D Scanning middleware, whose vertices 
+// carry colors and are in camera space, in meters.
+static bool LoadMeshOBJ(const FString& filename, TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FColor>& Colors)
 {
 	// TODO: Check if Reserving Lines ahead of time is faster
 	TArray<FString> Lines;
 	if (FFileHelper::LoadANSITextFileToStrings(filename.GetCharArray().GetData(), NULL, Lines) == false)
-		return;
+		return false;
 
 	Vertices.Empty();
 	Triangles.Empty();
@@ -258,23 +357,48 @@ void LoadMeshFile(const FString& filename, TArray<FVector>& Vertices, TArray<int
 				r = FCString::Atof(*(Tokens[4]));
 				g = FCString::Atof(*(Tokens[5]));
 				b = FCString::Atof(*(Tokens[6]));
-				Vertices.Add(ConvertRSVectorToUnreal(FVector(x, y, z)) * 150);
+				Vertices.Add(ConvertMiddlewareVertex(FVector(x, y, z)));
 				Colors.Add(FColor((uint8)(r * 255), (uint8)(g * 255), (uint8)(b * 255)));
 			}
 		}
 		else if (Line[0] == 'f') {
 			Tokens.Empty();
-			Line.ParseIntoArrayWS(Tokens, L"//", true);
-			// Need to subtract 1 from the vertex indices because .OBJ files start indexing them at at 1, not 0
+			Line.ParseIntoArrayWS(Tokens);
+			// Need to subtract 1 from the vertex indices because .OBJ files start indexing them at at 1, not 0.
+			// Atoi stops at the first '/', so this reads both "f 1 2 3" and "f 1//1 2//2 3//3".
 			v1 = FCString::Atoi(*(Tokens[1]));
-			v2 = FCString::Atoi(*(Tokens[3]));
-			v3 = FCString::Atoi(*(Tokens[5]));
+			v2 = FCString::Atoi(*(Tokens[2]));
+			v3 = FCString::Atoi(*(Tokens[3]));
 			Triangles.Add(v1 - 1);
 			Triangles.Add(v2 - 1);
 			Triangles.Add(v3 - 1);
 		}
 	}
 
+	return true;
+}
+
+// Loads the mesh with the reader matching the file extension, then centers 
+// it on the origin.
+void LoadMeshFile(const FString& filename, TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FColor>& Colors)
+{
+	bool bLoaded = false;
+	switch (GetMeshFileFormat(filename)) {
+	case EScan3DFileFormat::PLY:
+		bLoaded = LoadMeshPLY(filename, Vertices, Triangles, Colors);
+		break;
+	case EScan3DFileFormat::STL:
+		bLoaded = LoadMeshSTL(filename, Vertices, Triangles, Colors);
+		break;
+	default:
+		bLoaded = LoadMeshOBJ(filename, Vertices, Triangles, Colors);
+		break;
+	}
+
+	if ((bLoaded == false) || (Vertices.Num() == 0)) {
+		return;
+	}
+
 	FVector MeshCenter = FVector(0.0f, 0.0f, 0.0f);
 	for (FVector Vert : Vertices) {
 		MeshCenter += Vert;
@@ -15,12 +15,22 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 #include "RealSensePluginPrivatePCH.h"
 #include "Scan3DComponent.h"
+#include "RealSenseUtils.h"
+#include "RealSenseMeshProcessing.h"
+#include "RealSenseMeshBVH.h"
 
 UScan3DComponent::UScan3DComponent(const class FObjectInitializer& ObjInit) 
 	: Super(ObjInit) 
 { 
 	bHasScanStarted = false;
 	m_feature = RealSenseFeature::SCAN_3D;
+
+	LODRatios.Add(0.5f);
+	LODRatios.Add(0.25f);
+	LODRatios.Add(0.1f);
+
+	meshBVH = std::make_shared<RealSenseMeshBVH>();
+	meshRequest = std::make_shared<MeshRequest>();
 }
 
 // Adds the SCAN_3D feature to the RealSenseSessionManager and initializes the 
@@ -32,11 +42,18 @@ void UScan3DComponent::InitializeComponent()
 	ScanTexture = UTexture2D::CreateTransient(1, 1,	EPixelFormat::PF_B8G8R8A8);
 }
 
-// Copies the ScanBuffer and checks if a current scan has just completed.
-// If it has, the OnScanComplete event is broadcast.
+// Publishes a finished mesh task, copies the ScanBuffer and checks if a 
+// current scan has just completed. If it has, the OnScanComplete event is 
+// broadcast. Meshes can be loaded without the camera, so they are checked first.
 void UScan3DComponent::TickComponent(float DeltaTime, enum ELevelTick TickType, 
 	                                 FActorComponentTickFunction *ThisTickFunction) 
 {
+	if (meshTask.valid() && (meshTask.wait_for(std::chrono::seconds(0)) == std::future_status::ready)) {
+		std::shared_ptr<ScanMesh> Mesh = meshTask.get();
+		PublishMesh(*Mesh);
+		OnMeshReady.Broadcast();
+	}
+
 	if (globalRealSenseSession->IsCameraRunning() == false) {
 		return;
 	}
@@ -47,9 +64,7 @@ void UScan3DComponent::TickComponent(float DeltaTime, enum ELevelTick TickType,
 	if (globalRealSenseSession->HasScan3DImageSizeChanged()) {
 		int Scan3DImageWidth = globalRealSenseSession->GetScan3DImageWidth();
 		int Scan3DImageHeight = globalRealSenseSession->GetScan3DImageHeight();
-		ScanTexture = UTexture2D::CreateTransient(Scan3DImageWidth, Scan3DImageHeight,
-											      EPixelFormat::PF_B8G8R8A8);
-		ScanTexture->UpdateResource();
+		ScanTexture = FindOrCreateTexture(Scan3DImageWidth, Scan3DImageHeight);
 	}
 
 	ScanBuffer = globalRealSenseSession->GetScanBuffer();
@@ -76,19 +91,158 @@ void UScan3DComponent::StopScanning()
 	globalRealSenseSession->StopScanning();
 }
 
-void UScan3DComponent::SaveScan(FString Filename)
+void UScan3DComponent::SaveScan(FString Filename, EScan3DFileFormat Format)
 {
 	Filename = FPaths::GameContentDir().Append(Filename);
-	globalRealSenseSession->SaveScan(EScan3DFileFormat::OBJ, Filename);
+	globalRealSenseSession->SaveScan(Format, Filename);
 }
 
 void UScan3DComponent::LoadScan(FString Filename)
 {
 	Filename = FPaths::GameContentDir().Append(Filename);
-	LoadMeshFile(Filename, Vertices, Triangles, Colors);
+	StartMeshTask(std::make_shared<ScanMesh>(), Filename);
 }
 
 bool UScan3DComponent::IsScanning() 
 {
 	return globalRealSenseSession->IsScanning();
 }
+
+bool UScan3DComponent::IsProcessingMesh() const
+{
+	return meshTask.valid();
+}
+
+void UScan3DComponent::SetScanBackend(EScan3DBackend Backend)
+{
+	globalRealSenseSession->SetScan3DBackend(Backend);
+}
+
+void UScan3DComponent::ConfigureFusion(float VoxelSize, float TruncationDistance, float MaxDepth)
+{
+	globalRealSenseSession->ConfigureFusion(VoxelSize, TruncationDistance, MaxDepth);
+}
+
+void UScan3DComponent::SetFusionCameraPose(const FTransform& CameraToWorld)
+{
+	globalRealSenseSession->SetFusionCameraPose(CameraToWorld);
+}
+
+void UScan3DComponent::ResetFusion()
+{
+	globalRealSenseSession->ResetFusion();
+}
+
+// The volume is only locked while marching cubes runs, so the extraction 
+// stays on the game thread and the rest goes to the mesh task.
+void UScan3DComponent::ExtractFusionMesh()
+{
+	std::shared_ptr<ScanMesh> Mesh = std::make_shared<ScanMesh>();
+	globalRealSenseSession->ExtractFusionMesh(Mesh->vertices, Mesh->triangles, Mesh->colors);
+	StartMeshTask(Mesh, FString());
+}
+
+// Only one task builds meshes at a time. A new request is left in 
+// meshRequest for the running task, which checks the generation between 
+// stages and starts over with the latest request, so only the newest mesh
+// is published. The task owns everything it touches, so it does not depend
+// on the component staying alive.
+void UScan3DComponent::StartMeshTask(std::shared_ptr<ScanMesh> mesh, const FString& filename)
+{
+	std::shared_ptr<MeshRequest> request = meshRequest;
+	{
+		std::lock_guard<std::mutex> lock(request->mutex);
+		request->mesh = mesh;
+		request->filename = filename;
+		request->ratios = LODRatios;
+		request->generation++;
+		if (request->bRunning) {
+			return;
+		}
+		request->bRunning = true;
+	}
+
+	meshTask = std::async(std::launch::async, [request]() {
+		std::shared_ptr<ScanMesh> mesh;
+		FString filename;
+		TArray<float> ratios;
+		uint32 generation = 0;
+
+		while (true) {
+			{
+				std::lock_guard<std::mutex> lock(request->mutex);
+				if (request->mesh == nullptr) {
+					request->bRunning = false;
+					return mesh;
+				}
+				mesh = MoveTemp(request->mesh);
+				filename = request->filename;
+				ratios = request->ratios;
+				generation = request->generation;
+			}
+
+			auto IsStale = [&]() { return request->generation != generation; };
+
+			if (filename.IsEmpty() == false) {
+				LoadMeshFile(filename, mesh->vertices, mesh->triangles, mesh->colors);
+			}
+			if (IsStale()) {
+				continue;
+			}
+
+			RealSenseMeshAdjacency adjacency;
+			adjacency.Build(mesh->vertices.Num(), mesh->triangles);
+			ComputeVertexNormals(mesh->vertices, mesh->triangles, adjacency, mesh->normals, mesh->tangents);
+			if (IsStale()) {
+				continue;
+			}
+
+			BuildMeshLODs(mesh->vertices, mesh->triangles, mesh->colors, adjacency, ratios, mesh->lods);
+			if (IsStale()) {
+				continue;
+			}
+
+			mesh->bvh = std::make_shared<RealSenseMeshBVH>();
+			mesh->bvh->Build(mesh->vertices, mesh->triangles);
+		}
+	});
+}
+
+void UScan3DComponent::PublishMesh(ScanMesh& mesh)
+{
+	Vertices = MoveTemp(mesh.vertices);
+	Triangles = MoveTemp(mesh.triangles);
+	Colors = MoveTemp(mesh.colors);
+	Normals = MoveTemp(mesh.normals);
+	Tangents = MoveTemp(mesh.tangents);
+	LODs = MoveTemp(mesh.lods);
+
+	// The BVH still points at the arrays of the task's mesh, which is freed
+	meshBVH = MoveTemp(mesh.bvh);
+	meshBVH->Rebind(Vertices, Triangles);
+}
+
+bool UScan3DComponent::RaycastScan(FVector Start, FVector End, FVector& HitLocation, FVector& HitNormal, int32& Triangle)
+{
+	RealSenseMeshBVH::RayHit Hit;
+	if (meshBVH->Raycast(Start, End - Start, (End - Start).Size(), Hit) == false) {
+		return false;
+	}
+
+	HitLocation = Hit.position;
+	HitNormal = Hit.normal;
+	Triangle = Hit.triangle;
+	return true;
+}
+
+bool UScan3DComponent::FindClosestPointOnScan(FVector Point, float MaxDistance, FVector& ClosestPoint, int32& Triangle)
+{
+	return meshBVH->FindClosestPoint(Point, MaxDistance, ClosestPoint, Triangle);
+}
+
+TArray<int32> UScan3DComponent::FindScanTrianglesInBox(FBox Box)
+{
+	TArray<int32> Result;
+	meshBVH->FindOverlappingTriangles(Box, Result);
+	return Result;
+}
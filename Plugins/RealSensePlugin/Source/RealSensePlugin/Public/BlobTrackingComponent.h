@@ -0,0 +1,62 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseComponent.h"
+#include "BlobTrackingComponent.generated.h"
+
+// Finds the connected regions of the depth image within a near depth range, 
+// such as hands or objects held in front of the camera, and follows them from
+// frame to frame. Blobs keep their Id for as long as they are tracked, so
+// gameplay can attach state to a hand without re-identifying it every frame.
+//
+// Blobs are labeled on the camera processing thread, so they are updated at
+// camera rate without adding work to the game thread.
+UCLASS(editinlinenew, meta = (BlueprintSpawnableComponent), ClassGroup = RealSense) 
+class UBlobTrackingComponent : public URealSenseComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	// Blobs of the latest camera frame, largest first.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	TArray<FDepthBlob> Blobs;
+
+	// Triggered after the blobs of a new camera frame were copied to Blobs.
+	UPROPERTY(BlueprintAssignable, Category = "RealSense") 
+	FRealSenseNullaryDelegate OnBlobsUpdated;
+
+	// Sets the depth range (mm) of the pixels grouped into blobs, the area 
+	// (pixels) of the smallest blob kept, the number of blobs kept, and the 
+	// farthest a blob may move between frames (pixels) and keep its Id. 
+	// Tracking restarts, so all blobs get new Ids.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void ConfigureBlobTracking(int32 MinDepth = 150, int32 MaxDepth = 700, int32 MinArea = 150, 
+							   int32 MaxBlobs = 8, float MaxMatchDistance = 48.0f);
+
+	// Finds the blob with the given Id in Blobs. Returns false if the blob is
+	// no longer tracked.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	bool FindBlob(int32 Id, FDepthBlob& Blob);
+
+	UBlobTrackingComponent();
+
+	void TickComponent(float DeltaTime, enum ELevelTick TickType, 
+		               FActorComponentTickFunction *ThisTickFunction) override;
+
+private:
+	// Number of the last camera frame whose blobs were copied
+	uint64 lastFrameNumber;
+};
@@ -38,6 +38,24 @@ class UCameraStreamComponent : public URealSenseComponent
 	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
 	TArray<int32> DepthBuffer;
 
+	// Nearest distance, mean depth, valid pixel ratio, and a coarse histogram of
+	// the depth frame in DepthBuffer. Computed on the camera processing thread,
+	// so reading these is much cheaper than iterating over DepthBuffer.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
+	FDepthStatistics DepthStatistics;
+
+	// Coverage of the segmented user (0 = background, 255 = user) for every
+	// pixel of ColorBuffer. Only filled when 3D segmentation is enabled with 
+	// the Mask output.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
+	TArray<uint8> SegmentationMask;
+
+	// Segmentation mask as alternating run lengths of background and user 
+	// pixels, starting with background. Only filled when 3D segmentation is 
+	// enabled with the Run-Length Encoded Mask output.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
+	TArray<int32> SegmentationRuns;
+
 	// Texture2D object used to easily visualize the ColorBuffer. 
 	// This texture is initialized upon setting the color camera resolution, and 
 	// should be set by calling ColorBufferToTexture().
@@ -68,6 +86,104 @@ class UCameraStreamComponent : public URealSenseComponent
 	UFUNCTION(BlueprintCallable, Category = "RealSense")
 	virtual void Enable3DSegmentation(bool b3DSeg);
 
+	// Selects what 3D segmentation produces: the segmented color image in 
+	// ColorBuffer (the default), or the regular ColorBuffer plus the user 
+	// mask in SegmentationMask or SegmentationRuns, which moves a quarter of
+	// the data or less. Use CompositeSegmentedImage() to cut the user out.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void SetSegmentationOutput(ESegmentationOutput Output);
+
+	// Cleans up the segmented user on the camera thread before it reaches 
+	// ColorBuffer or SegmentationMask. OpenRadius removes specks of noise up
+	// to that size (in pixels), CloseRadius fills holes and notches, and 
+	// FeatherWidth softens the edge over that many pixels. Zero disables a step.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void SetSegmentationCleanup(int32 OpenRadius = 1, int32 CloseRadius = 2, int32 FeatherWidth = 4);
+
+	// Returns the depth (mm) at pixel (X, Y) of the latest depth frame, or 0 
+	// if there is no valid depth there. Much cheaper than reading DepthBuffer
+	// when only a few pixels are needed.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	int32 GetDepthAt(int32 X, int32 Y) const;
+
+	// Returns the minimum, median, or mean of the valid depth values (mm) 
+	// within the given rectangle of the latest depth frame, or 0 if there are
+	// none. Call EnableDepthSummedAreaTable() to make the mean constant time.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	float GetDepthInRect(int32 X, int32 Y, int32 Width, int32 Height, 
+						 EDepthRegionStatistic Statistic = EDepthRegionStatistic::MEAN) const;
+
+	// Returns the depth (mm) at each of the given pixels of the latest depth 
+	// frame, or 0 for pixels without valid depth.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	TArray<int32> GetDepthAtPoints(const TArray<FIntPoint>& Points) const;
+
+	// Computes a summed-area table with every depth frame on the camera 
+	// processing thread, so that GetDepthInRect() with Mean costs the same 
+	// for any rectangle size.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void EnableDepthSummedAreaTable(bool bEnable);
+
+	// Sends the frames of this camera to every client that connects to the 
+	// given TCP port, on this machine or over the local network. Color is 
+	// JPEG-compressed with the given quality (1-100) and depth is compressed 
+	// losslessly. Returns false if the port could not be opened.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	bool StartStreamServer(int32 Port = 5700, int32 JpegQuality = 85);
+
+	// Disconnects all clients and stops streaming.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void StopStreamServer();
+
+	// Receives frames from a stream server instead of the local camera. 
+	// ColorBuffer and DepthBuffer take the resolutions used by the server, so 
+	// set the same camera resolutions here to get matching textures. Returns 
+	// false if the connection failed.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	bool ConnectToStreamServer(const FString& Host, int32 Port = 5700);
+
+	// Disconnects from the stream server and returns to the local camera.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void DisconnectFromStreamServer();
+
+	// Returns frame counts, codec time, latency, and bandwidth of the current
+	// stream client or server.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	FRealSenseStreamStats GetStreamStats() const;
+
+	// Publishes the frames of this camera into a named shared-memory region 
+	// so that other processes on this machine can read them without copies.
+	// External applications read the region with RealSenseSharedMemoryReader.h.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	bool StartSharedMemoryPublisher(const FString& Name = TEXT("RealSenseFrames"));
+
+	// Stops publishing frames to shared memory.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void StopSharedMemoryPublisher();
+
+	// Records the most recent frames, downsampled by Downsample (1-8) in 
+	// both directions, into a ring of MemoryBudgetMB megabytes (1 to 1024), 
+	// so that effects can look back in time with GetDepthFrameAgo() and 
+	// GetColorFrameAgo(). The older frames are overwritten as new ones arrive.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void StartFrameHistory(int32 MemoryBudgetMB = 64, int32 Downsample = 2);
+
+	// Stops recording and frees the frame history.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void StopFrameHistory();
+
+	// Copies the recorded depth frame (mm) nearest to SecondsAgo before the 
+	// latest one, at the downsampled resolution. Returns false if nothing has
+	// been recorded.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	bool GetDepthFrameAgo(float SecondsAgo, TArray<int32>& Depth, int32& Width, int32& Height) const;
+
+	// Copies the recorded color frame nearest to SecondsAgo before the 
+	// latest one, at the downsampled resolution. Returns false if nothing has
+	// been recorded.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	bool GetColorFrameAgo(float SecondsAgo, TArray<FSimpleColor>& Color, int32& Width, int32& Height) const;
+
 	UCameraStreamComponent();
 
 	void InitializeComponent() override;
@@ -0,0 +1,77 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseComponent.h"
+#include "DepthBackgroundComponent.generated.h"
+
+// Separates people and objects from a static scene by comparing every depth
+// frame to a learned depth background, for fixed installations where the 
+// camera does not move. Unlike 3D segmentation, it needs no middleware 
+// support from the camera and costs far less CPU time.
+//
+// The background is learned from the first frames after the camera starts 
+// or LearnBackground() is called, then keeps adapting slowly to changes of 
+// the scene. Pixels without depth while learning are foreground until they
+// hold the same depth for UnobservedFrames frames in a row, which then 
+// becomes their background.
+UCLASS(editinlinenew, meta = (BlueprintSpawnableComponent), ClassGroup = RealSense) 
+class UDepthBackgroundComponent : public URealSenseComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	// Foreground mask of the latest camera frame at depth resolution, row by
+	// row: 255 for pixels in front of the background, 0 elsewhere.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	TArray<uint8> ForegroundMask;
+
+	// True while the background is being learned, during which ForegroundMask
+	// holds no foreground.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	bool bLearningBackground;
+
+	// Triggered after the mask of a new camera frame was copied to 
+	// ForegroundMask.
+	UPROPERTY(BlueprintAssignable, Category = "RealSense") 
+	FRealSenseNullaryDelegate OnForegroundUpdated;
+
+	// Sets the number of frames the background is learned from, how fast 
+	// (mm per frame) it follows changes of the scene, how many frames it 
+	// takes to move 1 mm behind foreground (0 for never), the smallest 
+	// distance (mm) and the number of deviations of the depth noise in front
+	// of it that make a pixel foreground, the radius of the cleanup that 
+	// removes specks from the mask, and how many frames in a row a pixel 
+	// that had no depth while learning must hold the same depth before it 
+	// becomes its background (0 for never). The background is learned again.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void ConfigureDepthBackground(int32 LearningFrames = 30, int32 AdaptationStep = 2, int32 AbsorbInterval = 8, 
+								  int32 MinBand = 20, int32 BandScale = 4, int32 OpenRadius = 1, 
+								  int32 UnobservedFrames = 3600);
+
+	// Forgets the background and learns it again from the next frames, which
+	// should not show anything that is meant to be foreground.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void LearnBackground();
+
+	UDepthBackgroundComponent();
+
+	void TickComponent(float DeltaTime, enum ELevelTick TickType, 
+		               FActorComponentTickFunction *ThisTickFunction) override;
+
+private:
+	// Number of the last camera frame whose mask was copied
+	uint64 lastFrameNumber;
+};
@@ -0,0 +1,84 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseComponent.h"
+#include "DepthMeshComponent.generated.h"
+
+class RealSenseDepthMesh;
+
+// Builds a live grid mesh of the scene from the depth stream, in Unreal units
+// relative to the camera (X forward, Y right, Z up). Vertices, Normals, UV, 
+// and Triangles can be passed directly to a ProceduralMeshComponent: create 
+// the mesh section when bTrianglesChanged is true, and only update the 
+// section's vertices and normals otherwise.
+UCLASS(editinlinenew, meta = (BlueprintSpawnableComponent), ClassGroup = RealSense) 
+class UDepthMeshComponent : public URealSenseComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	// Distance in depth pixels between neighboring vertices of the mesh. 
+	// Larger values make a coarser but cheaper mesh.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense")
+	int32 GridStep;
+
+	// Triangles are not created between neighboring vertices whose depth 
+	// differs by more than this fraction of the nearer one, so that objects
+	// are not connected to the background behind them.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense")
+	float DiscontinuityRatio;
+
+	// Depth (mm) beyond which the scene is left out of the mesh. 0 keeps everything.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense")
+	int32 MaxDepth;
+
+	// Mesh vertex positions, updated every camera frame.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	TArray<FVector> Vertices;
+
+	// Mesh vertex normals, updated every camera frame.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	TArray<FVector> Normals;
+
+	// Mesh texture coordinates into the depth image. Only change with the 
+	// depth resolution or GridStep.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	TArray<FVector2D> UV;
+
+	// Mesh triangles. Dropped triangles are kept as degenerate triangles so 
+	// the size of this array only changes with the depth resolution or GridStep.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	TArray<int32> Triangles;
+
+	// True if UV or Triangles changed during the last update.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	bool bTrianglesChanged;
+
+	// Triggered after the mesh has been updated from a new camera frame.
+	UPROPERTY(BlueprintAssignable, Category = "RealSense") 
+	FRealSenseNullaryDelegate OnMeshUpdated;
+
+	UDepthMeshComponent();
+
+	void TickComponent(float DeltaTime, enum ELevelTick TickType, 
+		               FActorComponentTickFunction *ThisTickFunction) override;
+
+private:
+	std::shared_ptr<RealSenseDepthMesh> depthMesh;
+
+	// Number of the last camera frame turned into a mesh
+	uint64 lastFrameNumber;
+};
@@ -18,6 +18,9 @@
 #include "RealSenseComponent.h"
 #include "HeadTrackingComponent.generated.h"
 
+class HeadPoseFilter;
+struct HeadPoseFilterSettings;
+
 UCLASS(editinlinenew, meta = (BlueprintSpawnableComponent), ClassGroup = RealSense) 
 class UHeadTrackingComponent : public URealSenseComponent
 {
@@ -32,6 +35,78 @@ class UHeadTrackingComponent : public URealSenseComponent
 	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
 	FRotator HeadRotation;
 
+	// Head position after filtering, as of the time the camera frame was captured.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	FVector FilteredHeadPosition;
+
+	// Head rotation after filtering, as of the time the camera frame was captured.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	FRotator FilteredHeadRotation;
+
+	// Filtered head position extrapolated to the expected display time of the
+	// current game frame (now + DisplayLatency).
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	FVector PredictedHeadPosition;
+
+	// Filtered head rotation extrapolated to the expected display time of the
+	// current game frame (now + DisplayLatency).
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	FRotator PredictedHeadRotation;
+
+	// Filter used to compute the filtered and predicted head pose.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense")
+	EHeadPoseFilter PoseFilter;
+
+	// One-Euro: cutoff frequency (Hz) applied when the head is at rest. 
+	// Lower values remove more jitter.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense")
+	float MinCutoff;
+
+	// One-Euro: how quickly the cutoff frequency rises with head speed. 
+	// Higher values reduce lag during fast motion.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense")
+	float Beta;
+
+	// One-Euro: cutoff frequency (Hz) used to smooth the velocity estimate.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense")
+	float DerivativeCutoff;
+
+	// Kalman: expected acceleration noise of the head motion.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense")
+	float ProcessNoise;
+
+	// Kalman: expected variance of the measured head pose.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense")
+	float MeasurementNoise;
+
+	// Time in seconds between the current game tick and the moment its frame 
+	// is displayed. The predicted head pose is extrapolated to this time.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense")
+	float DisplayLatency;
+
+	// If true, every new raw head pose is appended to PoseLog.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense")
+	bool bRecordPoseLog;
+
+	// Raw head poses recorded while bRecordPoseLog is enabled.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	TArray<FHeadPoseSample> PoseLog;
+
+	// Clears the filter state so that the next head pose is used as is.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void ResetPoseFilter();
+
+	// Clears the recorded PoseLog.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void ClearPoseLog();
+
+	// Replays a recorded pose log through the current filter settings and 
+	// returns the RMS error of the pose predicted Horizon seconds ahead. 
+	// The RMS rotation error (in degrees) is returned in RotationError.
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	float MeasurePredictionError(const TArray<FHeadPoseSample>& Log, float Horizon, 
+								 float& RotationError);
+
 	UHeadTrackingComponent();
 
 	void InitializeComponent() override;
@@ -40,4 +115,13 @@ class UHeadTrackingComponent : public URealSenseComponent
 		               FActorComponentTickFunction *ThisTickFunction) override;
 
 private:
+	std::shared_ptr<HeadPoseFilter> poseFilter;
+
+	// Number of the last camera frame fed to the pose filter
+	uint64 lastFrameNumber;
+
+	// Capture time of the first sample in PoseLog
+	double poseLogStartTime;
+
+	HeadPoseFilterSettings GetFilterSettings() const;
 };
@@ -0,0 +1,94 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseComponent.h"
+#include "OccupancyGridComponent.generated.h"
+
+class RealSenseOccupancyGrid;
+
+// Keeps a voxel occupancy grid of the scene in front of the camera, rebuilt 
+// from every depth frame on the camera processing thread, for fast collision
+// tests between game objects and the real scene. Positions are in the world
+// space set by SetOccupancyCameraPose(), relative to the camera (X forward, 
+// Y right, Z up) by default.
+//
+// The grid is copied to the component every tick, only the bricks of 4x4x4 
+// voxels that changed, so the queries below run on the game thread without
+// waiting on the camera.
+UCLASS(editinlinenew, meta = (BlueprintSpawnableComponent), ClassGroup = RealSense) 
+class UOccupancyGridComponent : public URealSenseComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	// Bounds of the regions of the grid that changed during the last tick, 
+	// for example to rebuild only the affected collision.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	TArray<FBox> ChangedRegions;
+
+	// Triggered after a tick in which the grid changed.
+	UPROPERTY(BlueprintAssignable, Category = "RealSense") 
+	FRealSenseNullaryDelegate OnOccupancyChanged;
+
+	// Sets the volume covered by the grid, the edge length of its voxels, and
+	// the distance in depth pixels between the samples binned into it, then 
+	// clears it. Smaller voxels and steps give finer but more costly grids.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void ConfigureOccupancyGrid(FBox Bounds, float VoxelSize = 4.0f, int32 PixelStep = 2);
+
+	// Sets the world transform of the camera, for example to place the grid 
+	// in the level. The camera is at the origin until this is called.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void SetOccupancyCameraPose(const FTransform& CameraToWorld);
+
+	// Returns true if the voxel containing the point is occupied.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "RealSense") 
+	bool IsPointOccupied(FVector Point);
+
+	// Returns true if any occupied voxel intersects the box.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	bool OverlapBox(FBox Box);
+
+	// Returns true if any occupied voxel intersects the sphere.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	bool OverlapSphere(FVector Center, float Radius);
+
+	// Finds the first occupied voxel along the segment from Start to End, and
+	// the normal of the voxel face the segment enters it through. Returns 
+	// false if the segment only crosses free space.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	bool RaycastOccupancy(FVector Start, FVector End, FVector& HitLocation, FVector& HitNormal);
+
+	// Returns the centers of the occupied voxels, for example to draw them 
+	// with instanced meshes of size GetVoxelSize().
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void GetOccupiedVoxels(TArray<FVector>& Centers);
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "RealSense") 
+	float GetVoxelSize();
+
+	UOccupancyGridComponent();
+
+	void TickComponent(float DeltaTime, enum ELevelTick TickType, 
+		               FActorComponentTickFunction *ThisTickFunction) override;
+
+private:
+	// Copy of the grid built by the camera processing thread
+	std::shared_ptr<RealSenseOccupancyGrid> occupancyGrid;
+
+	// Bricks copied during the last tick
+	TArray<int32> changedBricks;
+};
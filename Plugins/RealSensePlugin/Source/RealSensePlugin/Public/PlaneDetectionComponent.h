@@ -0,0 +1,75 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "RealSenseComponent.h"
+#include "PlaneDetectionComponent.generated.h"
+
+// Finds the dominant planes in front of the camera, such as the floor, a 
+// table, or a wall, for example to place virtual objects on them. Planes 
+// keep their Id for as long as they are tracked. Positions and normals are 
+// in Unreal units relative to the camera (X forward, Y right, Z up).
+//
+// Planes are found with RANSAC on the camera processing thread, and every 
+// depth pixel is labeled with the plane it lies on, in PlaneMask.
+UCLASS(editinlinenew, meta = (BlueprintSpawnableComponent), ClassGroup = RealSense) 
+class UPlaneDetectionComponent : public URealSenseComponent
+{
+	GENERATED_UCLASS_BODY()
+
+	// Planes of the latest camera frame, roughly largest first.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	TArray<FDepthPlane> Planes;
+
+	// Plane label of every depth pixel, row by row: 0 if the pixel is on no
+	// plane, otherwise 1 + the index of its plane in Planes.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense")
+	TArray<uint8> PlaneMask;
+
+	// Triggered after new planes were copied to Planes and PlaneMask, which 
+	// happens on the camera frames the detector ran for.
+	UPROPERTY(BlueprintAssignable, Category = "RealSense") 
+	FRealSenseNullaryDelegate OnPlanesUpdated;
+
+	// Sets the largest number of planes found, the farthest a point may lie
+	// from a plane and belong to it, the largest angle (degrees) between the
+	// surface at a point and its plane, and the distance in depth pixels 
+	// between the points sampled to find the planes. Tracking restarts, so 
+	// all planes get new Ids.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void ConfigurePlaneDetection(int32 MaxPlanes = 4, float InlierDistance = 1.5f, float MaxNormalAngle = 20.0f, 
+								 int32 PixelStep = 4);
+
+	// Finds the plane with the given Id in Planes. Returns false if the plane
+	// is no longer tracked.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	bool FindPlane(int32 Id, FDepthPlane& Plane);
+
+	// Finds the largest plane whose normal is within MaxAngle degrees of 
+	// Direction, for example Z to find the floor or a table when the camera
+	// is level. Returns false if there is none.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	bool FindPlaneFacing(FVector Direction, float MaxAngle, FDepthPlane& Plane);
+
+	UPlaneDetectionComponent();
+
+	void TickComponent(float DeltaTime, enum ELevelTick TickType, 
+		               FActorComponentTickFunction *ThisTickFunction) override;
+
+private:
+	// Revision of the planes last copied, see GetPlaneRevision()
+	uint64 lastPlaneRevision;
+};
@@ -36,6 +36,13 @@ class URealSenseBlueprintLibrary : public UBlueprintFunctionLibrary
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "RealSense Utilities") 
 	static FString ECameraModelToString(ECameraModel value);
 
+	// Returns the serial number, name, model and firmware of every supported 
+	// RealSense camera connected to this machine. Use the serial number to 
+	// select a camera through a RealSense component's DeviceSerial property.
+	// Waits for device discovery to finish if it is still running.
+	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
+	static TArray<FRealSenseDeviceInfo> GetConnectedDevices();
+
 	// Fills a Texture2D object with the data from a buffer of FSimpleColors.
 	// This function will return null if the size of the input buffer does not
 	// match the resolution of the Texture2D object.
@@ -59,9 +66,72 @@ class URealSenseBlueprintLibrary : public UBlueprintFunctionLibrary
 	static UTexture2D* DepthBufferToTexture(const TArray<int32>& Buffer, 
 											UTexture2D* Texture);
 
-	// Returns an array of .OBJ filenames found in the specified directory.
+	// Cuts the segmented user out of a color buffer and blends it over a 
+	// background buffer of the same size, using a segmentation mask from a 
+	// CameraStreamComponent. Returns false if the sizes do not match.
+	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
+	static bool CompositeSegmentedImage(const TArray<FSimpleColor>& Foreground, const TArray<uint8>& Mask, 
+										const TArray<FSimpleColor>& Background, TArray<FSimpleColor>& Result);
+
+	// Cuts the segmented user out of a color buffer and blends it over a 
+	// solid color. Returns false if the sizes do not match.
+	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
+	static bool CompositeSegmentedImageOverColor(const TArray<FSimpleColor>& Foreground, const TArray<uint8>& Mask, 
+												 FColor Background, TArray<FSimpleColor>& Result);
+
+	// Expands a run-length encoded segmentation mask (SegmentationRuns) into 
+	// a mask of NumPixels values of 0 (background) or 255 (user).
+	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
+	static TArray<uint8> DecodeSegmentationRuns(const TArray<int32>& Runs, int32 NumPixels);
+
+	// Fuses a synthetic sequence of depth frames of a sphere seen from an 
+	// orbiting camera with the plugin's volumetric fusion, and reports the 
+	// accuracy of the fused surface and the time spent per frame.
+	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
+	static FFusionBenchmarkResult BenchmarkFusion(int32 Frames = 60, int32 Width = 640, int32 Height = 480, 
+												  float VoxelSize = 0.5f, float TruncationDistance = 2.0f);
+
+	// Saves a mesh, or a point cloud if Triangles is empty, to the specified 
+	// file, relative to the /Game/Content asset directory. Binary PLY keeps 
+	// the vertex colors and is much smaller and faster to write and read than
+	// OBJ; STL stores triangles only. Returns false if the file could not be written.
+	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
+	static bool SaveMeshFile(FString Filename, EScan3DFileFormat Format, const TArray<FVector>& Vertices, 
+							 const TArray<int32>& Triangles, const TArray<FColor>& Colors);
+
+	// Computes area-weighted vertex normals, and tangents perpendicular to 
+	// them, for a triangle mesh. Runs in parallel.
+	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
+	static void ComputeMeshNormals(const TArray<FVector>& Vertices, const TArray<int32>& Triangles, 
+								   TArray<FVector>& Normals, TArray<FVector>& Tangents);
+
+	// Builds simplified versions of a triangle mesh keeping about the given 
+	// fractions of its triangles, by merging nearby vertices. Runs in parallel.
+	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
+	static TArray<FScanMeshLOD> BuildMeshLODs(const TArray<FVector>& Vertices, const TArray<int32>& Triangles, 
+											  const TArray<FColor>& Colors, const TArray<float>& Ratios);
+
+	// Writes and loads back a synthetic mesh with the given number of vertices
+	// in every supported file format, and reports the time spent and file sizes.
+	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
+	static TArray<FMeshFileBenchmarkResult> BenchmarkMeshFiles(int32 VertexCount = 250000);
+
+	// Builds a BVH over a synthetic mesh with the given number of triangles,
+	// as used for the queries of the Scan3DComponent, and reports the time to
+	// build it and the average time of ray cast, closest point, and box 
+	// overlap queries.
+	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
+	static FMeshBVHBenchmarkResult BenchmarkMeshBVH(int32 TriangleCount = 2000000, int32 QueryCount = 100000);
+
+	// Runs the blob tracker of the BlobTrackingComponent over synthetic depth
+	// frames of the given size and reports the time spent per frame, on the 
+	// calling thread as on the camera processing thread.
+	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
+	static FBlobTrackingBenchmarkResult BenchmarkBlobTracking(int32 Width = 640, int32 Height = 480, int32 Frames = 300);
+
+	// Returns an array of .OBJ, .PLY, and .STL filenames found in the specified directory.
 	// Note: The path is relative to the /Game/Content asset directory.
-	// Example: GetMeshFiles("Scans/Faces") searches for .OBJ files in 
+	// Example: GetMeshFiles("Scans/Faces") searches for mesh files in 
 	// /Games/Content/Scans/Faces.
 	UFUNCTION(BlueprintCallable, Category = "RealSense Utilities") 
 	static TArray<FString> GetMeshFiles(FString Directory);
@@ -52,6 +52,12 @@ class URealSenseComponent : public UActorComponent
 	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
 	FString CameraFirmware;
 
+	// Serial number of the RealSense device this component should use. Leave 
+	// empty to use the first camera found. Components that specify the same 
+	// serial number share a camera processing thread.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "RealSense") 
+	FString DeviceSerial;
+
 	// This function initiates a RealSense camera processing thread that collects 
 	// camera data, such as raw color and depth images and middleware-specific 
 	// constructs. You should call this function after setting the color and/or depth 
@@ -79,6 +85,24 @@ class URealSenseComponent : public UActorComponent
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "RealSense") 
 	bool IsCameraRunning();
 
+	// Sets the scheduling priority of the camera processing thread and the 
+	// cores it may run on, as a bit mask of logical cores. Leave AffinityMask
+	// at 0 to keep it off the cores the platform pins the game and render 
+	// threads to, if any; otherwise it may run on any core. Set a mask to 
+	// keep it away from them explicitly. Call this before StartCamera().
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void SetCameraThreadOptions(ERealSenseThreadPriority Priority = ERealSenseThreadPriority::ABOVE_NORMAL, 
+								int32 AffinityMask = 0);
+
+	// Lets the camera processing thread run face tracking, 3D segmentation, and
+	// the scan preview at a reduced rate (down to once every MaxInterval 
+	// frames) while the game frame time exceeds TargetFrameMs or those stages
+	// use more than StageBudgetMs of CPU time per camera frame. The current 
+	// rates and costs are shown by "stat RealSense".
+	UFUNCTION(BlueprintCallable, Category = "RealSense")
+	void ConfigureProcessingBudget(bool bEnabled = true, float TargetFrameMs = 16.6f, 
+								   float StageBudgetMs = 8.0f, int32 MaxInterval = 8);
+
 	// Returns the color camera resolution as an FStreamResolution object: 
 	// width, height, fps, and pixel format.
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "RealSense") 
@@ -116,4 +140,18 @@ protected:
 	ARealSenseSessionManager* globalRealSenseSession;
 
 	RealSenseFeature m_feature;
+
+	// Copies the camera model, firmware, and field of view from the session manager.
+	UFUNCTION()
+	void UpdateCameraInfo();
+
+	// Returns a transient BGRA texture of the given size. Textures are cached,
+	// so switching back and forth between resolutions reuses them instead of
+	// creating a new texture every time.
+	UTexture2D* FindOrCreateTexture(int32 Width, int32 Height);
+
+private:
+	// Textures created by FindOrCreateTexture()
+	UPROPERTY(Transient)
+	TArray<UTexture2D*> TextureCache;
 };
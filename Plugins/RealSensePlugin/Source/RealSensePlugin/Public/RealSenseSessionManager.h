@@ -15,18 +15,55 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
-#include "RealSenseImpl.h"
+#include "AllowWindowsPlatformTypes.h"
+#include <memory>
+#include "HideWindowsPlatformTypes.h"
+
 #include "RealSenseTypes.h"
 
 #include "RealSenseSessionManager.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FRealSenseNullaryDelegate);
 
+class RealSenseImpl;
+class IRealSenseFrameSource;
+class RealSenseDepthMesh;
+class RealSenseOccupancyGrid;
+class RealSenseStreamServer;
+class RealSenseStreamClient;
+class RealSenseSharedMemoryPublisher;
+class RealSenseFrameQueue;
+class RealSenseFrameHistory;
+
+// Manages access to a single RealSense camera. One session manager is spawned
+// for every distinct device serial number requested by RealSense components, 
+// and each one runs its own camera processing thread.
 UCLASS(ClassGroup = RealSense)
 class ARealSenseSessionManager : public AActor
 {
 	GENERATED_UCLASS_BODY()
 
+	// Selects the camera driven by this session manager. An empty serial number
+	// selects the first supported camera. Has no effect while the camera 
+	// processing thread is running.
+	void SetDeviceSerial(const FString& Serial);
+
+	// Returns the serial number requested through SetDeviceSerial().
+	inline const FString& GetDeviceSerial() const { return DeviceSerial; }
+
+	// Returns the serial number of the camera actually opened by this session
+	// manager, or an empty string if no camera was found.
+	FString GetConnectedDeviceSerial() const;
+
+	// Returns true once background device discovery has finished. Until then,
+	// any function that needs the camera blocks until discovery completes.
+	bool AreDevicesReady() const;
+
+	// Triggered on the first tick after background device discovery has 
+	// finished and camera information can be queried without blocking.
+	UPROPERTY(BlueprintAssignable, Category = "RealSense") 
+	FRealSenseNullaryDelegate OnDevicesReady;
+
 	// Enables the provided feature
 	void EnableFeature(RealSenseFeature feature);
 
@@ -41,9 +78,30 @@ class ARealSenseSessionManager : public AActor
 	// Stops the camera processing thread.
 	void StopCamera();
 
-	// Returns true if the camera processing thread is currently executing.
+	// Configures the governor that lowers the rate of face tracking, 
+	// segmentation, scan preview, the occupancy grid, blob tracking, plane 
+	// detection, and the depth background when the game frame time exceeds 
+	// TargetFrameMs or those stages use more than StageBudgetMs of CPU time 
+	// per camera frame. Each stage runs at least once every MaxInterval frames.
+	void ConfigureGovernor(bool bEnabled, float TargetFrameMs, float StageBudgetMs, int32 MaxInterval);
+
+	// Sets the priority and core affinity of the camera processing thread. An
+	// affinity mask of 0 keeps the thread off the cores the platform pins the
+	// game and render threads to. Where they are not pinned, as on Windows by
+	// default, the thread may run on any core. Applied on the next StartCamera().
+	void SetCameraThreadOptions(ERealSenseThreadPriority Priority, int64 AffinityMask);
+
+	// Returns true if the camera processing thread is currently executing, or
+	// if frames are being received from a stream server.
 	bool IsCameraRunning() const;
 
+	// Returns the number of the frame currently loaded into the foreground.
+	uint64 GetFrameNumber() const;
+
+	// Returns the time (FPlatformTime::Seconds) at which the foreground frame
+	// was acquired by the camera processing thread.
+	double GetFrameTimestamp() const;
+
 	// Returns true if there is a physical camera connected.
 	bool IsCameraConnected() const;
 
@@ -95,11 +153,120 @@ class ARealSenseSessionManager : public AActor
 
 	// CameraStreamComponent Support
 
-	// Returns a pointer to the latest frame obtained from the RealSense RGB camera.
-	TArray<FSimpleColor> GetColorBuffer() const;
-
-	// Returns a pointer to the latest frame obtained from the RealSense depth camera.
-	TArray<int32> GetDepthBuffer() const;
+	// Returns a reference to the latest frame obtained from the RealSense RGB camera.
+	const TArray<FSimpleColor>& GetColorBuffer() const;
+
+	// Returns a reference to the latest frame obtained from the RealSense depth camera.
+	const TArray<int32>& GetDepthBuffer() const;
+
+	// Selects what 3D segmentation produces. COLOR_WITH_ALPHA replaces the 
+	// color buffer with the segmented image (the default). MASK keeps the 
+	// regular color buffer and provides the 8-bit mask of the user through 
+	// GetSegmentationMask(). MASK_RLE provides the mask run-length encoded 
+	// through GetSegmentationRuns() instead.
+	void SetSegmentationOutput(ESegmentationOutput Output);
+
+	// Sets the cleanup applied to every segmentation result on the camera 
+	// thread: opening and closing radii (in pixels) to remove specks and fill
+	// holes, and the width (in pixels) of the feathered edge. Zero disables a step.
+	void SetSegmentationCleanup(int32 OpenRadius, int32 CloseRadius, int32 FeatherWidth);
+
+	// Returns the latest segmentation mask (one byte per color pixel) when 
+	// the MASK output is selected, otherwise an empty array.
+	const TArray<uint8>& GetSegmentationMask() const;
+
+	// Returns the latest segmentation mask as alternating background and 
+	// foreground run lengths when the MASK_RLE output is selected, otherwise
+	// an empty array.
+	const TArray<int32>& GetSegmentationRuns() const;
+
+	// Returns the nearest distance, mean depth, valid pixel ratio, and histogram
+	// of the latest depth frame. These are computed on the camera processing 
+	// thread, so this does not touch the depth pixels.
+	FDepthStatistics GetDepthStatistics() const;
+
+	// Returns the depth (mm) at the given pixel of the latest depth frame, or
+	// 0 if the pixel is outside the image or has no valid depth. Reads the 
+	// frame in place, without copying the depth buffer.
+	int32 GetDepthAt(int32 X, int32 Y) const;
+
+	// Returns the minimum, median, or mean of the valid depth values (mm) in 
+	// the given rectangle of the latest depth frame, or 0 if it contains no 
+	// valid depth. The rectangle is clipped to the image. With the summed-area
+	// table enabled, the mean costs the same for any rectangle size.
+	float GetDepthInRect(int32 X, int32 Y, int32 Width, int32 Height, EDepthRegionStatistic Statistic) const;
+
+	// Looks up the depth (mm) at several pixels at once, as GetDepthAt().
+	void GetDepthAtPoints(const TArray<FIntPoint>& Points, TArray<int32>& OutDepths) const;
+
+	// Updates a grid mesh from the latest depth frame, read in place. Returns
+	// true if the UVs or triangles changed along with the vertices and normals.
+	bool UpdateDepthMesh(RealSenseDepthMesh& Mesh, TArray<FVector>& Vertices, TArray<FVector>& Normals, 
+						 TArray<FVector2D>& UV, TArray<int32>& Triangles) const;
+
+	// Enables the summed-area table of each depth frame, built on the camera
+	// processing thread, which makes GetDepthInRect() with MEAN constant time.
+	void EnableDepthSummedAreaTable(bool bEnable);
+
+	// Creates a queue that receives every frame of the local camera according
+	// to the given delivery policy, for consumers that must see more frames 
+	// than the game thread does (recording, analytics). The game thread keeps
+	// receiving only the latest frame. Capacity is ignored by LATEST_ONLY.
+	std::shared_ptr<RealSenseFrameQueue> CreateFrameQueue(EFrameDeliveryPolicy Policy, int32 Capacity);
+
+	// Closes the queue and stops delivering frames to it.
+	void DestroyFrameQueue(const std::shared_ptr<RealSenseFrameQueue>& Queue);
+
+	// Returns the delivery statistics of every frame queue.
+	TArray<FFrameDeliveryStats> GetFrameQueueStats() const;
+
+	// Starts sending the color and depth frames of the local camera to every 
+	// client that connects to the given TCP port. Color is JPEG-compressed 
+	// with the given quality (1-100), depth is compressed losslessly.
+	bool StartStreamServer(int32 Port, int32 JpegQuality);
+
+	// Disconnects all stream clients and closes the port.
+	void StopStreamServer();
+
+	// Receives color and depth frames from a stream server instead of the 
+	// local camera. While connected, the color and depth buffers hold the 
+	// frames sent by the server, at the server's resolutions.
+	bool ConnectToStreamServer(const FString& Host, int32 Port);
+
+	// Disconnects from the stream server and returns to the local camera.
+	void DisconnectFromStreamServer();
+
+	// Returns the statistics of the stream client if connected, otherwise 
+	// those of the stream server.
+	FRealSenseStreamStats GetStreamStats() const;
+
+	// Publishes every frame of the local camera into a named shared-memory 
+	// ring that other processes can read with RealSenseSharedMemoryReader.h,
+	// without opening the camera themselves.
+	bool StartSharedMemoryPublisher(const FString& Name);
+
+	// Stops publishing frames to shared memory and releases the region.
+	void StopSharedMemoryPublisher();
+
+	// Keeps the most recent frames of the camera, downsampled by Downsample 
+	// (1-8) in both directions, in a ring of MemoryBudgetMB megabytes (1 to
+	// 1024), so that earlier frames can be looked up by time or frame number.
+	void StartFrameHistory(int32 MemoryBudgetMB, int32 Downsample);
+
+	// Stops recording and frees the frame history once its views are released.
+	void StopFrameHistory();
+
+	// Returns the frame history, or null if it is not recording. Its views 
+	// read the stored frames in place, without copies.
+	inline RealSenseFrameHistory* GetFrameHistory() const { return frameHistory.get(); }
+
+	// Copies the stored depth frame (mm) nearest to SecondsAgo before the 
+	// latest one. Returns false if the history has no depth frame.
+	bool GetHistoryDepthFrame(float SecondsAgo, TArray<int32>& Depth, int32& Width, int32& Height) const;
+
+	// Copies the stored color frame nearest to SecondsAgo before the latest 
+	// one. Returns false if the history has no color frame.
+	bool GetHistoryColorFrame(float SecondsAgo, TArray<FSimpleColor>& Color, int32& Width, int32& Height) const;
 
 	// Scan3DComponent Support 
 
@@ -130,12 +297,33 @@ class ARealSenseSessionManager : public AActor
 	void StopScanning();
 
 	// Saves the scanned data to a file with the specified format and filename.
-	// Currently only the OBJ format is supported.
+	// The file is written in the background; HasScanCompleted() turns true 
+	// once it is done.
 	void SaveScan(EScan3DFileFormat SaveFileFormat, FString filename);
 
 	// Returns true if the 3D scanning module is currently scanning.
 	bool IsScanning() const;
 
+	// Selects the engine used for 3D scanning: the RealSense middleware or 
+	// the plugin's own volumetric fusion, which builds the scan from depth 
+	// frames and camera poses. Must be called before the camera is started.
+	void SetScan3DBackend(EScan3DBackend Backend);
+
+	// Sets the voxel size, truncation distance, and maximum depth (all in 
+	// Unreal units) of the fusion volume and clears it.
+	void ConfigureFusion(float VoxelSize, float TruncationDistance, float MaxDepth);
+
+	// Sets the pose of the camera in the world for the depth frames fused 
+	// from now on. Without a pose the camera is assumed to be static.
+	void SetFusionCameraPose(const FTransform& CameraToWorld);
+
+	// Clears the fusion volume.
+	void ResetFusion();
+
+	// Replaces the contents of the arrays with the surface of the fusion 
+	// volume as a triangle mesh, in world space.
+	void ExtractFusionMesh(TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FColor>& Colors);
+
 	// Returns the middleware-defined resolution used by the 3D scanning module.
 	FStreamResolution GetScan3DResolution() const;
 
@@ -147,9 +335,9 @@ class ARealSenseSessionManager : public AActor
 	// 3D scanning module.
 	int32 GetScan3DImageHeight() const;
 
-	// Returns a pointer to the latest frame obtained from the 3D scanning
+	// Returns a reference to the latest frame obtained from the 3D scanning
 	// module, representing a preview of the current scanning progress.
-	TArray<FSimpleColor> GetScanBuffer() const;
+	const TArray<FSimpleColor>& GetScanBuffer() const;
 
 	// Returns true if the resolution of the 3D scanning module has changed.
 	bool HasScan3DImageSizeChanged() const;
@@ -168,18 +356,118 @@ class ARealSenseSessionManager : public AActor
 	// Return the current head rotation
 	FRotator GetHeadRotation() const;
 
+	// OccupancyGridComponent Support
+
+	// Sets the world space volume covered by the occupancy grid, the edge 
+	// length of its voxels, and the distance in depth pixels between the 
+	// samples binned into it, then clears it.
+	void ConfigureOccupancyGrid(const FBox& Bounds, float VoxelSize, int32 PixelStep);
+
+	// Sets the pose of the camera in the world for the depth frames binned 
+	// into the occupancy grid. Without a pose the camera is at the origin.
+	void SetOccupancyCameraPose(const FTransform& CameraToWorld);
+
+	// Brings a copy of the occupancy grid up to date by copying the bricks 
+	// that changed since the copy was last updated, and writes their indices
+	// to ChangedBricks.
+	void CopyOccupancyGrid(RealSenseOccupancyGrid& Grid, TArray<int32>& ChangedBricks) const;
+
+	// BlobTrackingComponent Support
+
+	// Sets the depth range (mm) of the pixels grouped into blobs, the area 
+	// (pixels) of the smallest blob kept, the number of blobs kept, and the 
+	// farthest a blob may move between frames (pixels) and keep its Id.
+	void ConfigureBlobTracking(int32 MinDepth, int32 MaxDepth, int32 MinArea, int32 MaxBlobs, float MaxMatchDistance);
+
+	// Returns the blobs of the latest frame, largest first.
+	const TArray<FDepthBlob>& GetBlobs() const;
+
+	// PlaneDetectionComponent Support
+
+	// Sets the largest number of planes found, the farthest a point may lie
+	// from a plane and belong to it, the largest angle (degrees) between the
+	// normal of a point and of its plane, and the distance in depth pixels 
+	// between the points sampled to find the planes.
+	void ConfigurePlaneDetection(int32 MaxPlanes, float InlierDistance, float MaxNormalAngle, int32 PixelStep);
+
+	// Returns the planes of the latest frame, roughly largest first.
+	const TArray<FDepthPlane>& GetPlanes() const;
+
+	// Returns the plane label of every depth pixel of the latest frame: 0 if
+	// the pixel is on no plane, otherwise 1 + the index of its plane in 
+	// GetPlanes().
+	const TArray<uint8>& GetPlaneMask() const;
+
+	// Returns a number that changes whenever the planes and the plane mask 
+	// change, and is 0 while there are none.
+	uint64 GetPlaneRevision() const;
+
+	// DepthBackgroundComponent Support
+
+	// Sets the number of frames the depth background is learned from, how
+	// fast (mm per frame) it follows changes of the scene, how many frames it
+	// takes to move 1 mm behind foreground (0 for never), the smallest 
+	// distance (mm) and the number of deviations in front of it that make a
+	// pixel foreground, the radius of the cleanup of the mask, and how many 
+	// frames in a row a pixel without background must hold a depth to take 
+	// it (0 for never). The background is learned again.
+	void ConfigureDepthBackground(int32 LearningFrames, int32 AdaptationStep, int32 AbsorbInterval, int32 MinBand, 
+								  int32 BandScale, int32 OpenRadius, int32 UnobservedFrames);
+
+	// Forgets the depth background and learns it again from the next frames,
+	// which should not show anything that is meant to be foreground.
+	void LearnDepthBackground();
+
+	// Returns the foreground mask of the latest frame at depth resolution:
+	// 255 for pixels in front of the depth background, 0 elsewhere.
+	const TArray<uint8>& GetForegroundMask() const;
+
+	// Returns true while the depth background is being learned, during which
+	// the foreground mask holds no foreground.
+	bool IsLearningDepthBackground() const;
+
 	ARealSenseSessionManager();
 
+	virtual void PostInitializeComponents() override;
+
 	virtual void BeginPlay() override;
 
 	virtual void Tick(float DeltaSeconds) override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 private:
-	std::unique_ptr<RealSenseImpl> impl;
+	// Publishes the governor state to the RealSense stat group.
+	void UpdateGovernorStats(float DeltaTime);
+
+	// Declared before impl so that the camera processing thread has been 
+	// stopped by the time the frame publishers are destroyed.
+	std::shared_ptr<RealSenseStreamServer> streamServer;
+	std::shared_ptr<RealSenseSharedMemoryPublisher> sharedMemoryPublisher;
+	std::shared_ptr<RealSenseFrameHistory> frameHistory;
+	TArray<std::shared_ptr<RealSenseFrameQueue>> frameQueues;
+	std::shared_ptr<RealSenseStreamClient> streamClient;
+
+	// Created lazily by GetImpl()
+	mutable std::shared_ptr<RealSenseImpl> impl;
+
+	bool bDevicesReady;
+
+	RealSenseImpl* GetImpl() const;
+
+	// Returns the stream client while it is connected, otherwise the local camera.
+	IRealSenseFrameSource* GetFrameSource() const;
+
+	uint32 RealSenseFeatureSet;
+
+	FString DeviceSerial;
 
-	uint8 RealSenseFeatureSet;
+	// Scratch storage for median queries
+	mutable TArray<uint16> DepthQueryScratch;
 
 	TArray<FSimpleColor> ColorBuffer;
 	TArray<int32> DepthBuffer;
 	TArray<FSimpleColor> ScanBuffer;
+	TArray<uint8> SegmentationMask;
+	TArray<int32> SegmentationRuns;
 };
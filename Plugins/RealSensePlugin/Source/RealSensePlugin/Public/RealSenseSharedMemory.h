@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Memory layout of the shared-memory frame ring written by the RealSense 
+// plugin. This header has no Unreal Engine dependencies so that it can be 
+// used by external processes (see RealSenseSharedMemoryReader.h).
+//
+// The region starts with a RealSenseSharedHeader followed by NumSlots slots
+// of SlotSize bytes each. Every slot holds a RealSenseSharedSlot followed by 
+// the BGRA color image at ColorOffset and the 16-bit depth image (in mm) at 
+// DepthOffset, both relative to the start of the slot.
+//
+// Synchronization is lock-free:
+//  - Each slot has a sequence number that is odd while the writer fills it.
+//  - Readers pin a slot by incrementing its reader count, then check that 
+//    the sequence number is even. The writer marks a slot as being written,
+//    then checks that its reader count is zero, and backs off otherwise. 
+//    Since both sides write their own counter before reading the other's, a
+//    pinned slot is never overwritten.
+//  - The writer never writes to the latest slot, so readers always find a 
+//    complete frame there.
+
+#include <atomic>
+#include <stdint.h>
+
+namespace RealSenseSharedMemory {
+
+static const uint32_t Magic = 0x4D535352;  // "RSSM"
+static const uint32_t Version = 1;
+static const uint32_t NumSlots = 4;
+static const uint32_t Alignment = 64;
+
+struct RealSenseSharedHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numSlots;
+	uint32_t slotSize;  // Size of one slot, including its RealSenseSharedSlot
+	uint32_t colorOffset;  // Offset of the color image within a slot
+	uint32_t depthOffset;  // Offset of the depth image within a slot
+	uint32_t maxColorBytes;
+	uint32_t maxDepthBytes;
+
+	std::atomic<uint64_t> latestSequence;  // Sequence number of the latest complete frame, 0 if none
+	std::atomic<uint32_t> latestSlot;  // Slot holding the latest complete frame
+	std::atomic<uint32_t> writerAlive;  // Non-zero while the writing process is publishing
+};
+
+struct RealSenseSharedSlot {
+	std::atomic<uint64_t> sequence;  // Odd while being written
+	std::atomic<uint32_t> readers;  // Number of readers currently pinning this slot
+	uint32_t reserved;
+
+	uint64_t frameNumber;  // Frame number assigned by the camera processing thread
+	double timestamp;  // Capture time in seconds, on the writer's clock
+	uint32_t colorWidth;
+	uint32_t colorHeight;
+	uint32_t depthWidth;
+	uint32_t depthHeight;
+};
+
+inline uint32_t AlignSize(uint32_t size)
+{
+	return (size + Alignment - 1) & ~(Alignment - 1);
+}
+
+// Returns the offset of the given slot from the start of the region.
+inline uint32_t GetSlotOffset(const RealSenseSharedHeader& header, uint32_t slot)
+{
+	return AlignSize(sizeof(RealSenseSharedHeader)) + slot * header.slotSize;
+}
+
+// Returns the size of a region able to hold the given maximum image sizes.
+inline uint32_t GetRegionSize(uint32_t maxColorBytes, uint32_t maxDepthBytes)
+{
+	const uint32_t slotSize = AlignSize(sizeof(RealSenseSharedSlot)) + AlignSize(maxColorBytes) + AlignSize(maxDepthBytes);
+	return AlignSize(sizeof(RealSenseSharedHeader)) + NumSlots * slotSize;
+}
+
+}  // namespace RealSenseSharedMemory
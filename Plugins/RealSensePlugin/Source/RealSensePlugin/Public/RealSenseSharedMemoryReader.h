@@ -0,0 +1,175 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Reads frames published by the RealSense plugin into shared memory (see
+// StartSharedMemoryPublisher on ARealSenseSessionManager) from another 
+// process, without copying them. Include this header in the external 
+// application; it only depends on the Windows API.
+//
+// Example usage:
+//   RealSenseSharedMemoryReader reader;
+//   if (reader.Open(L"RealSenseFrames")) {
+//       RealSenseSharedFrame frame;
+//       if (reader.AcquireLatest(frame)) {
+//           ... read frame.color and frame.depth ...
+//           reader.Release(frame);
+//       }
+//   }
+//
+// A frame must be released promptly: while it is pinned, the writer cannot 
+// reuse its slot, and once every slot is pinned new frames are dropped.
+
+#include "RealSenseSharedMemory.h"
+
+#include <string>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+// A pinned frame in shared memory. The pointers stay valid until Release().
+struct RealSenseSharedFrame {
+	const uint8_t* color;  // BGRA, colorWidth * colorHeight * 4 bytes
+	const uint16_t* depth;  // Depth in mm, depthWidth * depthHeight values
+	uint32_t colorWidth;
+	uint32_t colorHeight;
+	uint32_t depthWidth;
+	uint32_t depthHeight;
+	uint64_t frameNumber;
+	uint64_t sequence;
+	double timestamp;
+	uint32_t slot;
+};
+
+class RealSenseSharedMemoryReader {
+public:
+	RealSenseSharedMemoryReader() : mapping(nullptr), base(nullptr), header(nullptr) {}
+
+	~RealSenseSharedMemoryReader() { Close(); }
+
+	// Maps the named region. Returns false if no publisher has created it or
+	// if it was written by an incompatible version of the plugin. The engine
+	// creates named regions in the Global namespace, which is tried first.
+	bool Open(const wchar_t* name)
+	{
+		Close();
+
+		std::wstring globalName = std::wstring(L"Global\\") + name;
+		mapping = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, globalName.c_str());
+		if (mapping == nullptr) {
+			mapping = OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, name);
+		}
+		if (mapping == nullptr) {
+			return false;
+		}
+
+		base = static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+		if (base == nullptr) {
+			Close();
+			return false;
+		}
+
+		header = reinterpret_cast<RealSenseSharedMemory::RealSenseSharedHeader*>(base);
+		if ((header->magic != RealSenseSharedMemory::Magic) || (header->version != RealSenseSharedMemory::Version)) {
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void Close()
+	{
+		if (base) {
+			UnmapViewOfFile(base);
+			base = nullptr;
+		}
+		if (mapping) {
+			CloseHandle(mapping);
+			mapping = nullptr;
+		}
+		header = nullptr;
+	}
+
+	inline bool IsOpen() const { return (header != nullptr); }
+
+	// Returns true while the publishing process is running.
+	inline bool IsWriterAlive() const { return header && (header->writerAlive.load() != 0); }
+
+	// Returns the sequence number of the latest frame, which can be polled
+	// cheaply to find out whether a new frame is available.
+	inline uint64_t GetLatestSequence() const { return header ? header->latestSequence.load() : 0; }
+
+	// Pins the latest complete frame. Returns false if no frame has been 
+	// published yet. Every successful call must be matched by Release().
+	bool AcquireLatest(RealSenseSharedFrame& frame)
+	{
+		using namespace RealSenseSharedMemory;
+
+		if ((header == nullptr) || (header->latestSequence.load() == 0)) {
+			return false;
+		}
+
+		for (int attempt = 0; attempt < 16; attempt++) {
+			const uint32_t index = header->latestSlot.load();
+			RealSenseSharedSlot* slot = GetSlot(index);
+
+			slot->readers.fetch_add(1);
+			const uint64_t sequence = slot->sequence.load();
+			if ((sequence & 1) == 0) {
+				const uint8_t* data = reinterpret_cast<const uint8_t*>(slot);
+				frame.color = data + header->colorOffset;
+				frame.depth = reinterpret_cast<const uint16_t*>(data + header->depthOffset);
+				frame.colorWidth = slot->colorWidth;
+				frame.colorHeight = slot->colorHeight;
+				frame.depthWidth = slot->depthWidth;
+				frame.depthHeight = slot->depthHeight;
+				frame.frameNumber = slot->frameNumber;
+				frame.sequence = sequence;
+				frame.timestamp = slot->timestamp;
+				frame.slot = index;
+				return true;
+			}
+
+			// The writer grabbed this slot before we pinned it; retry with the
+			// slot that is now the latest
+			slot->readers.fetch_sub(1);
+		}
+		return false;
+	}
+
+	// Unpins a frame returned by AcquireLatest().
+	void Release(const RealSenseSharedFrame& frame)
+	{
+		if (header) {
+			GetSlot(frame.slot)->readers.fetch_sub(1);
+		}
+	}
+
+private:
+	RealSenseSharedMemory::RealSenseSharedSlot* GetSlot(uint32_t index) const
+	{
+		return reinterpret_cast<RealSenseSharedMemory::RealSenseSharedSlot*>(base + GetSlotOffset(*header, index));
+	}
+
+	HANDLE mapping;
+	uint8_t* base;
+	RealSenseSharedMemory::RealSenseSharedHeader* header;
+
+	RealSenseSharedMemoryReader(const RealSenseSharedMemoryReader&) = delete;
+	RealSenseSharedMemoryReader& operator=(const RealSenseSharedMemoryReader&) = delete;
+};
@@ -18,11 +18,15 @@
 #include "RealSenseTypes.generated.h"
 
 // List of features provided by the RealSense SDK
-enum RealSenseFeature : uint8 {
+enum RealSenseFeature : uint32 {
 	CAMERA_STREAMING = 0x1,
 	SCAN_3D = 0x2,
 	HEAD_TRACKING = 0x4,
 	SEGMENTATION_3D = 0x8,
+	OCCUPANCY_GRID = 0x10,
+	BLOB_TRACKING = 0x20,
+	PLANE_DETECTION = 0x40,
+	DEPTH_BACKGROUND = 0x80,
 };
 
 // Resolutions supported by the RealSense RGB camera
@@ -81,10 +85,61 @@ enum class EScan3DMode : uint8 {
 	FACE = 1 UMETA(DisplayName = "Face")
 };
 
-// File types supported by the 3D Scanning middleware for saving scans 
+// File types supported for saving scans 
 UENUM(BlueprintType) 
 enum class EScan3DFileFormat : uint8 {
-	OBJ = 0 UMETA(DisplayName = "OBJ")
+	OBJ = 0 UMETA(DisplayName = "OBJ"),
+	PLY = 1 UMETA(DisplayName = "PLY (Binary)"),
+	STL = 2 UMETA(DisplayName = "STL (Binary)")
+};
+
+// Engines available for 3D scanning
+UENUM(BlueprintType) 
+enum class EScan3DBackend : uint8 {
+	MIDDLEWARE = 0 UMETA(DisplayName = "RealSense Middleware"),
+	FUSION = 1 UMETA(DisplayName = "Plugin Volumetric Fusion")
+};
+
+// Filters available for smoothing and predicting the tracked head pose
+UENUM(BlueprintType) 
+enum class EHeadPoseFilter : uint8 {
+	NONE = 0 UMETA(DisplayName = "None"),
+	ONE_EURO = 1 UMETA(DisplayName = "One-Euro"),
+	KALMAN = 2 UMETA(DisplayName = "Kalman (Constant Velocity)")
+};
+
+// Statistics that can be computed over a rectangle of the depth image
+UENUM(BlueprintType) 
+enum class EDepthRegionStatistic : uint8 {
+	MIN = 0 UMETA(DisplayName = "Minimum"),
+	MEDIAN = 1 UMETA(DisplayName = "Median"),
+	MEAN = 2 UMETA(DisplayName = "Mean")
+};
+
+// How frames are delivered to a consumer that cannot keep up with the camera
+UENUM(BlueprintType) 
+enum class EFrameDeliveryPolicy : uint8 {
+	LATEST_ONLY = 0 UMETA(DisplayName = "Latest Only"),
+	BOUNDED_QUEUE = 1 UMETA(DisplayName = "Bounded Queue (Drop Oldest)"),
+	LOSSLESS = 2 UMETA(DisplayName = "Lossless (Block Camera)")
+};
+
+// Scheduling priority of the camera processing thread
+UENUM(BlueprintType) 
+enum class ERealSenseThreadPriority : uint8 {
+	LOWEST = 0 UMETA(DisplayName = "Lowest"),
+	BELOW_NORMAL = 1 UMETA(DisplayName = "Below Normal"),
+	NORMAL = 2 UMETA(DisplayName = "Normal"),
+	ABOVE_NORMAL = 3 UMETA(DisplayName = "Above Normal"),
+	HIGHEST = 4 UMETA(DisplayName = "Highest")
+};
+
+// What 3D segmentation writes for every frame
+UENUM(BlueprintType) 
+enum class ESegmentationOutput : uint8 {
+	COLOR_WITH_ALPHA = 0 UMETA(DisplayName = "Color With Alpha"),
+	MASK = 1 UMETA(DisplayName = "8-bit Mask"),
+	MASK_RLE = 2 UMETA(DisplayName = "Run-Length Encoded Mask")
 };
 
 // Basic 32-bit color structure (RGBA) 
@@ -118,3 +173,388 @@ struct FStreamResolution
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	ERealSensePixelFormat format;
 };
+
+// Timestamped head pose, used to record and replay head tracking sessions
+USTRUCT(BlueprintType) 
+struct FHeadPoseSample
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Capture time in seconds, relative to the first sample of the log
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Time;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FVector Position;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FRotator Rotation;
+};
+
+// Identifies a RealSense camera connected to this machine
+USTRUCT(BlueprintType) 
+struct FRealSenseDeviceInfo
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Serial number used to select this device from a RealSense component
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString SerialNumber;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString Name;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	ECameraModel CameraModel;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FString Firmware;
+};
+
+// Summary statistics of the latest depth frame, computed on the camera 
+// processing thread while the frame is ingested
+USTRUCT(BlueprintType) 
+struct FDepthStatistics
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Smallest valid depth value (mm), or 0 if no pixel has valid depth
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 NearestDepth;
+
+	// Mean of the valid depth values (mm)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float MeanDepth;
+
+	// Fraction of pixels with valid (non-zero) depth, between 0 and 1
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ValidPixelRatio;
+
+	// Depth range (mm) covered by each histogram bin
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 HistogramBinSize;
+
+	// Number of valid pixels per depth range. Bin i counts depths in 
+	// [i * HistogramBinSize, (i + 1) * HistogramBinSize); the last bin also 
+	// counts everything beyond.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<int32> Histogram;
+
+	FDepthStatistics() : NearestDepth(0), MeanDepth(0.0f), ValidPixelRatio(0.0f), HistogramBinSize(0) {}
+};
+
+// Connected region of the depth image within the near range of the blob 
+// tracker, such as a hand or an object held up to the camera
+USTRUCT(BlueprintType) 
+struct FDepthBlob
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Identifier kept by the blob from frame to frame while it is tracked
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Id;
+
+	// Number of consecutive frames the blob has been tracked for
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Age;
+
+	// Number of pixels in the blob
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Area;
+
+	// Centroid of the blob in depth image pixels
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FVector2D Center;
+
+	// Inclusive pixel bounds of the blob
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FIntPoint BoundsMin;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FIntPoint BoundsMax;
+
+	// Pixel of the blob nearest to the camera, and its depth (mm)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FIntPoint NearestPoint;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 NearestDepth;
+
+	// Mean depth (mm) of the blob
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float MeanDepth;
+
+	// Centroid at the mean depth, in Unreal units relative to the camera 
+	// (X forward, Y right, Z up)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FVector Position;
+
+	FDepthBlob() : Id(0), Age(0), Area(0), Center(0.0f, 0.0f), BoundsMin(0, 0), BoundsMax(0, 0), NearestPoint(0, 0), 
+		NearestDepth(0), MeanDepth(0.0f), Position(0.0f, 0.0f, 0.0f) {}
+};
+
+// Plane found in the depth image, such as a floor, a table, or a wall. 
+// Positions are in Unreal units relative to the camera (X forward, Y right, 
+// Z up).
+USTRUCT(BlueprintType) 
+struct FDepthPlane
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Identifier kept by the plane from frame to frame while it is tracked
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Id;
+
+	// Number of consecutive frames the plane has been tracked for
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Age;
+
+	// Unit normal of the plane, facing the camera
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FVector Normal;
+
+	// Signed distance of the plane from the camera along Normal, so that the
+	// plane holds the points P with Dot(Normal, P) == Distance
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Distance;
+
+	// Centroid of the inliers of the plane
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	FVector Center;
+
+	// Number of depth pixels labeled with the plane in the plane mask
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 InlierCount;
+
+	FDepthPlane() : Id(0), Age(0), Normal(0.0f, 0.0f, 0.0f), Distance(0.0f), Center(0.0f, 0.0f, 0.0f), 
+		InlierCount(0) {}
+};
+
+// Throughput of a frame stream server or client, accumulated since the 
+// stream was started
+USTRUCT(BlueprintType) 
+struct FRealSenseStreamStats
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Number of connected clients (server) or 1 while connected (client)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Connections;
+
+	// Frames sent to the clients (server) or received (client)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 FramesTransferred;
+
+	// Frames that were replaced by a newer frame before they could be sent 
+	// (server) or that never arrived (client)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 FramesDropped;
+
+	// Average time (ms) spent encoding (server) or decoding (client) a frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float AverageCodecMs;
+
+	// Average time (ms) from capture on the server to decoded frame on the
+	// client. Only meaningful when both run on the same machine, since it 
+	// compares the clocks of both ends.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float AverageLatencyMs;
+
+	// Average network bandwidth in megabits per second
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float BandwidthMbps;
+
+	FRealSenseStreamStats() : Connections(0), FramesTransferred(0), FramesDropped(0), AverageCodecMs(0.0f), 
+		AverageLatencyMs(0.0f), BandwidthMbps(0.0f) {}
+};
+
+// Delivery statistics of a single frame consumer
+USTRUCT(BlueprintType) 
+struct FFrameDeliveryStats
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EFrameDeliveryPolicy Policy;
+
+	// Frames produced by the camera while the consumer was registered
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 FramesPublished;
+
+	// Frames taken by the consumer
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 FramesDelivered;
+
+	// Frames discarded because the queue was full (always 0 when lossless)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 FramesDropped;
+
+	// Frames currently waiting for the consumer
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 QueueDepth;
+
+	// Largest number of frames that were waiting at the same time
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MaxQueueDepth;
+
+	// Average number of frames taken by the consumer per second
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float DeliveredPerSecond;
+
+	// Total time (ms) the camera processing thread was blocked waiting for 
+	// the consumer (lossless only)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float BlockedMs;
+
+	FFrameDeliveryStats() : Policy(EFrameDeliveryPolicy::LATEST_ONLY), FramesPublished(0), FramesDelivered(0), 
+		FramesDropped(0), QueueDepth(0), MaxQueueDepth(0), DeliveredPerSecond(0.0f), BlockedMs(0.0f) {}
+};
+
+// Accuracy and cost of the volumetric fusion engine on a synthetic sequence
+USTRUCT(BlueprintType) 
+struct FFusionBenchmarkResult
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Average time (ms) to fuse one depth frame
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float AverageIntegrationMs;
+
+	// Time (ms) to raycast one full frame of the fused surface
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float RaycastMs;
+
+	// RMS distance (cm) between the raycast surface and the true surface
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float SurfaceRMSError;
+
+	// Fraction of the pixels showing the true surface that the raycast hit
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Coverage;
+
+	// Number of allocated voxel blocks
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 BlockCount;
+
+	// Memory used by the volume (KB)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MemoryKB;
+
+	FFusionBenchmarkResult() : AverageIntegrationMs(0.0f), RaycastMs(0.0f), SurfaceRMSError(0.0f), Coverage(0.0f), 
+		BlockCount(0), MemoryKB(0) {}
+};
+
+// Cost of writing and reading back a mesh in one file format
+USTRUCT(BlueprintType) 
+struct FMeshFileBenchmarkResult
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	EScan3DFileFormat Format;
+
+	// Time (ms) to write the file
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float WriteMs;
+
+	// Time (ms) to load the file with LoadMeshFile()
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ReadMs;
+
+	// Size of the file (KB)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 FileSizeKB;
+
+	// Number of triangles read back
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 TriangleCount;
+
+	FMeshFileBenchmarkResult() : Format(EScan3DFileFormat::OBJ), WriteMs(0.0f), ReadMs(0.0f), FileSizeKB(0), 
+		TriangleCount(0) {}
+};
+
+// One level of detail of a scanned mesh
+USTRUCT(BlueprintType) 
+struct FScanMeshLOD
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<FVector> Vertices;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<int32> Triangles;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<FColor> Colors;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<FVector> Normals;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TArray<FVector> Tangents;
+};
+
+// Cost of building a BVH over a scanned mesh and of querying it
+USTRUCT(BlueprintType) 
+struct FMeshBVHBenchmarkResult
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 TriangleCount;
+
+	// Time (ms) to build the BVH
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float BuildMs;
+
+	// Average time (us) of a ray cast
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float RaycastMicroseconds;
+
+	// Fraction of the ray casts that hit the mesh
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float RaycastHitRatio;
+
+	// Average time (us) of a closest point query
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float ClosestPointMicroseconds;
+
+	// Average time (us) of a box overlap query
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float OverlapMicroseconds;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 NodeCount;
+
+	// Memory used by the BVH (KB)
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 MemoryKB;
+
+	FMeshBVHBenchmarkResult() : TriangleCount(0), BuildMs(0.0f), RaycastMicroseconds(0.0f), RaycastHitRatio(0.0f), 
+		ClosestPointMicroseconds(0.0f), OverlapMicroseconds(0.0f), NodeCount(0), MemoryKB(0) {}
+};
+
+// Cost of tracking the near-range blobs of a depth frame
+USTRUCT(BlueprintType) 
+struct FBlobTrackingBenchmarkResult
+{
+	GENERATED_USTRUCT_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Width;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Height;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 Frames;
+
+	// Average and longest time (ms) of an update of the tracker
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float MeanMs;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float MaxMs;
+
+	// Blobs tracked in the last frame, out of the two in the scene
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	int32 BlobCount;
+
+	FBlobTrackingBenchmarkResult() : Width(0), Height(0), Frames(0), MeanMs(0.0f), MaxMs(0.0f), BlobCount(0) {}
+};
@@ -17,8 +17,11 @@
 
 #include "RealSenseTypes.h"
 #include "pxc3dscan.h"
+#include "pxccapture.h"
 #include <assert.h>
 
+struct RealSenseDepthStatistics;
+
 // Log Category that can be used by all RealSensePlugin source files that inclue this file
 DECLARE_LOG_CATEGORY_EXTERN(RealSensePlugin, Log, All);
 
@@ -52,12 +55,27 @@ FVector ConvertRSVectorToUnreal(FVector v);
 // Converts a depth value (in millimeters) to an 8-bit scale (between 0 - 255).
 uint8 ConvertDepthValueTo8Bit(int32 depth, int32 width);
 
+// Returns true if the device model is one of the cameras supported by the plugin.
+bool IsSupportedCameraModel(PXCCapture::DeviceModel model);
+
+// Converts a PXCCapture::DeviceModel to a Blueprint-exposed CameraModel
+ECameraModel GetECameraModel(PXCCapture::DeviceModel model);
+
+// Converts a PXCCapture::DeviceInfo to a Blueprint-exposed RealSenseDeviceInfo
+FRealSenseDeviceInfo GetRealSenseDeviceInfo(const PXCCapture::DeviceInfo& info);
+
 // Returns a StreamResolution structure containing the values from the enumerated ColorResolution
 FStreamResolution GetEColorResolutionValue(EColorResolution res);
 
 // Returns a StreamResolution structure containing the values from the enumerated DepthResolution
 FStreamResolution GetEDepthResolutionValue(EDepthResolution res);
 
+// Returns the number of pixels in the largest supported color resolution
+int32 GetMaxColorImagePixels();
+
+// Returns the number of pixels in the largest supported depth resolution
+int32 GetMaxDepthImagePixels();
+
 // Converts a Blueprint-exposed RealSensePixelFormat to a PXCImage::PixelFormat
 PXCImage::PixelFormat GetPXCPixelFormat(ERealSensePixelFormat format);
 
@@ -67,13 +85,25 @@ PXC3DScan::ScanningMode GetPXCScanningMode(EScan3DMode mode);
 // Converts a Blueprint-exposed RealSensePixelFormat to a PXCImage::PixelFormat
 PXC3DScan::FileFormat GetPXCScanFileFormat(EScan3DFileFormat format);
 
-// Copies the data from the input color PXCImage into the input data structure.
-void CopyColorImageToBuffer(PXCImage* image, TArray<uint8>& data, const uint32 width, const uint32 height);
+// Copies the data from the input color PXCImage into the input buffer, which
+// must hold at least width * height * 4 bytes.
+void CopyColorImageToBuffer(PXCImage* image, uint8* data, const uint32 width, const uint32 height);
+
+// Copies the data from the input color PXCImage into the input buffer, which
+// must hold at least width * height * 4 bytes.
+void CopySegmentedImageToBuffer(PXCImage* image, uint8* data, const uint32 width, const uint32 height);
 
-// Copies the data from the input color PXCImage into the input data structure.
-void CopySegmentedImageToBuffer(PXCImage* image, TArray<uint8>& data, const uint32 width, const uint32 height);
+// Copies only the alpha channel (the segmentation mask) of the input 
+// segmented PXCImage into the input buffer, which must hold at least 
+// width * height bytes.
+void CopySegmentedMaskToBuffer(PXCImage* image, uint8* mask, const uint32 width, const uint32 height);
 
-// Copies the data from the input depth PXCImage into the input data structure.
-void CopyDepthImageToBuffer(PXCImage* image, TArray<uint16>& data, const uint32 width, const uint32 height);
+// Copies the data from the input depth PXCImage into the input buffer, which
+// must hold at least width * height values. If stats is not null, the depth
+// statistics of the image are computed in the same pass.
+void CopyDepthImageToBuffer(PXCImage* image, uint16* data, const uint32 width, const uint32 height, 
+							RealSenseDepthStatistics* stats = nullptr);
 
+// Loads an OBJ, binary PLY, or binary STL file, chosen by its extension, and
+// centers the mesh on the origin.
 void LoadMeshFile(const FString& filename, TArray<FVector>& Vertices, TArray<int32>& Triangles, TArray<FColor>& Colors);
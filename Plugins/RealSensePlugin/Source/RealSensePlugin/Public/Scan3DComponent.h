@@ -15,9 +15,18 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include "AllowWindowsPlatformTypes.h"
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include "HideWindowsPlatformTypes.h"
+
 #include "RealSenseComponent.h"
 #include "Scan3DComponent.generated.h"
 
+class RealSenseMeshBVH;
+
 UCLASS(editinlinenew, meta = (BlueprintSpawnableComponent), ClassGroup = RealSense) 
 class UScan3DComponent : public URealSenseComponent
 {
@@ -34,17 +43,41 @@ class UScan3DComponent : public URealSenseComponent
 	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
 	UTexture2D* ScanTexture;
 
-	// Array of mesh vertices. This array is populated by the LoadScan() function.
+	// Array of mesh vertices. This array is populated by the LoadScan() and 
+	// ExtractFusionMesh() functions, once OnMeshReady is triggered.
 	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
 	TArray<FVector> Vertices;
 
-	// Array of mesh triangles. This array is populated by the LoadScan() function.
+	// Array of mesh triangles. This array is populated by the LoadScan() and 
+	// ExtractFusionMesh() functions, once OnMeshReady is triggered.
 	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
 	TArray<int32> Triangles;
 
-	// Array of mesh vertex colors. This array is populated by the LoadScan() function.
+	// Array of mesh vertex colors. This array is populated by the LoadScan() and 
+	// ExtractFusionMesh() functions, once OnMeshReady is triggered.
 	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
 	TArray<FColor> Colors;
+
+	// Array of area-weighted mesh vertex normals, computed along with the 
+	// other mesh arrays.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
+	TArray<FVector> Normals;
+
+	// Array of mesh vertex tangents, perpendicular to the Normals. Scans have
+	// no texture coordinates, so the tangents only give a smooth, consistent
+	// frame for shading.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
+	TArray<FVector> Tangents;
+
+	// Fractions of the triangles of the full mesh kept by each level of 
+	// detail built in LODs. Ratios of 1 copy the full mesh.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "RealSense") 
+	TArray<float> LODRatios;
+
+	// Simplified versions of the mesh, one per entry of LODRatios, built 
+	// along with the other mesh arrays. The full mesh is LOD 0.
+	UPROPERTY(BlueprintReadOnly, Category = "RealSense") 
+	TArray<FScanMeshLOD> LODs;
 	
 	// Triggered after a scan has been saved to disk. A call to SaveScan() will 
 	// asynchronously save the scan. You can use this event to be notified when the 
@@ -52,6 +85,14 @@ class UScan3DComponent : public URealSenseComponent
 	UPROPERTY(BlueprintAssignable, Category = "RealSense") 
 	FRealSenseNullaryDelegate OnScanComplete;
 
+	// Triggered when the mesh of LoadScan() or ExtractFusionMesh() has been 
+	// copied into the mesh arrays. The mesh is loaded and its normals, LODs, 
+	// and spatial index are built on a background task, so the arrays and 
+	// the scan queries keep the previous mesh until then. A newer request 
+	// replaces one still being built, which is never triggered for.
+	UPROPERTY(BlueprintAssignable, Category = "RealSense") 
+	FRealSenseNullaryDelegate OnMeshReady;
+
 	// Sets the scanning mode and options for 3D Scanning. After calling this function, 
 	// the scanning preview image will be available in the ScanBuffer.
 	UFUNCTION(BlueprintCallable, Category = "RealSense") 
@@ -69,18 +110,71 @@ class UScan3DComponent : public URealSenseComponent
 	// Stops the scanning process and asynchronously saves the scanned data to a mesh 
 	// file with the specified file format and file name.
 	UFUNCTION(BlueprintCallable, Category = "RealSense") 
-	void SaveScan(FString Filename);
+	void SaveScan(FString Filename, EScan3DFileFormat Format = EScan3DFileFormat::OBJ);
 
-	// Opens the specified .OBJ file and loads the mesh information into this 
-	// component's Vertices, Triangles, and Colors arrays.
+	// Opens the specified .OBJ, .PLY, or .STL file and loads the mesh information 
+	// into this component's Vertices, Triangles, and Colors arrays, and computes
+	// its Normals and Tangents, in the background. OnMeshReady is triggered 
+	// when the arrays have been filled.
 	UFUNCTION(BlueprintCallable, Category = "RealSense") 
 	void LoadScan(FString Filename);
 
+	// Selects the engine used for scanning. The RealSense middleware is used
+	// by default; Fusion builds the scan inside the plugin from the depth 
+	// stream and the poses given to SetFusionCameraPose(). Call before the 
+	// camera starts.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void SetScanBackend(EScan3DBackend Backend);
+
+	// Sets the voxel size, the truncation distance of the surface, and the 
+	// depth beyond which data is ignored, all in Unreal units, for the Fusion
+	// backend. Clears the current scan.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void ConfigureFusion(float VoxelSize = 0.5f, float TruncationDistance = 2.0f, float MaxDepth = 150.0f);
+
+	// Sets the world transform of the camera for the Fusion backend, for 
+	// example from a tracked rig or turntable. Frames are fused from a static
+	// camera at the origin until this is called.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void SetFusionCameraPose(const FTransform& CameraToWorld);
+
+	// Clears the scan built by the Fusion backend.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void ResetFusion();
+
+	// Builds a mesh of the scan made by the Fusion backend so far, in world 
+	// space, into this component's mesh arrays. Runs in memory, so it is fast
+	// enough to preview the mesh while scanning. The rest of the mesh arrays
+	// are built in the background; OnMeshReady is triggered when they are.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	void ExtractFusionMesh();
+
+	// Finds the first point of the mesh hit by the segment from Start to End, 
+	// with the unit normal of the hit triangle. Positions are in the space of
+	// the Vertices. Returns false if the segment misses the mesh.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	bool RaycastScan(FVector Start, FVector End, FVector& HitLocation, FVector& HitNormal, int32& Triangle);
+
+	// Finds the point of the mesh closest to Point within MaxDistance, in the
+	// space of the Vertices. Returns false if there is none.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	bool FindClosestPointOnScan(FVector Point, float MaxDistance, FVector& ClosestPoint, int32& Triangle);
+
+	// Returns the indices of the mesh triangles that intersect the box, in 
+	// the space of the Vertices.
+	UFUNCTION(BlueprintCallable, Category = "RealSense") 
+	TArray<int32> FindScanTrianglesInBox(FBox Box);
+
 	// Returns true if the scanning is currently happening. Use this function after 
 	// calling StartScanning() to know when the scanning process has begun.
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "RealSense") 
 	bool IsScanning();
 
+	// Returns true while a mesh from LoadScan() or ExtractFusionMesh() is 
+	// being built in the background.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category = "RealSense") 
+	bool IsProcessingMesh() const;
+
 	UScan3DComponent();
 
 	void InitializeComponent() override;
@@ -91,4 +185,42 @@ class UScan3DComponent : public URealSenseComponent
 private:
 	// Used internally to know when to listen for ScanComplete events.
 	bool bHasScanStarted{ false };
+
+	// Spatial index over the Triangles for the queries above
+	std::shared_ptr<RealSenseMeshBVH> meshBVH;
+
+	// A mesh and everything derived from it, built by the mesh task
+	struct ScanMesh {
+		TArray<FVector> vertices;
+		TArray<int32> triangles;
+		TArray<FColor> colors;
+		TArray<FVector> normals;
+		TArray<FVector> tangents;
+		TArray<FScanMeshLOD> lods;
+		std::shared_ptr<RealSenseMeshBVH> bvh;
+	};
+
+	// Latest mesh request, taken by the mesh task when it starts or when it
+	// abandons an older mesh. Shared with the task, which may outlive this.
+	struct MeshRequest {
+		std::mutex mutex;
+		std::shared_ptr<ScanMesh> mesh;  // Null once taken
+		FString filename;
+		TArray<float> ratios;
+		bool bRunning{ false };  // A task is building or about to take the request
+		std::atomic<uint32> generation{ 0 };  // Increased by every request
+	};
+
+	std::shared_ptr<MeshRequest> meshRequest;
+
+	std::future<std::shared_ptr<ScanMesh>> meshTask;
+
+	// Loads the mesh from filename unless it is empty, then derives the 
+	// normals, tangents, LODs, and the BVH on a background task. A task 
+	// that is already running drops its mesh between stages and takes this
+	// one instead, so the game thread never waits for it.
+	void StartMeshTask(std::shared_ptr<ScanMesh> mesh, const FString& filename);
+
+	// Moves the finished mesh into the mesh arrays and the BVH.
+	void PublishMesh(ScanMesh& mesh);
 };
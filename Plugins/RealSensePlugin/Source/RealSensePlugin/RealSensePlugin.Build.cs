@@ -26,7 +26,7 @@ namespace UnrealBuildTool.Rules
             UEBuildConfiguration.bForceEnableExceptions = true;
 
             PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine" });
-            PrivateDependencyModuleNames.AddRange(new string[] { "RHI", "RenderCore", "ShaderCore" });
+            PrivateDependencyModuleNames.AddRange(new string[] { "RHI", "RenderCore", "ShaderCore", "Sockets", "Networking", "ImageWrapper" });
 
             PrivateIncludePaths.AddRange(new string[] { "RealSensePlugin/Private" });
 